@@ -0,0 +1,308 @@
+#include "binary_log.h"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace jl {
+
+    std::size_t kBinaryLogRingSize = 4096;
+    constexpr const char* kBinaryLoggerName = "binary_jl_tcpserver_logger";
+    constexpr std::chrono::milliseconds kDrainInterval(1);
+    constexpr std::chrono::seconds kDropReportInterval(1);
+
+    void SetBinaryLogRingSize(std::size_t slots)
+    {
+        std::size_t size = 2;
+        while (size < slots) {
+            size <<= 1;
+        }
+        kBinaryLogRingSize = size;
+    }
+
+    namespace detail {
+
+        /// @brief 单生产者（所属线程）单消费者（后台线程）环形缓冲区。
+        ///        head_ 只由生产者推进；tail_ 由消费者推进，kDropOldest 策略下生产者也会通过CAS推进 tail_ 来回收最旧的槽位，
+        ///        因此消费者先拷贝槽位再CAS确认，CAS失败说明该槽位已被生产者回收，拷贝结果丢弃。
+        class LogRing {
+        public:
+            explicit LogRing(std::size_t capacity) :
+                capacity_(capacity),
+                mask_(capacity - 1),
+                slots_(new char[capacity * kLogSlotSize]),
+                thread_id_(spdlog::details::os::thread_id()),
+                dropped_(0),
+                retired_(false),
+                head_(0),
+                tail_(0)
+            {
+            }
+
+            char* Slot(std::uint64_t index) { return slots_.get() + (index & mask_) * kLogSlotSize; }
+
+            bool Empty() const { return tail_.load(std::memory_order_acquire) == head_.load(std::memory_order_acquire); }
+
+            const std::size_t capacity_;
+            const std::uint64_t mask_;
+            std::unique_ptr<char[]> slots_;
+            const std::size_t thread_id_;
+            std::atomic<std::uint64_t> dropped_;
+            std::atomic<bool> retired_; // 所属线程已退出，后台线程写完后释放
+
+            alignas(64) std::atomic<std::uint64_t> head_;
+            alignas(64) std::atomic<std::uint64_t> tail_;
+        };
+
+        /// @brief 后台线程：轮询所有线程的环形缓冲区，格式化后写入 Logger 的 sinks
+        class LogDrainer {
+        public:
+            static LogDrainer& Instance()
+            {
+                static LogDrainer instance;
+                return instance;
+            }
+
+            void Register(const std::shared_ptr<LogRing>& ring)
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                rings_.emplace_back(ring);
+            }
+
+            void Flush()
+            {
+                while (!AllEmpty()) {
+                    std::this_thread::sleep_for(kDrainInterval);
+                }
+                for (auto& sink : sinks_) {
+                    sink->flush();
+                }
+            }
+
+            std::uint64_t Dropped()
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                return retired_dropped_ + SumDropped();
+            }
+
+            ~LogDrainer()
+            {
+                stop_ = true;
+                cond_.notify_all();
+                if (thread_.joinable()) {
+                    thread_.join();
+                }
+            }
+
+        private:
+            LogDrainer() :
+                sinks_(Logger::GetInstance().Sinks()),
+                stop_(false),
+                retired_dropped_(0),
+                reported_dropped_(0)
+            {
+                thread_ = std::thread([this]() { Run(); });
+            }
+
+            bool AllEmpty()
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                for (auto& ring : rings_) {
+                    if (!ring->Empty()) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            std::uint64_t SumDropped()
+            {
+                std::uint64_t dropped = 0;
+                for (auto& ring : rings_) {
+                    dropped += ring->dropped_.load(std::memory_order_relaxed);
+                }
+                return dropped;
+            }
+
+            void Run()
+            {
+                std::vector<std::shared_ptr<LogRing>> rings;
+                auto last_report = std::chrono::steady_clock::now();
+                while (true) {
+                    bool stop = stop_.load();
+                    {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        rings = rings_;
+                    }
+                    std::size_t drained = 0;
+                    for (auto& ring : rings) {
+                        drained += Drain(*ring);
+                    }
+                    ReleaseRetired();
+
+                    auto now = std::chrono::steady_clock::now();
+                    if (now - last_report >= kDropReportInterval) {
+                        last_report = now;
+                        ReportDropped();
+                    }
+                    if (stop) { // 退出前已经把所有缓冲区写完
+                        break;
+                    }
+                    if (drained == 0) {
+                        std::unique_lock<std::mutex> lock(mutex_);
+                        cond_.wait_for(lock, kDrainInterval);
+                    }
+                }
+                for (auto& sink : sinks_) {
+                    sink->flush();
+                }
+            }
+
+            std::size_t Drain(LogRing& ring)
+            {
+                std::size_t drained = 0;
+                std::uint64_t tail = ring.tail_.load(std::memory_order_acquire);
+                while (tail != ring.head_.load(std::memory_order_acquire)) {
+                    std::memcpy(event_, ring.Slot(tail), kLogSlotSize);
+                    if (!ring.tail_.compare_exchange_strong(tail, tail + 1, std::memory_order_acq_rel)) {
+                        continue; // 被生产者回收（kDropOldest），tail 已更新为最新值
+                    }
+                    ++tail;
+                    Write(ring);
+                    ++drained;
+                }
+                return drained;
+            }
+
+            void Write(const LogRing& ring)
+            {
+                const auto* header = reinterpret_cast<const LogEventHeader*>(event_);
+                const LogSite& site = *header->site;
+                buf_.clear();
+                try {
+                    header->decoder(site, event_ + sizeof(LogEventHeader), header->args_len, buf_);
+                }
+                catch (const std::exception& err) {
+                    buf_.clear();
+                    fmt::format_to(fmt::appender(buf_), "[format error: {}] {}", err.what(), site.format);
+                }
+                auto time = spdlog::log_clock::time_point(
+                    std::chrono::duration_cast<spdlog::log_clock::duration>(std::chrono::nanoseconds(header->timestamp_ns)));
+                spdlog::details::log_msg msg(time, spdlog::source_loc{ site.file, site.line, site.function },
+                    kBinaryLoggerName, site.level, spdlog::string_view_t(buf_.data(), buf_.size()));
+                msg.thread_id = ring.thread_id_;
+                for (auto& sink : sinks_) {
+                    if (sink->should_log(msg.level)) {
+                        sink->log(msg);
+                    }
+                }
+            }
+
+            void ReleaseRetired()
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                for (auto it = rings_.begin(); it != rings_.end();) {
+                    if ((*it)->retired_ && (*it)->Empty()) {
+                        retired_dropped_ += (*it)->dropped_.load(std::memory_order_relaxed);
+                        it = rings_.erase(it);
+                    }
+                    else {
+                        ++it;
+                    }
+                }
+            }
+
+            void ReportDropped()
+            {
+                std::uint64_t dropped = Dropped();
+                if (dropped == reported_dropped_) {
+                    return;
+                }
+                buf_.clear();
+                fmt::format_to(fmt::appender(buf_), "binary log dropped {} events (total {})", dropped - reported_dropped_, dropped);
+                reported_dropped_ = dropped;
+                spdlog::details::log_msg msg(spdlog::source_loc{}, kBinaryLoggerName, spdlog::level::warn,
+                    spdlog::string_view_t(buf_.data(), buf_.size()));
+                for (auto& sink : sinks_) {
+                    if (sink->should_log(msg.level)) {
+                        sink->log(msg);
+                    }
+                }
+            }
+
+        private:
+            const std::vector<spdlog::sink_ptr> sinks_;
+            std::atomic<bool> stop_;
+            std::mutex mutex_;
+            std::condition_variable cond_;
+            std::vector<std::shared_ptr<LogRing>> rings_;
+            std::uint64_t retired_dropped_;
+            std::uint64_t reported_dropped_;
+            alignas(8) char event_[kLogSlotSize];
+            spdlog::memory_buf_t buf_;
+            std::thread thread_;
+        };
+
+        /// @brief 线程退出时把缓冲区标记为retired，剩余事件由后台线程写完后释放
+        struct ThreadLogRingHolder {
+            std::shared_ptr<LogRing> ring;
+
+            ThreadLogRingHolder() : ring(std::make_shared<LogRing>(kBinaryLogRingSize))
+            {
+                LogDrainer::Instance().Register(ring);
+            }
+
+            ~ThreadLogRingHolder()
+            {
+                ring->retired_ = true;
+            }
+        };
+
+        LogRing& ThreadLogRing()
+        {
+            thread_local ThreadLogRingHolder holder;
+            return *holder.ring;
+        }
+
+        char* AcquireSlot(LogRing& ring)
+        {
+            std::uint64_t head = ring.head_.load(std::memory_order_relaxed);
+            std::uint64_t tail = ring.tail_.load(std::memory_order_acquire);
+            while (head - tail >= ring.capacity_) {
+                switch (GetLogOverflowPolicy()) {
+                case LogOverflowPolicy::kDropNewest:
+                    ring.dropped_.fetch_add(1, std::memory_order_relaxed);
+                    return nullptr;
+                case LogOverflowPolicy::kDropOldest:
+                    if (ring.tail_.compare_exchange_strong(tail, tail + 1, std::memory_order_acq_rel)) {
+                        ring.dropped_.fetch_add(1, std::memory_order_relaxed);
+                        ++tail;
+                    }
+                    break;
+                default:
+                    std::this_thread::yield();
+                    tail = ring.tail_.load(std::memory_order_acquire);
+                    break;
+                }
+            }
+            return ring.Slot(head);
+        }
+
+        void CommitSlot(LogRing& ring)
+        {
+            ring.head_.store(ring.head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+    }
+
+    void FlushBinaryLog()
+    {
+        detail::LogDrainer::Instance().Flush();
+    }
+
+    std::uint64_t GetBinaryLogDroppedCount()
+    {
+        return detail::LogDrainer::Instance().Dropped();
+    }
+}
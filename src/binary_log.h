@@ -0,0 +1,200 @@
+/// @file binary_log.h
+/// @brief 热路径二进制日志：每个线程一个无锁SPSC环形缓冲区，后台线程负责格式化和写入
+/// @author Jyang.
+/// @date 2026-10-19
+/// @version 1.0
+
+#pragma once
+
+#include <logger.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+// 热路径日志宏：调用线程只做级别判断 + 把 (时间戳, 调用点id, 原始参数) 拷贝进本线程的环形缓冲区，
+// 格式化和写文件都在后台线程完成。参数只支持算术类型、枚举、指针和字符串（字符串按字节拷贝，超长截断）。
+#define JL_FAST_LOG_CALL(LEVEL, FORMAT, ...)                                                          \
+    do {                                                                                              \
+        if (jl::Logger::GetInstance().ShouldLog(LEVEL)) {                                             \
+            static const jl::LogSite jl_log_site_{FORMAT, LEVEL, __FILE__, __LINE__, SPDLOG_FUNCTION}; \
+            jl::BinaryLog(jl_log_site_, ##__VA_ARGS__);                                               \
+        }                                                                                             \
+    } while (0)
+
+#if JL_LOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_DEBUG
+#define LOG_FAST_DEBUG(FORMAT, ...) JL_FAST_LOG_CALL(spdlog::level::debug, FORMAT, ##__VA_ARGS__)
+#else
+#define LOG_FAST_DEBUG(...) (void)0
+#endif
+
+#if JL_LOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_INFO
+#define LOG_FAST_INFO(FORMAT, ...) JL_FAST_LOG_CALL(spdlog::level::info, FORMAT, ##__VA_ARGS__)
+#else
+#define LOG_FAST_INFO(...) (void)0
+#endif
+
+#if JL_LOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_WARN
+#define LOG_FAST_WARN(FORMAT, ...) JL_FAST_LOG_CALL(spdlog::level::warn, FORMAT, ##__VA_ARGS__)
+#else
+#define LOG_FAST_WARN(...) (void)0
+#endif
+
+#if JL_LOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_ERROR
+#define LOG_FAST_ERROR(FORMAT, ...) JL_FAST_LOG_CALL(spdlog::level::err, FORMAT, ##__VA_ARGS__)
+#else
+#define LOG_FAST_ERROR(...) (void)0
+#endif
+
+namespace jl {
+
+    /// @brief 日志调用点的静态描述，其地址即为事件中的 format id
+    struct LogSite {
+        const char* format;
+        spdlog::level::level_enum level;
+        const char* file;
+        int line;
+        const char* function;
+    };
+
+    namespace detail {
+
+        constexpr std::size_t kLogSlotSize = 256;
+
+        class LogRing;
+
+        /// @brief 后台线程调用，把事件的原始参数还原并格式化到 buf
+        using LogDecoder = void (*)(const LogSite& site, const char* args, std::size_t len, spdlog::memory_buf_t& buf);
+
+        /// @brief 事件头，紧跟其后的是编码后的参数
+        struct LogEventHeader {
+            const LogSite* site;
+            LogDecoder decoder;
+            std::int64_t timestamp_ns; // system_clock
+            std::uint32_t args_len;
+        };
+
+        constexpr std::size_t kLogMaxArgsSize = kLogSlotSize - sizeof(LogEventHeader);
+
+        template <typename T>
+        struct IsLogString : std::bool_constant<
+            std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view> ||
+            std::is_same_v<T, const char*> || std::is_same_v<T, char*>> {};
+
+        template <typename T>
+        using LogDecodedType = std::conditional_t<IsLogString<T>::value, std::string_view, T>;
+
+        template <typename T>
+        inline std::string_view AsStringView(const T& value)
+        {
+            if constexpr (std::is_pointer_v<T>) {
+                return value ? std::string_view(value) : std::string_view("(null)");
+            }
+            else {
+                return std::string_view(value);
+            }
+        }
+
+        /// @brief 编码单个参数，空间不足时字符串截断、其他类型丢弃（解码时按默认值处理）
+        template <typename T>
+        inline void EncodeArg(char* buf, std::size_t& pos, const T& value)
+        {
+            if constexpr (IsLogString<T>::value) {
+                std::string_view sv = AsStringView(value);
+                std::size_t room = kLogMaxArgsSize - pos;
+                if (room < sizeof(std::uint16_t)) {
+                    return;
+                }
+                std::uint16_t n = static_cast<std::uint16_t>(std::min(sv.size(), room - sizeof(std::uint16_t)));
+                std::memcpy(buf + pos, &n, sizeof(n));
+                std::memcpy(buf + pos + sizeof(n), sv.data(), n);
+                pos += sizeof(n) + n;
+            }
+            else {
+                static_assert(std::is_trivially_copyable_v<T>, "LOG_FAST_XXX only supports trivially copyable or string arguments");
+                if (kLogMaxArgsSize - pos >= sizeof(T)) {
+                    std::memcpy(buf + pos, &value, sizeof(T));
+                    pos += sizeof(T);
+                }
+            }
+        }
+
+        template <typename T>
+        inline LogDecodedType<T> DecodeArg(const char* buf, std::size_t len, std::size_t& pos)
+        {
+            if constexpr (IsLogString<T>::value) {
+                std::uint16_t n = 0;
+                if (len - pos < sizeof(n)) {
+                    return {};
+                }
+                std::memcpy(&n, buf + pos, sizeof(n));
+                std::string_view sv(buf + pos + sizeof(n), n);
+                pos += sizeof(n) + n;
+                return sv;
+            }
+            else {
+                T value{};
+                if (len - pos >= sizeof(T)) {
+                    std::memcpy(&value, buf + pos, sizeof(T));
+                    pos += sizeof(T);
+                }
+                return value;
+            }
+        }
+
+        template <typename... Args>
+        void DecodeAndFormat(const LogSite& site, const char* args, std::size_t len, spdlog::memory_buf_t& buf)
+        {
+            std::size_t pos = 0;
+            // 花括号初始化保证参数按顺序解码
+            std::tuple<LogDecodedType<Args>...> values{ DecodeArg<Args>(args, len, pos)... };
+            std::apply([&](const auto&... v) {
+                fmt::vformat_to(fmt::appender(buf), fmt::string_view(site.format), fmt::make_format_args(v...));
+                }, values);
+        }
+
+        /// @brief 当前线程的环形缓冲区，首次调用时创建并注册到后台线程
+        LogRing& ThreadLogRing();
+
+        /// @brief 申请一个写入槽位，按溢出策略可能阻塞或返回nullptr（丢弃）
+        char* AcquireSlot(LogRing& ring);
+
+        /// @brief 发布已写好的槽位
+        void CommitSlot(LogRing& ring);
+    }
+
+    /// @brief 设置每个线程环形缓冲区的槽位数（向上取2的幂，每个槽位 256 字节），需在该线程第一条日志之前设置
+    void SetBinaryLogRingSize(std::size_t slots);
+
+    /// @brief 记录一条二进制日志事件，由 LOG_FAST_XXX 宏调用
+    template <typename... Args>
+    void BinaryLog(const LogSite& site, const Args&... args)
+    {
+        detail::LogRing& ring = detail::ThreadLogRing();
+        char* slot = detail::AcquireSlot(ring);
+        if (slot == nullptr) {
+            return;
+        }
+        auto* header = reinterpret_cast<detail::LogEventHeader*>(slot);
+        char* payload = slot + sizeof(detail::LogEventHeader);
+        std::size_t pos = 0;
+        (detail::EncodeArg<std::decay_t<const Args>>(payload, pos, args), ...);
+        header->site = &site;
+        header->decoder = &detail::DecodeAndFormat<std::decay_t<const Args>...>;
+        header->timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        header->args_len = static_cast<std::uint32_t>(pos);
+        detail::CommitSlot(ring);
+    }
+
+    /// @brief 等待所有线程缓冲区中的事件被后台线程写出
+    void FlushBinaryLog();
+
+    /// @brief 二进制日志因缓冲区满而丢弃的事件数（所有线程累计）
+    std::uint64_t GetBinaryLogDroppedCount();
+}
@@ -1,8 +1,187 @@
 #include "connection.h"
 #include <logger.h>
 #include <global.h>
+#include <ktls.h>
+#include <simd_scan.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
 
 namespace jl {
+	namespace {
+		/// @brief 从文件区间的 sent 处读取至多 max 字节到 out，用于不能 sendfile 时的缓冲发送
+		/// @return 读取的字节数，出错或文件在发送期间被截断时设置 ec
+		std::size_t ReadFileChunk(const FileSegment& file, std::uint64_t sent, std::string& out, std::size_t max, std::error_code& ec)
+		{
+			std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(file.length - sent, max));
+			out.resize(n);
+			std::size_t done = 0;
+			while (done < n) {
+				std::uint64_t offset = file.offset + sent + done;
+#ifdef _WIN32
+				// 同一个 fd 可能被多个连接并发读取，使用带偏移的 ReadFile 而不是 lseek + read
+				OVERLAPPED overlapped{};
+				overlapped.Offset = static_cast<DWORD>(offset);
+				overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+				DWORD got = 0;
+				if (!::ReadFile(reinterpret_cast<HANDLE>(_get_osfhandle(file.fd)), &out[done], static_cast<DWORD>(n - done), &got, &overlapped)) {
+					ec.assign(static_cast<int>(::GetLastError()), asio::error::get_system_category());
+					return 0;
+				}
+#else
+				ssize_t got = ::pread(file.fd, &out[done], n - done, static_cast<off_t>(offset));
+				if (got < 0 && errno == EINTR) {
+					continue;
+				}
+				if (got < 0) {
+					ec.assign(errno, asio::error::get_system_category());
+					return 0;
+				}
+#endif
+				if (got == 0) {
+					ec = asio::error::eof;
+					return 0;
+				}
+				done += static_cast<std::size_t>(got);
+			}
+			return n;
+		}
+
+#ifdef __linux__
+		/// @brief 以非阻塞 sendfile 发送文件区间剩余的部分，sent 累加已发送字节数
+		/// @return socket发送缓冲区已满、需要等待可写后再次调用时返回 true
+		bool SendFileNonBlocking(int socket_fd, const FileSegment& file, std::size_t& sent, std::error_code& ec)
+		{
+			while (sent < file.length) {
+				off_t offset = static_cast<off_t>(file.offset + sent);
+				ssize_t n = ::sendfile(socket_fd, file.fd, &offset, file.length - sent);
+				if (n > 0) {
+					sent += static_cast<std::size_t>(n);
+					continue;
+				}
+				if (n < 0 && errno == EINTR) {
+					continue;
+				}
+				if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+					return true;
+				}
+				if (n < 0) {
+					ec.assign(errno, asio::error::get_system_category());
+				}
+				else {
+					ec = asio::error::eof; // 文件在发送期间被截断
+				}
+				return false;
+			}
+			return false;
+		}
+#endif
+	}
+
+	/// @brief async_read_until 的匹配条件，用向量化查找代替asio对分隔符的逐字节比较
+	class SeparatorMatcher {
+	public:
+		using result_type = bool; // asio::is_match_condition 通过 result_type 识别匹配条件
+
+		explicit SeparatorMatcher(const std::string& sep) :
+			sep_(sep)
+		{
+		}
+
+		template <typename Iterator>
+		std::pair<Iterator, bool> operator()(Iterator begin, Iterator end) const
+		{
+			if (begin == end) {
+				return { end, false };
+			}
+			// asio::streambuf 的可读数据是一块连续内存
+			std::size_t len = end - begin;
+			const char* data = &*begin;
+			const char* found = simd::FindSequence(data, data + len, sep_.data(), sep_.size());
+			if (found != data + len) {
+				return { begin + (found - data + sep_.size()), true };
+			}
+			// 分隔符可能被拆在两次读取之间，下次从末尾 sep.size() - 1 字节处继续查找
+			std::size_t keep = std::min(len, sep_.empty() ? 0 : sep_.size() - 1);
+			return { end - keep, false };
+		}
+
+	private:
+		std::string sep_;
+	};
+
+	/// @brief 接收方向卸载到内核(kTLS)后的读取流，供 async_read/async_read_until 使用，代替直接读 socket。
+	///        告警记录（close_notify 或致命告警）按对端关闭处理；握手记录（如TLS1.3 KeyUpdate）使用的密钥和序号
+	///        已在内核中，OpenSSL 无法再处理，以 operation_not_supported 结束读取，由上层关闭连接
+	class KernelTLSReader {
+	public:
+		using executor_type = net::socket::executor_type;
+
+		explicit KernelTLSReader(net::socket& socket) :
+			socket_(socket)
+		{
+		}
+
+		executor_type get_executor() { return socket_.get_executor(); }
+
+		template <typename MutableBufferSequence, typename ReadHandler>
+		void async_read_some(const MutableBufferSequence& buffers, ReadHandler&& handler)
+		{
+			// async_read 传入的是 streambuf 的一块连续空间
+			asio::mutable_buffer buffer = *asio::buffer_sequence_begin(buffers);
+			socket_.async_wait(net::socket::wait_read,
+				[this, buffer, handler = std::forward<ReadHandler>(handler)](std::error_code ec) mutable {
+					std::size_t n = 0;
+					if (!ec) {
+						n = Receive(buffer, ec);
+						if (ec == asio::error::would_block) {
+							async_read_some(buffer, std::move(handler));
+							return;
+						}
+					}
+					std::move(handler)(ec, n);
+				});
+		}
+
+	private:
+		std::size_t Receive(asio::mutable_buffer buffer, std::error_code& ec)
+		{
+			unsigned char record_type = ktls::kRecordApplicationData;
+			long n = ktls::Receive(socket_.native_handle(), buffer.data(), buffer.size(), record_type);
+			if (n < 0) {
+				ec.assign(errno, asio::error::get_system_category());
+				return 0;
+			}
+			if (n == 0 && buffer.size() > 0) {
+				ec = asio::error::eof;
+				return 0;
+			}
+			switch (record_type) {
+			case ktls::kRecordApplicationData:
+				return static_cast<std::size_t>(n);
+			case ktls::kRecordAlert:
+				if (n >= 2 && static_cast<const unsigned char*>(buffer.data())[1] != 0) {
+					LOG_DEBUG("ktls: peer sent alert {}", static_cast<int>(static_cast<const unsigned char*>(buffer.data())[1]));
+				}
+				ec = asio::error::eof;
+				return 0;
+			default:
+				LOG_WARN_LIMIT(kErrorLogPerSecond, "ktls: unexpected record type {} after handshake, close", static_cast<int>(record_type));
+				ec = asio::error::operation_not_supported;
+				return 0;
+			}
+		}
+
+	private:
+		net::socket& socket_;
+	};
+
 	class Connection : public IConnection {
 	public:
 		Connection(net::socket&& socket, std::size_t max_buffer_size = kDefaultBufferMaxSize) :
@@ -66,7 +245,7 @@ namespace jl {
 				auto self = shared_from_this();
 				// note: read_until 读取的是包含sep的数据，而不是以sep为结束的数据。因此读取的数据量可能会更多
 				//		但是bytes_transfferred 表示的是第一个sep出现索引，所以可以使用bytes_transfferred来表示读取的长度
-				asio::async_read_until(socket_, read_buffer_, sep,
+				asio::async_read_until(socket_, read_buffer_, SeparatorMatcher(sep),
 					[self, this, sep](const std::error_code& ec, size_t bytes_transferred)
 				{
 					if (this->state_ != ConnectionState::kClosed)
@@ -80,7 +259,7 @@ namespace jl {
 			}
 		}
 
-		const asio::any_io_executor& GetExecutor()
+		asio::any_io_executor GetExecutor()
 		{
 			return socket_.get_executor();
 		}
@@ -94,9 +273,9 @@ namespace jl {
 			auto self = shared_from_this();
 			std::string copy(static_cast<const char*>(data), n);
 			asio::post(GetExecutor(), // 保证send_queue线程安全
-				[self, this, copy = std::move(copy)]() {
+				[self, this, copy = std::move(copy)]() mutable {
 				const bool write_in_progress = !this->send_queue_.empty();
-				this->send_queue_.emplace(copy);
+				this->send_queue_.push(SendItem::FromData(std::move(copy)));
 				if (!write_in_progress) {
 					this->DoWrite();
 				}
@@ -111,6 +290,34 @@ namespace jl {
 			Write(data.c_str(), data.size());
 		}
 
+		void Write(const std::shared_ptr<const std::string>& data)
+		{
+			auto self = shared_from_this();
+			asio::post(GetExecutor(),
+				[self, this, data]() {
+				const bool write_in_progress = !this->send_queue_.empty();
+				this->send_queue_.push(SendItem::FromShared(data));
+				if (!write_in_progress) {
+					this->DoWrite();
+				}
+			}
+			);
+		}
+
+		void SendFile(const FileSegment& file)
+		{
+			auto self = shared_from_this();
+			asio::post(GetExecutor(),
+				[self, this, file]() {
+				const bool write_in_progress = !this->send_queue_.empty();
+				this->send_queue_.push(SendItem::FromFile(file));
+				if (!write_in_progress) {
+					this->DoWrite();
+				}
+			}
+			);
+		}
+
 		/// @brief 关闭连接
 		void Close()
 		{
@@ -145,8 +352,14 @@ namespace jl {
 		void DoWrite()
 		{
 			//std::string data = this->send_queue_.front();
+			if (this->send_queue_.front().file.fd >= 0) {
+				file_sent_ = 0;
+				DoSendFile();
+				return;
+			}
 			auto self = shared_from_this();
-			asio::async_write(socket_, asio::buffer(this->send_queue_.front()), asio::transfer_exactly(this->send_queue_.front().size()),
+			const std::string& data = this->send_queue_.front().Payload();
+			asio::async_write(socket_, asio::buffer(data), asio::transfer_exactly(data.size()),
 				[self, this](const std::error_code& ec, size_t bytes_transferred)
 				{
 					if (state_ != ConnectionState::kClosed) // 连接已断开
@@ -163,6 +376,63 @@ namespace jl {
 			);
 		}
 
+		/// @brief 发送队首的文件区间，Linux上用 sendfile，其他平台分块读入后写出
+		void DoSendFile()
+		{
+			auto self = shared_from_this();
+			const FileSegment& file = this->send_queue_.front().file;
+			std::error_code ec;
+#ifdef __linux__
+			socket_.native_non_blocking(true, ec);
+			if (!ec && SendFileNonBlocking(socket_.native_handle(), file, file_sent_, ec)) {
+				socket_.async_wait(net::socket::wait_write, [self, this](const std::error_code& ec) {
+					if (state_ == ConnectionState::kClosed) {
+						return;
+					}
+					if (ec) {
+						this->FinishFile(ec);
+						return;
+					}
+					this->DoSendFile();
+					});
+				return;
+			}
+			FinishFile(ec);
+#else
+			if (file_sent_ == file.length) {
+				FinishFile(ec);
+				return;
+			}
+			ReadFileChunk(file, file_sent_, file_buffer_, kWriteCoalesceBytes, ec);
+			if (ec) {
+				FinishFile(ec);
+				return;
+			}
+			asio::async_write(socket_, asio::buffer(file_buffer_), [self, this](const std::error_code& ec, size_t bytes_transferred) {
+				if (state_ == ConnectionState::kClosed) {
+					return;
+				}
+				file_sent_ += bytes_transferred;
+				if (ec) {
+					this->FinishFile(ec);
+					return;
+				}
+				this->DoSendFile();
+				});
+#endif
+		}
+
+		void FinishFile(const std::error_code& ec)
+		{
+			std::size_t length = this->send_queue_.front().file.length;
+			this->send_queue_.pop();
+			std::string().swap(file_buffer_);
+			this->OnWrite(ec, length);
+			if (!ec && !this->send_queue_.empty()) {
+				this->DoWrite();
+			}
+		}
+
 		/// @brief 处理读取完成事件
 		/// @param ec 错误码
 		/// @param bytes_transferred 实际读取字节数
@@ -188,9 +458,7 @@ namespace jl {
 				else
 				{
 					if (ec != asio::error::eof) {
-						std::error_code ignore;
-						auto remote = GetRemoteEndpoint();
-						LOG_ERROR("{}:{} OnRead message:{}", remote.address().to_string(), remote.port(), ec.message());
+						LOG_ERROR_LIMIT(kErrorLogPerSecond, "{}:{} OnRead message:{}", GetRemoteEndpoint().address().to_string(), GetRemoteEndpoint().port(), ec.message());
 					}
 					Close();
 				}
@@ -210,9 +478,7 @@ namespace jl {
 				}
 			}
 			else {
-				std::error_code ignore;
-				auto remote = GetRemoteEndpoint();
-				LOG_ERROR("{}:{} OnWrite message:{}", remote.address().to_string(), remote.port(), ec.message());
+				LOG_ERROR_LIMIT(kErrorLogPerSecond, "{}:{} OnWrite message:{}", GetRemoteEndpoint().address().to_string(), GetRemoteEndpoint().port(), ec.message());
 				Close();
 			}
 		}
@@ -223,13 +489,19 @@ namespace jl {
 
 	private:
 		net::socket socket_;
+		std::size_t file_sent_ = 0;		// 队首文件区间已发送的字节数
+		std::string file_buffer_;		// 不能 sendfile 时的文件分块
 	};
 
 	class SSLConnection : public IConnection {
 	public:
 		SSLConnection(net::socket&& socket, std::size_t max_buffer_size = kDefaultBufferMaxSize) :
 			IConnection(max_buffer_size),
-			socket_(std::move(socket), Global::Instance().GetSSLContext())
+			socket_(std::move(socket), Global::Instance().GetSSLContext()),
+			ktls_reader_(socket_.next_layer()),
+			writing_(false),
+			record_size_(0),
+			bytes_since_idle_(0)
 		{
 		}
 
@@ -238,11 +510,57 @@ namespace jl {
 		void Handshake()
 		{
 			auto self = shared_from_this();
-			socket_.async_handshake(ssl::stream_base::server,
-				[self, this](const std::error_code& ec) {
-					this->OnHandshake(ec);
+			auto& global = Global::Instance();
+			if (!global.TryBeginHandshake()) {
+				LOG_WARN_LIMIT(kErrorLogPerSecond, "{}:{} too many pending handshakes, reject", GetRemoteEndpoint().address().to_string(), GetRemoteEndpoint().port());
+				state_ = ConnectionState::kClosed;
+				std::error_code ignore;
+				socket_.lowest_layer().close(ignore);
+				if (this->conn_close_callback_) {
+					this->conn_close_callback_(self);
 				}
-			);
+				return;
+			}
+			// async_handshake 的每一步(SSL_do_handshake)都在完成回调所绑定的执行器上运行：
+			// 配置了握手线程池时握手计算全部在线程池上完成，握手结束后再回到连接所在的io线程
+			asio::thread_pool* pool = global.GetHandshakePool();
+			asio::any_io_executor strand = pool ? asio::any_io_executor(asio::make_strand(pool->get_executor()))
+				: asio::any_io_executor(asio::make_strand(GetExecutor()));
+			struct HandshakeState {
+				asio::steady_timer timer;
+				bool done = false;
+				bool timeout = false;
+				explicit HandshakeState(const asio::any_io_executor& ex) : timer(ex) {}
+			};
+			auto hs = std::make_shared<HandshakeState>(strand);
+			if (global.GetHandshakeTimeout() > 0) {
+				hs->timer.expires_after(std::chrono::seconds(global.GetHandshakeTimeout()));
+				hs->timer.async_wait([self, this, hs](const std::error_code& ec) {
+					if (!ec && !hs->done) {
+						hs->timeout = true;
+						std::error_code ignore;
+						socket_.lowest_layer().close(ignore); // 握手以 operation_aborted 结束
+					}
+				});
+			}
+			asio::dispatch(strand, [self, this, strand, hs, pool]() {
+				socket_.async_handshake(ssl::stream_base::server, asio::bind_executor(strand,
+					[self, this, hs, pool](const std::error_code& ec) {
+						hs->done = true;
+						hs->timer.cancel();
+						Global::Instance().EndHandshake(hs->timeout);
+						if (hs->timeout) {
+							LOG_DEBUG("{}:{} handshake timeout", GetRemoteEndpoint().address().to_string(), GetRemoteEndpoint().port());
+						}
+						if (pool) {
+							asio::post(GetExecutor(), [self, this, ec]() { this->OnHandshake(ec); });
+						}
+						else {
+							this->OnHandshake(ec);
+						}
+					}
+				));
+			});
 		}
 
 		/// @brief 异步读取数据
@@ -252,16 +570,21 @@ namespace jl {
 			bool expected = false;
 			if (read_in_progress_.compare_exchange_strong(expected, true)) {
 				auto self = shared_from_this();
-				asio::async_read(this->socket_, read_buffer_, asio::transfer_at_least(1),
-					[self, this](const std::error_code& ec, std::size_t bytes_transferred)
+				auto handler = [self, this](const std::error_code& ec, std::size_t bytes_transferred)
 					{
 						if (state_ != ConnectionState::kClosed) {
 							bool expected = true;
 							read_in_progress_.compare_exchange_strong(expected, false);
 							this->OnRead(ec, bytes_transferred, 0);
 						}
-					}
-				);
+					};
+				// 接收方向已卸载到内核时直接从socket读明文，非数据记录由 KernelTLSReader 处理
+				if (ktls_.rx) {
+					asio::async_read(ktls_reader_, read_buffer_, asio::transfer_at_least(1), std::move(handler));
+				}
+				else {
+					asio::async_read(socket_, read_buffer_, asio::transfer_at_least(1), std::move(handler));
+				}
 			}
 		}
 
@@ -270,8 +593,7 @@ namespace jl {
 			bool expected = false;
 			if (read_in_progress_.compare_exchange_strong(expected, true)) {
 				auto self = shared_from_this();
-				asio::async_read(socket_, read_buffer_, asio::transfer_exactly(exactly_bytes),
-					[self, this](const std::error_code& ec, std::size_t bytes_transferred)
+				auto handler = [self, this](const std::error_code& ec, std::size_t bytes_transferred)
 					{
 						if (this->state_ != ConnectionState::kClosed)
 						{
@@ -279,8 +601,13 @@ namespace jl {
 							read_in_progress_.compare_exchange_strong(expected, false);
 							this->OnRead(ec, bytes_transferred, 0);
 						}
-					}
-				);
+					};
+				if (ktls_.rx) {
+					asio::async_read(ktls_reader_, read_buffer_, asio::transfer_exactly(exactly_bytes), std::move(handler));
+				}
+				else {
+					asio::async_read(socket_, read_buffer_, asio::transfer_exactly(exactly_bytes), std::move(handler));
+				}
 			}
 		}
 
@@ -291,21 +618,25 @@ namespace jl {
 				auto self = shared_from_this();
 				// note: read_until 读取的是包含sep的数据，而不是以sep为结束的数据。因此读取的数据量可能会更多
 				//		但是bytes_transfferred 表示的是第一个sep出现索引，所以可以使用bytes_transfferred来表示读取的长度
-				asio::async_read_until(socket_, read_buffer_, sep,
-					[self, this, sep = std::move(sep)](const std::error_code& ec, size_t bytes_transferred)
+				auto handler = [self, this, sep_len = sep.size()](const std::error_code& ec, size_t bytes_transferred)
 				{
 					if (this->state_ != ConnectionState::kClosed)
 					{
 						bool expected = true;
 						read_in_progress_.compare_exchange_strong(expected, false);
-						this->OnRead(ec, bytes_transferred, sep.size());
+						this->OnRead(ec, bytes_transferred, sep_len);
 					}
+				};
+				if (ktls_.rx) {
+					asio::async_read_until(ktls_reader_, read_buffer_, SeparatorMatcher(sep), std::move(handler));
+				}
+				else {
+					asio::async_read_until(socket_, read_buffer_, SeparatorMatcher(sep), std::move(handler));
 				}
-				);
 			}
 		}
 
-		const asio::any_io_executor& GetExecutor()
+		asio::any_io_executor GetExecutor()
 		{
 			return socket_.lowest_layer().get_executor();
 		}
@@ -318,10 +649,9 @@ namespace jl {
 			auto self = shared_from_this();
 			std::string copy(static_cast<const char*>(data), n);
 			asio::post(GetExecutor(), // 保证send_queue线程安全
-				[self, this, copy = std::move(copy)]() {
-				const bool write_in_progress = !this->send_queue_.empty();
-				this->send_queue_.emplace(copy);
-				if (!write_in_progress) {
+				[self, this, copy = std::move(copy)]() mutable {
+				this->send_queue_.push(SendItem::FromData(std::move(copy)));
+				if (!this->writing_) {
 					this->DoWrite();
 				}
 			}
@@ -335,6 +665,33 @@ namespace jl {
 			Write(data.c_str(), data.size());
 		}
 
+		/// @brief SSL连接需要为每个连接单独加密，共享数据在合并写入时复制一次
+		void Write(const std::shared_ptr<const std::string>& data)
+		{
+			auto self = shared_from_this();
+			asio::post(GetExecutor(),
+				[self, this, data]() {
+				this->send_queue_.push(SendItem::FromShared(data));
+				if (!this->writing_) {
+					this->DoWrite();
+				}
+			}
+			);
+		}
+
+		void SendFile(const FileSegment& file)
+		{
+			auto self = shared_from_this();
+			asio::post(GetExecutor(),
+				[self, this, file]() {
+				this->send_queue_.push(SendItem::FromFile(file));
+				if (!this->writing_) {
+					this->DoWrite();
+				}
+			}
+			);
+		}
+
 		/// @brief 关闭连接
 		void Close()
 		{
@@ -342,6 +699,15 @@ namespace jl {
 			if (state_.compare_exchange_strong(expected, ConnectionState::kClosed)) {
 				std::error_code ignore;
 				auto self = shared_from_this();
+				if (ktls_.tx) {
+					// 内核持有发送密钥和序号，OpenSSL已无法再发送记录，close_notify 交给内核发送
+					ktls::SendCloseNotify(socket_.lowest_layer().native_handle());
+					socket_.lowest_layer().close(ignore);
+					if (this->conn_close_callback_) {
+						this->conn_close_callback_(self);
+					}
+					return;
+				}
 				std::shared_ptr<bool> has_close = std::make_shared<bool>(false);
 				std::shared_ptr<asio::steady_timer> handshake_timer = std::make_shared<asio::steady_timer>(GetExecutor());
 				socket_.async_shutdown(
@@ -389,6 +755,11 @@ namespace jl {
 			return socket_.lowest_layer().local_endpoint(ignore);
 		}
 
+		bool IsSSL() const
+		{
+			return true;
+		}
+
 		~SSLConnection()
 		{
 			LOG_DEBUG("SSLConnection destruct");
@@ -396,23 +767,152 @@ namespace jl {
 	private:
 		void DoWrite()
 		{
-			//std::string data = this->send_queue_.front();
 			auto self = shared_from_this();
-			asio::async_write(socket_, asio::buffer(this->send_queue_.front()), asio::transfer_exactly(this->send_queue_.front().size()),
-				[self, this](const std::error_code& ec, size_t bytes_transferred)
+			writing_ = true;
+			if (send_queue_.front().file.fd >= 0) {
+				file_sent_ = 0;
+				DoSendFile();
+				return;
+			}
+			AdjustRecordSize();
+			// 把上一次写入期间排队的消息合并为一次写入，SSL_write按记录大小切分，避免每条小消息单独成为一个记录
+			if (send_queue_.front().shared) {
+				write_buffer_.assign(*send_queue_.front().shared);
+			}
+			else {
+				write_buffer_ = std::move(send_queue_.front().data);
+			}
+			send_queue_.pop();
+			write_sizes_.assign(1, write_buffer_.size());
+			while (!send_queue_.empty() && send_queue_.front().file.fd < 0 && write_buffer_.size() + send_queue_.front().Payload().size() <= kWriteCoalesceBytes) {
+				write_buffer_.append(send_queue_.front().Payload());
+				write_sizes_.push_back(send_queue_.front().Payload().size());
+				send_queue_.pop();
+			}
+			auto handler = [self, this](const std::error_code& ec, size_t bytes_transferred)
 				{
 					if (state_ != ConnectionState::kClosed) // 连接已断开
 					{
-						this->send_queue_.pop();
-						this->OnWrite(ec, bytes_transferred);
-						if (!ec) {
-							if (!this->send_queue_.empty()) {
-								this->DoWrite();
-							}
+						bytes_since_idle_ += bytes_transferred;
+						last_write_ = std::chrono::steady_clock::now();
+						if (ec) {
+							this->OnWrite(ec, bytes_transferred);
+							return;
+						}
+						// 空闲连接不保留大块写缓冲
+						write_buffer_.clear();
+						if (write_buffer_.capacity() > kTLSLargeRecordSize) {
+							std::string().swap(write_buffer_);
+						}
+						// 每条消息仍各自回调一次写完成
+						for (std::size_t n : write_sizes_) {
+							this->OnWrite(ec, n);
+						}
+						if (!this->send_queue_.empty()) {
+							this->DoWrite();
+						}
+						else {
+							writing_ = false;
 						}
 					}
+				};
+			// 发送方向已卸载到内核时直接写明文，由内核分片加密
+			if (ktls_.tx) {
+				asio::async_write(socket_.next_layer(), asio::buffer(write_buffer_), std::move(handler));
+			}
+			else {
+				asio::async_write(socket_, asio::buffer(write_buffer_), std::move(handler));
+			}
+		}
+
+		/// @brief 发送队首的文件区间：发送方向已卸载到内核时 sendfile 直接发送明文，否则分块读入后经 SSL 加密写出
+		void DoSendFile()
+		{
+			auto self = shared_from_this();
+			const FileSegment& file = send_queue_.front().file;
+			std::error_code ec;
+#ifdef __linux__
+			if (ktls_.tx) {
+				auto& socket = socket_.next_layer();
+				socket.native_non_blocking(true, ec);
+				if (!ec && SendFileNonBlocking(socket.native_handle(), file, file_sent_, ec)) {
+					socket.async_wait(net::socket::wait_write, [self, this](const std::error_code& ec) {
+						if (state_ == ConnectionState::kClosed) {
+							return;
+						}
+						if (ec) {
+							this->FinishFile(ec);
+							return;
+						}
+						this->DoSendFile();
+						});
+					return;
 				}
-			);
+				FinishFile(ec);
+				return;
+			}
+#endif
+			if (file_sent_ == file.length) {
+				FinishFile(ec);
+				return;
+			}
+			AdjustRecordSize();
+			ReadFileChunk(file, file_sent_, write_buffer_, kWriteCoalesceBytes, ec);
+			if (ec) {
+				FinishFile(ec);
+				return;
+			}
+			asio::async_write(socket_, asio::buffer(write_buffer_), [self, this](const std::error_code& ec, size_t bytes_transferred) {
+				if (state_ == ConnectionState::kClosed) {
+					return;
+				}
+				bytes_since_idle_ += bytes_transferred;
+				last_write_ = std::chrono::steady_clock::now();
+				file_sent_ += bytes_transferred;
+				if (ec) {
+					this->FinishFile(ec);
+					return;
+				}
+				this->DoSendFile();
+				});
+		}
+
+		void FinishFile(const std::error_code& ec)
+		{
+			std::size_t length = send_queue_.front().file.length;
+			send_queue_.pop();
+			write_buffer_.clear();
+			if (write_buffer_.capacity() > kTLSLargeRecordSize) {
+				std::string().swap(write_buffer_);
+			}
+			this->OnWrite(ec, length);
+			if (ec) {
+				return;
+			}
+			if (!send_queue_.empty()) {
+				this->DoWrite();
+			}
+			else {
+				writing_ = false;
+			}
+		}
+
+		/// @brief 动态记录大小：刚建立或空闲后的连接使用小记录降低首字节延迟，持续发送后使用最大记录降低开销
+		void AdjustRecordSize()
+		{
+			if (ktls_.tx) {
+				return; // 记录由内核切分
+			}
+			if (std::chrono::steady_clock::now() - last_write_ > kTLSRecordIdleReset) {
+				bytes_since_idle_ = 0;
+			}
+			std::size_t record_size = bytes_since_idle_ < kTLSRecordBoostBytes ? kTLSSmallRecordSize : kTLSLargeRecordSize;
+			if (record_size != record_size_) {
+				// 调小 max_send_fragment 时OpenSSL会同步调小 split_send_fragment，调大时需要显式恢复
+				SSL_set_max_send_fragment(socket_.native_handle(), static_cast<long>(record_size));
+				SSL_set_split_send_fragment(socket_.native_handle(), static_cast<long>(record_size));
+				record_size_ = record_size;
+			}
 		}
 
 		/// @brief 处理读取完成事件
@@ -439,9 +939,7 @@ namespace jl {
 			else
 			{
 				if (ec != asio::error::eof) {
-					std::error_code ignore;
-					auto remote = GetRemoteEndpoint();
-					LOG_ERROR("{}:{} OnRead message:{}", remote.address().to_string(), remote.port(), ec.message());
+					LOG_ERROR_LIMIT(kErrorLogPerSecond, "{}:{} OnRead message:{}", GetRemoteEndpoint().address().to_string(), GetRemoteEndpoint().port(), ec.message());
 				}
 				Close();
 			}
@@ -461,9 +959,7 @@ namespace jl {
 			}
 			else
 			{
-				std::error_code ignore;
-				auto remote = GetRemoteEndpoint();
-				LOG_ERROR("{}:{} OnWrite message:{}", remote.address().to_string(), remote.port(), ec.message());
+				LOG_ERROR_LIMIT(kErrorLogPerSecond, "{}:{} OnWrite message:{}", GetRemoteEndpoint().address().to_string(), GetRemoteEndpoint().port(), ec.message());
 				Close();
 			}
 		}
@@ -474,6 +970,12 @@ namespace jl {
 		{
 			if (!ec)
 			{
+				auto& global = Global::Instance();
+				global.OnHandshakeFinished(SSL_session_reused(socket_.native_handle()) == 1);
+				if (global.KernelTLSEnabled()) {
+					ktls_ = ktls::Enable(socket_.native_handle(), socket_.lowest_layer().native_handle());
+					global.OnKernelTLS(ktls_.tx, ktls_.rx);
+				}
 				if (handshake_callback_)
 				{
 					handshake_callback_(shared_from_this());
@@ -482,9 +984,7 @@ namespace jl {
 			else
 			{
 				if (ec != asio::error::eof) {
-					std::error_code ignore;
-					auto remote = GetRemoteEndpoint();
-					LOG_ERROR("{}:{} OnHandshake fail, message:{}", remote.address().to_string(), remote.port(), ec.message());
+					LOG_ERROR_LIMIT(kErrorLogPerSecond, "{}:{} OnHandshake fail, message:{}", GetRemoteEndpoint().address().to_string(), GetRemoteEndpoint().port(), ec.message());
 				}
 				Close();
 			}
@@ -492,6 +992,15 @@ namespace jl {
 
 	private:
 		ssl::stream<net::socket> socket_;
+		ktls::State ktls_{ false, false };
+		KernelTLSReader ktls_reader_;
+		bool writing_;							// 是否有写操作未完成
+		std::string write_buffer_;				// 合并后的待写数据
+		std::vector<std::size_t> write_sizes_;	// write_buffer_ 中每条消息的长度
+		std::size_t file_sent_ = 0;				// 队首文件区间已发送的字节数
+		std::size_t record_size_;				// 当前TLS记录大小
+		std::size_t bytes_since_idle_;			// 上次空闲以来发送的字节数
+		std::chrono::steady_clock::time_point last_write_;
 	};
 }
 
@@ -504,3 +1013,48 @@ std::shared_ptr<jl::IConnection> jl::MakeSSLConnection(net::socket&& socket, std
 {
 	return std::make_shared<jl::SSLConnection>(std::move(socket), max_buffer_size);
 }
+
+void jl::MakeAutoConnection(net::socket&& socket, const ConnCreatedCallback& callback, std::size_t max_buffer_size)
+{
+	constexpr unsigned char kTLSHandshakeRecord = 0x16;
+	struct SniffState {
+		net::socket socket;
+		asio::steady_timer timer;
+		bool timeout = false;
+		explicit SniffState(net::socket&& s) : socket(std::move(s)), timer(socket.get_executor()) {}
+	};
+	// 计时器和socket使用同一个执行器（Acceptor 为每个连接创建strand），超时回调与等待回调不会并发
+	auto state = std::make_shared<SniffState>(std::move(socket));
+	state->timer.expires_after(kProtocolSniffTimeout);
+	state->timer.async_wait([state](const std::error_code& ec) {
+		if (!ec) {
+			state->timeout = true;
+			std::error_code ignore;
+			state->socket.cancel(ignore);
+		}
+	});
+	state->socket.async_wait(net::socket::wait_read, [state, callback, max_buffer_size](const std::error_code& ec) {
+		state->timer.cancel();
+		std::error_code ignore;
+		if (ec && !state->timeout) {
+			state->socket.close(ignore);
+			return;
+		}
+		bool tls = false;
+		if (!ec) {
+			unsigned char first = 0;
+			std::error_code peek_ec;
+			std::size_t n = state->socket.receive(asio::buffer(&first, 1), net::socket::message_peek, peek_ec);
+			if (peek_ec || n == 0) { // 对端未发送数据就断开
+				state->socket.close(ignore);
+				return;
+			}
+			tls = first == kTLSHandshakeRecord;
+		}
+		auto conn = tls ? MakeSSLConnection(std::move(state->socket), max_buffer_size)
+			: MakeConnection(std::move(state->socket), max_buffer_size);
+		if (callback) {
+			callback(conn);
+		}
+	});
+}
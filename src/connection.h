@@ -14,6 +14,38 @@ namespace jl
 	constexpr std::size_t kDefaultMaxReadBytes = 2048;
 	constexpr std::size_t kDefaultTimeout = 5 * 60;
 	constexpr std::size_t kDefaultBufferMaxSize = 1024 * 4;
+	constexpr std::uint32_t kErrorLogPerSecond = 10; // 每个错误日志调用点每秒最多输出的条数，超出部分汇总为抑制计数
+
+	// SSL连接动态记录大小：连接开始或空闲后用小记录，保证首字节尽快可解密；持续大量发送后切换为最大记录
+	constexpr std::size_t kTLSSmallRecordSize = 1300;			// 一个TLS记录放进一个TCP报文段
+	constexpr std::size_t kTLSLargeRecordSize = 16 * 1024;		// TLS最大记录长度
+	constexpr std::size_t kTLSRecordBoostBytes = 1024 * 1024;	// 连续发送超过该字节数后切换为大记录
+	constexpr std::chrono::milliseconds kTLSRecordIdleReset(1000);	// 空闲超过该时间后回到小记录
+	constexpr std::size_t kWriteCoalesceBytes = 4 * kTLSLargeRecordSize;	// 单次合并写入的最大字节数
+
+	// MakeAutoConnection 等待客户端首字节的最长时间，超时后按普通连接处理（兼容服务端先发数据的协议）
+	constexpr std::chrono::milliseconds kProtocolSniffTimeout(3000);
+
+	/// @brief 待发送的文件区间。owner 持有打开的文件（例如缓存项），保证发送完成前 fd 不被关闭
+	struct FileSegment {
+		int fd = -1;
+		std::uint64_t offset = 0;
+		std::size_t length = 0;
+		std::shared_ptr<const void> owner;
+	};
+
+	/// @brief 发送队列中的一项：内存数据（data，或多个连接共享的 shared），或 file.fd >= 0 时的文件区间
+	struct SendItem {
+		std::string data;
+		FileSegment file;
+		std::shared_ptr<const std::string> shared;
+
+		static SendItem FromData(std::string data) { SendItem item; item.data = std::move(data); return item; }
+		static SendItem FromShared(std::shared_ptr<const std::string> shared) { SendItem item; item.shared = std::move(shared); return item; }
+		static SendItem FromFile(const FileSegment& file) { SendItem item; item.file = file; return item; }
+
+		const std::string& Payload() const { return shared ? *shared : data; }
+	};
 
 	enum class ConnectionState {
 		kActived = 1,
@@ -54,7 +86,7 @@ namespace jl
 
 		virtual void ReadUntil(const std::string& sep) = 0;
 
-		virtual const asio::any_io_executor& GetExecutor() = 0;
+		virtual asio::any_io_executor GetExecutor() = 0;
 
 		/// @brief 异步写入数据
 		/// @param data 数据指针
@@ -65,6 +97,13 @@ namespace jl
 		/// @param data 数据字符串
 		virtual void Write(const std::string& data) = 0;
 
+		/// @brief 异步写入多个连接共享的数据（例如广播），普通连接直接从共享缓冲区发送，不为每个连接复制
+		virtual void Write(const std::shared_ptr<const std::string>& data) = 0;
+
+		/// @brief 异步发送文件区间，与 Write 按调用顺序排队，完成后以 file.length 回调写完成。
+		///        普通连接和已卸载发送方向的kTLS连接使用 sendfile，数据不经过用户态；其他SSL连接分块读入后加密发送
+		virtual void SendFile(const FileSegment& file) = 0;
+
 		/// @brief 关闭连接
 		virtual void Close() = 0;
 
@@ -72,6 +111,9 @@ namespace jl
 
 		virtual net::endpoint GetLocalEndpoint() const = 0;
 
+		/// @brief 是否为SSL连接
+		virtual bool IsSSL() const { return false; }
+
 		/// @brief 设置写入完成回调函数
 		/// @param callback 写入完成回调函数
 		virtual void SetWriteFinishCallback(WriteFinishCallback callback) { write_finish_callback_ = callback; }
@@ -92,7 +134,7 @@ namespace jl
 		std::atomic<bool> read_in_progress_;
 		std::atomic<ConnectionState> state_;
 		asio::streambuf read_buffer_;
-		std::queue<std::string> send_queue_;
+		std::queue<SendItem> send_queue_;
 		HandshakeCallback handshake_callback_;
 		WriteFinishCallback write_finish_callback_;
 		MessageCommingCallback message_comming_callback_;
@@ -108,4 +150,11 @@ namespace jl
 	// @param socket 
 	// @param 连接最大读缓冲区
 	std::shared_ptr<IConnection> MakeSSLConnection(net::socket&& socket, std::size_t max_buffer_size = kDefaultBufferMaxSize);
+
+	// @brief 同一端口同时支持普通TCP和SSL：等待客户端首字节，以 MSG_PEEK 查看但不消费，
+	//        是TLS握手记录(0x16)时创建SSL连接，否则创建普通连接，已到达的数据留给连接自己读取
+	// @param socket 
+	// @param callback 连接创建后回调，在回调中设置连接的各个回调并调用 Handshake()；对端在发送数据前断开时不会回调
+	// @param 连接最大读缓冲区
+	void MakeAutoConnection(net::socket&& socket, const ConnCreatedCallback& callback, std::size_t max_buffer_size = kDefaultBufferMaxSize);
 }
\ No newline at end of file
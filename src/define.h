@@ -21,6 +21,7 @@ namespace jl
     using WriteFinishCallback = std::function<void(const std::shared_ptr<IConnection> &, std::size_t)>;
     using ConnCloseCallback = std::function<void(const std::shared_ptr<IConnection> &)>;
     using HandshakeCallback = std::function<void(const std::shared_ptr<IConnection> &)>;
+    using ConnCreatedCallback = std::function<void(const std::shared_ptr<IConnection> &)>; // MakeAutoConnection 识别出协议并创建连接后回调
 
     using TimeoutCallback = std::function<void()>;
 
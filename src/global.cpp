@@ -1,11 +1,34 @@
 #include "global.h"
 #include <logger.h>
+#include <ktls.h>
 
 namespace jl {
 
 	Global::Global() :
 #ifdef ENABLE_OPENSSL
-		ssl_context_(ssl::context::tlsv12_server)
+		ssl_context_(ssl::context::tls_server),
+		min_version_(TLS1_2_VERSION),
+		max_version_(TLS1_3_VERSION),
+		cipher_list_(kDefaultCipherList),
+		cipher_suites_(kDefaultCipherSuites),
+		groups_(kDefaultGroups),
+		session_cache_size_(20480),
+		session_timeout_(300),
+		session_cache_shards_(16),
+		session_ticket_(true),
+		ticket_rotate_secs_(3600),
+		num_tickets_(1),
+		kernel_tls_(false),
+		handshake_threads_(0),
+		handshake_max_pending_(0),
+		handshake_timeout_(10),
+		full_handshakes_(0),
+		resumed_handshakes_(0),
+		ktls_tx_(0),
+		ktls_rx_(0),
+		handshakes_pending_(0),
+		handshakes_rejected_(0),
+		handshakes_timeout_(0)
 #endif
 	{
 
@@ -21,9 +44,26 @@ namespace jl {
 				ssl::context::default_workarounds |  // 兼容性补丁
 				ssl::context::no_sslv2 | // 禁用不安全的sslV2
 				ssl::context::no_sslv3 | // 禁用不安全的sslV2
-				ssl::context::single_dh_use // 启动DH密钥单次使用
+				SSL_OP_CIPHER_SERVER_PREFERENCE // 按服务端顺序选择算法，保证ECDHE优先
 			);
 
+			SSL_CTX* ctx = ssl_context_.native_handle();
+			if (SSL_CTX_set_min_proto_version(ctx, min_version_) != 1 || SSL_CTX_set_max_proto_version(ctx, max_version_) != 1) {
+				throw std::runtime_error(fmt::format("invalid protocol version range [{:#x}, {:#x}]", min_version_, max_version_));
+			}
+			// TLS1.2 及以下的算法套件
+			if (!cipher_list_.empty() && SSL_CTX_set_cipher_list(ctx, cipher_list_.c_str()) != 1) {
+				throw std::runtime_error(fmt::format("invalid cipher list: {}", cipher_list_));
+			}
+			// TLS1.3 的算法套件
+			if (!cipher_suites_.empty() && SSL_CTX_set_ciphersuites(ctx, cipher_suites_.c_str()) != 1) {
+				throw std::runtime_error(fmt::format("invalid cipher suites: {}", cipher_suites_));
+			}
+			// ECDHE 使用的曲线，按优先级排列
+			if (!groups_.empty() && SSL_CTX_set1_groups_list(ctx, groups_.c_str()) != 1) {
+				throw std::runtime_error(fmt::format("invalid groups: {}", groups_));
+			}
+
 			// 设置私钥密码回调
 			ssl_context_.set_password_callback(password_callback_);
 
@@ -33,8 +73,47 @@ namespace jl {
 			// 加载私钥文件（pem格式，通常跟证书在同一文件）
 			ssl_context_.use_private_key_file(private_key_file_, ssl::context::pem);
 
-			// 加载临时DH参数文件（用于DHE密钥交换），每次生成新DH密钥，防止密钥重复攻击，实现完美前向保护（PFS）
-			ssl_context_.use_tmp_dh_file(tmp_db_file_);
+			// 加载临时DH参数文件，只有算法套件中包含DHE时才会用到（有限域DH每次握手开销很大，默认套件只用ECDHE）
+			if (!tmp_db_file_.empty()) {
+				ssl_context_.use_tmp_dh_file(tmp_db_file_);
+			}
+
+			// 会话复用：session id 走分片缓存，session ticket 使用定期轮换的密钥
+			const unsigned char sid_ctx[] = "jl_tcpserver";
+			SSL_CTX_set_session_id_context(ctx, sid_ctx, sizeof(sid_ctx) - 1);
+			if (session_cache_size_ > 0) {
+				session_cache_ = std::make_unique<SSLSessionCache>(session_cache_size_, std::chrono::seconds(session_timeout_), session_cache_shards_);
+				session_cache_->Attach(ctx);
+			}
+			else {
+				SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+			}
+			if (session_ticket_) {
+				ticket_keys_ = std::make_unique<SSLTicketKeys>(std::chrono::seconds(ticket_rotate_secs_));
+				ticket_keys_->Attach(ctx);
+				SSL_CTX_set_num_tickets(ctx, num_tickets_);
+			}
+			else {
+				SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+			}
+
+			// 连接空闲时释放OpenSSL内部的读写缓冲，降低大量空闲连接的内存占用
+			SSL_CTX_set_mode(ctx, SSL_MODE_RELEASE_BUFFERS);
+
+			// kTLS 需要在握手过程中拿到TLS1.3流量密钥和已发送的记录数
+			if (kernel_tls_) {
+				if (ktls::Supported()) {
+					ktls::Prepare(ctx);
+				}
+				else {
+					LOG_WARN("kernel tls is not supported on this platform, fallback to user space");
+					kernel_tls_ = false;
+				}
+			}
+
+			if (handshake_threads_ > 0 && !handshake_pool_) {
+				handshake_pool_ = std::make_unique<asio::thread_pool>(handshake_threads_);
+			}
 		}
 		catch (const std::exception& err) {
 			LOG_ERROR("fail: {}!", err.what());
@@ -66,6 +145,123 @@ namespace jl {
 	{
 		password_callback_ = callback;
 	}
+
+	void Global::SetProtocolVersion(int min_version, int max_version)
+	{
+		min_version_ = min_version;
+		max_version_ = max_version;
+	}
+
+	void Global::SetCipherList(const std::string& ciphers)
+	{
+		cipher_list_ = ciphers;
+	}
+
+	void Global::SetCipherSuites(const std::string& suites)
+	{
+		cipher_suites_ = suites;
+	}
+
+	void Global::SetGroups(const std::string& groups)
+	{
+		groups_ = groups;
+	}
+
+	void Global::SetSessionCache(std::size_t capacity, std::size_t timeout_secs, std::size_t shards)
+	{
+		session_cache_size_ = capacity;
+		session_timeout_ = timeout_secs;
+		session_cache_shards_ = shards;
+	}
+
+	void Global::SetSessionTicket(bool enable, std::size_t rotate_secs, std::size_t num_tickets)
+	{
+		session_ticket_ = enable;
+		ticket_rotate_secs_ = rotate_secs;
+		num_tickets_ = num_tickets;
+	}
+
+	void Global::SetKernelTLS(bool enable)
+	{
+		kernel_tls_ = enable;
+	}
+
+	bool Global::KernelTLSEnabled() const
+	{
+		return kernel_tls_;
+	}
+
+	void Global::SetHandshakeOptions(std::size_t worker_threads, std::size_t max_pending, std::size_t timeout_secs)
+	{
+		handshake_threads_ = worker_threads;
+		handshake_max_pending_ = max_pending;
+		handshake_timeout_ = timeout_secs;
+	}
+
+	asio::thread_pool* Global::GetHandshakePool()
+	{
+		return handshake_pool_.get();
+	}
+
+	std::size_t Global::GetHandshakeTimeout() const
+	{
+		return handshake_timeout_;
+	}
+
+	bool Global::TryBeginHandshake()
+	{
+		std::uint64_t pending = handshakes_pending_.fetch_add(1, std::memory_order_relaxed);
+		if (handshake_max_pending_ > 0 && pending >= handshake_max_pending_) {
+			handshakes_pending_.fetch_sub(1, std::memory_order_relaxed);
+			handshakes_rejected_.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		return true;
+	}
+
+	void Global::EndHandshake(bool timeout)
+	{
+		handshakes_pending_.fetch_sub(1, std::memory_order_relaxed);
+		if (timeout) {
+			handshakes_timeout_.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	Global::SSLStats Global::GetSSLStats() const
+	{
+		SSLStats stats{};
+		stats.full_handshakes = full_handshakes_.load();
+		stats.resumed_handshakes = resumed_handshakes_.load();
+		stats.ktls_tx = ktls_tx_.load();
+		stats.ktls_rx = ktls_rx_.load();
+		stats.handshakes_pending = handshakes_pending_.load();
+		stats.handshakes_rejected = handshakes_rejected_.load();
+		stats.handshakes_timeout = handshakes_timeout_.load();
+		if (session_cache_) {
+			stats.session_cache = session_cache_->GetStats();
+		}
+		return stats;
+	}
+
+	void Global::OnHandshakeFinished(bool resumed)
+	{
+		if (resumed) {
+			resumed_handshakes_.fetch_add(1, std::memory_order_relaxed);
+		}
+		else {
+			full_handshakes_.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	void Global::OnKernelTLS(bool tx, bool rx)
+	{
+		if (tx) {
+			ktls_tx_.fetch_add(1, std::memory_order_relaxed);
+		}
+		if (rx) {
+			ktls_rx_.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
 #endif // ENABLE_OPENSSL
 
 	Global& Global::Instance()
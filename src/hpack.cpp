@@ -0,0 +1,517 @@
+#include "hpack.h"
+
+#include <limits>
+
+namespace jl {
+    namespace http2 {
+
+        namespace {
+            struct StaticEntry {
+                std::string_view name;
+                std::string_view value;
+            };
+
+            // RFC 7541 附录 A，索引从 1 开始
+            constexpr StaticEntry kStaticTable[] = {
+                { ":authority", "" },
+                { ":method", "GET" },
+                { ":method", "POST" },
+                { ":path", "/" },
+                { ":path", "/index.html" },
+                { ":scheme", "http" },
+                { ":scheme", "https" },
+                { ":status", "200" },
+                { ":status", "204" },
+                { ":status", "206" },
+                { ":status", "304" },
+                { ":status", "400" },
+                { ":status", "404" },
+                { ":status", "500" },
+                { "accept-charset", "" },
+                { "accept-encoding", "gzip, deflate" },
+                { "accept-language", "" },
+                { "accept-ranges", "" },
+                { "accept", "" },
+                { "access-control-allow-origin", "" },
+                { "age", "" },
+                { "allow", "" },
+                { "authorization", "" },
+                { "cache-control", "" },
+                { "content-disposition", "" },
+                { "content-encoding", "" },
+                { "content-language", "" },
+                { "content-length", "" },
+                { "content-location", "" },
+                { "content-range", "" },
+                { "content-type", "" },
+                { "cookie", "" },
+                { "date", "" },
+                { "etag", "" },
+                { "expect", "" },
+                { "expires", "" },
+                { "from", "" },
+                { "host", "" },
+                { "if-match", "" },
+                { "if-modified-since", "" },
+                { "if-none-match", "" },
+                { "if-range", "" },
+                { "if-unmodified-since", "" },
+                { "last-modified", "" },
+                { "link", "" },
+                { "location", "" },
+                { "max-forwards", "" },
+                { "proxy-authenticate", "" },
+                { "proxy-authorization", "" },
+                { "range", "" },
+                { "referer", "" },
+                { "refresh", "" },
+                { "retry-after", "" },
+                { "server", "" },
+                { "set-cookie", "" },
+                { "strict-transport-security", "" },
+                { "transfer-encoding", "" },
+                { "user-agent", "" },
+                { "vary", "" },
+                { "via", "" },
+                { "www-authenticate", "" },
+            };
+            constexpr std::size_t kStaticTableSize = sizeof(kStaticTable) / sizeof(kStaticTable[0]);
+
+            // RFC 7541 附录 B 中每个符号（0-255 和 EOS）的码长。编码是范式 Huffman 编码，码字由码长推出
+            constexpr std::uint8_t kHuffmanCodeLength[257] = {
+            13, 23, 28, 28, 28, 28, 28, 28, 28, 24, 30, 28, 28, 30, 28, 28,
+            28, 28, 28, 28, 28, 28, 30, 28, 28, 28, 28, 28, 28, 28, 28, 28,
+            6, 10, 10, 12, 13, 6, 8, 11, 10, 10, 8, 11, 8, 6, 6, 6,
+            5, 5, 5, 6, 6, 6, 6, 6, 6, 6, 7, 8, 15, 6, 12, 10,
+            13, 6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+            7, 7, 7, 7, 7, 7, 7, 7, 8, 7, 8, 13, 19, 13, 14, 6,
+            15, 5, 6, 5, 6, 5, 6, 6, 6, 5, 7, 7, 6, 6, 6, 5,
+            6, 7, 6, 5, 5, 6, 7, 7, 7, 7, 7, 15, 11, 14, 13, 28,
+            20, 22, 20, 20, 22, 22, 22, 23, 22, 23, 23, 23, 23, 23, 24, 23,
+            24, 24, 22, 23, 24, 23, 23, 23, 23, 21, 22, 23, 22, 23, 23, 24,
+            22, 21, 20, 22, 22, 23, 23, 21, 23, 22, 22, 24, 21, 22, 23, 23,
+            21, 21, 22, 21, 23, 22, 23, 23, 20, 22, 22, 22, 23, 22, 22, 23,
+            26, 26, 20, 19, 22, 23, 22, 25, 26, 26, 26, 27, 27, 26, 24, 25,
+            19, 21, 26, 27, 27, 26, 27, 24, 21, 21, 26, 26, 28, 27, 27, 27,
+            20, 24, 20, 21, 22, 21, 21, 23, 22, 22, 25, 25, 24, 24, 26, 23,
+            26, 27, 26, 26, 27, 27, 27, 27, 27, 28, 27, 27, 27, 27, 27, 26,
+            30,
+            };
+            constexpr int kMaxHuffmanCodeLength = 30;
+            constexpr int kEos = 256;
+
+            /// @brief 由码长生成的范式 Huffman 码表：同一码长的码字连续递增，解码时按码长比较范围即可
+            struct HuffmanTable {
+                std::uint32_t code[257];
+                std::uint32_t first[kMaxHuffmanCodeLength + 1];     // 每种码长的第一个码字
+                std::uint16_t count[kMaxHuffmanCodeLength + 1];     // 每种码长的码字个数
+                std::uint16_t offset[kMaxHuffmanCodeLength + 1];    // 每种码长的第一个符号在 symbols 中的位置
+                std::uint16_t symbols[257];                         // 按（码长，符号）排序
+
+                HuffmanTable() : code(), first(), count(), offset(), symbols()
+                {
+                    for (int sym = 0; sym <= kEos; ++sym) {
+                        ++count[kHuffmanCodeLength[sym]];
+                    }
+                    std::uint32_t next = 0;
+                    std::uint16_t position = 0;
+                    for (int len = 1; len <= kMaxHuffmanCodeLength; ++len) {
+                        next = (next + count[len - 1]) << 1;
+                        first[len] = next;
+                        offset[len] = position;
+                        position = static_cast<std::uint16_t>(position + count[len]);
+                    }
+                    std::uint32_t assigned[kMaxHuffmanCodeLength + 1] = {};
+                    for (int sym = 0; sym <= kEos; ++sym) {
+                        int len = kHuffmanCodeLength[sym];
+                        code[sym] = first[len] + assigned[len];
+                        symbols[offset[len] + assigned[len]] = static_cast<std::uint16_t>(sym);
+                        ++assigned[len];
+                    }
+                }
+            };
+
+            const HuffmanTable& Huffman()
+            {
+                static const HuffmanTable table;
+                return table;
+            }
+
+            char ToLower(char c)
+            {
+                return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+            }
+
+            /// @brief 按前缀位数解码整数，超过 limit 时返回 false
+            bool DecodeInteger(const std::uint8_t*& p, const std::uint8_t* end, int prefix_bits, std::uint64_t limit, std::uint64_t& value)
+            {
+                if (p == end) {
+                    return false;
+                }
+                const std::uint64_t max_prefix = (1u << prefix_bits) - 1;
+                value = *p++ & max_prefix;
+                if (value < max_prefix) {
+                    return value <= limit;
+                }
+                for (int shift = 0; ; shift += 7) {
+                    if (p == end || shift > 56) {
+                        return false;
+                    }
+                    const std::uint8_t b = *p++;
+                    value += static_cast<std::uint64_t>(b & 0x7f) << shift;
+                    if (value > limit) {
+                        return false;
+                    }
+                    if ((b & 0x80) == 0) {
+                        return true;
+                    }
+                }
+            }
+
+            /// @brief 每次都不同或只对单个请求有意义的头部，加入动态表只会挤掉有用的项
+            bool ShouldIndex(std::string_view name)
+            {
+                return name != ":path" && name != "content-length" && name != "etag" && name != "last-modified";
+            }
+        }
+
+        void AppendInteger(std::string& out, std::uint8_t first, int prefix_bits, std::uint64_t value)
+        {
+            const std::uint64_t max_prefix = (1u << prefix_bits) - 1;
+            if (value < max_prefix) {
+                out.push_back(static_cast<char>(first | value));
+                return;
+            }
+            out.push_back(static_cast<char>(first | max_prefix));
+            value -= max_prefix;
+            while (value >= 0x80) {
+                out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+                value >>= 7;
+            }
+            out.push_back(static_cast<char>(value));
+        }
+
+        std::size_t HuffmanEncodedSize(std::string_view text)
+        {
+            std::size_t bits = 0;
+            for (unsigned char c : text) {
+                bits += kHuffmanCodeLength[c];
+            }
+            return (bits + 7) / 8;
+        }
+
+        void HuffmanEncode(std::string& out, std::string_view text)
+        {
+            const HuffmanTable& huffman = Huffman();
+            std::uint64_t bits = 0;     // 低 nbits 位有效
+            int nbits = 0;
+            for (unsigned char c : text) {
+                bits = (bits << kHuffmanCodeLength[c]) | huffman.code[c];
+                nbits += kHuffmanCodeLength[c];
+                while (nbits >= 8) {
+                    nbits -= 8;
+                    out.push_back(static_cast<char>(bits >> nbits));
+                }
+            }
+            if (nbits > 0) {
+                out.push_back(static_cast<char>((bits << (8 - nbits)) | (0xff >> nbits)));
+            }
+        }
+
+        bool HuffmanDecode(std::string_view data, std::string& out)
+        {
+            const HuffmanTable& huffman = Huffman();
+            const unsigned char* p = reinterpret_cast<const unsigned char*>(data.data());
+            const unsigned char* end = p + data.size();
+            std::uint64_t bits = 0;     // 高 nbits 位有效
+            int nbits = 0;
+            while (true) {
+                while (nbits <= 56 && p < end) {
+                    bits |= static_cast<std::uint64_t>(*p++) << (56 - nbits);
+                    nbits += 8;
+                }
+                if (nbits == 0) {
+                    return true;
+                }
+                bool found = false;
+                for (int len = 5; len <= kMaxHuffmanCodeLength && len <= nbits; ++len) {   // 最短的码长为5
+                    std::uint32_t code = static_cast<std::uint32_t>(bits >> (64 - len));
+                    if (code - huffman.first[len] < huffman.count[len]) {
+                        int sym = huffman.symbols[huffman.offset[len] + code - huffman.first[len]];
+                        if (sym == kEos) {
+                            return false;
+                        }
+                        out.push_back(static_cast<char>(sym));
+                        bits <<= len;
+                        nbits -= len;
+                        found = true;
+                        break;
+                    }
+                }
+                if (!found) {
+                    // 剩余的位不构成完整的码字，只能是不超过7位的全1填充
+                    return p == end && nbits <= 7 && (bits >> (64 - nbits)) == (1u << nbits) - 1;
+                }
+            }
+        }
+
+        void AppendString(std::string& out, std::string_view text)
+        {
+            const std::size_t huffman_size = HuffmanEncodedSize(text);
+            if (huffman_size < text.size()) {
+                AppendInteger(out, 0x80, 7, huffman_size);
+                HuffmanEncode(out, text);
+            }
+            else {
+                AppendInteger(out, 0x00, 7, text.size());
+                out.append(text);
+            }
+        }
+
+        HeaderTable::HeaderTable(std::size_t max_size) :
+            size_(0),
+            max_size_(max_size)
+        {
+        }
+
+        void HeaderTable::Add(std::string_view name, std::string_view value)
+        {
+            const std::size_t entry_size = name.size() + value.size() + kHeaderEntryOverhead;
+            if (entry_size > max_size_) {
+                Evict(0);
+                return;
+            }
+            Evict(max_size_ - entry_size);
+            entries_.push_front(HeaderField{ std::string(name), std::string(value) });
+            size_ += entry_size;
+        }
+
+        const HeaderField* HeaderTable::Get(std::size_t index) const
+        {
+            if (index <= kStaticTableSize || index - kStaticTableSize > entries_.size()) {
+                return nullptr;
+            }
+            return &entries_[index - kStaticTableSize - 1];
+        }
+
+        std::size_t HeaderTable::Find(std::string_view name, std::string_view value, bool& value_match) const
+        {
+            std::size_t name_index = 0;
+            for (std::size_t i = 0; i < kStaticTableSize; ++i) {
+                if (kStaticTable[i].name == name) {
+                    if (kStaticTable[i].value == value) {
+                        value_match = true;
+                        return i + 1;
+                    }
+                    if (name_index == 0) {
+                        name_index = i + 1;
+                    }
+                }
+            }
+            for (std::size_t i = 0; i < entries_.size(); ++i) {
+                if (entries_[i].name == name) {
+                    if (entries_[i].value == value) {
+                        value_match = true;
+                        return kStaticTableSize + 1 + i;
+                    }
+                    if (name_index == 0) {
+                        name_index = kStaticTableSize + 1 + i;
+                    }
+                }
+            }
+            value_match = false;
+            return name_index;
+        }
+
+        void HeaderTable::SetMaxSize(std::size_t max_size)
+        {
+            max_size_ = max_size;
+            Evict(max_size);
+        }
+
+        std::size_t HeaderTable::MemoryUsage() const
+        {
+            std::size_t bytes = 0;
+            for (const auto& entry : entries_) {
+                bytes += sizeof(entry) + entry.name.capacity() + entry.value.capacity();
+            }
+            return bytes;
+        }
+
+        void HeaderTable::Evict(std::size_t max_size)
+        {
+            while (size_ > max_size) {
+                size_ -= entries_.back().Size();
+                entries_.pop_back();
+            }
+        }
+
+        HpackDecoder::HpackDecoder(std::size_t max_table_size, std::size_t max_header_list_size) :
+            table_(max_table_size),
+            max_table_size_(max_table_size),
+            max_header_list_size_(max_header_list_size)
+        {
+        }
+
+        bool HpackDecoder::DecodeString(const std::uint8_t*& p, const std::uint8_t* end, std::string& out)
+        {
+            if (p == end) {
+                return false;
+            }
+            const bool huffman = (*p & 0x80) != 0;
+            std::uint64_t length;
+            if (!DecodeInteger(p, end, 7, max_header_list_size_, length) || length > static_cast<std::uint64_t>(end - p)) {
+                return false;
+            }
+            std::string_view data(reinterpret_cast<const char*>(p), static_cast<std::size_t>(length));
+            p += length;
+            if (!huffman) {
+                out.assign(data);
+                return true;
+            }
+            out.clear();
+            return HuffmanDecode(data, out);
+        }
+
+        bool HpackDecoder::Decode(std::string_view block, const FieldCallback& on_field)
+        {
+            const std::uint8_t* p = reinterpret_cast<const std::uint8_t*>(block.data());
+            const std::uint8_t* end = p + block.size();
+            bool seen_field = false;    // 动态表大小更新只能出现在头部块开头
+            std::size_t list_size = 0;
+            while (p < end) {
+                const std::uint8_t b = *p;
+                std::uint64_t index;
+                std::string_view name;
+                std::string_view value;
+                if (b & 0x80) {
+                    // 已索引的字段
+                    if (!DecodeInteger(p, end, 7, std::numeric_limits<std::uint32_t>::max(), index) || index == 0) {
+                        return false;
+                    }
+                    if (index <= kStaticTableSize) {
+                        const StaticEntry& entry = kStaticTable[index - 1];
+                        name = entry.name;
+                        value = entry.value;
+                    }
+                    else {
+                        const HeaderField* field = table_.Get(static_cast<std::size_t>(index));
+                        if (!field) {
+                            return false;
+                        }
+                        name = field->name;
+                        value = field->value;
+                    }
+                }
+                else if ((b & 0xe0) == 0x20) {
+                    std::uint64_t size;
+                    if (seen_field || !DecodeInteger(p, end, 5, max_table_size_, size)) {
+                        return false;
+                    }
+                    table_.SetMaxSize(static_cast<std::size_t>(size));
+                    continue;
+                }
+                else {
+                    // 字面量：0x40 加入动态表，0x00 不加入，0x10 不加入且中间节点也不能加入
+                    const bool incremental = (b & 0x40) != 0;
+                    if (!DecodeInteger(p, end, incremental ? 6 : 4, std::numeric_limits<std::uint32_t>::max(), index)) {
+                        return false;
+                    }
+                    if (index == 0) {
+                        if (!DecodeString(p, end, name_)) {
+                            return false;
+                        }
+                        name = name_;
+                    }
+                    else if (index <= kStaticTableSize) {
+                        name = kStaticTable[index - 1].name;
+                    }
+                    else {
+                        const HeaderField* named = table_.Get(static_cast<std::size_t>(index));
+                        if (!named) {
+                            return false;
+                        }
+                        // 加入动态表时引用的项可能被淘汰，先复制
+                        name_ = named->name;
+                        name = name_;
+                    }
+                    if (!DecodeString(p, end, value_)) {
+                        return false;
+                    }
+                    value = value_;
+                    if (incremental) {
+                        table_.Add(name, value);
+                    }
+                }
+                seen_field = true;
+                list_size += name.size() + value.size() + kHeaderEntryOverhead;
+                if (list_size > max_header_list_size_) {
+                    return false;
+                }
+                on_field(name, value);
+            }
+            return true;
+        }
+
+        bool HpackDecoder::Decode(std::string_view block, std::vector<HeaderField>& headers)
+        {
+            return Decode(block, [&headers](std::string_view name, std::string_view value) {
+                headers.push_back(HeaderField{ std::string(name), std::string(value) });
+                });
+        }
+
+        HpackEncoder::HpackEncoder(std::size_t max_table_size) :
+            table_(max_table_size),
+            pending_size_update_(std::numeric_limits<std::size_t>::max()),
+            min_size_update_(std::numeric_limits<std::size_t>::max())
+        {
+        }
+
+        void HpackEncoder::SetMaxTableSize(std::size_t max_table_size)
+        {
+            if (max_table_size < min_size_update_) {
+                min_size_update_ = max_table_size;
+            }
+            pending_size_update_ = max_table_size;
+            table_.SetMaxSize(max_table_size);
+        }
+
+        void HpackEncoder::Encode(std::string& out, std::string_view name, std::string_view value, bool sensitive)
+        {
+            if (pending_size_update_ != std::numeric_limits<std::size_t>::max()) {
+                // 两次头部块之间先调小再调大时，对端需要先看到最小值才会淘汰对应的项（RFC 7541 4.2）
+                if (min_size_update_ < pending_size_update_) {
+                    AppendInteger(out, 0x20, 5, min_size_update_);
+                }
+                AppendInteger(out, 0x20, 5, pending_size_update_);
+                pending_size_update_ = std::numeric_limits<std::size_t>::max();
+                min_size_update_ = std::numeric_limits<std::size_t>::max();
+            }
+            lower_.resize(name.size());
+            for (std::size_t i = 0; i < name.size(); ++i) {
+                lower_[i] = ToLower(name[i]);
+            }
+            bool value_match = false;
+            const std::size_t index = table_.Find(lower_, value, value_match);
+            if (value_match && !sensitive) {
+                AppendInteger(out, 0x80, 7, index);
+                return;
+            }
+            const bool indexing = !sensitive && ShouldIndex(lower_)
+                && lower_.size() + value.size() + kHeaderEntryOverhead <= table_.MaxSize() / 2;
+            if (indexing) {
+                AppendInteger(out, 0x40, 6, index);
+            }
+            else {
+                AppendInteger(out, sensitive ? 0x10 : 0x00, 4, index);
+            }
+            if (index == 0) {
+                AppendString(out, lower_);
+            }
+            AppendString(out, value);
+            if (indexing) {
+                table_.Add(lower_, value);
+            }
+        }
+    }
+}
@@ -0,0 +1,127 @@
+/// @file hpack.h
+/// @brief HPACK（RFC 7541）头部压缩：静态表、动态表、整数和字符串编码、Huffman 编解码
+/// @author Jyang.
+/// @date 2026-10-19
+/// @version 1.0
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace jl {
+    namespace http2 {
+
+        constexpr std::size_t kDefaultHeaderTableSize = 4096;          // SETTINGS_HEADER_TABLE_SIZE 的初始值
+        constexpr std::size_t kHeaderEntryOverhead = 32;               // 动态表中每一项在名称和值之外计入的字节数
+        constexpr std::size_t kDefaultMaxHeaderListSize = 64 * 1024;   // 解码后一个头部块的最大字节数（按表项大小计）
+
+        struct HeaderField {
+            std::string name;
+            std::string value;
+
+            std::size_t Size() const { return name.size() + value.size() + kHeaderEntryOverhead; }
+        };
+
+        /// @brief 按前缀位数编码整数（RFC 7541 5.1），first 为第一个字节中前缀之外的高位标志
+        void AppendInteger(std::string& out, std::uint8_t first, int prefix_bits, std::uint64_t value);
+
+        /// @brief Huffman 编码后的字节数
+        std::size_t HuffmanEncodedSize(std::string_view text);
+
+        /// @brief Huffman 编码追加到 out，末尾不足一字节的部分用 EOS 的高位（全1）填充
+        void HuffmanEncode(std::string& out, std::string_view text);
+
+        /// @brief Huffman 解码追加到 out，填充超过7位、填充不是全1或出现 EOS 时返回 false
+        bool HuffmanDecode(std::string_view data, std::string& out);
+
+        /// @brief 字符串字面量（RFC 7541 5.2）追加到 out，Huffman 编码更短时使用 Huffman 编码
+        void AppendString(std::string& out, std::string_view text);
+
+        /// @brief 动态表，新加入的项在最前面，超出容量时从最旧的项开始淘汰
+        class HeaderTable {
+        public:
+            explicit HeaderTable(std::size_t max_size = kDefaultHeaderTableSize);
+
+            /// @brief 加入一项，大于容量的项清空整个表且不加入
+            void Add(std::string_view name, std::string_view value);
+
+            /// @brief 按 HPACK 索引（静态表之后从 62 开始）取项，不存在时返回 nullptr
+            const HeaderField* Get(std::size_t index) const;
+
+            /// @brief 查找名称和值都相同的项，否则名称相同的项，返回 HPACK 索引，都没有时返回0
+            std::size_t Find(std::string_view name, std::string_view value, bool& value_match) const;
+
+            void SetMaxSize(std::size_t max_size);
+
+            std::size_t MaxSize() const { return max_size_; }
+            std::size_t Size() const { return size_; }
+            std::size_t Count() const { return entries_.size(); }
+
+            /// @brief 表项占用的堆内存字节数
+            std::size_t MemoryUsage() const;
+
+        private:
+            void Evict(std::size_t max_size);
+
+        private:
+            std::deque<HeaderField> entries_;
+            std::size_t size_;
+            std::size_t max_size_;
+        };
+
+        /// @brief 头部块解码器，每个连接一个，动态表在该连接的所有头部块之间共享
+        class HpackDecoder {
+        public:
+            /// @param max_table_size 本端 SETTINGS_HEADER_TABLE_SIZE，对端的动态表大小更新不能超过它
+            explicit HpackDecoder(std::size_t max_table_size = kDefaultHeaderTableSize, std::size_t max_header_list_size = kDefaultMaxHeaderListSize);
+
+            /// @brief 解码出的字段，视图只在回调期间有效
+            using FieldCallback = std::function<void(std::string_view name, std::string_view value)>;
+
+            /// @brief 解码一个完整的头部块，依次回调每个字段，字面量解码到复用的缓冲区中，不为每个字段分配内存。
+            ///        出错时连接必须以 COMPRESSION_ERROR 关闭
+            bool Decode(std::string_view block, const FieldCallback& on_field);
+
+            /// @brief 解码一个完整的头部块，字段追加到 headers
+            bool Decode(std::string_view block, std::vector<HeaderField>& headers);
+
+            const HeaderTable& Table() const { return table_; }
+
+        private:
+            bool DecodeString(const std::uint8_t*& p, const std::uint8_t* end, std::string& out);
+
+        private:
+            HeaderTable table_;
+            const std::size_t max_table_size_;
+            const std::size_t max_header_list_size_;
+            std::string name_;      // 字面量名称的复用缓冲区
+            std::string value_;     // 字面量值的复用缓冲区
+        };
+
+        /// @brief 头部块编码器。名称编码为小写；:path、content-length 等每次都不同的头部不加入动态表
+        class HpackEncoder {
+        public:
+            explicit HpackEncoder(std::size_t max_table_size = kDefaultHeaderTableSize);
+
+            /// @brief 编码一个字段追加到 out。sensitive 的字段以 never indexed 编码，中间节点也不会索引
+            void Encode(std::string& out, std::string_view name, std::string_view value, bool sensitive = false);
+
+            /// @brief 对端 SETTINGS_HEADER_TABLE_SIZE 变化，下一个头部块开头发出动态表大小更新
+            void SetMaxTableSize(std::size_t max_table_size);
+
+            const HeaderTable& Table() const { return table_; }
+
+        private:
+            HeaderTable table_;
+            std::size_t pending_size_update_;   // 待发出的动态表大小更新，没有时为 SIZE_MAX
+            std::size_t min_size_update_;       // 两次头部块之间表大小被调小过时，先发出最小值
+            std::string lower_;                 // 名称转小写的复用缓冲区
+        };
+    }
+}
@@ -0,0 +1,800 @@
+#include "http2.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace jl {
+    namespace http2 {
+
+        namespace {
+            constexpr std::size_t kPoolLargestBlock = 16 * 1024;   // 不超过该大小的响应体副本在 pool_ 中复用，更大的直接向堆申请
+
+            std::uint32_t ReadUint32(const char* p)
+            {
+                const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+                return (std::uint32_t(u[0]) << 24) | (std::uint32_t(u[1]) << 16) | (std::uint32_t(u[2]) << 8) | u[3];
+            }
+
+            void AppendUint32(std::string& out, std::uint32_t value)
+            {
+                const char bytes[] = { static_cast<char>(value >> 24), static_cast<char>(value >> 16), static_cast<char>(value >> 8), static_cast<char>(value) };
+                out.append(bytes, sizeof(bytes));
+            }
+
+            bool EqualsIgnoreCase(std::string_view a, std::string_view b)
+            {
+                if (a.size() != b.size()) {
+                    return false;
+                }
+                for (std::size_t i = 0; i < a.size(); ++i) {
+                    char x = a[i] >= 'A' && a[i] <= 'Z' ? static_cast<char>(a[i] - 'A' + 'a') : a[i];
+                    if (x != b[i]) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            /// @brief HTTP/2 中不能出现的连接相关头部（RFC 9113 8.2.2）
+            bool IsConnectionHeader(std::string_view name)
+            {
+                return EqualsIgnoreCase(name, "connection") || EqualsIgnoreCase(name, "keep-alive") || EqualsIgnoreCase(name, "proxy-connection")
+                    || EqualsIgnoreCase(name, "transfer-encoding") || EqualsIgnoreCase(name, "upgrade");
+            }
+
+            bool HasUppercase(std::string_view name)
+            {
+                return std::any_of(name.begin(), name.end(), [](char c) { return c >= 'A' && c <= 'Z'; });
+            }
+        }
+
+        FrameHeader ParseFrameHeader(const char* data)
+        {
+            const unsigned char* u = reinterpret_cast<const unsigned char*>(data);
+            FrameHeader header;
+            header.length = (std::uint32_t(u[0]) << 16) | (std::uint32_t(u[1]) << 8) | u[2];
+            header.type = static_cast<FrameType>(u[3]);
+            header.flags = u[4];
+            header.stream_id = ReadUint32(data + 5) & 0x7fffffff;
+            return header;
+        }
+
+        void AppendFrameHeader(std::string& out, std::uint32_t length, FrameType type, std::uint8_t flags, std::uint32_t stream_id)
+        {
+            const char bytes[] = {
+                static_cast<char>(length >> 16), static_cast<char>(length >> 8), static_cast<char>(length),
+                static_cast<char>(type), static_cast<char>(flags),
+            };
+            out.append(bytes, sizeof(bytes));
+            AppendUint32(out, stream_id & 0x7fffffff);
+        }
+
+        void AppendSettings(std::string& out, const std::vector<std::pair<SettingId, std::uint32_t>>& settings)
+        {
+            AppendFrameHeader(out, static_cast<std::uint32_t>(settings.size() * 6), FrameType::kSettings, 0, 0);
+            for (const auto& setting : settings) {
+                const std::uint16_t id = static_cast<std::uint16_t>(setting.first);
+                out.push_back(static_cast<char>(id >> 8));
+                out.push_back(static_cast<char>(id));
+                AppendUint32(out, setting.second);
+            }
+        }
+
+        void AppendWindowUpdate(std::string& out, std::uint32_t stream_id, std::uint32_t increment)
+        {
+            AppendFrameHeader(out, 4, FrameType::kWindowUpdate, 0, stream_id);
+            AppendUint32(out, increment & 0x7fffffff);
+        }
+
+        void AppendRstStream(std::string& out, std::uint32_t stream_id, ErrorCode code)
+        {
+            AppendFrameHeader(out, 4, FrameType::kRstStream, 0, stream_id);
+            AppendUint32(out, static_cast<std::uint32_t>(code));
+        }
+
+        void AppendGoAway(std::string& out, std::uint32_t last_stream_id, ErrorCode code)
+        {
+            AppendFrameHeader(out, 8, FrameType::kGoAway, 0, 0);
+            AppendUint32(out, last_stream_id & 0x7fffffff);
+            AppendUint32(out, static_cast<std::uint32_t>(code));
+        }
+
+        ServerSession::ServerSession(const Settings& settings) :
+            settings_(settings),
+            pool_(std::pmr::pool_options{ 0, kPoolLargestBlock }),
+            streams_(&pool_),
+            send_queue_(&pool_),
+            header_block_stream_(0),
+            header_block_end_stream_(false),
+            preface_received_(false),
+            goaway_sent_(false),
+            goaway_received_(false),
+            last_stream_id_(0),
+            send_window_(kDefaultWindowSize),
+            recv_window_(kDefaultWindowSize),
+            peer_initial_window_(kDefaultWindowSize),
+            peer_max_frame_size_(kDefaultMaxFrameSize)
+        {
+        }
+
+        http::ParseStatus ServerSession::Receive(const char* data, std::size_t len, std::size_t& consumed)
+        {
+            consumed = 0;
+            if (goaway_sent_) {
+                return http::ParseStatus::kError;
+            }
+            if (!preface_received_) {
+                if (std::memcmp(data, kClientPreface.data(), std::min(len, kClientPreface.size())) != 0) {
+                    return ConnectionError(ErrorCode::kProtocolError);
+                }
+                if (len < kClientPreface.size()) {
+                    return http::ParseStatus::kNeedMore;
+                }
+                consumed = kClientPreface.size();
+                preface_received_ = true;
+                AppendSettings(output_, {
+                    { SettingId::kMaxConcurrentStreams, settings_.max_concurrent_streams },
+                    { SettingId::kInitialWindowSize, settings_.initial_window_size },
+                    { SettingId::kMaxHeaderListSize, settings_.max_header_list_size },
+                    });
+                if (settings_.connection_window_size > kDefaultWindowSize) {
+                    AppendWindowUpdate(output_, 0, settings_.connection_window_size - kDefaultWindowSize);
+                    recv_window_ = settings_.connection_window_size;
+                }
+            }
+            while (len - consumed >= kFrameHeaderSize) {
+                const FrameHeader header = ParseFrameHeader(data + consumed);
+                // 没有通告更大的 SETTINGS_MAX_FRAME_SIZE
+                if (header.length > kDefaultMaxFrameSize) {
+                    return ConnectionError(ErrorCode::kFrameSizeError);
+                }
+                if (len - consumed - kFrameHeaderSize < header.length) {
+                    break;
+                }
+                http::ParseStatus status = ProcessFrame(header, data + consumed + kFrameHeaderSize);
+                consumed += kFrameHeaderSize + header.length;
+                if (status == http::ParseStatus::kError) {
+                    return status;
+                }
+            }
+            return http::ParseStatus::kNeedMore;
+        }
+
+        http::ParseStatus ServerSession::ProcessFrame(const FrameHeader& header, const char* payload)
+        {
+            // 头部块必须由连续的 CONTINUATION 帧完成，中间不能插入其他帧
+            if (header_block_stream_ != 0 && (header.type != FrameType::kContinuation || header.stream_id != header_block_stream_)) {
+                return ConnectionError(ErrorCode::kProtocolError);
+            }
+            switch (header.type) {
+            case FrameType::kData:
+                return OnData(header, payload);
+            case FrameType::kHeaders:
+                return OnHeaders(header, payload);
+            case FrameType::kPriority:
+                // 不实现优先级，只检查格式
+                if (header.stream_id == 0) {
+                    return ConnectionError(ErrorCode::kProtocolError);
+                }
+                if (header.length != 5) {
+                    ResetStream(header.stream_id, ErrorCode::kFrameSizeError);
+                }
+                return http::ParseStatus::kNeedMore;
+            case FrameType::kRstStream:
+                return OnRstStream(header, payload);
+            case FrameType::kSettings:
+                return OnSettings(header, payload);
+            case FrameType::kPushPromise:
+                // 客户端不能推送
+                return ConnectionError(ErrorCode::kProtocolError);
+            case FrameType::kPing:
+                if (header.stream_id != 0) {
+                    return ConnectionError(ErrorCode::kProtocolError);
+                }
+                if (header.length != 8) {
+                    return ConnectionError(ErrorCode::kFrameSizeError);
+                }
+                if ((header.flags & flags::kAck) == 0) {
+                    AppendFrameHeader(output_, 8, FrameType::kPing, flags::kAck, 0);
+                    output_.append(payload, 8);
+                }
+                return http::ParseStatus::kNeedMore;
+            case FrameType::kGoAway:
+                if (header.stream_id != 0) {
+                    return ConnectionError(ErrorCode::kProtocolError);
+                }
+                if (header.length < 8) {
+                    return ConnectionError(ErrorCode::kFrameSizeError);
+                }
+                goaway_received_ = true;
+                return http::ParseStatus::kNeedMore;
+            case FrameType::kWindowUpdate:
+                return OnWindowUpdate(header, payload);
+            case FrameType::kContinuation:
+                if (header_block_stream_ == 0) {
+                    return ConnectionError(ErrorCode::kProtocolError);
+                }
+                header_block_.append(payload, header.length);
+                if (header_block_.size() > settings_.max_header_list_size) {
+                    return ConnectionError(ErrorCode::kEnhanceYourCalm);
+                }
+                if (header.flags & flags::kEndHeaders) {
+                    return OnHeaderBlockEnd();
+                }
+                return http::ParseStatus::kNeedMore;
+            default:
+                // 未知类型的帧必须忽略
+                return http::ParseStatus::kNeedMore;
+            }
+        }
+
+        http::ParseStatus ServerSession::OnData(const FrameHeader& header, const char* payload)
+        {
+            if (header.stream_id == 0) {
+                return ConnectionError(ErrorCode::kProtocolError);
+            }
+            const char* data = payload;
+            std::size_t size = header.length;
+            if (header.flags & flags::kPadded) {
+                if (size == 0 || static_cast<std::uint8_t>(data[0]) >= size) {
+                    return ConnectionError(ErrorCode::kProtocolError);
+                }
+                size -= 1 + static_cast<std::uint8_t>(data[0]);
+                ++data;
+            }
+            // 流量控制按整个帧（包括填充）计算。请求体已复制到流中，立即归还连接窗口
+            if (header.length > recv_window_) {
+                return ConnectionError(ErrorCode::kFlowControlError);
+            }
+            if (header.length > 0) {
+                AppendWindowUpdate(output_, 0, header.length);
+            }
+
+            auto it = streams_.find(header.stream_id);
+            if (it == streams_.end()) {
+                if (header.stream_id > last_stream_id_) {
+                    return ConnectionError(ErrorCode::kProtocolError);
+                }
+                // 已经关闭或被重置的流，对端可能还没收到 RST_STREAM
+                return http::ParseStatus::kNeedMore;
+            }
+            Stream& stream = it->second;
+            if (stream.end_stream) {
+                ResetStream(stream.id, ErrorCode::kStreamClosed);
+                return http::ParseStatus::kNeedMore;
+            }
+            if (header.length > stream.recv_window) {
+                ResetStream(stream.id, ErrorCode::kFlowControlError);
+                return http::ParseStatus::kNeedMore;
+            }
+            if (!stream.too_large && stream.body.size() + size > settings_.max_body_bytes) {
+                stream.too_large = true;
+                std::string().swap(stream.body);
+                Respond(stream.id, 413, {}, {});
+            }
+            if (!stream.too_large) {
+                stream.body.append(data, size);
+            }
+            if (header.flags & flags::kEndStream) {
+                stream.end_stream = true;
+                if (!stream.too_large) {
+                    DispatchWithBody(stream);
+                }
+            }
+            else if (header.length > 0) {
+                AppendWindowUpdate(output_, stream.id, header.length);
+            }
+            return http::ParseStatus::kNeedMore;
+        }
+
+        http::ParseStatus ServerSession::OnHeaders(const FrameHeader& header, const char* payload)
+        {
+            if (header.stream_id == 0) {
+                return ConnectionError(ErrorCode::kProtocolError);
+            }
+            const char* data = payload;
+            std::size_t size = header.length;
+            std::size_t padding = 0;
+            if (header.flags & flags::kPadded) {
+                if (size == 0) {
+                    return ConnectionError(ErrorCode::kProtocolError);
+                }
+                padding = static_cast<std::uint8_t>(data[0]);
+                ++data;
+                --size;
+            }
+            if (header.flags & flags::kPriority) {
+                if (size < 5) {
+                    return ConnectionError(ErrorCode::kFrameSizeError);
+                }
+                data += 5;
+                size -= 5;
+            }
+            if (padding > size) {
+                return ConnectionError(ErrorCode::kProtocolError);
+            }
+            header_block_.assign(data, size - padding);
+            header_block_stream_ = header.stream_id;
+            header_block_end_stream_ = (header.flags & flags::kEndStream) != 0;
+            if (header.flags & flags::kEndHeaders) {
+                return OnHeaderBlockEnd();
+            }
+            return http::ParseStatus::kNeedMore;
+        }
+
+        http::ParseStatus ServerSession::OnHeaderBlockEnd()
+        {
+            const std::uint32_t id = header_block_stream_;
+            header_block_stream_ = 0;
+            // 即使流会被拒绝也要解码，保持与对端的动态表一致。字段复制到 arena_，处理完这个头部块后一次性释放
+            fields_.clear();
+            const bool decoded = decoder_.Decode(header_block_, [this](std::string_view name, std::string_view value) {
+                fields_.push_back(http::Header{ arena_.Copy(name), arena_.Copy(value) });
+                });
+            header_block_.clear();
+            http::ParseStatus status = decoded ? OnRequestHeaders(id) : ConnectionError(ErrorCode::kCompressionError);
+            fields_.clear();
+            arena_.Reset();
+            return status;
+        }
+
+        http::ParseStatus ServerSession::OnRequestHeaders(std::uint32_t id)
+        {
+            auto it = streams_.find(id);
+            if (it != streams_.end()) {
+                // 请求体之后的 trailers，必须结束流
+                Stream& stream = it->second;
+                if (stream.end_stream) {
+                    ResetStream(id, ErrorCode::kStreamClosed);
+                }
+                else if (!header_block_end_stream_) {
+                    ResetStream(id, ErrorCode::kProtocolError);
+                }
+                else {
+                    stream.end_stream = true;
+                    if (!stream.too_large) {
+                        DispatchWithBody(stream);
+                    }
+                }
+                return http::ParseStatus::kNeedMore;
+            }
+            if (id <= last_stream_id_ || id % 2 == 0) {
+                return ConnectionError(ErrorCode::kProtocolError);
+            }
+            last_stream_id_ = id;
+            if (goaway_received_) {
+                return http::ParseStatus::kNeedMore;
+            }
+            if (streams_.size() >= settings_.max_concurrent_streams) {
+                ++stats_.refused_streams;
+                ResetStream(id, ErrorCode::kRefusedStream);
+                return http::ParseStatus::kNeedMore;
+            }
+            Stream& stream = streams_.try_emplace(id, &pool_).first->second;
+            stream.id = id;
+            stream.send_window = peer_initial_window_;
+            stream.recv_window = settings_.initial_window_size;
+            stream.end_stream = header_block_end_stream_;
+            if (stream.end_stream) {
+                Dispatch(stream, fields_);
+            }
+            else {
+                // 请求体可能跨越很多帧，期间其他流的头部块会 Reset arena_，头部复制到流中保存
+                stream.headers.reserve(fields_.size());
+                for (const auto& field : fields_) {
+                    stream.headers.push_back(HeaderField{ std::string(field.name), std::string(field.value) });
+                }
+            }
+            return http::ParseStatus::kNeedMore;
+        }
+
+        http::ParseStatus ServerSession::OnSettings(const FrameHeader& header, const char* payload)
+        {
+            if (header.stream_id != 0) {
+                return ConnectionError(ErrorCode::kProtocolError);
+            }
+            if (header.flags & flags::kAck) {
+                return header.length == 0 ? http::ParseStatus::kNeedMore : ConnectionError(ErrorCode::kFrameSizeError);
+            }
+            if (header.length % 6 != 0) {
+                return ConnectionError(ErrorCode::kFrameSizeError);
+            }
+            for (std::size_t offset = 0; offset < header.length; offset += 6) {
+                const std::uint16_t id = static_cast<std::uint16_t>((static_cast<std::uint8_t>(payload[offset]) << 8) | static_cast<std::uint8_t>(payload[offset + 1]));
+                const std::uint32_t value = ReadUint32(payload + offset + 2);
+                switch (static_cast<SettingId>(id)) {
+                case SettingId::kHeaderTableSize:
+                {
+                    // 编码器的动态表不超过默认大小，限制每个连接的内存
+                    const std::size_t size = std::min<std::size_t>(value, kDefaultHeaderTableSize);
+                    if (size != encoder_.Table().MaxSize()) {
+                        encoder_.SetMaxTableSize(size);
+                    }
+                    break;
+                }
+                case SettingId::kEnablePush:
+                    if (value > 1) {
+                        return ConnectionError(ErrorCode::kProtocolError);
+                    }
+                    break;
+                case SettingId::kInitialWindowSize:
+                {
+                    if (value > kMaxWindowSize) {
+                        return ConnectionError(ErrorCode::kFlowControlError);
+                    }
+                    // 新的初始窗口对所有已打开的流生效（RFC 9113 6.9.2）
+                    const std::int64_t delta = static_cast<std::int64_t>(value) - peer_initial_window_;
+                    peer_initial_window_ = value;
+                    for (auto& item : streams_) {
+                        Stream& stream = item.second;
+                        stream.send_window += delta;
+                        if (stream.send_window > kMaxWindowSize) {
+                            return ConnectionError(ErrorCode::kFlowControlError);
+                        }
+                        if (delta > 0 && stream.responded && !stream.queued) {
+                            Enqueue(stream);
+                        }
+                    }
+                    break;
+                }
+                case SettingId::kMaxFrameSize:
+                    if (value < kDefaultMaxFrameSize || value > kMaxFrameSizeLimit) {
+                        return ConnectionError(ErrorCode::kProtocolError);
+                    }
+                    peer_max_frame_size_ = value;
+                    break;
+                default:
+                    // SETTINGS_MAX_CONCURRENT_STREAMS 只限制服务端推送，不推送时忽略；未知的设置必须忽略
+                    break;
+                }
+            }
+            AppendFrameHeader(output_, 0, FrameType::kSettings, flags::kAck, 0);
+            return http::ParseStatus::kNeedMore;
+        }
+
+        http::ParseStatus ServerSession::OnWindowUpdate(const FrameHeader& header, const char* payload)
+        {
+            if (header.length != 4) {
+                return ConnectionError(ErrorCode::kFrameSizeError);
+            }
+            const std::uint32_t increment = ReadUint32(payload) & 0x7fffffff;
+            if (header.stream_id == 0) {
+                if (increment == 0) {
+                    return ConnectionError(ErrorCode::kProtocolError);
+                }
+                send_window_ += increment;
+                if (send_window_ > kMaxWindowSize) {
+                    return ConnectionError(ErrorCode::kFlowControlError);
+                }
+                return http::ParseStatus::kNeedMore;
+            }
+            if (header.stream_id > last_stream_id_) {
+                return ConnectionError(ErrorCode::kProtocolError);
+            }
+            auto it = streams_.find(header.stream_id);
+            if (it == streams_.end()) {
+                return http::ParseStatus::kNeedMore;
+            }
+            Stream& stream = it->second;
+            if (increment == 0) {
+                ResetStream(stream.id, ErrorCode::kProtocolError);
+                return http::ParseStatus::kNeedMore;
+            }
+            stream.send_window += increment;
+            if (stream.send_window > kMaxWindowSize) {
+                ResetStream(stream.id, ErrorCode::kFlowControlError);
+                return http::ParseStatus::kNeedMore;
+            }
+            if (stream.responded && !stream.queued) {
+                Enqueue(stream);
+            }
+            return http::ParseStatus::kNeedMore;
+        }
+
+        http::ParseStatus ServerSession::OnRstStream(const FrameHeader& header, const char* payload)
+        {
+            (void)payload;
+            if (header.stream_id == 0 || header.stream_id > last_stream_id_) {
+                return ConnectionError(ErrorCode::kProtocolError);
+            }
+            if (header.length != 4) {
+                return ConnectionError(ErrorCode::kFrameSizeError);
+            }
+            if (streams_.erase(header.stream_id) > 0) {
+                ++stats_.reset_streams;
+            }
+            return http::ParseStatus::kNeedMore;
+        }
+
+        http::ParseStatus ServerSession::ConnectionError(ErrorCode code)
+        {
+            if (!goaway_sent_) {
+                AppendGoAway(output_, last_stream_id_, code);
+                goaway_sent_ = true;
+            }
+            return http::ParseStatus::kError;
+        }
+
+        void ServerSession::ResetStream(std::uint32_t stream_id, ErrorCode code)
+        {
+            AppendRstStream(output_, stream_id, code);
+            streams_.erase(stream_id);
+        }
+
+        void ServerSession::DispatchWithBody(Stream& stream)
+        {
+            std::vector<HeaderField> headers;
+            headers.swap(stream.headers);
+            fields_.clear();
+            for (const auto& field : headers) {
+                fields_.push_back(http::Header{ field.name, field.value });
+            }
+            Dispatch(stream, fields_);
+            fields_.clear();
+        }
+
+        void ServerSession::Dispatch(Stream& stream, const std::vector<http::Header>& fields)
+        {
+            std::string_view method, path, authority;
+            bool has_scheme = false;
+            bool regular_seen = false;
+            bool has_host = false;
+            bool malformed = false;
+            std::string_view content_length;
+            request_headers_.clear();
+            for (const auto& field : fields) {
+                const std::string_view name = field.name;
+                if (!name.empty() && name[0] == ':') {
+                    // 伪头部必须在普通头部之前，且每个只能出现一次
+                    std::string_view* target = nullptr;
+                    if (name == ":method") {
+                        target = &method;
+                    }
+                    else if (name == ":path") {
+                        target = &path;
+                    }
+                    else if (name == ":authority") {
+                        target = &authority;
+                    }
+                    else if (name == ":scheme" && !has_scheme) {
+                        has_scheme = true;
+                        continue;
+                    }
+                    if (!target || regular_seen || !target->empty() || field.value.empty()) {
+                        malformed = true;
+                        break;
+                    }
+                    *target = field.value;
+                    continue;
+                }
+                regular_seen = true;
+                if (HasUppercase(name) || IsConnectionHeader(name) || (name == "te" && field.value != "trailers")) {
+                    malformed = true;
+                    break;
+                }
+                if (name == "host") {
+                    has_host = true;
+                }
+                else if (name == "content-length") {
+                    content_length = field.value;
+                }
+                request_headers_.push_back(http::Header{ name, field.value });
+            }
+            // 不支持 CONNECT，其他方法必须有 :method、:scheme 和 :path
+            if (malformed || method.empty() || path.empty() || !has_scheme || method == "CONNECT") {
+                ResetStream(stream.id, ErrorCode::kProtocolError);
+                return;
+            }
+            if (!content_length.empty() && content_length != std::to_string(stream.body.size())) {
+                ResetStream(stream.id, ErrorCode::kProtocolError);
+                return;
+            }
+            if (!has_host && !authority.empty()) {
+                request_headers_.push_back(http::Header{ "host", authority });
+            }
+
+            http::Request request;
+            request.method = method;
+            request.target = path;
+            request.version_major = 2;
+            request.version_minor = 0;
+            request.headers.swap(request_headers_);
+            request.content_length = stream.body.size();
+            request.has_content_length = !content_length.empty();
+            ++stats_.streams;
+            if (request_callback_) {
+                request_callback_(stream.id, request, stream.body);
+            }
+            request.headers.swap(request_headers_);
+            // 请求只在回调期间有效，等待响应发完的流不再占用请求体的内存
+            std::string().swap(stream.body);
+        }
+
+        ServerSession::Stream* ServerSession::AppendResponseHeaders(std::uint32_t stream_id, int status, const std::vector<http::Header>& headers, bool end_stream)
+        {
+            auto it = streams_.find(stream_id);
+            if (it == streams_.end() || it->second.responded || goaway_sent_) {
+                return nullptr;
+            }
+            Stream& stream = it->second;
+            stream.responded = true;
+
+            // 先预留帧头，编码完成后按头部块长度填写；超过对端的最大帧长度时拆成 HEADERS 和 CONTINUATION
+            const std::size_t start = output_.size();
+            output_.append(kFrameHeaderSize, '\0');
+            char status_text[4] = { static_cast<char>('0' + status / 100 % 10), static_cast<char>('0' + status / 10 % 10), static_cast<char>('0' + status % 10) };
+            encoder_.Encode(output_, ":status", std::string_view(status_text, 3));
+            for (const auto& header : headers) {
+                if (!IsConnectionHeader(header.name)) {
+                    encoder_.Encode(output_, header.name, header.value);
+                }
+            }
+            const std::uint8_t end_stream_flag = end_stream ? flags::kEndStream : 0;
+            const std::size_t block_size = output_.size() - start - kFrameHeaderSize;
+            if (block_size <= peer_max_frame_size_) {
+                std::string frame_header;
+                AppendFrameHeader(frame_header, static_cast<std::uint32_t>(block_size), FrameType::kHeaders, flags::kEndHeaders | end_stream_flag, stream_id);
+                output_.replace(start, kFrameHeaderSize, frame_header);
+            }
+            else {
+                std::string block = output_.substr(start + kFrameHeaderSize);
+                output_.resize(start);
+                for (std::size_t offset = 0; offset < block.size(); offset += peer_max_frame_size_) {
+                    const std::size_t n = std::min<std::size_t>(peer_max_frame_size_, block.size() - offset);
+                    const bool last = offset + n == block.size();
+                    if (offset == 0) {
+                        AppendFrameHeader(output_, static_cast<std::uint32_t>(n), FrameType::kHeaders, end_stream_flag, stream_id);
+                    }
+                    else {
+                        AppendFrameHeader(output_, static_cast<std::uint32_t>(n), FrameType::kContinuation, last ? flags::kEndHeaders : 0, stream_id);
+                    }
+                    output_.append(block, offset, n);
+                }
+            }
+            return &stream;
+        }
+
+        void ServerSession::Respond(std::uint32_t stream_id, int status, const std::vector<http::Header>& headers,
+            std::string_view body, std::shared_ptr<const void> owner)
+        {
+            Stream* stream = AppendResponseHeaders(stream_id, status, headers, body.empty());
+            if (!stream) {
+                return;
+            }
+            if (owner) {
+                stream->owner = std::move(owner);
+                stream->pending = body;
+            }
+            else if (!body.empty()) {
+                stream->owned_body.assign(body);
+                stream->pending = stream->owned_body;
+            }
+            // 响应体为空时也排队，由 Flush 结束流，避免在请求回调中删除流
+            if (!stream->queued) {
+                Enqueue(*stream);
+            }
+        }
+
+        void ServerSession::Respond(std::uint32_t stream_id, int status, const std::vector<http::Header>& headers,
+            std::uint64_t size, BodyReader reader)
+        {
+            Stream* stream = AppendResponseHeaders(stream_id, status, headers, size == 0);
+            if (!stream) {
+                return;
+            }
+            if (size > 0) {
+                stream->reader = std::move(reader);
+                stream->reader_offset = 0;
+                stream->reader_remaining = size;
+            }
+            if (!stream->queued) {
+                Enqueue(*stream);
+            }
+        }
+
+        void ServerSession::Flush(std::size_t max_output)
+        {
+            while (!send_queue_.empty() && output_.size() < max_output) {
+                const std::uint32_t id = send_queue_.front();
+                send_queue_.pop_front();
+                auto it = streams_.find(id);
+                if (it == streams_.end()) {
+                    continue;
+                }
+                Stream& stream = it->second;
+                stream.queued = false;
+                const std::uint64_t remaining = stream.reader ? stream.reader_remaining : stream.pending.size();
+                if (remaining == 0) {
+                    FinishStream(id);
+                    continue;
+                }
+                if (send_window_ <= 0) {
+                    // 连接窗口耗尽，等待对端的 WINDOW_UPDATE，流保持原来的顺序
+                    send_queue_.push_front(id);
+                    stream.queued = true;
+                    break;
+                }
+                if (stream.send_window <= 0) {
+                    continue;   // 流的 WINDOW_UPDATE 到达时重新排队
+                }
+                const std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>({
+                    remaining, static_cast<std::uint64_t>(send_window_), static_cast<std::uint64_t>(stream.send_window), peer_max_frame_size_ }));
+                const bool last = n == remaining;
+                const std::size_t frame_start = output_.size();
+                AppendFrameHeader(output_, static_cast<std::uint32_t>(n), FrameType::kData, last ? flags::kEndStream : 0, id);
+                if (stream.reader) {
+                    // 直接读到输出缓冲区，窗口没有打开的数据不会被读取
+                    const std::size_t data_start = output_.size();
+                    output_.resize(data_start + n);
+                    if (!stream.reader(stream.reader_offset, &output_[data_start], n)) {
+                        output_.resize(frame_start);
+                        ResetStream(id, ErrorCode::kInternalError);
+                        continue;
+                    }
+                    stream.reader_offset += n;
+                    stream.reader_remaining -= n;
+                }
+                else {
+                    output_.append(stream.pending.data(), n);
+                    stream.pending.remove_prefix(n);
+                }
+                send_window_ -= n;
+                stream.send_window -= n;
+                if (last) {
+                    FinishStream(id);
+                }
+                else {
+                    Enqueue(stream);
+                }
+            }
+        }
+
+        void ServerSession::FinishStream(std::uint32_t stream_id)
+        {
+            auto it = streams_.find(stream_id);
+            if (it == streams_.end()) {
+                return;
+            }
+            if (!it->second.end_stream) {
+                AppendRstStream(output_, stream_id, ErrorCode::kNoError);
+            }
+            streams_.erase(it);
+        }
+
+        void ServerSession::Enqueue(Stream& stream)
+        {
+            stream.queued = true;
+            send_queue_.push_back(stream.id);
+        }
+
+        bool ServerSession::Closed() const
+        {
+            return goaway_sent_ || (goaway_received_ && streams_.empty());
+        }
+
+        ServerSession::Stats ServerSession::GetStats() const
+        {
+            Stats stats = stats_;
+            stats.open_streams = streams_.size();
+            return stats;
+        }
+
+        std::size_t ServerSession::MemoryUsage() const
+        {
+            std::size_t bytes = sizeof(*this) + output_.capacity() + header_block_.capacity() + arena_.Capacity()
+                + decoder_.Table().MemoryUsage() + encoder_.Table().MemoryUsage()
+                + (request_headers_.capacity() + fields_.capacity()) * sizeof(http::Header)
+                + send_queue_.size() * sizeof(std::uint32_t)
+                + streams_.bucket_count() * sizeof(void*);
+            for (const auto& item : streams_) {
+                const Stream& stream = item.second;
+                bytes += sizeof(item) + sizeof(void*) + stream.body.capacity() + stream.owned_body.capacity()
+                    + stream.headers.capacity() * sizeof(HeaderField);
+                for (const auto& field : stream.headers) {
+                    bytes += field.name.capacity() + field.value.capacity();
+                }
+            }
+            return bytes;
+        }
+    }
+}
@@ -0,0 +1,246 @@
+/// @file http2.h
+/// @brief HTTP/2（RFC 9113）明文 h2c：帧编解码和服务端连接引擎。
+///        引擎不持有连接，调用方把收到的数据交给 Receive，把 Output() 中待发送的数据写到连接上，
+///        与 HTTP/1.1 的 RequestParser 一样不关心传输方式。只支持 prior knowledge（客户端直接发送连接前言），不支持 Upgrade: h2c
+/// @author Jyang.
+/// @date 2026-10-19
+/// @version 1.0
+
+#pragma once
+
+#include <hpack.h>
+#include <http_parser.h>
+#include <request_arena.h>
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace jl {
+    namespace http2 {
+
+        constexpr std::string_view kClientPreface = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+        constexpr std::size_t kFrameHeaderSize = 9;
+        constexpr std::uint32_t kDefaultWindowSize = 65535;
+        constexpr std::uint32_t kMaxWindowSize = 0x7fffffff;
+        constexpr std::uint32_t kDefaultMaxFrameSize = 16384;
+        constexpr std::uint32_t kMaxFrameSizeLimit = (1 << 24) - 1;
+
+        enum class FrameType : std::uint8_t {
+            kData = 0x0,
+            kHeaders = 0x1,
+            kPriority = 0x2,
+            kRstStream = 0x3,
+            kSettings = 0x4,
+            kPushPromise = 0x5,
+            kPing = 0x6,
+            kGoAway = 0x7,
+            kWindowUpdate = 0x8,
+            kContinuation = 0x9,
+        };
+
+        namespace flags {
+            constexpr std::uint8_t kEndStream = 0x1;
+            constexpr std::uint8_t kAck = 0x1;
+            constexpr std::uint8_t kEndHeaders = 0x4;
+            constexpr std::uint8_t kPadded = 0x8;
+            constexpr std::uint8_t kPriority = 0x20;
+        }
+
+        enum class ErrorCode : std::uint32_t {
+            kNoError = 0x0,
+            kProtocolError = 0x1,
+            kInternalError = 0x2,
+            kFlowControlError = 0x3,
+            kSettingsTimeout = 0x4,
+            kStreamClosed = 0x5,
+            kFrameSizeError = 0x6,
+            kRefusedStream = 0x7,
+            kCancel = 0x8,
+            kCompressionError = 0x9,
+            kConnectError = 0xa,
+            kEnhanceYourCalm = 0xb,
+            kInadequateSecurity = 0xc,
+            kHttp11Required = 0xd,
+        };
+
+        enum class SettingId : std::uint16_t {
+            kHeaderTableSize = 0x1,
+            kEnablePush = 0x2,
+            kMaxConcurrentStreams = 0x3,
+            kInitialWindowSize = 0x4,
+            kMaxFrameSize = 0x5,
+            kMaxHeaderListSize = 0x6,
+        };
+
+        struct FrameHeader {
+            std::uint32_t length = 0;
+            FrameType type = FrameType::kData;
+            std::uint8_t flags = 0;
+            std::uint32_t stream_id = 0;
+        };
+
+        /// @brief 解析 9 字节帧头，data 至少 kFrameHeaderSize 字节
+        FrameHeader ParseFrameHeader(const char* data);
+
+        void AppendFrameHeader(std::string& out, std::uint32_t length, FrameType type, std::uint8_t flags, std::uint32_t stream_id);
+
+        void AppendSettings(std::string& out, const std::vector<std::pair<SettingId, std::uint32_t>>& settings);
+
+        void AppendWindowUpdate(std::string& out, std::uint32_t stream_id, std::uint32_t increment);
+
+        void AppendRstStream(std::string& out, std::uint32_t stream_id, ErrorCode code);
+
+        void AppendGoAway(std::string& out, std::uint32_t last_stream_id, ErrorCode code);
+
+        /// @brief 本端通告给对端的设置
+        struct Settings {
+            std::uint32_t max_concurrent_streams = 128;
+            std::uint32_t initial_window_size = 1024 * 1024;           // 每个流的接收窗口
+            std::uint32_t connection_window_size = 4 * 1024 * 1024;    // 连接的接收窗口，连接建立后用 WINDOW_UPDATE 从 65535 调大
+            std::uint32_t max_header_list_size = kDefaultMaxHeaderListSize;
+            std::uint64_t max_body_bytes = 8 * 1024 * 1024;            // 请求体在内存中累积，超过时回应 413
+        };
+
+        /// @brief 服务端连接引擎，非线程安全，调用方在同一把锁或同一个 strand 中调用。
+        ///        请求（头部和完整的请求体）收齐后回调 RequestCallback，调用方随时可以用 Respond 回应，
+        ///        不必在回调中完成；多个流的响应按流量控制窗口轮流发送
+        class ServerSession {
+        public:
+            /// @brief request 中的视图指向引擎内部的头部，只在回调期间有效；request.version_major 为 2
+            using RequestCallback = std::function<void(std::uint32_t stream_id, const http::Request& request, std::string_view body)>;
+
+            /// @brief 按需读取响应体：把响应体中 [offset, offset + size) 写到 out，失败时返回 false
+            using BodyReader = std::function<bool(std::uint64_t offset, char* out, std::size_t size)>;
+
+            struct Stats {
+                std::uint64_t streams = 0;          // 已分发的请求数
+                std::uint64_t refused_streams = 0;  // 超过并发流上限被拒绝的流
+                std::uint64_t reset_streams = 0;    // 对端取消的流
+                std::size_t open_streams = 0;       // 请求未收齐或响应未发完的流
+            };
+
+            explicit ServerSession(const Settings& settings = Settings());
+
+            void SetRequestCallback(const RequestCallback& callback) { request_callback_ = callback; }
+
+            /// @brief 处理收到的数据，data 从连接前言开始。完整的帧被处理并计入 consumed，不完整的帧留给下一次调用
+            /// @return kError 表示连接错误，GOAWAY 已追加到 Output()，调用方写完后关闭连接；否则为 kNeedMore
+            http::ParseStatus Receive(const char* data, std::size_t len, std::size_t& consumed);
+
+            /// @brief 回应一个流，响应头立即追加到 Output()，响应体由 Flush 按流量控制窗口发送。
+            ///        headers 是 :status 以外的响应头，名称不区分大小写，连接相关的头部被忽略。
+            ///        body 在发送完之前必须有效：owner 持有 body 所在的对象；owner 为空时复制 body。
+            ///        流已被对端取消或不存在时什么也不做
+            void Respond(std::uint32_t stream_id, int status, const std::vector<http::Header>& headers,
+                std::string_view body, std::shared_ptr<const void> owner = nullptr);
+
+            /// @brief 以长度为 size 的响应体回应一个流，响应体不必整体在内存中（例如大文件）：
+            ///        Flush 在流量控制窗口允许发送时每个 DATA 帧调用一次 reader，直接读到 Output() 中。
+            ///        reader 在流结束前一直被持有；读取失败时以 RST_STREAM(INTERNAL_ERROR) 结束流
+            void Respond(std::uint32_t stream_id, int status, const std::vector<http::Header>& headers,
+                std::uint64_t size, BodyReader reader);
+
+            /// @brief 把流量控制允许发送的响应数据追加到 Output()，直到输出达到 max_output 字节
+            void Flush(std::size_t max_output);
+
+            /// @brief 待写到连接上的数据，调用方写出后 clear()
+            std::string& Output() { return output_; }
+
+            /// @brief 连接已经结束：发出了 GOAWAY，或对端发出 GOAWAY 且所有流都已完成
+            bool Closed() const;
+
+            /// @brief 还有响应数据因为输出上限或流量控制没有发出
+            bool HasPendingData() const { return !send_queue_.empty(); }
+
+            Stats GetStats() const;
+
+            /// @brief 引擎占用的内存字节数（对象本身、HPACK 动态表、请求内存池的初始块、未完成的流、输出缓冲区），用于估计每个连接的内存
+            std::size_t MemoryUsage() const;
+
+        private:
+            struct Stream {
+                explicit Stream(std::pmr::memory_resource* resource) : owned_body(resource) {}
+
+                std::uint32_t id = 0;
+                std::vector<HeaderField> headers;   // 有请求体时保存请求头部直到请求收齐；没有请求体的请求直接从 arena_ 分发
+                std::string body;                   // 请求体
+                bool end_stream = false;            // 请求已收齐
+                bool responded = false;
+                bool too_large = false;             // 请求体超过上限，已回应 413，丢弃后续数据
+                std::int64_t send_window = 0;
+                std::int64_t recv_window = 0;
+                std::string_view pending;           // 还没发送的响应体
+                std::shared_ptr<const void> owner;
+                std::pmr::string owned_body;        // 在 pool_ 中
+                BodyReader reader;                  // 设置时响应体由 reader 按帧读取，不使用 pending
+                std::uint64_t reader_offset = 0;
+                std::uint64_t reader_remaining = 0;
+                bool queued = false;                // 在 send_queue_ 中
+            };
+
+            http::ParseStatus ProcessFrame(const FrameHeader& header, const char* payload);
+            http::ParseStatus OnData(const FrameHeader& header, const char* payload);
+            http::ParseStatus OnHeaders(const FrameHeader& header, const char* payload);
+            http::ParseStatus OnHeaderBlockEnd();
+            http::ParseStatus OnSettings(const FrameHeader& header, const char* payload);
+            http::ParseStatus OnWindowUpdate(const FrameHeader& header, const char* payload);
+            http::ParseStatus OnRstStream(const FrameHeader& header, const char* payload);
+
+            /// @brief 编码响应头并追加 HEADERS（和 CONTINUATION）帧，标记流已回应
+            /// @return 流不存在、已回应或连接已结束时返回空
+            Stream* AppendResponseHeaders(std::uint32_t stream_id, int status, const std::vector<http::Header>& headers, bool end_stream);
+
+            /// @brief 连接错误：发出 GOAWAY，之后不再处理任何帧
+            http::ParseStatus ConnectionError(ErrorCode code);
+
+            /// @brief 流错误：发出 RST_STREAM 并丢弃流
+            void ResetStream(std::uint32_t stream_id, ErrorCode code);
+
+            /// @brief 处理解码后的请求头部（在 fields_ 中）：新建流，或者作为 trailers 结束流
+            http::ParseStatus OnRequestHeaders(std::uint32_t stream_id);
+
+            /// @brief 请求收齐，校验伪头部后回调
+            void Dispatch(Stream& stream, const std::vector<http::Header>& fields);
+
+            /// @brief 有请求体的流收齐后，以保存的请求头部分发
+            void DispatchWithBody(Stream& stream);
+
+            /// @brief 响应已全部发出，请求还没收齐时以 RST_STREAM(NO_ERROR) 通知对端不必再发送
+            void FinishStream(std::uint32_t stream_id);
+
+            void Enqueue(Stream& stream);
+
+        private:
+            const Settings settings_;
+            RequestCallback request_callback_;
+            HpackDecoder decoder_;
+            HpackEncoder encoder_;
+            http::RequestArena arena_;                      // 头部块解码出的字段，每个头部块处理完后 Reset
+            std::vector<http::Header> fields_;              // 正在处理的请求头部，视图指向 arena_ 或流保存的头部
+            std::pmr::unsynchronized_pool_resource pool_;   // 流和响应体副本的内存池，流结束后内存留在池中给后续的流复用
+            std::pmr::unordered_map<std::uint32_t, Stream> streams_;
+            std::pmr::deque<std::uint32_t> send_queue_;     // 有响应数据待发送且窗口未耗尽的流，轮流发送
+            std::string output_;
+            std::string header_block_;                      // 收到 CONTINUATION 之前的头部块片段
+            std::uint32_t header_block_stream_;             // 正在接收头部块的流，0 表示没有
+            bool header_block_end_stream_;
+            bool preface_received_;
+            bool goaway_sent_;
+            bool goaway_received_;
+            std::uint32_t last_stream_id_;                  // 收到的最大的流 ID
+            std::int64_t send_window_;                      // 连接级发送窗口
+            std::int64_t recv_window_;                      // 连接级接收窗口
+            std::uint32_t peer_initial_window_;
+            std::uint32_t peer_max_frame_size_;
+            std::vector<http::Header> request_headers_;     // 复用的回调参数
+            Stats stats_;
+        };
+    }
+}
@@ -0,0 +1,296 @@
+#include "http_compress.h"
+
+#include <compute_pool.hpp>
+
+#include <climits>
+#ifdef ENABLE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef ENABLE_OPENSSL
+#include <openssl/sha.h>
+#endif
+
+namespace jl {
+    namespace http {
+
+        namespace {
+            char ToLower(char c)
+            {
+                return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+            }
+
+            bool EqualsIgnoreCase(std::string_view a, std::string_view b)
+            {
+                if (a.size() != b.size()) {
+                    return false;
+                }
+                for (std::size_t i = 0; i < a.size(); ++i) {
+                    if (ToLower(a[i]) != ToLower(b[i])) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            std::string_view TrimOWS(std::string_view s)
+            {
+                while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+                    s.remove_prefix(1);
+                }
+                while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) {
+                    s.remove_suffix(1);
+                }
+                return s;
+            }
+
+            /// @brief 解析 "q=0.5" 形式的权重，返回千分之几；没有权重时为 1000
+            int ParseQuality(std::string_view params)
+            {
+                while (!params.empty()) {
+                    std::size_t semicolon = params.find(';');
+                    std::string_view param = TrimOWS(params.substr(0, semicolon));
+                    if (param.size() >= 2 && ToLower(param[0]) == 'q' && param[1] == '=') {
+                        param.remove_prefix(2);
+                        if (param.empty() || (param[0] != '0' && param[0] != '1')) {
+                            return 0;
+                        }
+                        int quality = (param[0] - '0') * 1000;
+                        int scale = 100;
+                        for (std::size_t i = 2; i < param.size() && i < 5 && param[1] == '.'; ++i) {
+                            if (param[i] < '0' || param[i] > '9') {
+                                return 0;
+                            }
+                            quality += (param[i] - '0') * scale;
+                            scale /= 10;
+                        }
+                        return quality > 1000 ? 1000 : quality;
+                    }
+                    if (semicolon == std::string_view::npos) {
+                        break;
+                    }
+                    params.remove_prefix(semicolon + 1);
+                }
+                return 1000;
+            }
+        }
+
+        std::string_view EncodingName(ContentEncoding encoding)
+        {
+            switch (encoding) {
+            case ContentEncoding::kGzip: return "gzip";
+            case ContentEncoding::kDeflate: return "deflate";
+            default: return {};
+            }
+        }
+
+        ContentEncoding NegotiateEncoding(std::string_view accept_encoding)
+        {
+#ifdef ENABLE_ZLIB
+            int gzip = -1, deflate = -1, any = -1;
+            while (!accept_encoding.empty()) {
+                std::size_t comma = accept_encoding.find(',');
+                std::string_view item = accept_encoding.substr(0, comma);
+                std::size_t semicolon = item.find(';');
+                std::string_view coding = TrimOWS(item.substr(0, semicolon));
+                int quality = semicolon == std::string_view::npos ? 1000 : ParseQuality(item.substr(semicolon + 1));
+                if (EqualsIgnoreCase(coding, "gzip") || EqualsIgnoreCase(coding, "x-gzip")) {
+                    gzip = quality;
+                }
+                else if (EqualsIgnoreCase(coding, "deflate")) {
+                    deflate = quality;
+                }
+                else if (coding == "*") {
+                    any = quality;
+                }
+                if (comma == std::string_view::npos) {
+                    break;
+                }
+                accept_encoding.remove_prefix(comma + 1);
+            }
+            // 没有单独列出的编码按 * 的权重
+            if (gzip < 0) {
+                gzip = any;
+            }
+            if (deflate < 0) {
+                deflate = any;
+            }
+            if (gzip > 0 && gzip >= deflate) {
+                return ContentEncoding::kGzip;
+            }
+            if (deflate > 0) {
+                return ContentEncoding::kDeflate;
+            }
+#else
+            (void)accept_encoding;
+#endif
+            return ContentEncoding::kIdentity;
+        }
+
+        bool IsCompressible(std::string_view content_type)
+        {
+            std::string_view type = TrimOWS(content_type.substr(0, content_type.find(';')));
+            if (type.size() > 5 && EqualsIgnoreCase(type.substr(0, 5), "text/")) {
+                return true;
+            }
+            static const std::string_view kTypes[] = {
+                "application/json",
+                "application/javascript",
+                "application/xml",
+                "application/wasm",
+                "image/svg+xml",
+            };
+            for (const auto& compressible : kTypes) {
+                if (EqualsIgnoreCase(type, compressible)) {
+                    return true;
+                }
+            }
+            // application/xxx+json、application/xxx+xml
+            return type.size() > 5 && (EqualsIgnoreCase(type.substr(type.size() - 5), "+json") || EqualsIgnoreCase(type.substr(type.size() - 4), "+xml"));
+        }
+
+        bool Compress(ContentEncoding encoding, std::string_view data, std::string& out, int level)
+        {
+#ifdef ENABLE_ZLIB
+            if (encoding == ContentEncoding::kIdentity || data.size() > UINT_MAX) {
+                return false;
+            }
+            z_stream stream{};
+            // windowBits 加 16 输出 gzip 格式，否则为 zlib 格式
+            int window_bits = encoding == ContentEncoding::kGzip ? 15 + 16 : 15;
+            if (deflateInit2(&stream, level, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+                return false;
+            }
+            std::size_t old_size = out.size();
+            out.resize(old_size + deflateBound(&stream, static_cast<uLong>(data.size())));
+            stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+            stream.avail_in = static_cast<uInt>(data.size());
+            stream.next_out = reinterpret_cast<Bytef*>(&out[old_size]);
+            stream.avail_out = static_cast<uInt>(out.size() - old_size);
+            int ret = deflate(&stream, Z_FINISH);
+            out.resize(old_size + stream.total_out);
+            deflateEnd(&stream);
+            if (ret != Z_STREAM_END) {
+                out.resize(old_size);
+                return false;
+            }
+            return true;
+#else
+            (void)encoding, (void)data, (void)out, (void)level;
+            return false;
+#endif
+        }
+
+        CompressionCache::CompressionCache(std::size_t max_bytes, int level) :
+            max_bytes_(max_bytes),
+            level_(level)
+        {
+        }
+
+        CompressionCache::Key CompressionCache::MakeKey(ContentEncoding encoding, std::string_view data)
+        {
+            Key key;
+#ifdef ENABLE_OPENSSL
+            key.digest.resize(SHA256_DIGEST_LENGTH);
+            SHA256(reinterpret_cast<const unsigned char*>(data.data()), data.size(), reinterpret_cast<unsigned char*>(&key.digest[0]));
+#else
+            // 没有摘要算法时按内容本身比较，键的大小计入缓存容量
+            key.digest.assign(data.data(), data.size());
+#endif
+            key.size = data.size();
+            key.encoding = encoding;
+            return key;
+        }
+
+        CompressionCache::Result CompressionCache::Find(const Key& key)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = entries_.find(key);
+            if (it == entries_.end()) {
+                return nullptr;
+            }
+            ++stats_.hits;
+            lru_.splice(lru_.begin(), lru_, it->second.lru);
+            return it->second.data;
+        }
+
+        void CompressionCache::CompressAsync(const Key& key, std::shared_ptr<const std::string> data, Callback callback)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                auto it = entries_.find(key);
+                if (it != entries_.end()) {
+                    ++stats_.hits;
+                    lru_.splice(lru_.begin(), lru_, it->second.lru);
+                    Result result = it->second.data;
+                    lock.unlock();
+                    callback(result);
+                    return;
+                }
+                auto pending = pending_.find(key);
+                if (pending != pending_.end()) {
+                    ++stats_.coalesced;
+                    pending->second.push_back(std::move(callback));
+                    return;
+                }
+                ++stats_.misses;
+                pending_[key].push_back(std::move(callback));
+            }
+            ComputeThreadPool::GetInstance().Post([self = shared_from_this(), key, data = std::move(data)]()
+                {
+                    std::string out;
+                    Result result;
+                    if (Compress(key.encoding, *data, out, self->level_)) {
+                        result = std::make_shared<const std::string>(std::move(out));
+                    }
+                    std::vector<Callback> callbacks;
+                    {
+                        std::lock_guard<std::mutex> lock(self->mutex_);
+                        if (result) {
+                            self->stats_.input_bytes += data->size();
+                            self->stats_.output_bytes += result->size();
+                            callbacks = self->Insert(key, result);
+                        }
+                        else {
+                            auto pending = self->pending_.find(key);
+                            callbacks = std::move(pending->second);
+                            self->pending_.erase(pending);
+                        }
+                    }
+                    for (const auto& callback : callbacks) {
+                        callback(result);
+                    }
+                });
+        }
+
+        std::vector<CompressionCache::Callback> CompressionCache::Insert(const Key& key, const Result& data)
+        {
+            auto pending = pending_.find(key);
+            std::vector<Callback> callbacks = std::move(pending->second);
+            pending_.erase(pending);
+            // 键在 lru_ 和 entries_ 中各存一份
+            const std::size_t size = data->size() + 2 * key.digest.size();
+            if (size > max_bytes_) {
+                return callbacks;
+            }
+            lru_.push_front(key);
+            entries_.emplace(key, Entry{ data, lru_.begin() });
+            stats_.bytes += size;
+            while (stats_.bytes > max_bytes_) {
+                auto it = entries_.find(lru_.back());
+                stats_.bytes -= it->second.data->size() + 2 * it->first.digest.size();
+                entries_.erase(it);
+                lru_.pop_back();
+                ++stats_.evictions;
+            }
+            return callbacks;
+        }
+
+        CompressionCache::Stats CompressionCache::GetStats() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            Stats stats = stats_;
+            stats.entries = entries_.size();
+            return stats;
+        }
+    }
+}
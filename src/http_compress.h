@@ -0,0 +1,116 @@
+/// @file http_compress.h
+/// @brief 响应体压缩：按 Accept-Encoding 协商 gzip/deflate，压缩在 ComputeThreadPool 中执行，
+///        结果按内容摘要缓存，相同的响应体只压缩一次
+/// @author Jyang.
+/// @date 2026-10-19
+/// @version 1.0
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace jl {
+    namespace http {
+
+        enum class ContentEncoding {
+            kIdentity,
+            kGzip,
+            kDeflate,   // zlib 格式（RFC 1950），即 HTTP 的 deflate
+        };
+
+        constexpr std::size_t kMinCompressBytes = 256;                      // 小于该大小的响应体不压缩
+        constexpr int kDefaultCompressLevel = 6;
+        constexpr std::size_t kDefaultCompressCacheBytes = 32 * 1024 * 1024; // 缓存的压缩结果总字节数上限
+
+        /// @brief Content-Encoding 头部的取值，kIdentity 返回空
+        std::string_view EncodingName(ContentEncoding encoding);
+
+        /// @brief 按 Accept-Encoding 选择编码：优先 gzip，其次 deflate，q=0 表示不接受；
+        ///        没有该头部或编译时未启用 zlib（ENABLE_ZLIB）时返回 kIdentity
+        ContentEncoding NegotiateEncoding(std::string_view accept_encoding);
+
+        /// @brief 文本类内容（text/*、json、javascript、xml、svg、wasm）值得压缩，图片、视频等已压缩的格式不压缩
+        bool IsCompressible(std::string_view content_type);
+
+        /// @brief 压缩 data 并追加到 out，失败或未启用 zlib 时返回 false
+        bool Compress(ContentEncoding encoding, std::string_view data, std::string& out, int level = kDefaultCompressLevel);
+
+        /// @brief 压缩结果缓存，键为编码、响应体长度和响应体的 SHA-256 摘要（未启用 ENABLE_OPENSSL 时为响应体本身），线程安全。
+        ///        调用方在io线程中用 Find 查找，未命中时 CompressAsync 在计算线程池中压缩，
+        ///        同一内容的并发请求合并为一次压缩。需要通过 std::make_shared 创建，压缩任务持有缓存直到完成
+        class CompressionCache : public std::enable_shared_from_this<CompressionCache> {
+        public:
+            using Result = std::shared_ptr<const std::string>;
+            /// @brief 压缩完成回调，在计算线程中执行（Find 未命中后结果刚好由其他请求写入缓存时在调用线程中执行），失败时参数为 nullptr
+            using Callback = std::function<void(const Result&)>;
+
+            /// @brief 不同的响应体共用一个键会把别的内容发给客户端，所以不用非加密哈希
+            struct Key {
+                std::string digest;
+                std::uint64_t size = 0;
+                ContentEncoding encoding = ContentEncoding::kIdentity;
+
+                bool operator==(const Key& other) const
+                {
+                    return size == other.size && encoding == other.encoding && digest == other.digest;
+                }
+            };
+
+            struct Stats {
+                std::uint64_t hits = 0;
+                std::uint64_t misses = 0;           // 实际执行的压缩次数
+                std::uint64_t coalesced = 0;        // 等待同一内容正在进行的压缩
+                std::uint64_t evictions = 0;
+                std::uint64_t input_bytes = 0;      // 压缩过的原始字节数
+                std::uint64_t output_bytes = 0;     // 压缩后的字节数
+                std::size_t bytes = 0;              // 当前缓存的字节数，包括压缩结果和键
+                std::size_t entries = 0;
+            };
+
+            explicit CompressionCache(std::size_t max_bytes = kDefaultCompressCacheBytes, int level = kDefaultCompressLevel);
+
+            static Key MakeKey(ContentEncoding encoding, std::string_view data);
+
+            /// @brief 查找压缩结果，未命中返回 nullptr
+            Result Find(const Key& key);
+
+            /// @brief 在计算线程池中压缩 data，完成后写入缓存并调用 callback
+            void CompressAsync(const Key& key, std::shared_ptr<const std::string> data, Callback callback);
+
+            Stats GetStats() const;
+
+        private:
+            struct KeyHash {
+                std::size_t operator()(const Key& key) const
+                {
+                    return std::hash<std::string>()(key.digest) ^ static_cast<std::size_t>(key.encoding);
+                }
+            };
+
+            struct Entry {
+                Result data;
+                std::list<Key>::iterator lru;
+            };
+
+            /// @brief 写入压缩结果并按上限淘汰最久未使用的项，取出等待该结果的回调。调用方需持有 mutex_
+            std::vector<Callback> Insert(const Key& key, const Result& data);
+
+        private:
+            const std::size_t max_bytes_;
+            const int level_;
+            mutable std::mutex mutex_;
+            std::list<Key> lru_;    // 最近使用的在前
+            std::unordered_map<Key, Entry, KeyHash> entries_;
+            std::unordered_map<Key, std::vector<Callback>, KeyHash> pending_;  // 正在压缩的内容和等待结果的回调
+            Stats stats_;
+        };
+    }
+}
@@ -0,0 +1,447 @@
+#include "http_parser.h"
+
+#include <simd_scan.h>
+
+#include <algorithm>
+
+namespace jl {
+    namespace http {
+
+        namespace {
+            bool IsToken(std::string_view s)
+            {
+                return !s.empty() && simd::FindNonToken(s.data(), s.data() + s.size()) == s.data() + s.size();
+            }
+
+            bool IsFieldValue(std::string_view s)
+            {
+                return simd::FindNonFieldValue(s.data(), s.data() + s.size()) == s.data() + s.size();
+            }
+
+            bool EqualsNoCase(std::string_view a, std::string_view b)
+            {
+                return a.size() == b.size() && simd::EqualsNoCase(a.data(), b.data(), a.size());
+            }
+
+            std::string_view TrimOWS(std::string_view s)
+            {
+                while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+                    s.remove_prefix(1);
+                }
+                while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) {
+                    s.remove_suffix(1);
+                }
+                return s;
+            }
+
+            /// @brief 逐个处理逗号分隔的列表元素，例如 Connection: keep-alive, Upgrade
+            template <typename Func>
+            void ForEachListItem(std::string_view value, Func func)
+            {
+                while (!value.empty()) {
+                    std::size_t comma = value.find(',');
+                    func(TrimOWS(value.substr(0, comma)));
+                    if (comma == std::string_view::npos) {
+                        break;
+                    }
+                    value.remove_prefix(comma + 1);
+                }
+            }
+        }
+
+        std::string_view Request::GetHeader(std::string_view name) const
+        {
+            for (const Header& header : headers) {
+                if (EqualsNoCase(header.name, name)) {
+                    return header.value;
+                }
+            }
+            return {};
+        }
+
+        int StatusCode(ParseError error)
+        {
+            switch (error) {
+            case ParseError::kNone: return 200;
+            case ParseError::kHeaderTooLarge: return 431;
+            case ParseError::kVersionNotSupported: return 505;
+            case ParseError::kPayloadTooLarge: return 413;
+            default: return 400;
+            }
+        }
+
+        RequestParser::RequestParser(std::size_t max_header_bytes, std::size_t max_headers) :
+            max_header_bytes_(max_header_bytes),
+            max_headers_(max_headers),
+            scanned_(0),
+            head_start_(0),
+            line_start_(0),
+            lines_(0),
+            header_bytes_(0),
+            base_(nullptr),
+            error_(ParseError::kNone)
+        {
+        }
+
+        void RequestParser::Reset()
+        {
+            scanned_ = 0;
+            head_start_ = 0;
+            line_start_ = 0;
+            lines_ = 0;
+            header_bytes_ = 0;
+            base_ = nullptr;
+            error_ = ParseError::kNone;
+            request_.method = {};
+            request_.target = {};
+            request_.version_major = 1;
+            request_.version_minor = 1;
+            request_.headers.clear();
+            request_.content_length = 0;
+            request_.has_content_length = false;
+            request_.chunked = false;
+            request_.keep_alive = true;
+        }
+
+        ParseStatus RequestParser::Fail(ParseError error)
+        {
+            error_ = error;
+            return ParseStatus::kError;
+        }
+
+        ParseStatus RequestParser::Parse(const char* data, std::size_t len)
+        {
+            if (error_ != ParseError::kNone) {
+                return ParseStatus::kError;
+            }
+            if (header_bytes_ > 0) {
+                if (data != base_) {
+                    Rebase(data);
+                }
+                return ParseStatus::kComplete;
+            }
+            // 只在限制范围内查找，超长的头部不会被完整扫描
+            const std::size_t limit = len < max_header_bytes_ ? len : max_header_bytes_;
+            std::size_t pos = scanned_;
+            while (pos < limit) {
+                const char* lf = simd::FindByte(data + pos, data + limit, '\n');
+                if (lf == data + limit) {
+                    pos = limit;
+                    break;
+                }
+                std::size_t eol = lf - data;
+                std::size_t line_len = eol - line_start_;
+                if (line_len > 0 && data[eol - 1] == '\r') {
+                    --line_len;
+                }
+                pos = eol + 1;
+                if (line_len == 0) {
+                    if (lines_ == 0) {
+                        // RFC 9112 2.2：请求行之前的空行应忽略
+                        head_start_ = line_start_ = pos;
+                        continue;
+                    }
+                    header_bytes_ = pos;
+                    base_ = data;
+                    return ParseHead(data, line_start_);
+                }
+                if (++lines_ > max_headers_ + 1) {
+                    return Fail(ParseError::kHeaderTooLarge);
+                }
+                line_start_ = pos;
+            }
+            scanned_ = pos;
+            if (len >= max_header_bytes_) {
+                return Fail(ParseError::kHeaderTooLarge);
+            }
+            return ParseStatus::kNeedMore;
+        }
+
+        void RequestParser::Rebase(const char* data)
+        {
+            auto move = [&](std::string_view& view) {
+                if (view.data()) {
+                    view = std::string_view(data + (view.data() - base_), view.size());
+                }
+            };
+            move(request_.method);
+            move(request_.target);
+            for (Header& header : request_.headers) {
+                move(header.name);
+                move(header.value);
+            }
+            base_ = data;
+        }
+
+        ParseStatus RequestParser::ParseHead(const char* data, std::size_t end)
+        {
+            bool request_line = true;
+            bool has_transfer_encoding = false;
+            std::size_t pos = head_start_;
+            while (pos < end) {
+                std::size_t eol = simd::FindByte(data + pos, data + end, '\n') - data;
+                std::string_view line(data + pos, eol - pos);
+                if (!line.empty() && line.back() == '\r') {
+                    line.remove_suffix(1);
+                }
+                pos = eol + 1;
+                if (request_line) {
+                    if (!ParseRequestLine(line)) {
+                        return ParseStatus::kError;
+                    }
+                    request_line = false;
+                    continue;
+                }
+                if (!ParseHeaderLine(line)) {
+                    return Fail(ParseError::kBadRequest);
+                }
+                has_transfer_encoding = has_transfer_encoding || EqualsNoCase(request_.headers.back().name, "transfer-encoding");
+            }
+            // RFC 9112 6.1/6.3：Transfer-Encoding 与 Content-Length 同时出现或最后的编码不是 chunked 时无法确定请求体长度
+            if (has_transfer_encoding && (!request_.chunked || request_.has_content_length)) {
+                return Fail(ParseError::kBadRequest);
+            }
+            return ParseStatus::kComplete;
+        }
+
+        bool RequestParser::ParseRequestLine(std::string_view line)
+        {
+            std::size_t sp1 = line.find(' ');
+            if (sp1 == std::string_view::npos) {
+                Fail(ParseError::kBadRequest);
+                return false;
+            }
+            std::size_t sp2 = line.find(' ', sp1 + 1);
+            if (sp2 == std::string_view::npos) {
+                Fail(ParseError::kBadRequest);
+                return false;
+            }
+            request_.method = line.substr(0, sp1);
+            request_.target = line.substr(sp1 + 1, sp2 - sp1 - 1);
+            std::string_view version = line.substr(sp2 + 1);
+            if (!IsToken(request_.method) || request_.target.empty() || !IsFieldValue(request_.target) ||
+                request_.target.find_first_of(" \t") != std::string_view::npos) {
+                Fail(ParseError::kBadRequest);
+                return false;
+            }
+            if (version.size() != 8 || version.substr(0, 5) != "HTTP/" || version[6] != '.' ||
+                version[5] < '0' || version[5] > '9' || version[7] < '0' || version[7] > '9') {
+                Fail(ParseError::kBadRequest);
+                return false;
+            }
+            request_.version_major = version[5] - '0';
+            request_.version_minor = version[7] - '0';
+            if (request_.version_major != 1) {
+                Fail(ParseError::kVersionNotSupported);
+                return false;
+            }
+            request_.keep_alive = request_.version_minor >= 1;
+            return true;
+        }
+
+        bool RequestParser::ParseHeaderLine(std::string_view line)
+        {
+            // 以空白开头的是已废弃的折行(obs-fold)，RFC 9112 5.2 允许直接拒绝
+            std::size_t colon = simd::FindByte(line.data(), line.data() + line.size(), ':') - line.data();
+            if (colon == line.size()) {
+                return false;
+            }
+            Header header{ line.substr(0, colon), TrimOWS(line.substr(colon + 1)) };
+            if (!IsToken(header.name) || !IsFieldValue(header.value)) {
+                return false;
+            }
+            request_.headers.push_back(header);
+
+            if (EqualsNoCase(header.name, "content-length")) {
+                if (header.value.empty() || header.value.size() > 19) {
+                    return false;
+                }
+                std::uint64_t length = 0;
+                for (char c : header.value) {
+                    if (c < '0' || c > '9') {
+                        return false;
+                    }
+                    length = length * 10 + static_cast<std::uint64_t>(c - '0');
+                }
+                // 多个 Content-Length 必须一致
+                if (request_.has_content_length && request_.content_length != length) {
+                    return false;
+                }
+                request_.content_length = length;
+                request_.has_content_length = true;
+            }
+            else if (EqualsNoCase(header.name, "transfer-encoding")) {
+                bool chunked = false;
+                ForEachListItem(header.value, [&](std::string_view coding) { chunked = EqualsNoCase(coding, "chunked"); });
+                request_.chunked = chunked;
+            }
+            else if (EqualsNoCase(header.name, "connection")) {
+                ForEachListItem(header.value, [&](std::string_view option) {
+                    if (EqualsNoCase(option, "close")) {
+                        request_.keep_alive = false;
+                    }
+                    else if (EqualsNoCase(option, "keep-alive")) {
+                        request_.keep_alive = true;
+                    }
+                    });
+            }
+            return true;
+        }
+
+        void AppendChunkHeader(std::string& out, std::size_t n)
+        {
+            char size[2 * sizeof(std::size_t)];
+            char* p = size + sizeof(size);
+            do {
+                *--p = "0123456789abcdef"[n & 0xf];
+                n >>= 4;
+            } while (n);
+            out.append(p, size + sizeof(size) - p);
+            out.append("\r\n");
+        }
+
+        void AppendChunk(std::string& out, std::string_view data)
+        {
+            if (data.empty()) {
+                return;
+            }
+            AppendChunkHeader(out, data.size());
+            out.append(data);
+            out.append("\r\n");
+        }
+
+        ChunkedDecoder::ChunkedDecoder(std::uint64_t max_body_bytes, std::size_t max_trailer_bytes) :
+            max_body_bytes_(max_body_bytes),
+            max_trailer_bytes_(max_trailer_bytes)
+        {
+            Reset();
+        }
+
+        void ChunkedDecoder::Reset()
+        {
+            state_ = State::kSize;
+            chunk_size_ = 0;
+            size_digits_ = 0;
+            extension_bytes_ = 0;
+            trailer_bytes_ = 0;
+            line_bytes_ = 0;
+            body_bytes_ = 0;
+            error_ = ParseError::kNone;
+        }
+
+        ParseStatus ChunkedDecoder::Fail(ParseError error)
+        {
+            error_ = error;
+            return ParseStatus::kError;
+        }
+
+        ParseStatus ChunkedDecoder::Decode(const char* data, std::size_t len, std::size_t& consumed, const BodyCallback& on_data)
+        {
+            consumed = 0;
+            if (error_ != ParseError::kNone) {
+                return ParseStatus::kError;
+            }
+            const char* p = data;
+            const char* end = data + len;
+            while (p < end && state_ != State::kDone) {
+                if (state_ == State::kData) {
+                    // 数据部分直接以视图交给回调
+                    std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(chunk_size_, end - p));
+                    on_data(std::string_view(p, n));
+                    p += n;
+                    chunk_size_ -= n;
+                    if (chunk_size_ == 0) {
+                        state_ = State::kDataCR;
+                    }
+                    continue;
+                }
+                char c = *p++;
+                switch (state_) {
+                case State::kSize:
+                {
+                    int digit = (c >= '0' && c <= '9') ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+                    if (digit >= 0) {
+                        if (++size_digits_ > 15) { // 防止溢出，同时拒绝 PB 级的块
+                            consumed = p - data;
+                            return Fail(ParseError::kPayloadTooLarge);
+                        }
+                        chunk_size_ = chunk_size_ * 16 + digit;
+                        break;
+                    }
+                    if (size_digits_ == 0) {
+                        consumed = p - data;
+                        return Fail(ParseError::kBadRequest);
+                    }
+                    if (c == ';' || c == ' ' || c == '\t') {
+                        state_ = State::kExtension;
+                    }
+                    else if (c == '\r') {
+                        state_ = State::kSizeLF;
+                    }
+                    else {
+                        consumed = p - data;
+                        return Fail(ParseError::kBadRequest);
+                    }
+                    break;
+                }
+                case State::kExtension:
+                    if (c == '\r') {
+                        state_ = State::kSizeLF;
+                    }
+                    else if (++extension_bytes_ > kMaxChunkExtensionBytes) {
+                        consumed = p - data;
+                        return Fail(ParseError::kBadRequest);
+                    }
+                    break;
+                case State::kSizeLF:
+                    if (c != '\n') {
+                        consumed = p - data;
+                        return Fail(ParseError::kBadRequest);
+                    }
+                    if (chunk_size_ > max_body_bytes_ - body_bytes_) {
+                        consumed = p - data;
+                        return Fail(ParseError::kPayloadTooLarge);
+                    }
+                    body_bytes_ += chunk_size_;
+                    size_digits_ = 0;
+                    extension_bytes_ = 0;
+                    state_ = chunk_size_ > 0 ? State::kData : State::kTrailer;
+                    break;
+                case State::kDataCR:
+                    if (c != '\r') {
+                        consumed = p - data;
+                        return Fail(ParseError::kBadRequest);
+                    }
+                    state_ = State::kDataLF;
+                    break;
+                case State::kDataLF:
+                    if (c != '\n') {
+                        consumed = p - data;
+                        return Fail(ParseError::kBadRequest);
+                    }
+                    state_ = State::kSize;
+                    break;
+                case State::kTrailer:
+                    if (c == '\n') {
+                        if (line_bytes_ == 0) {
+                            state_ = State::kDone;
+                        }
+                        line_bytes_ = 0;
+                    }
+                    else if (c != '\r') {
+                        ++line_bytes_;
+                        if (++trailer_bytes_ > max_trailer_bytes_) {
+                            consumed = p - data;
+                            return Fail(ParseError::kHeaderTooLarge);
+                        }
+                    }
+                    break;
+                default:
+                    break;
+                }
+            }
+            consumed = p - data;
+            return state_ == State::kDone ? ParseStatus::kComplete : ParseStatus::kNeedMore;
+        }
+    }
+}
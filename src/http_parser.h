@@ -0,0 +1,170 @@
+/// @file http_parser.h
+/// @brief 增量式HTTP/1.x请求解析器：不拷贝数据，method/target/header均为指向调用方缓冲区的视图
+/// @author Jyang.
+/// @date 2026-10-19
+/// @version 1.0
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace jl {
+    namespace http {
+
+        constexpr std::size_t kDefaultMaxHeaderBytes = 8 * 1024;   // 请求行+全部头部的最大字节数
+        constexpr std::size_t kDefaultMaxHeaders = 64;              // 最大头部个数
+        constexpr std::uint64_t kDefaultMaxBodyBytes = 64 * 1024 * 1024; // chunked 请求体解码后的最大字节数
+        constexpr std::size_t kMaxChunkExtensionBytes = 1024;        // chunk 扩展(;name=value)的最大字节数
+        constexpr std::string_view kLastChunk = "0\r\n\r\n";        // chunked 编码的结束块
+
+        struct Header {
+            std::string_view name;
+            std::string_view value;   // 已去掉首尾空白
+        };
+
+        /// @brief 解析结果，所有 string_view 指向传给 RequestParser::Parse 的缓冲区，缓冲区移动或释放后失效
+        struct Request {
+            std::string_view method;
+            std::string_view target;
+            int version_major = 1;
+            int version_minor = 1;
+            std::vector<Header> headers;
+
+            std::uint64_t content_length = 0;   // 没有 Content-Length 时为0
+            bool has_content_length = false;
+            bool chunked = false;               // Transfer-Encoding 以 chunked 结尾
+            bool keep_alive = true;             // HTTP/1.1 默认长连接，除非 Connection: close；HTTP/1.0 需显式 keep-alive
+
+            /// @brief 按名称查找头部（不区分大小写），不存在时返回空视图
+            std::string_view GetHeader(std::string_view name) const;
+        };
+
+        enum class ParseStatus {
+            kNeedMore,  // 头部不完整，追加数据后再次调用 Parse
+            kComplete,  // 请求头解析完成，HeaderBytes() 之后是请求体
+            kError,     // 请求非法，见 Error()
+        };
+
+        enum class ParseError {
+            kNone,
+            kBadRequest,            // 400
+            kHeaderTooLarge,        // 431，超过 max_header_bytes 或 max_headers
+            kVersionNotSupported,   // 505
+            kPayloadTooLarge,       // 413，请求体超过上限
+        };
+
+        /// @brief 返回错误对应的HTTP状态码
+        int StatusCode(ParseError error);
+
+        /// @brief 增量式请求头解析器。
+        ///        调用方把收到的数据追加到同一块连续缓冲区，每次以缓冲区起始地址和当前总长度调用 Parse；
+        ///        解析器只记录已扫描的位置，新数据到达时从上次位置继续查找头部结束标记，不重复扫描，也不拷贝数据。
+        ///        头部完成后若继续向缓冲区追加请求体导致缓冲区移动，再次调用 Parse 会把视图更新到新地址。
+        ///        请求完成后调用方从缓冲区消费 HeaderBytes() + 请求体，再调用 Reset() 解析下一个请求。
+        class RequestParser {
+        public:
+            explicit RequestParser(std::size_t max_header_bytes = kDefaultMaxHeaderBytes, std::size_t max_headers = kDefaultMaxHeaders);
+
+            /// @brief 解析请求头
+            /// @param data 缓冲区起始地址，每次调用可以不同（缓冲区扩容），但内容必须是上次的延续
+            /// @return 头部完成后再次调用直接返回 kComplete
+            /// @param len 缓冲区中的数据总长度
+            ParseStatus Parse(const char* data, std::size_t len);
+
+            /// @brief 解析完成后请求行+头部（含结尾空行）的字节数
+            std::size_t HeaderBytes() const { return header_bytes_; }
+
+            const Request& GetRequest() const { return request_; }
+
+            ParseError Error() const { return error_; }
+
+            /// @brief 准备解析下一个请求，保留 headers 的容量
+            void Reset();
+
+        private:
+            ParseStatus Fail(ParseError error);
+
+            /// @brief 缓冲区移动后把所有视图平移到新地址
+            void Rebase(const char* data);
+
+            /// @brief 头部已完整，逐行解析 [head_start_, end)，end 为结尾空行的起始位置
+            ParseStatus ParseHead(const char* data, std::size_t end);
+
+            bool ParseRequestLine(std::string_view line);
+
+            bool ParseHeaderLine(std::string_view line);
+
+        private:
+            const std::size_t max_header_bytes_;
+            const std::size_t max_headers_;
+            std::size_t scanned_;       // 已经查找过头部结束标记的字节数
+            std::size_t head_start_;    // 请求行起始位置（跳过请求行之前的空行）
+            std::size_t line_start_;    // 当前行的起始位置
+            std::size_t lines_;         // 已扫描到的完整行数
+            std::size_t header_bytes_;
+            const char* base_;          // 视图所指向的缓冲区起始地址
+            ParseError error_;
+            Request request_;
+        };
+    
+        /// @brief 在 out 末尾追加 chunk 头（十六进制大小和CRLF），调用方随后追加 size 字节数据和CRLF
+        void AppendChunkHeader(std::string& out, std::size_t size);
+
+        /// @brief 在 out 末尾追加一个 chunked 编码的数据块，data 为空时不追加（空块表示结束）
+        void AppendChunk(std::string& out, std::string_view data);
+
+        /// @brief 增量式 chunked 请求体解码器。
+        ///        调用方每次传入缓冲区中未消费的数据，解码出的请求体片段以指向该数据的视图交给回调，不拷贝、不累积；
+        ///        返回后调用方从缓冲区移除 consumed 字节，剩余数据（结束块之后的下一个请求）留在缓冲区。
+        class ChunkedDecoder {
+        public:
+            using BodyCallback = std::function<void(std::string_view)>;
+
+            explicit ChunkedDecoder(std::uint64_t max_body_bytes = kDefaultMaxBodyBytes, std::size_t max_trailer_bytes = kDefaultMaxHeaderBytes);
+
+            /// @brief 解码
+            /// @param consumed 输出本次消费的字节数，返回 kNeedMore 时等于 len
+            /// @param on_data 请求体片段回调，视图只在回调期间有效
+            /// @return kComplete 表示已读完结束块和 trailer
+            ParseStatus Decode(const char* data, std::size_t len, std::size_t& consumed, const BodyCallback& on_data);
+
+            ParseError Error() const { return error_; }
+
+            /// @brief 已解码的请求体字节数
+            std::uint64_t BodyBytes() const { return body_bytes_; }
+
+            void Reset();
+
+        private:
+            enum class State {
+                kSize,          // chunk 大小（十六进制）
+                kExtension,     // 大小之后的 ;name=value，忽略
+                kSizeLF,
+                kData,
+                kDataCR,        // 数据之后的 CRLF
+                kDataLF,
+                kTrailer,       // 结束块之后的 trailer 行，以空行结束
+                kDone,
+            };
+
+            ParseStatus Fail(ParseError error);
+
+        private:
+            const std::uint64_t max_body_bytes_;
+            const std::size_t max_trailer_bytes_;
+            State state_;
+            std::uint64_t chunk_size_;      // 当前块剩余字节数
+            std::size_t size_digits_;
+            std::size_t extension_bytes_;
+            std::size_t trailer_bytes_;
+            std::size_t line_bytes_;        // 当前 trailer 行的字节数（不含CRLF）
+            std::uint64_t body_bytes_;
+            ParseError error_;
+        };
+    }
+}
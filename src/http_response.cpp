@@ -0,0 +1,199 @@
+#include "http_response.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+namespace jl {
+    namespace http {
+
+        std::string_view ReasonPhrase(int status)
+        {
+            switch (status) {
+            case 100: return "Continue";
+            case 101: return "Switching Protocols";
+            case 200: return "OK";
+            case 201: return "Created";
+            case 202: return "Accepted";
+            case 204: return "No Content";
+            case 206: return "Partial Content";
+            case 301: return "Moved Permanently";
+            case 302: return "Found";
+            case 304: return "Not Modified";
+            case 307: return "Temporary Redirect";
+            case 308: return "Permanent Redirect";
+            case 400: return "Bad Request";
+            case 401: return "Unauthorized";
+            case 403: return "Forbidden";
+            case 404: return "Not Found";
+            case 405: return "Method Not Allowed";
+            case 408: return "Request Timeout";
+            case 411: return "Length Required";
+            case 413: return "Payload Too Large";
+            case 414: return "URI Too Long";
+            case 415: return "Unsupported Media Type";
+            case 416: return "Range Not Satisfiable";
+            case 426: return "Upgrade Required";
+            case 429: return "Too Many Requests";
+            case 431: return "Request Header Fields Too Large";
+            case 500: return "Internal Server Error";
+            case 501: return "Not Implemented";
+            case 502: return "Bad Gateway";
+            case 503: return "Service Unavailable";
+            case 504: return "Gateway Timeout";
+            case 505: return "HTTP Version Not Supported";
+            default: return "Unknown";
+            }
+        }
+
+        namespace {
+            const char* const kDays[] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+            const char* const kMonths[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+
+            /// @brief 公历日期到1970-01-01的天数，不依赖时区和 timegm
+            std::int64_t DaysFromCivil(std::int64_t y, unsigned m, unsigned d)
+            {
+                y -= m <= 2;
+                const std::int64_t era = (y >= 0 ? y : y - 399) / 400;
+                const unsigned yoe = static_cast<unsigned>(y - era * 400);
+                const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+                const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+                return era * 146097 + static_cast<std::int64_t>(doe) - 719468;
+            }
+
+            bool ParseDigits(std::string_view text, std::size_t pos, std::size_t n, int& value)
+            {
+                value = 0;
+                for (std::size_t i = pos; i < pos + n; ++i) {
+                    if (text[i] < '0' || text[i] > '9') {
+                        return false;
+                    }
+                    value = value * 10 + (text[i] - '0');
+                }
+                return true;
+            }
+
+            /// @brief 把 value 的低 n 位十进制数字写入 out，不足补0
+            void PutDigits(char* out, int value, int n)
+            {
+                for (int i = n - 1; i >= 0; --i) {
+                    out[i] = static_cast<char>('0' + value % 10);
+                    value /= 10;
+                }
+            }
+        }
+
+        void FormatHttpDate(std::time_t time, char* out)
+        {
+            std::tm tm;
+#ifdef _WIN32
+            gmtime_s(&tm, &time);
+#else
+            gmtime_r(&time, &tm);
+#endif
+            // strftime 的 %a/%b 受 locale 影响，HTTP 要求固定的英文缩写；年份固定4位，超出范围时截到 0000~9999
+            const int year = std::min(9999, std::max(0, tm.tm_year + 1900));
+            std::memcpy(out, kDays[tm.tm_wday], 3);
+            std::memcpy(out + 3, ", ", 2);
+            PutDigits(out + 5, tm.tm_mday, 2);
+            out[7] = ' ';
+            std::memcpy(out + 8, kMonths[tm.tm_mon], 3);
+            out[11] = ' ';
+            PutDigits(out + 12, year, 4);
+            out[16] = ' ';
+            PutDigits(out + 17, tm.tm_hour, 2);
+            out[19] = ':';
+            PutDigits(out + 20, tm.tm_min, 2);
+            out[22] = ':';
+            PutDigits(out + 23, tm.tm_sec, 2);
+            std::memcpy(out + 25, " GMT", 5);
+        }
+
+        bool ParseHttpDate(std::string_view text, std::time_t& time)
+        {
+            // "Sun, 06 Nov 1994 08:49:37 GMT"
+            if (text.size() != kHttpDateLength || text.substr(3, 2) != ", " || text[7] != ' ' || text[11] != ' '
+                || text[16] != ' ' || text[19] != ':' || text[22] != ':' || text.substr(25) != " GMT") {
+                return false;
+            }
+            int month = -1;
+            for (int i = 0; i < 12; ++i) {
+                if (text.substr(8, 3) == kMonths[i]) {
+                    month = i + 1;
+                }
+            }
+            int day, year, hour, minute, second;
+            if (month < 0 || !ParseDigits(text, 5, 2, day) || !ParseDigits(text, 12, 4, year) || !ParseDigits(text, 17, 2, hour)
+                || !ParseDigits(text, 20, 2, minute) || !ParseDigits(text, 23, 2, second)
+                || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60) {
+                return false;
+            }
+            std::int64_t days = DaysFromCivil(year, static_cast<unsigned>(month), static_cast<unsigned>(day));
+            time = static_cast<std::time_t>(((days * 24 + hour) * 60 + minute) * 60 + second);
+            return true;
+        }
+
+        std::string_view HttpDate()
+        {
+            thread_local std::time_t cached_second = -1;
+            thread_local char cached[kHttpDateLength + 1];
+            std::time_t now = std::time(nullptr);
+            if (now != cached_second) {
+                FormatHttpDate(now, cached);
+                cached_second = now;
+            }
+            return std::string_view(cached, kHttpDateLength);
+        }
+
+        ResponseWriter& ResponseWriter::Status(int status)
+        {
+            char code[3] = {
+                static_cast<char>('0' + status / 100 % 10),
+                static_cast<char>('0' + status / 10 % 10),
+                static_cast<char>('0' + status % 10),
+            };
+            out_.append("HTTP/1.1 ", 9);
+            out_.append(code, 3);
+            out_.push_back(' ');
+            out_.append(ReasonPhrase(status));
+            out_.append("\r\n", 2);
+            return *this;
+        }
+
+        ResponseWriter& ResponseWriter::Header(std::string_view name, std::string_view value)
+        {
+            out_.append(name);
+            out_.append(": ", 2);
+            out_.append(value);
+            out_.append("\r\n", 2);
+            return *this;
+        }
+
+        ResponseWriter& ResponseWriter::Header(std::string_view name, std::uint64_t value)
+        {
+            char digits[20];
+            auto result = std::to_chars(digits, digits + sizeof(digits), value);
+            return Header(name, std::string_view(digits, result.ptr - digits));
+        }
+
+        ResponseWriter& ResponseWriter::Headers(std::string_view lines)
+        {
+            out_.append(lines);
+            return *this;
+        }
+
+        ResponseWriter& ResponseWriter::EndHeaders()
+        {
+            out_.append("\r\n", 2);
+            return *this;
+        }
+
+        ResponseWriter& ResponseWriter::Body(std::string_view body)
+        {
+            out_.append(body);
+            return *this;
+        }
+    }
+}
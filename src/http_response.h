@@ -0,0 +1,65 @@
+/// @file http_response.h
+/// @brief HTTP/1.1 响应序列化：状态行、头部和响应体直接追加到调用方复用的输出缓冲区，
+///        Date 头部每个线程每秒只格式化一次
+/// @author Jyang.
+/// @date 2026-10-19
+/// @version 1.0
+
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <string_view>
+
+namespace jl {
+    namespace http {
+
+        /// @brief 状态码对应的原因短语，未知状态码返回 "Unknown"
+        std::string_view ReasonPhrase(int status);
+
+        constexpr std::size_t kHttpDateLength = 29; // "Sun, 06 Nov 1994 08:49:37 GMT"
+
+        /// @brief 把时间格式化为 IMF-fixdate，out 至少 kHttpDateLength + 1 字节
+        void FormatHttpDate(std::time_t time, char* out);
+
+        /// @brief 解析 IMF-fixdate，格式不符时返回 false（不支持已废弃的 RFC 850 和 asctime 格式）
+        bool ParseHttpDate(std::string_view text, std::time_t& time);
+
+        /// @brief 当前时间的 IMF-fixdate（RFC 9110 5.6.7），例如 "Sun, 06 Nov 1994 08:49:37 GMT"。
+        ///        结果缓存在线程局部变量中，同一秒内的调用不再格式化；返回的视图在本线程下一次调用前有效
+        std::string_view HttpDate();
+
+        /// @brief 响应构建器，把响应追加到 out 末尾，不做其他内存分配。
+        ///        调用方在连接或线程上复用同一个 out，clear() 后容量保留，稳定后序列化一个响应不再分配内存。
+        ///        调用顺序：Status -> Header... -> EndHeaders -> Body
+        class ResponseWriter {
+        public:
+            explicit ResponseWriter(std::string& out) : out_(out) {}
+
+            /// @brief 状态行，例如 "HTTP/1.1 200 OK\r\n"
+            ResponseWriter& Status(int status);
+
+            ResponseWriter& Header(std::string_view name, std::string_view value);
+
+            ResponseWriter& Header(std::string_view name, std::uint64_t value);
+
+            ResponseWriter& Date() { return Header("Date", HttpDate()); }
+
+            ResponseWriter& ContentLength(std::uint64_t length) { return Header("Content-Length", length); }
+
+            ResponseWriter& Connection(bool keep_alive) { return Header("Connection", keep_alive ? "keep-alive" : "close"); }
+
+            /// @brief 预先格式化好的若干头部行，每行以CRLF结尾
+            ResponseWriter& Headers(std::string_view lines);
+
+            /// @brief 头部结束的空行
+            ResponseWriter& EndHeaders();
+
+            ResponseWriter& Body(std::string_view body);
+
+        private:
+            std::string& out_;
+        };
+    }
+}
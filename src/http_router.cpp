@@ -0,0 +1,283 @@
+#include "http_router.h"
+
+#include <logger.h>
+
+#include <map>
+#include <stdexcept>
+
+namespace jl {
+    namespace http {
+
+        namespace {
+            constexpr std::uint32_t kMaxLinearChildren = 4;   // 超过该数量的子节点使用哈希表查找
+            constexpr std::size_t kNoRoute = static_cast<std::size_t>(-1);
+
+            std::uint32_t HashSegment(std::string_view s)
+            {
+                std::uint32_t hash = 2166136261u; // FNV-1a
+                for (char c : s) {
+                    hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+                }
+                return hash;
+            }
+
+            /// @brief 把 path（不含开头的 /）按 / 切分，逐段回调
+            template <typename Func>
+            void ForEachSegment(std::string_view path, Func func)
+            {
+                while (true) {
+                    std::size_t slash = path.find('/');
+                    func(path.substr(0, slash));
+                    if (slash == std::string_view::npos) {
+                        return;
+                    }
+                    path.remove_prefix(slash + 1);
+                }
+            }
+
+            // 编译前的前缀树
+            struct BuildNode {
+                std::map<std::string, std::uint32_t> children;
+                std::int32_t param_child = -1;
+                std::vector<std::pair<std::string, std::uint32_t>> methods;
+                std::vector<std::pair<std::string, std::uint32_t>> wildcards;
+            };
+
+            void AddMethod(std::vector<std::pair<std::string, std::uint32_t>>& methods, const std::string& method, std::uint32_t route, const std::string& pattern)
+            {
+                for (const auto& item : methods) {
+                    if (item.first == method) {
+                        throw std::runtime_error(fmt::format("duplicate route: {} {}", method, pattern));
+                    }
+                }
+                methods.emplace_back(method, route);
+            }
+        }
+
+        std::string_view RouteParams::Get(std::string_view name) const
+        {
+            for (std::size_t i = 0; i < size_; ++i) {
+                if (names_[i] == name) {
+                    return values_[i];
+                }
+            }
+            return std::string_view();
+        }
+
+        std::size_t RouteTable::Add(std::string_view method, std::string_view pattern)
+        {
+            if (compiled_) {
+                throw std::runtime_error("route table already compiled");
+            }
+            if (method.empty() || pattern.empty() || pattern.front() != '/') {
+                throw std::runtime_error(fmt::format("invalid route: {} {}", method, pattern));
+            }
+            Route route{ std::string(method), std::string(pattern), {} };
+            bool wildcard = false;
+            ForEachSegment(pattern.substr(1), [&](std::string_view segment) {
+                if (wildcard) {
+                    throw std::runtime_error(fmt::format("wildcard must be the last segment: {}", pattern));
+                }
+                if (!segment.empty() && (segment.front() == ':' || segment.front() == '*')) {
+                    if (segment.size() == 1) {
+                        throw std::runtime_error(fmt::format("unnamed parameter: {}", pattern));
+                    }
+                    wildcard = segment.front() == '*';
+                    route.param_names.emplace_back(segment.substr(1));
+                }
+                });
+            if (route.param_names.size() > kMaxRouteParams) {
+                throw std::runtime_error(fmt::format("too many parameters: {}", pattern));
+            }
+            routes_.push_back(std::move(route));
+            return routes_.size() - 1;
+        }
+
+        void RouteTable::Compile()
+        {
+            if (compiled_) {
+                return;
+            }
+            std::vector<BuildNode> tree(1);
+            for (std::uint32_t id = 0; id < routes_.size(); ++id) {
+                const Route& route = routes_[id];
+                std::uint32_t node = 0;
+                bool wildcard = false;
+                ForEachSegment(std::string_view(route.pattern).substr(1), [&](std::string_view segment) {
+                    if (!segment.empty() && segment.front() == '*') {
+                        AddMethod(tree[node].wildcards, route.method, id, route.pattern);
+                        wildcard = true;
+                        return;
+                    }
+                    if (!segment.empty() && segment.front() == ':') {
+                        if (tree[node].param_child < 0) {
+                            tree[node].param_child = static_cast<std::int32_t>(tree.size());
+                            tree.emplace_back();
+                        }
+                        node = static_cast<std::uint32_t>(tree[node].param_child);
+                        return;
+                    }
+                    auto it = tree[node].children.find(std::string(segment));
+                    if (it != tree[node].children.end()) {
+                        node = it->second;
+                        return;
+                    }
+                    std::uint32_t child = static_cast<std::uint32_t>(tree.size());
+                    tree[node].children.emplace(std::string(segment), child);
+                    tree.emplace_back();
+                    node = child;
+                    });
+                if (!wildcard) {
+                    AddMethod(tree[node].methods, route.method, id, route.pattern);
+                }
+            }
+
+            // 节点编号不变，子节点、方法按节点顺序存入连续数组
+            nodes_.assign(tree.size(), Node());
+            auto add_string = [this](const std::string& s) {
+                std::uint32_t offset = static_cast<std::uint32_t>(strings_.size());
+                strings_.append(s);
+                return offset;
+            };
+            auto add_methods = [&](const std::vector<std::pair<std::string, std::uint32_t>>& methods) {
+                for (const auto& item : methods) {
+                    methods_.push_back(MethodRoute{ add_string(item.first), static_cast<std::uint32_t>(item.first.size()), item.second });
+                }
+            };
+            for (std::uint32_t i = 0; i < tree.size(); ++i) {
+                const BuildNode& build = tree[i];
+                Node& node = nodes_[i];
+                node.param_child = build.param_child;
+                node.first_child = static_cast<std::uint32_t>(children_.size());
+                node.child_count = static_cast<std::uint32_t>(build.children.size());
+                for (const auto& child : build.children) {
+                    children_.push_back(Child{ add_string(child.first), static_cast<std::uint32_t>(child.first.size()), child.second });
+                }
+                if (node.child_count > kMaxLinearChildren) {
+                    std::uint32_t slots = 1;
+                    while (slots < node.child_count * 2) {
+                        slots <<= 1;
+                    }
+                    node.first_slot = static_cast<std::uint32_t>(slots_.size());
+                    node.slot_mask = slots - 1;
+                    slots_.resize(slots_.size() + slots, 0);
+                    for (std::uint32_t c = node.first_child; c < node.first_child + node.child_count; ++c) {
+                        std::uint32_t h = HashSegment(Text(children_[c].offset, children_[c].length)) & node.slot_mask;
+                        while (slots_[node.first_slot + h] != 0) {
+                            h = (h + 1) & node.slot_mask;
+                        }
+                        slots_[node.first_slot + h] = c + 1;
+                    }
+                }
+                node.first_method = static_cast<std::uint32_t>(methods_.size());
+                node.method_count = static_cast<std::uint32_t>(build.methods.size());
+                add_methods(build.methods);
+                node.first_wildcard = static_cast<std::uint32_t>(methods_.size());
+                node.wildcard_count = static_cast<std::uint32_t>(build.wildcards.size());
+                add_methods(build.wildcards);
+            }
+            compiled_ = true;
+        }
+
+        std::int64_t RouteTable::FindChild(const Node& node, std::string_view segment) const
+        {
+            if (node.slot_mask == 0) {
+                for (std::uint32_t c = node.first_child; c < node.first_child + node.child_count; ++c) {
+                    if (Text(children_[c].offset, children_[c].length) == segment) {
+                        return children_[c].node;
+                    }
+                }
+                return -1;
+            }
+            std::uint32_t h = HashSegment(segment) & node.slot_mask;
+            while (std::uint32_t slot = slots_[node.first_slot + h]) {
+                const Child& child = children_[slot - 1];
+                if (Text(child.offset, child.length) == segment) {
+                    return child.node;
+                }
+                h = (h + 1) & node.slot_mask;
+            }
+            return -1;
+        }
+
+        std::size_t RouteTable::FindMethod(std::uint32_t first, std::uint32_t count, std::string_view method, bool& method_mismatch) const
+        {
+            std::size_t any = kNoRoute;
+            for (std::uint32_t i = first; i < first + count; ++i) {
+                std::string_view name = Text(methods_[i].offset, methods_[i].length);
+                if (name == method) {
+                    return methods_[i].route;
+                }
+                if (name == "*") {
+                    any = methods_[i].route;
+                }
+            }
+            if (any == kNoRoute && count > 0) {
+                method_mismatch = true;
+            }
+            return any;
+        }
+
+        std::size_t RouteTable::Walk(std::uint32_t index, std::string_view rest, bool has_rest, std::string_view method,
+            std::string_view* values, std::size_t depth, bool& method_mismatch) const
+        {
+            const Node& node = nodes_[index];
+            if (!has_rest) {
+                return FindMethod(node.first_method, node.method_count, method, method_mismatch);
+            }
+            std::size_t slash = rest.find('/');
+            std::string_view segment = rest.substr(0, slash);
+            std::string_view next = slash == std::string_view::npos ? std::string_view() : rest.substr(slash + 1);
+            bool has_next = slash != std::string_view::npos;
+
+            std::int64_t child = FindChild(node, segment);
+            if (child >= 0) {
+                std::size_t route = Walk(static_cast<std::uint32_t>(child), next, has_next, method, values, depth, method_mismatch);
+                if (route != kNoRoute) {
+                    return route;
+                }
+            }
+            if (node.param_child >= 0 && !segment.empty()) {
+                values[depth] = segment;
+                std::size_t route = Walk(static_cast<std::uint32_t>(node.param_child), next, has_next, method, values, depth + 1, method_mismatch);
+                if (route != kNoRoute) {
+                    return route;
+                }
+            }
+            if (node.wildcard_count > 0) {
+                std::size_t route = FindMethod(node.first_wildcard, node.wildcard_count, method, method_mismatch);
+                if (route != kNoRoute) {
+                    values[depth] = rest;
+                    return route;
+                }
+            }
+            return kNoRoute;
+        }
+
+        RouteStatus RouteTable::Match(std::string_view method, std::string_view target, std::size_t& route, RouteParams& params) const
+        {
+            params.size_ = 0;
+            // find_first_of 对每个字节调用一次 traits::find，这里直接逐字节比较
+            std::size_t query = 0;
+            while (query < target.size() && target[query] != '?' && target[query] != '#') {
+                ++query;
+            }
+            std::string_view path = target.substr(0, query);
+            if (!compiled_ || path.empty() || path.front() != '/') {
+                return RouteStatus::kNotFound;
+            }
+            bool method_mismatch = false;
+            std::size_t found = Walk(0, path.substr(1), true, method, params.values_, 0, method_mismatch);
+            if (found == kNoRoute) {
+                return method_mismatch ? RouteStatus::kMethodNotAllowed : RouteStatus::kNotFound;
+            }
+            const Route& matched = routes_[found];
+            params.size_ = matched.param_names.size();
+            for (std::size_t i = 0; i < params.size_; ++i) {
+                params.names_[i] = matched.param_names[i];
+            }
+            route = found;
+            return RouteStatus::kFound;
+        }
+    }
+}
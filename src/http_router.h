@@ -0,0 +1,148 @@
+/// @file http_router.h
+/// @brief HTTP请求路由：method + path 映射到处理函数，支持路径参数和通配符。
+///        启动时注册全部路由并编译为按路径段划分的前缀树，查找不分配内存，耗时只与路径段数有关，与路由数量无关
+/// @author Jyang.
+/// @date 2026-10-19
+/// @version 1.0
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace jl {
+    namespace http {
+
+        constexpr std::size_t kMaxRouteParams = 8;  // 单个路由的参数（含通配符）个数上限
+
+        /// @brief 匹配到的路径参数，名称指向路由表，值指向请求 target
+        class RouteParams {
+        public:
+            std::size_t Size() const { return size_; }
+
+            std::string_view Name(std::size_t i) const { return names_[i]; }
+
+            std::string_view Value(std::size_t i) const { return values_[i]; }
+
+            /// @brief 按名称查找参数值，不存在时返回空视图
+            std::string_view Get(std::string_view name) const;
+
+        private:
+            friend class RouteTable;
+
+            std::size_t size_ = 0;
+            std::string_view names_[kMaxRouteParams];
+            std::string_view values_[kMaxRouteParams];
+        };
+
+        enum class RouteStatus {
+            kFound,
+            kNotFound,          // 404
+            kMethodNotAllowed,  // 405，路径存在但没有注册该方法
+        };
+
+        /// @brief 路由表，只负责把请求映射为路由编号，处理函数由 Router 保存。
+        ///        路径模式以 / 开头、按 / 分段：
+        ///        - 普通段精确匹配（区分大小写）；
+        ///        - ":name" 匹配一个非空段；
+        ///        - "*name" 匹配剩余的全部路径（可以为空或包含 /），只能是最后一段。
+        ///        同一位置优先匹配普通段，其次参数，最后通配符，优先的分支后续匹配失败时回溯。
+        ///        方法为 "*" 的路由匹配任意方法，优先级低于精确的方法。
+        class RouteTable {
+        public:
+            /// @brief 注册路由，模式非法、参数过多、重复注册或已经 Compile 时抛出 std::runtime_error
+            /// @return 路由编号，按注册顺序从0开始
+            std::size_t Add(std::string_view method, std::string_view pattern);
+
+            /// @brief 编译查找结构，之后不能再 Add
+            void Compile();
+
+            /// @brief 查找路由，target 中 ? 之后的查询串不参与匹配
+            /// @param route 输出路由编号，只在返回 kFound 时有效
+            RouteStatus Match(std::string_view method, std::string_view target, std::size_t& route, RouteParams& params) const;
+
+            std::size_t Size() const { return routes_.size(); }
+
+        private:
+            struct Route {
+                std::string method;
+                std::string pattern;
+                std::vector<std::string> param_names;
+            };
+
+            // 编译后的节点，子节点、哈希槽和方法都是各自数组中的连续区间
+            struct Node {
+                std::uint32_t first_child = 0;
+                std::uint32_t child_count = 0;
+                std::uint32_t first_slot = 0;       // 子节点较多时使用的开放寻址哈希表
+                std::uint32_t slot_mask = 0;        // 为0表示子节点较少，直接线性比较
+                std::int32_t param_child = -1;
+                std::uint32_t first_method = 0;     // 路径在此结束的路由
+                std::uint32_t method_count = 0;
+                std::uint32_t first_wildcard = 0;   // 在此位置以通配符结束的路由
+                std::uint32_t wildcard_count = 0;
+            };
+
+            struct Child {
+                std::uint32_t offset;   // 段文本在 strings_ 中的位置
+                std::uint32_t length;
+                std::uint32_t node;
+            };
+
+            struct MethodRoute {
+                std::uint32_t offset;   // 方法名在 strings_ 中的位置
+                std::uint32_t length;
+                std::uint32_t route;
+            };
+
+            std::string_view Text(std::uint32_t offset, std::uint32_t length) const { return std::string_view(strings_.data() + offset, length); }
+
+            std::int64_t FindChild(const Node& node, std::string_view segment) const;
+
+            std::size_t FindMethod(std::uint32_t first, std::uint32_t count, std::string_view method, bool& method_mismatch) const;
+
+            /// @brief 从 node 开始匹配剩余路径 rest，has_rest 为 false 表示路径已经全部匹配
+            std::size_t Walk(std::uint32_t node, std::string_view rest, bool has_rest, std::string_view method,
+                std::string_view* values, std::size_t depth, bool& method_mismatch) const;
+
+        private:
+            std::vector<Route> routes_;
+            bool compiled_ = false;
+            std::vector<Node> nodes_;
+            std::vector<Child> children_;
+            std::vector<std::uint32_t> slots_;  // 子节点在 children_ 中的下标+1，0为空槽
+            std::vector<MethodRoute> methods_;
+            std::string strings_;               // 所有段文本和方法名
+        };
+
+        /// @brief 带处理函数的路由器，Handler 由使用方定义，例如 std::function
+        template <typename Handler>
+        class Router {
+        public:
+            void Add(std::string_view method, std::string_view pattern, Handler handler)
+            {
+                table_.Add(method, pattern);
+                handlers_.push_back(std::move(handler));
+            }
+
+            void Compile() { table_.Compile(); }
+
+            /// @brief 查找处理函数，未匹配时返回 nullptr，status 区分 404 和 405
+            const Handler* Match(std::string_view method, std::string_view target, RouteParams& params, RouteStatus& status) const
+            {
+                std::size_t route = 0;
+                status = table_.Match(method, target, route, params);
+                return status == RouteStatus::kFound ? &handlers_[route] : nullptr;
+            }
+
+            std::size_t Size() const { return table_.Size(); }
+
+        private:
+            RouteTable table_;
+            std::vector<Handler> handlers_;
+        };
+    }
+}
@@ -0,0 +1,350 @@
+#include "ktls.h"
+
+#ifdef ENABLE_OPENSSL
+
+#include <logger.h>
+
+#include <openssl/evp.h>
+#include <openssl/kdf.h>
+#include <openssl/crypto.h>
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/tls.h>)
+#include <linux/tls.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#define JL_HAS_KTLS 1
+#endif
+#endif
+
+#ifndef TCP_ULP
+#define TCP_ULP 31
+#endif
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+
+namespace jl {
+    namespace ktls {
+
+        namespace {
+            /// @brief 每个SSL对象握手期间收集的信息
+            struct Secrets {
+                std::vector<unsigned char> client_traffic; // TLS1.3 CLIENT_TRAFFIC_SECRET_0
+                std::vector<unsigned char> server_traffic; // TLS1.3 SERVER_TRAFFIC_SECRET_0
+                std::uint64_t tickets_sent = 0;            // TLS1.3 握手后用应用密钥发出的 NewSessionTicket 记录数
+
+                ~Secrets()
+                {
+                    OPENSSL_cleanse(client_traffic.data(), client_traffic.size());
+                    OPENSSL_cleanse(server_traffic.data(), server_traffic.size());
+                }
+            };
+
+            void FreeSecrets(void*, void* ptr, CRYPTO_EX_DATA*, int, long, void*)
+            {
+                delete static_cast<Secrets*>(ptr);
+            }
+
+            int SecretsIndex()
+            {
+                static int index = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, &FreeSecrets);
+                return index;
+            }
+
+            Secrets* GetSecrets(const SSL* ssl, bool create)
+            {
+                auto* secrets = static_cast<Secrets*>(SSL_get_ex_data(ssl, SecretsIndex()));
+                if (!secrets && create) {
+                    secrets = new Secrets();
+                    SSL_set_ex_data(const_cast<SSL*>(ssl), SecretsIndex(), secrets);
+                }
+                return secrets;
+            }
+
+            std::vector<unsigned char> HexDecode(const std::string& hex)
+            {
+                std::vector<unsigned char> out(hex.size() / 2);
+                for (std::size_t i = 0; i < out.size(); ++i) {
+                    out[i] = static_cast<unsigned char>(std::stoi(hex.substr(i * 2, 2), nullptr, 16));
+                }
+                return out;
+            }
+
+            /// @brief keylog格式: <label> <client_random hex> <secret hex>
+            void OnKeyLog(const SSL* ssl, const char* line)
+            {
+                std::string text(line);
+                std::size_t first = text.find(' ');
+                std::size_t second = text.find(' ', first + 1);
+                if (first == std::string::npos || second == std::string::npos) {
+                    return;
+                }
+                std::string label = text.substr(0, first);
+                if (label == "CLIENT_TRAFFIC_SECRET_0") {
+                    GetSecrets(ssl, true)->client_traffic = HexDecode(text.substr(second + 1));
+                }
+                else if (label == "SERVER_TRAFFIC_SECRET_0") {
+                    GetSecrets(ssl, true)->server_traffic = HexDecode(text.substr(second + 1));
+                }
+            }
+
+            void OnMessage(int write_p, int version, int content_type, const void* buf, std::size_t len, SSL* ssl, void*)
+            {
+                if (write_p && version == TLS1_3_VERSION && content_type == SSL3_RT_HANDSHAKE && len > 0 &&
+                    static_cast<const unsigned char*>(buf)[0] == SSL3_MT_NEWSESSION_TICKET) {
+                    ++GetSecrets(ssl, true)->tickets_sent;
+                }
+            }
+
+            /// @brief TLS1.3 HKDF-Expand-Label(secret, label, "", len)
+            bool ExpandLabel(const EVP_MD* md, const std::vector<unsigned char>& secret, const std::string& label,
+                unsigned char* out, std::size_t len)
+            {
+                std::string full_label = "tls13 " + label;
+                std::vector<unsigned char> info;
+                info.push_back(static_cast<unsigned char>(len >> 8));
+                info.push_back(static_cast<unsigned char>(len & 0xff));
+                info.push_back(static_cast<unsigned char>(full_label.size()));
+                info.insert(info.end(), full_label.begin(), full_label.end());
+                info.push_back(0); // 空context
+
+                EVP_PKEY_CTX* pctx = EVP_PKEY_CTX_new_id(EVP_PKEY_HKDF, nullptr);
+                bool ok = pctx &&
+                    EVP_PKEY_derive_init(pctx) == 1 &&
+                    EVP_PKEY_CTX_hkdf_mode(pctx, EVP_PKEY_HKDEF_MODE_EXPAND_ONLY) == 1 &&
+                    EVP_PKEY_CTX_set_hkdf_md(pctx, md) == 1 &&
+                    EVP_PKEY_CTX_set1_hkdf_key(pctx, secret.data(), static_cast<int>(secret.size())) == 1 &&
+                    EVP_PKEY_CTX_add1_hkdf_info(pctx, info.data(), static_cast<int>(info.size())) == 1 &&
+                    EVP_PKEY_derive(pctx, out, &len) == 1;
+                EVP_PKEY_CTX_free(pctx);
+                return ok;
+            }
+
+            /// @brief TLS1.2 key_block = PRF(master_secret, "key expansion", server_random + client_random)
+            bool KeyBlock(SSL* ssl, const EVP_MD* md, unsigned char* out, std::size_t len)
+            {
+                unsigned char master[SSL_MAX_MASTER_KEY_LENGTH];
+                unsigned char client_random[SSL3_RANDOM_SIZE];
+                unsigned char server_random[SSL3_RANDOM_SIZE];
+                std::size_t master_len = SSL_SESSION_get_master_key(SSL_get_session(ssl), master, sizeof(master));
+                SSL_get_client_random(ssl, client_random, sizeof(client_random));
+                SSL_get_server_random(ssl, server_random, sizeof(server_random));
+                const char label[] = "key expansion";
+
+                EVP_PKEY_CTX* pctx = EVP_PKEY_CTX_new_id(EVP_PKEY_TLS1_PRF, nullptr);
+                bool ok = pctx && master_len > 0 &&
+                    EVP_PKEY_derive_init(pctx) == 1 &&
+                    EVP_PKEY_CTX_set_tls1_prf_md(pctx, md) == 1 &&
+                    EVP_PKEY_CTX_set1_tls1_prf_secret(pctx, master, static_cast<int>(master_len)) == 1 &&
+                    EVP_PKEY_CTX_add1_tls1_prf_seed(pctx, reinterpret_cast<const unsigned char*>(label), sizeof(label) - 1) == 1 &&
+                    EVP_PKEY_CTX_add1_tls1_prf_seed(pctx, server_random, sizeof(server_random)) == 1 &&
+                    EVP_PKEY_CTX_add1_tls1_prf_seed(pctx, client_random, sizeof(client_random)) == 1 &&
+                    EVP_PKEY_derive(pctx, out, &len) == 1;
+                EVP_PKEY_CTX_free(pctx);
+                OPENSSL_cleanse(master, sizeof(master));
+                return ok;
+            }
+
+#ifdef JL_HAS_KTLS
+            union CryptoInfo {
+                tls_crypto_info info;
+                tls12_crypto_info_aes_gcm_128 aes128;
+                tls12_crypto_info_aes_gcm_256 aes256;
+                tls12_crypto_info_chacha20_poly1305 chacha;
+            };
+
+            /// @brief 单个方向的密钥材料
+            struct Direction {
+                unsigned char key[32];
+                unsigned char iv[12]; // TLS1.3/CHACHA为完整12字节IV，TLS1.2 GCM只有前4字节(salt)
+                std::uint64_t seq;
+            };
+
+            std::size_t BuildCryptoInfo(int version, int nid, const Direction& dir, CryptoInfo& ci)
+            {
+                std::memset(&ci, 0, sizeof(ci));
+                unsigned char seq[8];
+                for (int i = 0; i < 8; ++i) {
+                    seq[i] = static_cast<unsigned char>(dir.seq >> (56 - 8 * i));
+                }
+                ci.info.version = version == TLS1_3_VERSION ? TLS_1_3_VERSION : TLS_1_2_VERSION;
+                // TLS1.2 GCM 的显式nonce只需唯一，沿用记录序号
+                const unsigned char* explicit_iv = version == TLS1_3_VERSION ? dir.iv + 4 : seq;
+                switch (nid) {
+                case NID_aes_128_gcm:
+                    ci.info.cipher_type = TLS_CIPHER_AES_GCM_128;
+                    std::memcpy(ci.aes128.key, dir.key, sizeof(ci.aes128.key));
+                    std::memcpy(ci.aes128.salt, dir.iv, sizeof(ci.aes128.salt));
+                    std::memcpy(ci.aes128.iv, explicit_iv, sizeof(ci.aes128.iv));
+                    std::memcpy(ci.aes128.rec_seq, seq, sizeof(ci.aes128.rec_seq));
+                    return sizeof(ci.aes128);
+                case NID_aes_256_gcm:
+                    ci.info.cipher_type = TLS_CIPHER_AES_GCM_256;
+                    std::memcpy(ci.aes256.key, dir.key, sizeof(ci.aes256.key));
+                    std::memcpy(ci.aes256.salt, dir.iv, sizeof(ci.aes256.salt));
+                    std::memcpy(ci.aes256.iv, explicit_iv, sizeof(ci.aes256.iv));
+                    std::memcpy(ci.aes256.rec_seq, seq, sizeof(ci.aes256.rec_seq));
+                    return sizeof(ci.aes256);
+                case NID_chacha20_poly1305:
+                    ci.info.cipher_type = TLS_CIPHER_CHACHA20_POLY1305;
+                    std::memcpy(ci.chacha.key, dir.key, sizeof(ci.chacha.key));
+                    std::memcpy(ci.chacha.iv, dir.iv, sizeof(ci.chacha.iv));
+                    std::memcpy(ci.chacha.rec_seq, seq, sizeof(ci.chacha.rec_seq));
+                    return sizeof(ci.chacha);
+                default:
+                    return 0;
+                }
+            }
+#endif
+        }
+
+        bool Supported()
+        {
+#ifdef JL_HAS_KTLS
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        void Prepare(SSL_CTX* ctx)
+        {
+            SSL_CTX_set_keylog_callback(ctx, &OnKeyLog);
+            SSL_CTX_set_msg_callback(ctx, &OnMessage);
+        }
+
+        State Enable(SSL* ssl, int fd)
+        {
+            State state{ false, false };
+#ifdef JL_HAS_KTLS
+            const int version = SSL_version(ssl);
+            const SSL_CIPHER* cipher = SSL_get_current_cipher(ssl);
+            if (!cipher || (version != TLS1_2_VERSION && version != TLS1_3_VERSION)) {
+                return state;
+            }
+            const int nid = SSL_CIPHER_get_cipher_nid(cipher);
+            const EVP_MD* md = SSL_CIPHER_get_handshake_digest(cipher);
+            std::size_t key_len = 0;
+            std::size_t fixed_iv_len = 0; // TLS1.2 key_block中的IV长度
+            switch (nid) {
+            case NID_aes_128_gcm: key_len = 16; fixed_iv_len = 4; break;
+            case NID_aes_256_gcm: key_len = 32; fixed_iv_len = 4; break;
+            case NID_chacha20_poly1305: key_len = 32; fixed_iv_len = 12; break;
+            default:
+                LOG_DEBUG("ktls: cipher {} not supported", SSL_CIPHER_get_name(cipher));
+                return state;
+            }
+
+            Direction client{}, server{};
+            if (version == TLS1_3_VERSION) {
+                Secrets* secrets = GetSecrets(ssl, false);
+                if (!secrets || secrets->client_traffic.empty() || secrets->server_traffic.empty() ||
+                    !ExpandLabel(md, secrets->client_traffic, "key", client.key, key_len) ||
+                    !ExpandLabel(md, secrets->client_traffic, "iv", client.iv, 12) ||
+                    !ExpandLabel(md, secrets->server_traffic, "key", server.key, key_len) ||
+                    !ExpandLabel(md, secrets->server_traffic, "iv", server.iv, 12)) {
+                    return state;
+                }
+                client.seq = 0; // 客户端Finished使用握手密钥，应用数据从0开始
+                server.seq = secrets->tickets_sent;
+            }
+            else {
+                // AEAD没有MAC密钥: client_key | server_key | client_iv | server_iv
+                unsigned char block[2 * 32 + 2 * 12];
+                std::size_t block_len = 2 * key_len + 2 * fixed_iv_len;
+                if (!md || !KeyBlock(ssl, md, block, block_len)) {
+                    return state;
+                }
+                std::memcpy(client.key, block, key_len);
+                std::memcpy(server.key, block + key_len, key_len);
+                std::memcpy(client.iv, block + 2 * key_len, fixed_iv_len);
+                std::memcpy(server.iv, block + 2 * key_len + fixed_iv_len, fixed_iv_len);
+                OPENSSL_cleanse(block, sizeof(block));
+                client.seq = 1; // Finished 是新密钥下的第一条记录
+                server.seq = 1;
+            }
+            const Direction& tx = SSL_is_server(ssl) ? server : client;
+            const Direction& rx = SSL_is_server(ssl) ? client : server;
+
+            if (setsockopt(fd, SOL_TCP, TCP_ULP, "tls", sizeof("tls")) != 0) {
+                LOG_DEBUG("ktls: attach tls ulp fail, errno: {}", errno);
+            }
+            else {
+                CryptoInfo ci;
+                std::size_t len = BuildCryptoInfo(version, nid, tx, ci);
+                state.tx = len > 0 && setsockopt(fd, SOL_TLS, TLS_TX, &ci, static_cast<socklen_t>(len)) == 0;
+                // OpenSSL中还有已收到未处理的数据时不能切换接收方向，否则这些记录会丢失
+                if (state.tx && SSL_has_pending(ssl) == 0 && BIO_ctrl_pending(SSL_get_rbio(ssl)) == 0) {
+                    len = BuildCryptoInfo(version, nid, rx, ci);
+                    state.rx = len > 0 && setsockopt(fd, SOL_TLS, TLS_RX, &ci, static_cast<socklen_t>(len)) == 0;
+                }
+                OPENSSL_cleanse(&ci, sizeof(ci));
+            }
+            OPENSSL_cleanse(&client, sizeof(client));
+            OPENSSL_cleanse(&server, sizeof(server));
+#endif
+            return state;
+        }
+
+        void SendCloseNotify(int fd)
+        {
+#ifdef JL_HAS_KTLS
+            unsigned char alert[2] = { 1, 0 }; // warning, close_notify
+            char cbuf[CMSG_SPACE(sizeof(unsigned char))] = {};
+            iovec iov{ alert, sizeof(alert) };
+            msghdr msg{};
+            msg.msg_iov = &iov;
+            msg.msg_iovlen = 1;
+            msg.msg_control = cbuf;
+            msg.msg_controllen = sizeof(cbuf);
+            cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+            cmsg->cmsg_level = SOL_TLS;
+            cmsg->cmsg_type = TLS_SET_RECORD_TYPE;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(unsigned char));
+            *CMSG_DATA(cmsg) = 21; // alert
+            sendmsg(fd, &msg, MSG_NOSIGNAL);
+#else
+            (void)fd;
+#endif
+        }
+
+        long Receive(int fd, void* data, std::size_t size, unsigned char& record_type)
+        {
+#ifdef JL_HAS_KTLS
+            char cbuf[CMSG_SPACE(sizeof(unsigned char))];
+            iovec iov{ data, size };
+            msghdr msg{};
+            msg.msg_iov = &iov;
+            msg.msg_iovlen = 1;
+            msg.msg_control = cbuf;
+            msg.msg_controllen = sizeof(cbuf);
+            ssize_t n;
+            do {
+                n = recvmsg(fd, &msg, MSG_DONTWAIT);
+            } while (n < 0 && errno == EINTR);
+            record_type = kRecordApplicationData;
+            if (n >= 0) {
+                cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+                if (cmsg && cmsg->cmsg_level == SOL_TLS && cmsg->cmsg_type == TLS_GET_RECORD_TYPE) {
+                    record_type = *CMSG_DATA(cmsg);
+                }
+            }
+            return static_cast<long>(n);
+#else
+            (void)fd, (void)data, (void)size;
+            record_type = kRecordApplicationData;
+            errno = ENOSYS;
+            return -1;
+#endif
+        }
+    }
+}
+
+#endif // ENABLE_OPENSSL
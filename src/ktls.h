@@ -0,0 +1,49 @@
+/// @file ktls.h
+/// @brief Linux内核TLS(kTLS)卸载：握手完成后把协商出的密钥安装到socket的TLS ULP，之后的加解密由内核完成
+/// @author Jyang.
+/// @date 2026-10-19
+/// @version 1.0
+
+#pragma once
+
+#ifdef ENABLE_OPENSSL
+
+#include <openssl/ssl.h>
+
+namespace jl {
+    namespace ktls {
+
+        /// @brief 卸载结果
+        struct State {
+            bool tx; // 发送方向由内核加密，可以直接写明文到socket（含sendfile）
+            bool rx; // 接收方向由内核解密，可以直接从socket读明文
+        };
+
+        /// @brief 当前平台/编译环境是否支持kTLS
+        bool Supported();
+
+        /// @brief 在SSL_CTX上安装keylog和消息回调，用于握手后取得TLS1.3流量密钥和记录序号，需在握手之前调用
+        void Prepare(SSL_CTX* ctx);
+
+        /// @brief 握手完成后尝试卸载。支持 TLS1.2/1.3 + AES-GCM-128/256、CHACHA20-POLY1305。
+        ///        内核不支持、算法不支持或OpenSSL中还有未读取的数据时，对应方向保持用户态加解密。
+        /// @param ssl 已完成握手的SSL对象
+        /// @param fd socket描述符
+        State Enable(SSL* ssl, int fd);
+
+        /// @brief 已卸载发送方向时，通过内核发送 close_notify 告警
+        void SendCloseNotify(int fd);
+
+        constexpr unsigned char kRecordAlert = 21;
+        constexpr unsigned char kRecordHandshake = 22;
+        constexpr unsigned char kRecordApplicationData = 23;
+
+        /// @brief 已卸载接收方向时以非阻塞 recvmsg 读取明文。内核把非应用数据的记录（告警、TLS1.3 的 KeyUpdate 等握手消息）
+        ///        单独交给一次读取，并用 TLS_GET_RECORD_TYPE 标出类型；不取类型的 read 遇到这类记录会失败(EIO)
+        /// @param record_type 读到的记录类型，kRecordApplicationData 时返回的才是应用数据
+        /// @return 读取的字节数，0 表示对端关闭TCP连接，-1 表示出错（errno）
+        long Receive(int fd, void* data, std::size_t size, unsigned char& record_type);
+    }
+}
+
+#endif // ENABLE_OPENSSL
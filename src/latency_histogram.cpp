@@ -0,0 +1,131 @@
+#include "latency_histogram.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace jl {
+    namespace util {
+
+        namespace {
+            /// @brief value 的最高位序号，value 不为0
+            inline int HighestBit(std::uint64_t value)
+            {
+#ifdef _MSC_VER
+                unsigned long index;
+                _BitScanReverse64(&index, value);
+                return static_cast<int>(index);
+#else
+                return 63 - __builtin_clzll(value);
+#endif
+            }
+        }
+
+        LatencyHistogram::LatencyHistogram(std::uint64_t max_value, int significant_digits) :
+            highest_trackable_(std::max<std::uint64_t>(max_value, 2)),
+            total_(0),
+            min_(std::numeric_limits<std::uint64_t>::max()),
+            max_(0),
+            sum_(0)
+        {
+            significant_digits = std::min(5, std::max(1, significant_digits));
+            // 每段至少 2*10^d 个子桶，段内相邻两个值的相对差不超过 10^-d
+            const std::uint64_t resolution = 2 * static_cast<std::uint64_t>(std::pow(10, significant_digits));
+            int count_magnitude = HighestBit(resolution - 1) + 1;
+            sub_bucket_half_magnitude_ = count_magnitude - 1;
+            const std::uint64_t sub_bucket_count = 1ull << count_magnitude;
+            sub_bucket_mask_ = sub_bucket_count - 1;
+
+            // 第 i 段覆盖 [0, sub_bucket_count << i)，段数足够覆盖 highest_trackable_
+            std::size_t buckets = 1;
+            std::uint64_t smallest_untrackable = sub_bucket_count;
+            while (smallest_untrackable <= highest_trackable_) {
+                ++buckets;
+                if (smallest_untrackable > std::numeric_limits<std::uint64_t>::max() / 2) {
+                    break;
+                }
+                smallest_untrackable <<= 1;
+            }
+            counts_.assign((buckets + 1) << sub_bucket_half_magnitude_, 0);
+        }
+
+        std::size_t LatencyHistogram::IndexOf(std::uint64_t value) const
+        {
+            // 段号由最高位决定，段内按 value >> 段号 线性划分；第0段用满全部子桶，其余段只用后一半
+            const int bucket = HighestBit(value | sub_bucket_mask_) - sub_bucket_half_magnitude_;
+            const std::uint64_t sub_bucket = value >> bucket;
+            return (static_cast<std::size_t>(bucket + 1) << sub_bucket_half_magnitude_) +
+                static_cast<std::size_t>(sub_bucket - (1ull << sub_bucket_half_magnitude_));
+        }
+
+        std::uint64_t LatencyHistogram::HighestEquivalent(std::size_t index) const
+        {
+            int bucket = static_cast<int>(index >> sub_bucket_half_magnitude_) - 1;
+            std::uint64_t sub_bucket = (index & ((1ull << sub_bucket_half_magnitude_) - 1)) + (1ull << sub_bucket_half_magnitude_);
+            if (bucket < 0) {
+                sub_bucket -= 1ull << sub_bucket_half_magnitude_;
+                bucket = 0;
+            }
+            return (sub_bucket << bucket) + ((1ull << bucket) - 1);
+        }
+
+        void LatencyHistogram::RecordValues(std::uint64_t value, std::uint64_t count)
+        {
+            if (count == 0) {
+                return;
+            }
+            counts_[IndexOf(std::min(value, highest_trackable_))] += count;
+            total_ += count;
+            sum_ += value * count;
+            min_ = std::min(min_, value);
+            max_ = std::max(max_, value);
+        }
+
+        void LatencyHistogram::Merge(const LatencyHistogram& other)
+        {
+            assert(counts_.size() == other.counts_.size() && sub_bucket_half_magnitude_ == other.sub_bucket_half_magnitude_);
+            if (other.total_ == 0) {
+                return;
+            }
+            for (std::size_t i = 0; i < counts_.size(); ++i) {
+                counts_[i] += other.counts_[i];
+            }
+            total_ += other.total_;
+            sum_ += other.sum_;
+            min_ = std::min(min_, other.min_);
+            max_ = std::max(max_, other.max_);
+        }
+
+        void LatencyHistogram::Reset()
+        {
+            std::fill(counts_.begin(), counts_.end(), 0);
+            total_ = 0;
+            min_ = std::numeric_limits<std::uint64_t>::max();
+            max_ = 0;
+            sum_ = 0;
+        }
+
+        std::uint64_t LatencyHistogram::Percentile(double percentile) const
+        {
+            if (total_ == 0) {
+                return 0;
+            }
+            percentile = std::min(100.0, std::max(0.0, percentile));
+            const std::uint64_t target = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(percentile / 100.0 * total_)));
+            std::uint64_t seen = 0;
+            for (std::size_t i = 0; i < counts_.size(); ++i) {
+                seen += counts_[i];
+                if (seen >= target) {
+                    // 桶的上界可能超过真实的最大值
+                    return std::min(HighestEquivalent(i), max_);
+                }
+            }
+            return max_;
+        }
+    }
+}
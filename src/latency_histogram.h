@@ -0,0 +1,61 @@
+/// @file latency_histogram.h
+/// @brief HDR 风格的延迟直方图：对数分段、段内线性，在固定内存内以给定的有效数字精度记录很大范围的值
+/// @author Jyang.
+/// @date 2026-10-19
+/// @version 1.0
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace jl {
+    namespace util {
+
+        constexpr std::uint64_t kDefaultHistogramMax = 3600ull * 1000 * 1000 * 1000;   // 默认可记录的最大值，以纳秒计为1小时
+
+        /// @brief 非线程安全，每个线程各自记录，结束后 Merge 到一起。
+        ///        值按最高位分段，每段再等分为 2^k 个子桶，相对误差不超过 10^-significant_digits；
+        ///        Record 只做一次位运算和一次计数，不分配内存
+        class LatencyHistogram {
+        public:
+            /// @param max_value 可记录的最大值，更大的值计入最后一个桶，Max() 仍为真实值
+            /// @param significant_digits 有效数字位数，1~5
+            explicit LatencyHistogram(std::uint64_t max_value = kDefaultHistogramMax, int significant_digits = 3);
+
+            void Record(std::uint64_t value) { RecordValues(value, 1); }
+
+            /// @brief 记录 count 个相同的值
+            void RecordValues(std::uint64_t value, std::uint64_t count);
+
+            /// @brief 把 other 的计数加到本直方图，两者的 max_value 和精度必须相同
+            void Merge(const LatencyHistogram& other);
+
+            void Reset();
+
+            /// @brief 第 percentile（0~100）百分位的值，返回所在桶的上界，与真实值的误差在精度之内
+            std::uint64_t Percentile(double percentile) const;
+
+            std::uint64_t Count() const { return total_; }
+            std::uint64_t Min() const { return total_ == 0 ? 0 : min_; }
+            std::uint64_t Max() const { return max_; }
+            double Mean() const { return total_ == 0 ? 0.0 : static_cast<double>(sum_) / total_; }
+
+        private:
+            std::size_t IndexOf(std::uint64_t value) const;
+
+            /// @brief 下标为 index 的桶中最大的值
+            std::uint64_t HighestEquivalent(std::size_t index) const;
+
+        private:
+            std::uint64_t highest_trackable_;
+            int sub_bucket_half_magnitude_;     // 子桶数的一半为 2^sub_bucket_half_magnitude_
+            std::uint64_t sub_bucket_mask_;
+            std::vector<std::uint64_t> counts_;
+            std::uint64_t total_;
+            std::uint64_t min_;
+            std::uint64_t max_;
+            std::uint64_t sum_;
+        };
+    }
+}
@@ -10,10 +10,12 @@ namespace jl {
     bool kLogIsBlock = false;
     int kLogThreadCount = 1;
     int kLogQueueSize = 2048;
+    LogOverflowPolicy kLogOverflowPolicy = LogOverflowPolicy::kBlock;
     // std::string kDefaultLogFile = fmt::format("{}/{}", GetDataRoot(), "logs/easy_tools_log.txt");
     std::string kDefaultLogFile = fmt::format("{}/{}", "./logs", "jl_tcpserver.txt");
     constexpr const char* kAsyncLoggerName = "async_jl_tcpserver_logger";
     constexpr const char* kSyncLoggerName = "sync_jl_tcpserver_logger";
+    constexpr std::chrono::seconds kSuppressedSummaryInterval(1);   // 与限流窗口相同
     constexpr const char* LOG_FORMAT = "%^[%Y-%m-%d %H:%M:%S.%e][thread %t][%l]: %v%$"; // %^...%$ 打印颜色
 
     void SetLogFileMaxSize(int size) {
@@ -39,6 +41,44 @@ namespace jl {
         kLogThreadCount = thread_count;
     }
 
+    void SetLogOverflowPolicy(LogOverflowPolicy policy)
+    {
+        kLogOverflowPolicy = policy;
+    }
+
+    LogOverflowPolicy GetLogOverflowPolicy()
+    {
+        return kLogOverflowPolicy;
+    }
+
+    namespace {
+        std::atomic<LogRateLimiter*> g_rate_limiters{ nullptr };   // 所有调用点限流器，只在头部插入
+    }
+
+    LogRateLimiter::LogRateLimiter(std::uint32_t per_second, spdlog::level::level_enum level, const spdlog::source_loc& location) :
+        per_second_(per_second),
+        level_(level),
+        location_(location),
+        window_(-1),
+        count_(0),
+        suppressed_(0),
+        next_(g_rate_limiters.load(std::memory_order_relaxed))
+    {
+        while (!g_rate_limiters.compare_exchange_weak(next_, this, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+    }
+
+    LogRateLimiter* LogRateLimiter::First()
+    {
+        return g_rate_limiters.load(std::memory_order_acquire);
+    }
+
+    std::uint64_t GetAsyncLogOverrunCount()
+    {
+        auto pool = spdlog::thread_pool();
+        return pool ? pool->overrun_counter() : 0;
+    }
+
     class AsyncLoggerImpl : public BaseLoggerImpl
     {
     public:
@@ -47,7 +87,8 @@ namespace jl {
         {
             logger_ = std::make_shared<spdlog::async_logger>(
                 logger_name, sink_list.begin(), sink_list.end(),
-                spdlog::thread_pool(), spdlog::async_overflow_policy::block);
+                spdlog::thread_pool(),
+                kLogOverflowPolicy == LogOverflowPolicy::kBlock ? spdlog::async_overflow_policy::block : spdlog::async_overflow_policy::overrun_oldest);
 #ifdef _DEBUG
             logger_->set_level(spdlog::level::debug);
 #else
@@ -56,31 +97,6 @@ namespace jl {
             spdlog::register_logger(logger_);
         }
 
-        void LogDebug(const std::string& msg) override
-        {
-            logger_->debug(msg);
-        };
-
-        void LogInfo(const std::string& msg) override
-        {
-            logger_->info(msg);
-        };
-
-        void LogWarn(const std::string& msg) override
-        {
-            logger_->warn(msg);
-        };
-
-        void LogError(const std::string& msg) override
-        {
-            logger_->error(msg);
-        };
-
-        void log(spdlog::source_loc&& source, spdlog::level::level_enum lvl, const std::string& msg) override
-        {
-            logger_->log(std::move(source), lvl, msg);
-        }
-
         void Flush()
         {
             logger_->flush();
@@ -112,31 +128,6 @@ namespace jl {
             spdlog::register_logger(logger_);
         }
 
-        void LogDebug(const std::string& msg) override
-        {
-            logger_->debug(msg);
-        };
-
-        void LogInfo(const std::string& msg) override
-        {
-            logger_->info(msg);
-        };
-
-        void LogWarn(const std::string& msg) override
-        {
-            logger_->warn(msg);
-        };
-
-        void LogError(const std::string& msg) override
-        {
-            logger_->error(msg);
-        };
-
-        void log(spdlog::source_loc&& source, spdlog::level::level_enum lvl, const std::string& msg) override
-        {
-            logger_->log(std::move(source), lvl, msg);
-        }
-
         void Flush()
         {
             logger_->flush();
@@ -154,6 +145,8 @@ namespace jl {
     Logger& Logger::GetInstance()
     {
         static std::once_flag flag;
+        // 保证spdlog的registry(含异步线程池)先于Logger构造、后于Logger析构，否则退出时flush会抛出异常
+        spdlog::details::registry::instance();
         static Logger instance;
         std::call_once(flag, [&]()
             {
@@ -182,15 +175,47 @@ namespace jl {
                     sink->set_level(spdlog::level::info);
                 }
 #endif
+                instance.summary_worker_ = std::make_unique<spdlog::details::periodic_worker>([]() {
+                    instance.FlushSuppressed();
+                    }, kSuppressedSummaryInterval);
             });
         return instance;
     }
 
+    Logger::~Logger()
+    {
+        // 先停止汇总线程，再输出最后一次汇总
+        summary_worker_.reset();
+        if (logger_impl_) {
+            FlushSuppressed();
+        }
+    }
+
+    void Logger::LogSuppressed(const LogRateLimiter& limiter, std::uint64_t suppressed)
+    {
+        const spdlog::source_loc& location = limiter.Location();
+        Log(location, limiter.Level(), "suppressed {} similar log messages at {}:{}", suppressed, location.filename, location.line);
+    }
+
+    void Logger::FlushSuppressed()
+    {
+        for (LogRateLimiter* limiter = LogRateLimiter::First(); limiter; limiter = limiter->Next()) {
+            if (!ShouldLog(limiter->Level())) {
+                continue;
+            }
+            std::uint64_t suppressed = limiter->TakeSuppressed();
+            if (suppressed > 0) {
+                LogSuppressed(*limiter, suppressed);
+            }
+        }
+    }
+
 
     void Logger::Flush()
     {
         if (logger_impl_)
         {
+            FlushSuppressed();
             logger_impl_->Flush();
         }
     }
@@ -6,13 +6,108 @@
 #include <spdlog/sinks/rotating_file_sink.h>
 #include <spdlog/async.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/details/periodic_worker.h>
 
-#define LOG_DEBUG(FORMAT, ...) jl::Logger::GetInstance().LogDebug(fmt::format(FORMAT, __VA_ARGS__))
-#define LOG_INFO(FORMAT, ...) jl::Logger::GetInstance().LogInfo(fmt::format(FORMAT, __VA_ARGS__))
-#define LOG_WARN(FORMAT, ...) jl::Logger::GetInstance().LogWarn(fmt::format(FORMAT, __VA_ARGS__))
-#define LOG_ERROR(FORMAT, ...) jl::Logger::GetInstance().LogError(fmt::format(FORMAT, __VA_ARGS__))
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// 编译期日志级别：低于该级别的 LOG_XXX 调用会被预处理器整体移除，参数不会被求值。
+// 可通过编译选项 -DJL_LOG_ACTIVE_LEVEL=SPDLOG_LEVEL_XXX 覆盖（cmake: -DJL_LOG_ACTIVE_LEVEL=...）
+#ifndef JL_LOG_ACTIVE_LEVEL
+#ifdef _DEBUG
+#define JL_LOG_ACTIVE_LEVEL SPDLOG_LEVEL_DEBUG
+#else
+#define JL_LOG_ACTIVE_LEVEL SPDLOG_LEVEL_INFO
+#endif
+#endif
+
+// 先判断运行期级别，再对参数求值并格式化，格式化直接写入spdlog内部缓冲区（不再额外构造std::string）
+#define JL_LOG_CALL(LEVEL, ...)                                                                                 \
+    do {                                                                                                        \
+        auto& jl_logger_instance_ = jl::Logger::GetInstance();                                                  \
+        if (jl_logger_instance_.ShouldLog(LEVEL)) {                                                             \
+            jl_logger_instance_.Log(spdlog::source_loc{__FILE__, __LINE__, SPDLOG_FUNCTION}, LEVEL, __VA_ARGS__); \
+        }                                                                                                       \
+    } while (0)
+
+// 按调用点限流：每秒最多输出 RATE 条，超出部分只计数。被抑制的条数在下一条放行的日志之前输出；
+// 调用点之后不再有日志时，由 Logger 每秒一次的汇总（以及 Flush）输出
+#define JL_LOG_LIMIT_CALL(LEVEL, RATE, ...)                                                                      \
+    do {                                                                                                        \
+        auto& jl_logger_instance_ = jl::Logger::GetInstance();                                                  \
+        if (jl_logger_instance_.ShouldLog(LEVEL)) {                                                             \
+            static jl::LogRateLimiter jl_log_limiter_(RATE, LEVEL, spdlog::source_loc{__FILE__, __LINE__, SPDLOG_FUNCTION}); \
+            std::uint64_t jl_log_suppressed_ = 0;                                                               \
+            if (jl_log_limiter_.Allow(jl_log_suppressed_)) {                                                    \
+                if (jl_log_suppressed_ > 0) {                                                                   \
+                    jl_logger_instance_.LogSuppressed(jl_log_limiter_, jl_log_suppressed_);                     \
+                }                                                                                               \
+                jl_logger_instance_.Log(jl_log_limiter_.Location(), LEVEL, __VA_ARGS__);                        \
+            }                                                                                                   \
+        }                                                                                                       \
+    } while (0)
+
+// 按调用点采样：每 N 次调用输出一次（第1、N+1、2N+1...次）
+#define JL_LOG_EVERY_N_CALL(LEVEL, N, ...)                                                                       \
+    do {                                                                                                        \
+        auto& jl_logger_instance_ = jl::Logger::GetInstance();                                                  \
+        if (jl_logger_instance_.ShouldLog(LEVEL)) {                                                             \
+            static jl::LogSampler jl_log_sampler_(N);                                                           \
+            if (jl_log_sampler_.Sample()) {                                                                     \
+                jl_logger_instance_.Log(spdlog::source_loc{__FILE__, __LINE__, SPDLOG_FUNCTION}, LEVEL, __VA_ARGS__); \
+            }                                                                                                   \
+        }                                                                                                       \
+    } while (0)
+
+#if JL_LOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) JL_LOG_CALL(spdlog::level::debug, __VA_ARGS__)
+#define LOG_DEBUG_LIMIT(RATE, ...) JL_LOG_LIMIT_CALL(spdlog::level::debug, RATE, __VA_ARGS__)
+#define LOG_DEBUG_EVERY_N(N, ...) JL_LOG_EVERY_N_CALL(spdlog::level::debug, N, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) (void)0
+#define LOG_DEBUG_LIMIT(...) (void)0
+#define LOG_DEBUG_EVERY_N(...) (void)0
+#endif
+
+#if JL_LOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_INFO
+#define LOG_INFO(...) JL_LOG_CALL(spdlog::level::info, __VA_ARGS__)
+#define LOG_INFO_LIMIT(RATE, ...) JL_LOG_LIMIT_CALL(spdlog::level::info, RATE, __VA_ARGS__)
+#define LOG_INFO_EVERY_N(N, ...) JL_LOG_EVERY_N_CALL(spdlog::level::info, N, __VA_ARGS__)
+#else
+#define LOG_INFO(...) (void)0
+#define LOG_INFO_LIMIT(...) (void)0
+#define LOG_INFO_EVERY_N(...) (void)0
+#endif
+
+#if JL_LOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_WARN
+#define LOG_WARN(...) JL_LOG_CALL(spdlog::level::warn, __VA_ARGS__)
+#define LOG_WARN_LIMIT(RATE, ...) JL_LOG_LIMIT_CALL(spdlog::level::warn, RATE, __VA_ARGS__)
+#define LOG_WARN_EVERY_N(N, ...) JL_LOG_EVERY_N_CALL(spdlog::level::warn, N, __VA_ARGS__)
+#else
+#define LOG_WARN(...) (void)0
+#define LOG_WARN_LIMIT(...) (void)0
+#define LOG_WARN_EVERY_N(...) (void)0
+#endif
+
+#if JL_LOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_ERROR
+#define LOG_ERROR(...) JL_LOG_CALL(spdlog::level::err, __VA_ARGS__)
+#define LOG_ERROR_LIMIT(RATE, ...) JL_LOG_LIMIT_CALL(spdlog::level::err, RATE, __VA_ARGS__)
+#define LOG_ERROR_EVERY_N(N, ...) JL_LOG_EVERY_N_CALL(spdlog::level::err, N, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) (void)0
+#define LOG_ERROR_LIMIT(...) (void)0
+#define LOG_ERROR_EVERY_N(...) (void)0
+#endif
 
 namespace jl {
+    /// @brief 日志队列满时的处理策略
+    enum class LogOverflowPolicy {
+        kBlock = 1,     // 阻塞调用线程直到有空位
+        kDropNewest,    // 丢弃当前这条日志
+        kDropOldest,    // 覆盖队列中最旧的日志
+    };
+
     /// <summary>
     /// 设置单个文件最大size
     /// </summary>
@@ -44,24 +139,94 @@ namespace jl {
     /// <param name="thread_count">线程数量</param>
     void SetLogThreadPool(int q_size, int thread_count);
 
+    /// <summary>
+    /// 设置日志队列满时的处理策略，作用于异步logger和二进制日志环形缓冲区，需在第一条日志之前设置。
+    /// spdlog的异步队列不支持丢弃最新，kDropNewest在该路径上按kDropOldest处理
+    /// </summary>
+    /// <param name="policy"></param>
+    void SetLogOverflowPolicy(LogOverflowPolicy policy);
+
+    LogOverflowPolicy GetLogOverflowPolicy();
+
+    /// <summary>
+    /// 异步logger因队列满而覆盖的日志条数
+    /// </summary>
+    std::uint64_t GetAsyncLogOverrunCount();
+
+
+    /// @brief 调用点限流器：以秒为窗口，每个窗口最多放行 per_second 次，其余计入被抑制次数。
+    ///        构造时登记到全局列表（只增不减），调用点安静之后剩余的抑制次数由 Logger 的定时汇总取出。
+    ///        作为函数内的静态对象使用，析构是平凡的，退出期间汇总线程仍可以读取
+    class LogRateLimiter
+    {
+    public:
+        LogRateLimiter(std::uint32_t per_second, spdlog::level::level_enum level, const spdlog::source_loc& location);
+
+        /// @brief 是否放行本次日志
+        /// @param suppressed 放行时返回此前被抑制的次数（并清零）
+        bool Allow(std::uint64_t& suppressed)
+        {
+            std::int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+            std::int64_t window = window_.load(std::memory_order_relaxed);
+            if (now != window && window_.compare_exchange_strong(window, now, std::memory_order_relaxed)) {
+                count_.store(0, std::memory_order_relaxed);
+            }
+            if (count_.fetch_add(1, std::memory_order_relaxed) < per_second_) {
+                suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+                return true;
+            }
+            suppressed_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        /// @brief 取出并清零被抑制的次数，与 Allow 并发时每次抑制只会被取出一次
+        std::uint64_t TakeSuppressed() { return suppressed_.exchange(0, std::memory_order_relaxed); }
+
+        spdlog::level::level_enum Level() const { return level_; }
+
+        const spdlog::source_loc& Location() const { return location_; }
+
+        /// @brief 所有登记的限流器，构造顺序的逆序
+        static LogRateLimiter* First();
+
+        LogRateLimiter* Next() const { return next_; }
+
+    private:
+        const std::uint32_t per_second_;
+        const spdlog::level::level_enum level_;
+        const spdlog::source_loc location_;
+        std::atomic<std::int64_t> window_;
+        std::atomic<std::uint32_t> count_;
+        std::atomic<std::uint64_t> suppressed_;
+        LogRateLimiter* next_;
+    };
+
+    /// @brief 调用点采样器：每 n 次放行一次
+    class LogSampler
+    {
+    public:
+        explicit LogSampler(std::uint32_t n) : n_(n == 0 ? 1 : n), count_(0) {}
+
+        bool Sample()
+        {
+            return count_.fetch_add(1, std::memory_order_relaxed) % n_ == 0;
+        }
+
+    private:
+        const std::uint32_t n_;
+        std::atomic<std::uint64_t> count_;
+    };
 
     class BaseLoggerImpl
     {
     public:
         BaseLoggerImpl(const std::shared_ptr<spdlog::logger>& logger) : logger_(logger) {}
 
-        virtual void LogDebug(const std::string& msg) = 0;
-        virtual void LogInfo(const std::string& msg) = 0;
-        virtual void LogWarn(const std::string& msg) = 0;
-        virtual void LogError(const std::string& msg) = 0;
+        virtual ~BaseLoggerImpl() = default;
 
-        /// <summary>
-        /// SPDLOG_LOGGER_XXXX 宏需要调用该函数，也是实际调用的log函数。以上四个函数并没有被调用（无法打印源文件、函数和行号）
-        /// </summary>
-        /// <param name="source">文件名、函数、行号</param>
-        /// <param name="lvl">level</param>
-        /// <param name="msg">日志内容</param>
-        virtual void log(spdlog::source_loc&& source, spdlog::level::level_enum lvl, const std::string& msg) = 0;
+        /// @brief 底层spdlog logger，LOG_XXX 宏通过它直接格式化到spdlog的缓冲区
+        spdlog::logger* Get() const { return logger_.get(); }
 
         virtual void Flush() = 0;
 
@@ -74,42 +239,43 @@ namespace jl {
     public:
         static Logger& GetInstance();
 
-        void LogDebug(const std::string& msg)
+        /// @brief 运行期级别判断，LOG_XXX 宏在参数求值之前调用
+        bool ShouldLog(spdlog::level::level_enum lvl) const
         {
-            // logger_impl_->LogDebug(msg); // 无法打印文件、函数、行号
-            SPDLOG_LOGGER_DEBUG(logger_impl_, msg);
+            return logger_impl_->Get()->should_log(lvl);
         }
 
-        void LogInfo(const std::string& msg)
+        /// @brief logger的输出目标，二进制日志的后台线程直接写入这些sink
+        const std::vector<spdlog::sink_ptr>& Sinks() const
         {
-            SPDLOG_LOGGER_INFO(logger_impl_, msg);
-            // logger_impl_->LogInfo(msg);
+            return logger_impl_->Get()->sinks();
         }
 
-        void LogWarn(const std::string& msg)
+        /// @brief 格式化并输出日志，格式串在编译期检查
+        /// @param source 文件名、函数、行号
+        /// @param lvl level
+        template <typename... Args>
+        void Log(spdlog::source_loc source, spdlog::level::level_enum lvl, spdlog::format_string_t<Args...> fmt, Args&&... args)
         {
-            // logger_impl_->LogWarn(msg);
-            SPDLOG_LOGGER_WARN(logger_impl_, msg);
+            logger_impl_->Get()->log(source, lvl, fmt, std::forward<Args>(args)...);
         }
 
-        void LogError(const std::string& msg)
-        {
-            // logger_impl_->LogError(msg);
-            SPDLOG_LOGGER_ERROR(logger_impl_, msg);
-        }
+        /// @brief 输出限流调用点被抑制的条数，位置为该调用点
+        void LogSuppressed(const LogRateLimiter& limiter, std::uint64_t suppressed);
 
+        /// @brief 输出所有限流调用点还没汇总的抑制条数，再刷新输出
         void Flush();
 
-        ~Logger()
-        {
-            // LOG_DEBUG("~ToolLogger");
-            //  spdlog::shutdown();
-        }
+        ~Logger();
 
     private:
         Logger() : logger_impl_(nullptr) {};
 
+        /// @brief 取出所有限流调用点的抑制次数并输出汇总。汇总线程每秒调用一次，突发结束后调用点不再有日志时计数也不会丢失
+        void FlushSuppressed();
+
     private:
         std::unique_ptr<BaseLoggerImpl> logger_impl_;
+        std::unique_ptr<spdlog::details::periodic_worker> summary_worker_;  // 在 logger_impl_ 之前析构，停止后不再写日志
     };
 }
\ No newline at end of file
@@ -0,0 +1,57 @@
+#include "request_arena.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace jl {
+    namespace http {
+
+        void* RequestArena::Upstream::do_allocate(std::size_t bytes, std::size_t alignment)
+        {
+            ++stats_.overflow_allocations;
+            stats_.overflow_bytes += bytes;
+            bytes_ += bytes;
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+
+        void RequestArena::Upstream::do_deallocate(void* p, std::size_t bytes, std::size_t alignment)
+        {
+            std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+        }
+
+        RequestArena::RequestArena(std::size_t initial_bytes, std::size_t max_initial_bytes) :
+            upstream_(stats_),
+            initial_(new char[initial_bytes]),
+            initial_size_(initial_bytes),
+            max_initial_bytes_(std::max(initial_bytes, max_initial_bytes))
+        {
+            resource_.emplace(initial_.get(), initial_size_, &upstream_);
+        }
+
+        std::string_view RequestArena::Copy(std::string_view text)
+        {
+            if (text.empty()) {
+                return std::string_view();
+            }
+            char* p = static_cast<char*>(resource_->allocate(text.size(), 1));
+            std::memcpy(p, text.data(), text.size());
+            return std::string_view(p, text.size());
+        }
+
+        void RequestArena::Reset()
+        {
+            ++stats_.resets;
+            const std::size_t overflow = upstream_.Bytes();
+            upstream_.ClearBytes();
+            if (overflow == 0 || initial_size_ >= max_initial_bytes_) {
+                resource_->release();
+                return;
+            }
+            // 本请求超出了初始块，扩大初始块，下一个同样大小的请求不再向堆申请
+            resource_.reset();
+            initial_size_ = std::min(max_initial_bytes_, initial_size_ + overflow);
+            initial_.reset(new char[initial_size_]);
+            resource_.emplace(initial_.get(), initial_size_, &upstream_);
+        }
+    }
+}
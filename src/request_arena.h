@@ -0,0 +1,80 @@
+/// @file request_arena.h
+/// @brief 单个请求的内存池，请求处理期间的临时数据从这里分配，请求结束时一次性释放
+/// @author Jyang.
+/// @date 2026-10-19
+/// @version 1.0
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <string_view>
+
+namespace jl {
+    namespace http {
+
+        constexpr std::size_t kDefaultArenaBytes = 2 * 1024;           // 初始块大小
+        constexpr std::size_t kMaxArenaInitialBytes = 64 * 1024;       // 初始块自动扩大的上限
+
+        /// @brief 基于 std::pmr::monotonic_buffer_resource 的请求内存池，每个连接一个，非线程安全。
+        ///        分配只移动指针，释放什么也不做，Reset 时整体回到初始块。
+        ///        某个请求用完了初始块时，Reset 把初始块扩大到能容纳该请求（不超过上限），稳定后每个请求都不再访问堆
+        class RequestArena {
+        public:
+            struct Stats {
+                std::uint64_t resets = 0;
+                std::uint64_t overflow_allocations = 0;    // 初始块用完后向堆申请的次数
+                std::uint64_t overflow_bytes = 0;
+            };
+
+            explicit RequestArena(std::size_t initial_bytes = kDefaultArenaBytes, std::size_t max_initial_bytes = kMaxArenaInitialBytes);
+
+            RequestArena(const RequestArena&) = delete;
+            RequestArena& operator=(const RequestArena&) = delete;
+
+            /// @brief 供 std::pmr 容器使用，分配的内存在 Reset 之前有效
+            std::pmr::memory_resource* Resource() { return &*resource_; }
+
+            /// @brief 把 text 复制到内存池中，返回的视图在 Reset 之前有效
+            std::string_view Copy(std::string_view text);
+
+            /// @brief 释放本请求的所有分配。之前从 Resource() 和 Copy 得到的内存全部失效
+            void Reset();
+
+            /// @brief 初始块的字节数，即空闲时每个连接常驻的内存
+            std::size_t Capacity() const { return initial_size_; }
+
+            const Stats& GetStats() const { return stats_; }
+
+        private:
+            /// @brief 初始块用完后的上游，统计本请求向堆申请的字节数
+            class Upstream : public std::pmr::memory_resource {
+            public:
+                explicit Upstream(Stats& stats) : stats_(stats), bytes_(0) {}
+
+                std::size_t Bytes() const { return bytes_; }
+                void ClearBytes() { bytes_ = 0; }
+
+            private:
+                void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+                void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+                bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+            private:
+                Stats& stats_;
+                std::size_t bytes_;     // 上次 Reset 以来申请的字节数
+            };
+
+        private:
+            Stats stats_;
+            Upstream upstream_;
+            std::unique_ptr<char[]> initial_;
+            std::size_t initial_size_;
+            const std::size_t max_initial_bytes_;
+            std::optional<std::pmr::monotonic_buffer_resource> resource_;
+        };
+    }
+}
@@ -0,0 +1,147 @@
+#include "response_cache.h"
+
+#include <http_response.h>
+
+namespace jl {
+    namespace http {
+
+        std::shared_ptr<const CachedResponse> MakeCachedResponse(int status, std::string_view content_type, std::string body, std::string_view headers)
+        {
+            auto response = std::make_shared<CachedResponse>();
+            response->status = status;
+            response->content_type.assign(content_type);
+            response->body = std::move(body);
+            ResponseWriter(response->wire)
+                .Status(status)
+                .Header("Content-Type", content_type)
+                .Date()
+                .Headers(headers)
+                .ContentLength(response->body.size())
+                .Connection(true)
+                .EndHeaders()
+                .Body(response->body);
+            return response;
+        }
+
+        ResponseCache::ResponseCache(std::vector<std::string> vary, std::size_t max_bytes, std::size_t shards) :
+            vary_(std::move(vary)),
+            shard_max_bytes_(max_bytes / (shards == 0 ? 1 : shards))
+        {
+            for (std::size_t i = 0; i < (shards == 0 ? 1 : shards); ++i) {
+                shards_.push_back(std::make_unique<Shard>());
+            }
+        }
+
+        void ResponseCache::MakeKey(const Request& request, std::string& key) const
+        {
+            key.clear();
+            key.append(request.method);
+            key.push_back(' ');
+            key.append(request.target);
+            for (const auto& name : vary_) {
+                key.push_back('\n');
+                key.append(request.GetHeader(name));
+            }
+        }
+
+        ResponseCache::LookupStatus ResponseCache::Lookup(std::string_view key, Entry& response)
+        {
+            const std::uint64_t hash = std::hash<std::string_view>()(key);
+            Shard& shard = *shards_[(hash >> 32) % shards_.size()];   // 低位留给分片内的哈希表
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto it = shard.items.find(hash);
+            if (it != shard.items.end() && it->second.key == key) {
+                if (std::chrono::steady_clock::now() < it->second.expires) {
+                    ++shard.stats.hits;
+                    shard.stats.hit_bytes += it->second.response->body.size();
+                    shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lru);
+                    response = it->second.response;
+                    return LookupStatus::kHit;
+                }
+                ++shard.stats.expired;
+                Erase(shard, it);
+            }
+            auto pending = shard.pending.find(hash);
+            if (pending != shard.pending.end()) {
+                if (pending->second.key == key) {
+                    return LookupStatus::kPending;
+                }
+                // 哈希冲突的另一个键正在生成，不合并
+                ++shard.stats.misses;
+                return LookupStatus::kMiss;
+            }
+            ++shard.stats.misses;
+            shard.pending.emplace(hash, Pending{ std::string(key), {} });
+            return LookupStatus::kMiss;
+        }
+
+        bool ResponseCache::Wait(std::string_view key, Callback callback)
+        {
+            const std::uint64_t hash = std::hash<std::string_view>()(key);
+            Shard& shard = *shards_[(hash >> 32) % shards_.size()];
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto pending = shard.pending.find(hash);
+            if (pending == shard.pending.end() || pending->second.key != key) {
+                return false;
+            }
+            ++shard.stats.coalesced;
+            pending->second.callbacks.push_back(std::move(callback));
+            return true;
+        }
+
+        void ResponseCache::Complete(std::string_view key, const Entry& response, std::chrono::milliseconds ttl)
+        {
+            const std::uint64_t hash = std::hash<std::string_view>()(key);
+            Shard& shard = *shards_[(hash >> 32) % shards_.size()];   // 低位留给分片内的哈希表
+            std::vector<Callback> callbacks;
+            {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                auto pending = shard.pending.find(hash);
+                if (pending != shard.pending.end() && pending->second.key == key) {
+                    callbacks = std::move(pending->second.callbacks);
+                    shard.pending.erase(pending);
+                }
+                if (response && ttl.count() > 0 && response->Size() <= shard_max_bytes_) {
+                    auto it = shard.items.find(hash);
+                    if (it != shard.items.end()) {
+                        Erase(shard, it);
+                    }
+                    shard.lru.push_front(hash);
+                    shard.items.emplace(hash, Item{ std::string(key), response, std::chrono::steady_clock::now() + ttl, shard.lru.begin() });
+                    shard.stats.bytes += response->Size();
+                    while (shard.stats.bytes > shard_max_bytes_) {
+                        ++shard.stats.evictions;
+                        Erase(shard, shard.items.find(shard.lru.back()));
+                    }
+                }
+            }
+            for (const auto& callback : callbacks) {
+                callback(response);
+            }
+        }
+
+        void ResponseCache::Erase(Shard& shard, std::unordered_map<std::uint64_t, Item>::iterator it)
+        {
+            shard.stats.bytes -= it->second.response->Size();
+            shard.lru.erase(it->second.lru);
+            shard.items.erase(it);
+        }
+
+        ResponseCache::Stats ResponseCache::GetStats() const
+        {
+            Stats stats;
+            for (const auto& shard : shards_) {
+                std::lock_guard<std::mutex> lock(shard->mutex);
+                stats.hits += shard->stats.hits;
+                stats.misses += shard->stats.misses;
+                stats.coalesced += shard->stats.coalesced;
+                stats.expired += shard->stats.expired;
+                stats.evictions += shard->stats.evictions;
+                stats.hit_bytes += shard->stats.hit_bytes;
+                stats.bytes += shard->stats.bytes;
+                stats.entries += shard->items.size();
+            }
+            return stats;
+        }
+    }
+}
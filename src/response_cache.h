@@ -0,0 +1,129 @@
+/// @file response_cache.h
+/// @brief 处理函数生成的响应缓存：分片 LRU，按方法、请求目标和 Vary 头部缓存，带 TTL 和容量上限；
+///        同一个键的并发未命中合并为一次处理函数调用，缓存的响应在所有连接之间共享，不复制
+/// @author Jyang.
+/// @date 2026-10-19
+/// @version 1.0
+
+#pragma once
+
+#include <http_parser.h>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace jl {
+    namespace http {
+
+        constexpr std::size_t kDefaultResponseCacheBytes = 64 * 1024 * 1024;  // 缓存的响应总字节数上限
+        constexpr std::size_t kDefaultResponseCacheShards = 16;
+
+        /// @brief 缓存的响应，创建后只读
+        struct CachedResponse {
+            int status = 200;
+            std::string content_type;
+            std::string body;
+            std::string wire;       // 序列化好的 HTTP/1.1 完整响应，Date 为生成时间，Connection: keep-alive
+
+            std::size_t Size() const { return sizeof(*this) + content_type.size() + body.size() + wire.size(); }
+        };
+
+        /// @brief 生成缓存项并序列化 wire，headers 为追加到 wire 中的其他头部行，每行以CRLF结尾（例如 Vary）
+        std::shared_ptr<const CachedResponse> MakeCachedResponse(int status, std::string_view content_type, std::string body, std::string_view headers = {});
+
+        /// @brief 与 response 共用引用计数的 wire 指针，可以直接交给 IConnection::Write 共享写出
+        inline std::shared_ptr<const std::string> SharedWire(const std::shared_ptr<const CachedResponse>& response)
+        {
+            return std::shared_ptr<const std::string>(response, &response->wire);
+        }
+
+        /// @brief 线程安全。键按哈希分到各个分片，每个分片各自加锁、各自按最近使用淘汰。
+        ///        Lookup 未命中时调用方执行处理函数并 Complete；期间同一个键的 Lookup 返回 kPending，调用方用 Wait 等待结果
+        class ResponseCache {
+        public:
+            using Entry = std::shared_ptr<const CachedResponse>;
+            /// @brief 合并的请求在 Complete 的调用线程中回调，response 为生成的响应（不可缓存时也会传递），生成失败时为 nullptr
+            using Callback = std::function<void(const Entry& response)>;
+
+            enum class LookupStatus {
+                kHit,       // response 为缓存的响应
+                kMiss,      // 调用方负责生成响应，之后必须以同一个键调用 Complete
+                kPending,   // 同一个键正在生成，调用方用 Wait 等待
+            };
+
+            struct Stats {
+                std::uint64_t hits = 0;
+                std::uint64_t misses = 0;           // 执行处理函数的次数
+                std::uint64_t coalesced = 0;        // 合并到正在生成的响应的请求
+                std::uint64_t expired = 0;          // 查找时发现已过期的项
+                std::uint64_t evictions = 0;
+                std::uint64_t hit_bytes = 0;        // 命中的响应体字节数
+                std::size_t bytes = 0;              // 当前缓存的字节数
+                std::size_t entries = 0;
+
+                /// @brief 命中率，合并的请求也没有执行处理函数，计为命中
+                double HitRatio() const
+                {
+                    const std::uint64_t total = hits + coalesced + misses;
+                    return total == 0 ? 0.0 : static_cast<double>(hits + coalesced) / total;
+                }
+            };
+
+            /// @param vary 响应随之变化的请求头部，它们的值是键的一部分
+            /// @param max_bytes 所有分片合计的字节数上限，大于一个分片容量的响应不缓存
+            explicit ResponseCache(std::vector<std::string> vary = {}, std::size_t max_bytes = kDefaultResponseCacheBytes,
+                std::size_t shards = kDefaultResponseCacheShards);
+
+            /// @brief 请求的缓存键（方法、请求目标和 vary 头部的值）写入 key，调用方复用 key 避免每个请求分配内存
+            void MakeKey(const Request& request, std::string& key) const;
+
+            /// @brief 查找响应，命中时不分配内存
+            LookupStatus Lookup(std::string_view key, Entry& response);
+
+            /// @brief Lookup 返回 kPending 后等待正在生成的响应，Complete 时回调。
+            ///        生成在两次调用之间已经结束时返回 false，调用方重新 Lookup
+            bool Wait(std::string_view key, Callback callback);
+
+            /// @brief 结束 Lookup 返回 kMiss 的生成：唤醒合并的请求，ttl 大于0且 response 不为空时写入缓存
+            void Complete(std::string_view key, const Entry& response, std::chrono::milliseconds ttl);
+
+            Stats GetStats() const;
+
+        private:
+            struct Item {
+                std::string key;
+                Entry response;
+                std::chrono::steady_clock::time_point expires;
+                std::list<std::uint64_t>::iterator lru;
+            };
+
+            struct Pending {
+                std::string key;
+                std::vector<Callback> callbacks;
+            };
+
+            struct Shard {
+                mutable std::mutex mutex;
+                std::list<std::uint64_t> lru;    // 最近使用的在前
+                std::unordered_map<std::uint64_t, Item> items;          // 以键的哈希索引，命中时再比较完整的键
+                std::unordered_map<std::uint64_t, Pending> pending;     // 正在生成的键和等待的回调
+                Stats stats;
+            };
+
+            /// @brief 移除一项，调用方需持有分片的锁
+            void Erase(Shard& shard, std::unordered_map<std::uint64_t, Item>::iterator it);
+
+        private:
+            const std::vector<std::string> vary_;
+            const std::size_t shard_max_bytes_;
+            std::vector<std::unique_ptr<Shard>> shards_;
+        };
+    }
+}
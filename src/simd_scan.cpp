@@ -0,0 +1,621 @@
+#include "simd_scan.h"
+
+#include <array>
+#include <atomic>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define JL_SIMD_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define JL_TARGET_AVX2
+#else
+#define JL_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace jl {
+    namespace simd {
+
+        namespace {
+            // RFC 9110 5.6.2 token字符
+            constexpr std::array<bool, 256> MakeTokenTable()
+            {
+                std::array<bool, 256> table{};
+                for (int c = '0'; c <= '9'; ++c) table[c] = true;
+                for (int c = 'a'; c <= 'z'; ++c) table[c] = true;
+                for (int c = 'A'; c <= 'Z'; ++c) table[c] = true;
+                for (char c : { '!', '#', '$', '%', '&', '\'', '*', '+', '-', '.', '^', '_', '`', '|', '~' }) table[static_cast<unsigned char>(c)] = true;
+                return table;
+            }
+            constexpr std::array<bool, 256> kTokenTable = MakeTokenTable();
+
+            // 头部值中不允许出现除HTAB以外的控制字符
+            constexpr std::array<bool, 256> MakeFieldValueTable()
+            {
+                std::array<bool, 256> table{};
+                for (int c = 0x20; c < 0x100; ++c) table[c] = true;
+                table['\t'] = true;
+                table[0x7f] = false;
+                return table;
+            }
+            constexpr std::array<bool, 256> kFieldValueTable = MakeFieldValueTable();
+
+            inline char ToLower(char c)
+            {
+                return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+            }
+
+            // ---------------- 标量实现 ----------------
+
+            const char* ScalarFindByte(const char* begin, const char* end, char c)
+            {
+                // libc 的 memchr 通常已经向量化
+                const void* found = begin < end ? std::memchr(begin, c, end - begin) : nullptr;
+                return found ? static_cast<const char*>(found) : end;
+            }
+
+            const char* ScalarFindSequence(const char* begin, const char* end, const char* sep, std::size_t sep_len)
+            {
+                if (sep_len == 0) {
+                    return begin;
+                }
+                if (static_cast<std::size_t>(end - begin) < sep_len) {
+                    return end;
+                }
+                const char* last = end - sep_len + 1;
+                for (const char* p = begin; (p = ScalarFindByte(p, last, sep[0])) != last; ++p) {
+                    if (std::memcmp(p, sep, sep_len) == 0) {
+                        return p;
+                    }
+                }
+                return end;
+            }
+
+            const char* ScalarFindNonToken(const char* begin, const char* end)
+            {
+                for (const char* p = begin; p < end; ++p) {
+                    if (!kTokenTable[static_cast<unsigned char>(*p)]) {
+                        return p;
+                    }
+                }
+                return end;
+            }
+
+            const char* ScalarFindNonFieldValue(const char* begin, const char* end)
+            {
+                for (const char* p = begin; p < end; ++p) {
+                    if (!kFieldValueTable[static_cast<unsigned char>(*p)]) {
+                        return p;
+                    }
+                }
+                return end;
+            }
+
+            bool ScalarEqualsNoCase(const char* a, const char* b, std::size_t n)
+            {
+                for (std::size_t i = 0; i < n; ++i) {
+                    if (ToLower(a[i]) != ToLower(b[i])) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            /// @brief 从 key_offset 开始的 4 字节掩码，向量宽度是 4 的倍数，每个向量内的掩码排列相同
+            inline std::uint32_t RotatedMask(const std::uint8_t key[4], std::size_t key_offset)
+            {
+                std::uint8_t rotated[4];
+                for (std::size_t i = 0; i < 4; ++i) {
+                    rotated[i] = key[(key_offset + i) & 3];
+                }
+                std::uint32_t mask;
+                std::memcpy(&mask, rotated, sizeof(mask));
+                return mask;
+            }
+
+            /// @brief 逐字节处理 [0, n)，pattern 为 RotatedMask 的结果
+            inline void XorMaskTail(char* data, std::size_t n, std::uint32_t pattern)
+            {
+                std::uint8_t bytes[4];
+                std::memcpy(bytes, &pattern, sizeof(bytes));
+                for (std::size_t i = 0; i < n; ++i) {
+                    data[i] = static_cast<char>(data[i] ^ bytes[i & 3]);
+                }
+            }
+
+            // 标量实现按8字节异或，异或不能像扫描那样让尾部与前一块重叠处理
+            void ScalarXorMask(char* data, std::size_t n, const std::uint8_t key[4], std::size_t key_offset)
+            {
+                const std::uint32_t pattern = RotatedMask(key, key_offset);
+                const std::uint64_t wide = (static_cast<std::uint64_t>(pattern) << 32) | pattern;
+                std::size_t i = 0;
+                for (; i + 8 <= n; i += 8) {
+                    std::uint64_t word;
+                    std::memcpy(&word, data + i, sizeof(word));
+                    word ^= wide;
+                    std::memcpy(data + i, &word, sizeof(word));
+                }
+                XorMaskTail(data + i, n - i, pattern);
+            }
+
+#ifdef JL_SIMD_X86
+            inline unsigned CountTrailingZeros(unsigned mask)
+            {
+#ifdef _MSC_VER
+                unsigned long index;
+                _BitScanForward(&index, mask);
+                return index;
+#else
+                return __builtin_ctz(mask);
+#endif
+            }
+
+            // ---------------- SSE2 实现，每次处理16字节 ----------------
+            // 长度不足一个向量时使用标量实现；最后一块与前一块重叠加载，重叠部分已确认没有匹配，不会改变结果，
+            // 这样AVX2实现中也不需要切换回非VEX编码的SSE指令处理尾部
+
+            /// @brief 无符号比较 lo <= x <= hi
+            inline __m128i InRange128(__m128i x, char lo, char hi)
+            {
+                __m128i offset = _mm_sub_epi8(x, _mm_set1_epi8(lo));
+                return _mm_cmpeq_epi8(_mm_subs_epu8(offset, _mm_set1_epi8(static_cast<char>(hi - lo))), _mm_setzero_si128());
+            }
+
+            inline __m128i ToLower128(__m128i x)
+            {
+                return _mm_or_si128(x, _mm_and_si128(InRange128(x, 'A', 'Z'), _mm_set1_epi8(0x20)));
+            }
+
+            /// @brief 字母、数字和'-'的掩码，token中其他符号较少见，由调用方逐字节查表
+            inline unsigned CommonTokenMask128(__m128i x)
+            {
+                __m128i alpha = InRange128(_mm_or_si128(x, _mm_set1_epi8(0x20)), 'a', 'z');
+                __m128i digit = InRange128(x, '0', '9');
+                __m128i dash = _mm_cmpeq_epi8(x, _mm_set1_epi8('-'));
+                return static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(alpha, digit), dash)));
+            }
+
+            /// @brief 除HTAB以外的控制字符的掩码
+            inline unsigned InvalidFieldValueMask128(__m128i x)
+            {
+                __m128i control = _mm_cmpeq_epi8(_mm_subs_epu8(x, _mm_set1_epi8(0x1f)), _mm_setzero_si128());
+                __m128i tab = _mm_cmpeq_epi8(x, _mm_set1_epi8('\t'));
+                __m128i del = _mm_cmpeq_epi8(x, _mm_set1_epi8(0x7f));
+                return static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(_mm_andnot_si128(tab, control), del)));
+            }
+
+            inline __m128i Load128(const char* p)
+            {
+                return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            }
+
+            const char* SSE2FindByte(const char* begin, const char* end, char c)
+            {
+                if (end - begin < 16) {
+                    return ScalarFindByte(begin, end, c);
+                }
+                const __m128i needle = _mm_set1_epi8(c);
+                const char* p = begin;
+                // 每次检查64字节，有匹配时交给下面的循环定位
+                for (; end - p >= 64; p += 64) {
+                    __m128i any = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(Load128(p), needle), _mm_cmpeq_epi8(Load128(p + 16), needle)),
+                        _mm_or_si128(_mm_cmpeq_epi8(Load128(p + 32), needle), _mm_cmpeq_epi8(Load128(p + 48), needle)));
+                    if (_mm_movemask_epi8(any)) {
+                        break;
+                    }
+                }
+                for (; ; p += 16) {
+                    p = end - p < 16 ? end - 16 : p;
+                    unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(Load128(p), needle));
+                    if (mask) {
+                        return p + CountTrailingZeros(mask);
+                    }
+                    if (p + 16 == end) {
+                        return end;
+                    }
+                }
+            }
+
+            /// @brief 同时比较候选位置的首字节和尾字节，两者都相等时再比较中间部分
+            const char* SSE2FindSequence(const char* begin, const char* end, const char* sep, std::size_t sep_len)
+            {
+                if (sep_len <= 1) {
+                    return sep_len == 0 ? begin : SSE2FindByte(begin, end, sep[0]);
+                }
+                const std::ptrdiff_t window = 16 + sep_len - 1;
+                if (end - begin < window) {
+                    return ScalarFindSequence(begin, end, sep, sep_len);
+                }
+                const __m128i first = _mm_set1_epi8(sep[0]);
+                const __m128i last = _mm_set1_epi8(sep[sep_len - 1]);
+                const char* p = begin;
+                for (; end - p >= window + 48; p += 64) {
+                    __m128i any = _mm_setzero_si128();
+                    for (int i = 0; i < 64; i += 16) {
+                        any = _mm_or_si128(any, _mm_and_si128(_mm_cmpeq_epi8(Load128(p + i), first), _mm_cmpeq_epi8(Load128(p + i + sep_len - 1), last)));
+                    }
+                    if (_mm_movemask_epi8(any)) {
+                        break;
+                    }
+                }
+                for (; ; p += 16) {
+                    p = end - p < window ? end - window : p;
+                    unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(Load128(p), first), _mm_cmpeq_epi8(Load128(p + sep_len - 1), last)));
+                    while (mask) {
+                        const char* candidate = p + CountTrailingZeros(mask);
+                        if (std::memcmp(candidate + 1, sep + 1, sep_len - 2) == 0) {
+                            return candidate;
+                        }
+                        mask &= mask - 1;
+                    }
+                    if (p + window == end) {
+                        return end;
+                    }
+                }
+            }
+
+            const char* SSE2FindNonToken(const char* begin, const char* end)
+            {
+                if (end - begin < 16) {
+                    return ScalarFindNonToken(begin, end);
+                }
+                for (const char* p = begin; ; p += 16) {
+                    p = end - p < 16 ? end - 16 : p;
+                    unsigned mask = ~CommonTokenMask128(Load128(p)) & 0xffffu;
+                    if (mask) {
+                        const char* bad = ScalarFindNonToken(p + CountTrailingZeros(mask), p + 16);
+                        if (bad != p + 16) {
+                            return bad;
+                        }
+                    }
+                    if (p + 16 == end) {
+                        return end;
+                    }
+                }
+            }
+
+            const char* SSE2FindNonFieldValue(const char* begin, const char* end)
+            {
+                if (end - begin < 16) {
+                    return ScalarFindNonFieldValue(begin, end);
+                }
+                for (const char* p = begin; ; p += 16) {
+                    p = end - p < 16 ? end - 16 : p;
+                    unsigned mask = InvalidFieldValueMask128(Load128(p));
+                    if (mask) {
+                        return p + CountTrailingZeros(mask);
+                    }
+                    if (p + 16 == end) {
+                        return end;
+                    }
+                }
+            }
+
+            bool SSE2EqualsNoCase(const char* a, const char* b, std::size_t n)
+            {
+                if (n < 16) {
+                    return ScalarEqualsNoCase(a, b, n);
+                }
+                for (std::size_t i = 0; ; i += 16) {
+                    i = n - i < 16 ? n - 16 : i;
+                    if (_mm_movemask_epi8(_mm_cmpeq_epi8(ToLower128(Load128(a + i)), ToLower128(Load128(b + i)))) != 0xffff) {
+                        return false;
+                    }
+                    if (i + 16 == n) {
+                        return true;
+                    }
+                }
+            }
+
+            void SSE2XorMask(char* data, std::size_t n, const std::uint8_t key[4], std::size_t key_offset)
+            {
+                const std::uint32_t pattern = RotatedMask(key, key_offset);
+                const __m128i mask = _mm_set1_epi32(static_cast<int>(pattern));
+                std::size_t i = 0;
+                for (; i + 64 <= n; i += 64) {
+                    __m128i* p = reinterpret_cast<__m128i*>(data + i);
+                    _mm_storeu_si128(p, _mm_xor_si128(_mm_loadu_si128(p), mask));
+                    _mm_storeu_si128(p + 1, _mm_xor_si128(_mm_loadu_si128(p + 1), mask));
+                    _mm_storeu_si128(p + 2, _mm_xor_si128(_mm_loadu_si128(p + 2), mask));
+                    _mm_storeu_si128(p + 3, _mm_xor_si128(_mm_loadu_si128(p + 3), mask));
+                }
+                for (; i + 16 <= n; i += 16) {
+                    __m128i* p = reinterpret_cast<__m128i*>(data + i);
+                    _mm_storeu_si128(p, _mm_xor_si128(_mm_loadu_si128(p), mask));
+                }
+                XorMaskTail(data + i, n - i, pattern);
+            }
+
+            // ---------------- AVX2 实现，每次处理32字节，不足32字节时交给SSE2实现 ----------------
+
+            JL_TARGET_AVX2 inline __m256i InRange256(__m256i x, char lo, char hi)
+            {
+                __m256i offset = _mm256_sub_epi8(x, _mm256_set1_epi8(lo));
+                return _mm256_cmpeq_epi8(_mm256_subs_epu8(offset, _mm256_set1_epi8(static_cast<char>(hi - lo))), _mm256_setzero_si256());
+            }
+
+            JL_TARGET_AVX2 inline __m256i ToLower256(__m256i x)
+            {
+                return _mm256_or_si256(x, _mm256_and_si256(InRange256(x, 'A', 'Z'), _mm256_set1_epi8(0x20)));
+            }
+
+            JL_TARGET_AVX2 inline unsigned CommonTokenMask256(__m256i x)
+            {
+                __m256i alpha = InRange256(_mm256_or_si256(x, _mm256_set1_epi8(0x20)), 'a', 'z');
+                __m256i digit = InRange256(x, '0', '9');
+                __m256i dash = _mm256_cmpeq_epi8(x, _mm256_set1_epi8('-'));
+                return static_cast<unsigned>(_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(alpha, digit), dash)));
+            }
+
+            JL_TARGET_AVX2 inline unsigned InvalidFieldValueMask256(__m256i x)
+            {
+                __m256i control = _mm256_cmpeq_epi8(_mm256_subs_epu8(x, _mm256_set1_epi8(0x1f)), _mm256_setzero_si256());
+                __m256i tab = _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\t'));
+                __m256i del = _mm256_cmpeq_epi8(x, _mm256_set1_epi8(0x7f));
+                return static_cast<unsigned>(_mm256_movemask_epi8(_mm256_or_si256(_mm256_andnot_si256(tab, control), del)));
+            }
+
+            JL_TARGET_AVX2 inline __m256i Load256(const char* p)
+            {
+                return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            }
+
+            JL_TARGET_AVX2 const char* AVX2FindByte(const char* begin, const char* end, char c)
+            {
+                if (end - begin < 32) {
+                    return SSE2FindByte(begin, end, c);
+                }
+                const __m256i needle = _mm256_set1_epi8(c);
+                const char* p = begin;
+                for (; end - p >= 128; p += 128) {
+                    __m256i any = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(Load256(p), needle), _mm256_cmpeq_epi8(Load256(p + 32), needle)),
+                        _mm256_or_si256(_mm256_cmpeq_epi8(Load256(p + 64), needle), _mm256_cmpeq_epi8(Load256(p + 96), needle)));
+                    if (!_mm256_testz_si256(any, any)) {
+                        break;
+                    }
+                }
+                for (; ; p += 32) {
+                    p = end - p < 32 ? end - 32 : p;
+                    unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(Load256(p), needle)));
+                    if (mask) {
+                        return p + CountTrailingZeros(mask);
+                    }
+                    if (p + 32 == end) {
+                        return end;
+                    }
+                }
+            }
+
+            JL_TARGET_AVX2 const char* AVX2FindSequence(const char* begin, const char* end, const char* sep, std::size_t sep_len)
+            {
+                const std::ptrdiff_t window = 32 + sep_len - 1;
+                if (sep_len <= 1 || end - begin < window) {
+                    return SSE2FindSequence(begin, end, sep, sep_len);
+                }
+                const __m256i first = _mm256_set1_epi8(sep[0]);
+                const __m256i last = _mm256_set1_epi8(sep[sep_len - 1]);
+                const char* p = begin;
+                for (; end - p >= window + 96; p += 128) {
+                    __m256i any = _mm256_setzero_si256();
+                    for (int i = 0; i < 128; i += 32) {
+                        any = _mm256_or_si256(any, _mm256_and_si256(_mm256_cmpeq_epi8(Load256(p + i), first), _mm256_cmpeq_epi8(Load256(p + i + sep_len - 1), last)));
+                    }
+                    if (!_mm256_testz_si256(any, any)) {
+                        break;
+                    }
+                }
+                for (; ; p += 32) {
+                    p = end - p < window ? end - window : p;
+                    unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(Load256(p), first), _mm256_cmpeq_epi8(Load256(p + sep_len - 1), last))));
+                    while (mask) {
+                        const char* candidate = p + CountTrailingZeros(mask);
+                        if (std::memcmp(candidate + 1, sep + 1, sep_len - 2) == 0) {
+                            return candidate;
+                        }
+                        mask &= mask - 1;
+                    }
+                    if (p + window == end) {
+                        return end;
+                    }
+                }
+            }
+
+            JL_TARGET_AVX2 const char* AVX2FindNonToken(const char* begin, const char* end)
+            {
+                if (end - begin < 32) {
+                    return SSE2FindNonToken(begin, end);
+                }
+                for (const char* p = begin; ; p += 32) {
+                    p = end - p < 32 ? end - 32 : p;
+                    unsigned mask = ~CommonTokenMask256(Load256(p));
+                    if (mask) {
+                        const char* bad = ScalarFindNonToken(p + CountTrailingZeros(mask), p + 32);
+                        if (bad != p + 32) {
+                            return bad;
+                        }
+                    }
+                    if (p + 32 == end) {
+                        return end;
+                    }
+                }
+            }
+
+            JL_TARGET_AVX2 const char* AVX2FindNonFieldValue(const char* begin, const char* end)
+            {
+                if (end - begin < 32) {
+                    return SSE2FindNonFieldValue(begin, end);
+                }
+                for (const char* p = begin; ; p += 32) {
+                    p = end - p < 32 ? end - 32 : p;
+                    unsigned mask = InvalidFieldValueMask256(Load256(p));
+                    if (mask) {
+                        return p + CountTrailingZeros(mask);
+                    }
+                    if (p + 32 == end) {
+                        return end;
+                    }
+                }
+            }
+
+            JL_TARGET_AVX2 bool AVX2EqualsNoCase(const char* a, const char* b, std::size_t n)
+            {
+                if (n < 32) {
+                    return SSE2EqualsNoCase(a, b, n);
+                }
+                for (std::size_t i = 0; ; i += 32) {
+                    i = n - i < 32 ? n - 32 : i;
+                    if (static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(ToLower256(Load256(a + i)), ToLower256(Load256(b + i))))) != 0xffffffffu) {
+                        return false;
+                    }
+                    if (i + 32 == n) {
+                        return true;
+                    }
+                }
+            }
+
+            JL_TARGET_AVX2 void AVX2XorMask(char* data, std::size_t n, const std::uint8_t key[4], std::size_t key_offset)
+            {
+                if (n < 32) {
+                    ScalarXorMask(data, n, key, key_offset);
+                    return;
+                }
+                const std::uint32_t pattern = RotatedMask(key, key_offset);
+                const __m256i mask = _mm256_set1_epi32(static_cast<int>(pattern));
+                std::size_t i = 0;
+                for (; i + 128 <= n; i += 128) {
+                    __m256i* p = reinterpret_cast<__m256i*>(data + i);
+                    _mm256_storeu_si256(p, _mm256_xor_si256(_mm256_loadu_si256(p), mask));
+                    _mm256_storeu_si256(p + 1, _mm256_xor_si256(_mm256_loadu_si256(p + 1), mask));
+                    _mm256_storeu_si256(p + 2, _mm256_xor_si256(_mm256_loadu_si256(p + 2), mask));
+                    _mm256_storeu_si256(p + 3, _mm256_xor_si256(_mm256_loadu_si256(p + 3), mask));
+                }
+                for (; i + 32 <= n; i += 32) {
+                    __m256i* p = reinterpret_cast<__m256i*>(data + i);
+                    _mm256_storeu_si256(p, _mm256_xor_si256(_mm256_loadu_si256(p), mask));
+                }
+                // 剩余不足32字节，用标量实现避免切换到非VEX编码的SSE指令
+                ScalarXorMask(data + i, n - i, key, key_offset + i);
+            }
+
+            bool CpuHasAVX2()
+            {
+#ifdef _MSC_VER
+                int info[4];
+                __cpuid(info, 1);
+                bool os_avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 0x6) == 0x6; // OSXSAVE、AVX、YMM状态已启用
+                if (!os_avx) {
+                    return false;
+                }
+                __cpuidex(info, 7, 0);
+                return (info[1] & (1 << 5)) != 0;
+#else
+                return __builtin_cpu_supports("avx2");
+#endif
+            }
+#endif // JL_SIMD_X86
+
+            struct Functions {
+                Level level;
+                const char* (*find_byte)(const char*, const char*, char);
+                const char* (*find_sequence)(const char*, const char*, const char*, std::size_t);
+                const char* (*find_non_token)(const char*, const char*);
+                const char* (*find_non_field_value)(const char*, const char*);
+                bool (*equals_no_case)(const char*, const char*, std::size_t);
+                void (*xor_mask)(char*, std::size_t, const std::uint8_t*, std::size_t);
+            };
+
+            constexpr Functions kScalar{ Level::kScalar, ScalarFindByte, ScalarFindSequence, ScalarFindNonToken, ScalarFindNonFieldValue, ScalarEqualsNoCase, ScalarXorMask };
+#ifdef JL_SIMD_X86
+            constexpr Functions kSSE2{ Level::kSSE2, SSE2FindByte, SSE2FindSequence, SSE2FindNonToken, SSE2FindNonFieldValue, SSE2EqualsNoCase, SSE2XorMask };
+            constexpr Functions kAVX2{ Level::kAVX2, AVX2FindByte, AVX2FindSequence, AVX2FindNonToken, AVX2FindNonFieldValue, AVX2EqualsNoCase, AVX2XorMask };
+#endif
+
+            const Functions* GetFunctions(Level level)
+            {
+                switch (level) {
+#ifdef JL_SIMD_X86
+                case Level::kAVX2: return &kAVX2;
+                case Level::kSSE2: return &kSSE2;
+#endif
+                default: return &kScalar;
+                }
+            }
+
+            std::atomic<const Functions*>& Active()
+            {
+                static std::atomic<const Functions*> functions(GetFunctions(SupportedLevel()));
+                return functions;
+            }
+
+            inline const Functions& Current()
+            {
+                return *Active().load(std::memory_order_relaxed);
+            }
+        }
+
+        Level SupportedLevel()
+        {
+#ifdef JL_SIMD_X86
+            static const Level level = CpuHasAVX2() ? Level::kAVX2 : Level::kSSE2; // x86-64 必定支持SSE2
+            return level;
+#else
+            return Level::kScalar;
+#endif
+        }
+
+        Level ActiveLevel()
+        {
+            return Current().level;
+        }
+
+        Level SetLevel(Level level)
+        {
+            if (static_cast<int>(level) > static_cast<int>(SupportedLevel())) {
+                level = SupportedLevel();
+            }
+            Active().store(GetFunctions(level), std::memory_order_relaxed);
+            return level;
+        }
+
+        const char* LevelName(Level level)
+        {
+            switch (level) {
+            case Level::kSSE2: return "SSE2";
+            case Level::kAVX2: return "AVX2";
+            default: return "scalar";
+            }
+        }
+
+        const char* FindByte(const char* begin, const char* end, char c)
+        {
+            return Current().find_byte(begin, end, c);
+        }
+
+        const char* FindSequence(const char* begin, const char* end, const char* sep, std::size_t sep_len)
+        {
+            return Current().find_sequence(begin, end, sep, sep_len);
+        }
+
+        const char* FindNonToken(const char* begin, const char* end)
+        {
+            return Current().find_non_token(begin, end);
+        }
+
+        const char* FindNonFieldValue(const char* begin, const char* end)
+        {
+            return Current().find_non_field_value(begin, end);
+        }
+
+        bool EqualsNoCase(const char* a, const char* b, std::size_t n)
+        {
+            return Current().equals_no_case(a, b, n);
+        }
+
+        void XorMask(char* data, std::size_t n, const std::uint8_t key[4], std::size_t key_offset)
+        {
+            Current().xor_mask(data, n, key, key_offset);
+        }
+    }
+}
@@ -0,0 +1,53 @@
+/// @file simd_scan.h
+/// @brief 向量化字节扫描：分隔符查找、HTTP token/头部值校验、不区分大小写比较，以及 WebSocket 掩码异或。
+///        x86 上提供 SSE2/AVX2 实现，首次调用时按CPU能力选择，其他平台使用标量实现
+/// @author Jyang.
+/// @date 2026-10-19
+/// @version 1.0
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace jl {
+    namespace simd {
+
+        enum class Level {
+            kScalar,
+            kSSE2,
+            kAVX2,
+        };
+
+        /// @brief 当前CPU支持的最高级别
+        Level SupportedLevel();
+
+        /// @brief 当前使用的级别
+        Level ActiveLevel();
+
+        /// @brief 指定使用的级别（用于测试和基准对比），超过 SupportedLevel() 时取 SupportedLevel()
+        /// @return 实际使用的级别
+        Level SetLevel(Level level);
+
+        const char* LevelName(Level level);
+
+        /// @brief 查找字节 c，不存在时返回 end
+        const char* FindByte(const char* begin, const char* end, char c);
+
+        /// @brief 查找字节序列 [sep, sep + sep_len) 第一次出现的位置，不存在时返回 end
+        const char* FindSequence(const char* begin, const char* end, const char* sep, std::size_t sep_len);
+
+        /// @brief 查找第一个不是 token 字符(RFC 9110 5.6.2)的字节，全部合法时返回 end
+        const char* FindNonToken(const char* begin, const char* end);
+
+        /// @brief 查找第一个不能出现在头部值中的字节（除HTAB以外的控制字符），全部合法时返回 end
+        const char* FindNonFieldValue(const char* begin, const char* end);
+
+        /// @brief ASCII 不区分大小写比较 n 个字节
+        bool EqualsNoCase(const char* a, const char* b, std::size_t n);
+
+        /// @brief 原地异或 4 字节循环掩码：data[i] ^= key[(key_offset + i) % 4]（RFC 6455 5.3），掩码和去掩码是同一操作
+        /// @param key_offset data[0] 在整个负载中的位置，负载分段处理时传入已处理的字节数
+        void XorMask(char* data, std::size_t n, const std::uint8_t key[4], std::size_t key_offset = 0);
+    }
+}
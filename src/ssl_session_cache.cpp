@@ -0,0 +1,297 @@
+#include "ssl_session_cache.h"
+
+#ifdef ENABLE_OPENSSL
+
+#include <logger.h>
+
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+namespace jl {
+
+    namespace {
+        int SessionCacheIndex()
+        {
+            static int index = SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+            return index;
+        }
+
+        int TicketKeysIndex()
+        {
+            static int index = SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+            return index;
+        }
+
+        std::string SessionId(SSL_SESSION* session)
+        {
+            unsigned int len = 0;
+            const unsigned char* id = SSL_SESSION_get_id(session, &len);
+            return std::string(reinterpret_cast<const char*>(id), len);
+        }
+    }
+
+    SSLSessionCache::SSLSessionCache(std::size_t capacity, std::chrono::seconds ttl, std::size_t shards) :
+        shard_capacity_(std::max<std::size_t>(1, capacity / std::max<std::size_t>(1, shards))),
+        ttl_(ttl),
+        hits_(0),
+        misses_(0),
+        evictions_(0),
+        size_(0)
+    {
+        shards = std::max<std::size_t>(1, shards);
+        for (std::size_t i = 0; i < shards; ++i) {
+            shards_.emplace_back(std::make_unique<Shard>());
+        }
+    }
+
+    void SSLSessionCache::Attach(SSL_CTX* ctx)
+    {
+        SSL_CTX_set_ex_data(ctx, SessionCacheIndex(), this);
+        SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER | SSL_SESS_CACHE_NO_INTERNAL);
+        SSL_CTX_set_timeout(ctx, static_cast<long>(ttl_.count()));
+        SSL_CTX_sess_set_new_cb(ctx, &SSLSessionCache::OnNewSession);
+        SSL_CTX_sess_set_get_cb(ctx, &SSLSessionCache::OnGetSession);
+        SSL_CTX_sess_set_remove_cb(ctx, &SSLSessionCache::OnRemoveSession);
+    }
+
+    SSLSessionCache::Stats SSLSessionCache::GetStats() const
+    {
+        return Stats{ hits_.load(), misses_.load(), evictions_.load(), size_.load() };
+    }
+
+    SSLSessionCache::Shard& SSLSessionCache::ShardOf(const std::string& id)
+    {
+        return *shards_[std::hash<std::string>()(id) % shards_.size()];
+    }
+
+    void SSLSessionCache::Put(SSL_SESSION* session)
+    {
+        std::string id = SessionId(session);
+        int len = i2d_SSL_SESSION(session, nullptr);
+        if (id.empty() || len <= 0) {
+            return;
+        }
+        std::string der(static_cast<std::size_t>(len), '\0');
+        unsigned char* p = reinterpret_cast<unsigned char*>(&der[0]);
+        i2d_SSL_SESSION(session, &p);
+
+        Shard& shard = ShardOf(id);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.entries.find(id);
+        if (it != shard.entries.end()) {
+            shard.lru.erase(it->second.lru_it);
+            shard.entries.erase(it);
+            --size_;
+        }
+        while (shard.entries.size() >= shard_capacity_) { // 淘汰最久未使用
+            shard.entries.erase(shard.lru.back());
+            shard.lru.pop_back();
+            --size_;
+            ++evictions_;
+        }
+        shard.lru.emplace_front(id);
+        shard.entries.emplace(std::move(id), Entry{ std::move(der), std::chrono::steady_clock::now() + ttl_, shard.lru.begin() });
+        ++size_;
+    }
+
+    SSL_SESSION* SSLSessionCache::Get(const unsigned char* id, int len)
+    {
+        std::string key(reinterpret_cast<const char*>(id), static_cast<std::size_t>(len));
+        Shard& shard = ShardOf(key);
+        std::string der;
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto it = shard.entries.find(key);
+            if (it == shard.entries.end()) {
+                ++misses_;
+                return nullptr;
+            }
+            if (it->second.expire <= std::chrono::steady_clock::now()) {
+                shard.lru.erase(it->second.lru_it);
+                shard.entries.erase(it);
+                --size_;
+                ++misses_;
+                return nullptr;
+            }
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lru_it);
+            der = it->second.der;
+        }
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(der.data());
+        SSL_SESSION* session = d2i_SSL_SESSION(nullptr, &p, static_cast<long>(der.size()));
+        session ? ++hits_ : ++misses_;
+        return session;
+    }
+
+    void SSLSessionCache::Remove(SSL_SESSION* session)
+    {
+        std::string id = SessionId(session);
+        Shard& shard = ShardOf(id);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.entries.find(id);
+        if (it != shard.entries.end()) {
+            shard.lru.erase(it->second.lru_it);
+            shard.entries.erase(it);
+            --size_;
+        }
+    }
+
+    int SSLSessionCache::OnNewSession(SSL* ssl, SSL_SESSION* session)
+    {
+        auto* cache = static_cast<SSLSessionCache*>(SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), SessionCacheIndex()));
+        if (cache) {
+            cache->Put(session);
+        }
+        return 0; // 不持有session引用
+    }
+
+    SSL_SESSION* SSLSessionCache::OnGetSession(SSL* ssl, const unsigned char* id, int len, int* copy)
+    {
+        *copy = 0; // 新反序列化的session，引用计数直接交给OpenSSL
+        auto* cache = static_cast<SSLSessionCache*>(SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), SessionCacheIndex()));
+        return cache ? cache->Get(id, len) : nullptr;
+    }
+
+    void SSLSessionCache::OnRemoveSession(SSL_CTX* ctx, SSL_SESSION* session)
+    {
+        auto* cache = static_cast<SSLSessionCache*>(SSL_CTX_get_ex_data(ctx, SessionCacheIndex()));
+        if (cache) {
+            cache->Remove(session);
+        }
+    }
+
+    SSLTicketKeys::SSLTicketKeys(std::chrono::seconds rotate_interval, std::size_t keep) :
+        rotate_interval_(rotate_interval),
+        keep_(keep)
+    {
+        keys_.emplace_back(NewKey());
+    }
+
+    void SSLTicketKeys::Attach(SSL_CTX* ctx)
+    {
+        SSL_CTX_set_ex_data(ctx, TicketKeysIndex(), this);
+        SSL_CTX_clear_options(ctx, SSL_OP_NO_TICKET);
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+        SSL_CTX_set_tlsext_ticket_key_evp_cb(ctx, &SSLTicketKeys::OnTicketKey);
+#else
+        SSL_CTX_set_tlsext_ticket_key_cb(ctx, &SSLTicketKeys::OnTicketKey);
+#endif
+    }
+
+    void SSLTicketKeys::Rotate()
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        PushKey(NewKey());
+    }
+
+    SSLTicketKeys::Key SSLTicketKeys::NewKey()
+    {
+        Key key;
+        if (RAND_bytes(key.name.data(), static_cast<int>(key.name.size())) != 1 ||
+            RAND_bytes(key.aes_key.data(), static_cast<int>(key.aes_key.size())) != 1 ||
+            RAND_bytes(key.hmac_key.data(), static_cast<int>(key.hmac_key.size())) != 1) {
+            throw std::runtime_error("RAND_bytes failed when generating session ticket key");
+        }
+        key.created = std::chrono::steady_clock::now();
+        return key;
+    }
+
+    void SSLTicketKeys::RotateIfNeeded()
+    {
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            if (std::chrono::steady_clock::now() - keys_.front().created < rotate_interval_) {
+                return;
+            }
+        }
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        if (std::chrono::steady_clock::now() - keys_.front().created < rotate_interval_) {
+            return; // 其他线程已经轮换
+        }
+        PushKey(NewKey());
+    }
+
+    void SSLTicketKeys::PushKey(const Key& key)
+    {
+        keys_.insert(keys_.begin(), key);
+        if (keys_.size() > keep_ + 1) {
+            keys_.resize(keep_ + 1);
+        }
+        LOG_INFO("session ticket key rotated, {} keys active.", keys_.size());
+    }
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    int SSLTicketKeys::OnTicketKey(SSL* ssl, unsigned char key_name[16], unsigned char* iv,
+        EVP_CIPHER_CTX* cipher_ctx, EVP_MAC_CTX* mac_ctx, int enc)
+#else
+    int SSLTicketKeys::OnTicketKey(SSL* ssl, unsigned char key_name[16], unsigned char* iv,
+        EVP_CIPHER_CTX* cipher_ctx, HMAC_CTX* hmac_ctx, int enc)
+#endif
+    {
+        auto* self = static_cast<SSLTicketKeys*>(SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), TicketKeysIndex()));
+        if (!self) {
+            return -1;
+        }
+        try {
+            self->RotateIfNeeded();
+        }
+        catch (const std::exception& err) { // 不能让异常穿过OpenSSL的C回调
+            LOG_ERROR("session ticket key rotate fail: {}", err.what());
+            return -1;
+        }
+
+        std::shared_lock<std::shared_mutex> lock(self->mutex_);
+        const Key* key = nullptr;
+        bool is_current = true;
+        if (enc) { // 签发新ticket
+            key = &self->keys_.front();
+            if (RAND_bytes(iv, EVP_CIPHER_iv_length(EVP_aes_256_cbc())) != 1) {
+                return -1;
+            }
+            std::memcpy(key_name, key->name.data(), key->name.size());
+            if (EVP_EncryptInit_ex(cipher_ctx, EVP_aes_256_cbc(), nullptr, key->aes_key.data(), iv) != 1) {
+                return -1;
+            }
+        }
+        else { // 解密客户端带来的ticket
+            for (std::size_t i = 0; i < self->keys_.size(); ++i) {
+                if (std::memcmp(key_name, self->keys_[i].name.data(), self->keys_[i].name.size()) == 0) {
+                    key = &self->keys_[i];
+                    is_current = (i == 0);
+                    break;
+                }
+            }
+            if (!key) {
+                return 0; // 未知或已过期的密钥，走完整握手
+            }
+            if (EVP_DecryptInit_ex(cipher_ctx, EVP_aes_256_cbc(), nullptr, key->aes_key.data(), iv) != 1) {
+                return -1;
+            }
+        }
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+        char digest[] = "SHA256";
+        OSSL_PARAM params[] = {
+            OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, const_cast<unsigned char*>(key->hmac_key.data()), key->hmac_key.size()),
+            OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, digest, 0),
+            OSSL_PARAM_construct_end()
+        };
+        if (EVP_MAC_CTX_set_params(mac_ctx, params) != 1) {
+            return -1;
+        }
+#else
+        if (HMAC_Init_ex(hmac_ctx, key->hmac_key.data(), static_cast<int>(key->hmac_key.size()), EVP_sha256(), nullptr) != 1) {
+            return -1;
+        }
+#endif
+        return is_current ? 1 : 2; // 2: 旧密钥解密成功，要求签发新ticket
+    }
+}
+
+#endif // ENABLE_OPENSSL
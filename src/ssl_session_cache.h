@@ -0,0 +1,130 @@
+/// @file ssl_session_cache.h
+/// @brief TLS会话复用：服务端session缓存 + 轮换的session ticket密钥
+/// @author Jyang.
+/// @date 2026-10-19
+/// @version 1.0
+
+#pragma once
+
+#ifdef ENABLE_OPENSSL
+
+#include <openssl/ssl.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace jl {
+
+    /// @brief 服务端session缓存，替代OpenSSL内置缓存（内置缓存只有一把全局锁）。
+    ///        按session id分片，每个分片独立加锁、按LRU淘汰，条目超过TTL后视为未命中。
+    ///        缓存中保存的是序列化后的session，不持有SSL_SESSION引用。
+    class SSLSessionCache {
+    public:
+        struct Stats {
+            std::uint64_t hits;
+            std::uint64_t misses;
+            std::uint64_t evictions;
+            std::uint64_t size;
+        };
+
+        /// @param capacity 最大条目数（所有分片合计）
+        /// @param ttl 条目有效期
+        /// @param shards 分片数
+        SSLSessionCache(std::size_t capacity, std::chrono::seconds ttl, std::size_t shards = 16);
+
+        /// @brief 安装到SSL_CTX：关闭内置缓存，设置new/get/remove回调和session超时时间
+        void Attach(SSL_CTX* ctx);
+
+        Stats GetStats() const;
+
+    private:
+        struct Entry {
+            std::string der;
+            std::chrono::steady_clock::time_point expire;
+            std::list<std::string>::iterator lru_it;
+        };
+
+        struct Shard {
+            std::mutex mutex;
+            std::list<std::string> lru; // 头部为最近使用
+            std::unordered_map<std::string, Entry> entries;
+        };
+
+        Shard& ShardOf(const std::string& id);
+
+        void Put(SSL_SESSION* session);
+
+        SSL_SESSION* Get(const unsigned char* id, int len);
+
+        void Remove(SSL_SESSION* session);
+
+        static int OnNewSession(SSL* ssl, SSL_SESSION* session);
+
+        static SSL_SESSION* OnGetSession(SSL* ssl, const unsigned char* id, int len, int* copy);
+
+        static void OnRemoveSession(SSL_CTX* ctx, SSL_SESSION* session);
+
+    private:
+        const std::size_t shard_capacity_;
+        const std::chrono::seconds ttl_;
+        std::vector<std::unique_ptr<Shard>> shards_;
+        std::atomic<std::uint64_t> hits_;
+        std::atomic<std::uint64_t> misses_;
+        std::atomic<std::uint64_t> evictions_;
+        std::atomic<std::uint64_t> size_;
+    };
+
+    /// @brief session ticket密钥，按固定间隔轮换。
+    ///        新ticket总是用当前密钥加密；之前的密钥在保留期内仍可解密，解密成功后要求客户端换成新ticket。
+    class SSLTicketKeys {
+    public:
+        /// @param rotate_interval 轮换间隔
+        /// @param keep 除当前密钥外保留的旧密钥个数
+        SSLTicketKeys(std::chrono::seconds rotate_interval, std::size_t keep = 2);
+
+        /// @brief 安装到SSL_CTX的ticket密钥回调
+        void Attach(SSL_CTX* ctx);
+
+        /// @brief 立即轮换一次（例如收到外部下发的轮换指令）
+        void Rotate();
+
+    private:
+        struct Key {
+            std::array<unsigned char, 16> name;
+            std::array<unsigned char, 32> aes_key;
+            std::array<unsigned char, 32> hmac_key;
+            std::chrono::steady_clock::time_point created;
+        };
+
+        static Key NewKey();
+
+        void RotateIfNeeded();
+
+        /// @brief 插入新的当前密钥并丢弃超出保留个数的旧密钥，调用方持有写锁
+        void PushKey(const Key& key);
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+        static int OnTicketKey(SSL* ssl, unsigned char key_name[16], unsigned char* iv,
+            EVP_CIPHER_CTX* cipher_ctx, EVP_MAC_CTX* mac_ctx, int enc);
+#else
+        static int OnTicketKey(SSL* ssl, unsigned char key_name[16], unsigned char* iv,
+            EVP_CIPHER_CTX* cipher_ctx, HMAC_CTX* hmac_ctx, int enc);
+#endif
+
+    private:
+        const std::chrono::seconds rotate_interval_;
+        const std::size_t keep_;
+        std::shared_mutex mutex_;
+        std::vector<Key> keys_; // keys_[0] 为当前密钥
+    };
+}
+
+#endif // ENABLE_OPENSSL
@@ -0,0 +1,360 @@
+#include "static_file_cache.h"
+
+#include <http_compress.h>
+#include <http_response.h>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace jl {
+    namespace http {
+
+        namespace {
+#ifdef _WIN32
+            using FileStat = struct _stat64;
+
+            int OpenFile(const std::string& path) { return _open(path.c_str(), _O_RDONLY | _O_BINARY); }
+            int StatFile(const std::string& path, FileStat& st) { return _stat64(path.c_str(), &st); }
+            int StatFd(int fd, FileStat& st) { return _fstat64(fd, &st); }
+            int CloseFile(int fd) { return _close(fd); }
+            long long ReadFd(int fd, char* data, std::size_t n) { return _read(fd, data, static_cast<unsigned int>(n)); }
+            bool IsRegular(const FileStat& st) { return (st.st_mode & _S_IFMT) == _S_IFREG; }
+#else
+            using FileStat = struct stat;
+
+            int OpenFile(const std::string& path) { return ::open(path.c_str(), O_RDONLY | O_CLOEXEC); }
+            int StatFile(const std::string& path, FileStat& st) { return ::stat(path.c_str(), &st); }
+            int StatFd(int fd, FileStat& st) { return ::fstat(fd, &st); }
+            int CloseFile(int fd) { return ::close(fd); }
+            long long ReadFd(int fd, char* data, std::size_t n) { return ::read(fd, data, n); }
+            bool IsRegular(const FileStat& st) { return S_ISREG(st.st_mode); }
+#endif
+
+            /// @brief 缓存项是否仍对应磁盘上的文件
+            bool SameFile(const StaticFile& file, const FileStat& st)
+            {
+                return file.size == static_cast<std::uint64_t>(st.st_size) && file.mtime == st.st_mtime
+                    && file.inode == static_cast<std::uint64_t>(st.st_ino);
+            }
+
+            int HexValue(char c)
+            {
+                if (c >= '0' && c <= '9') {
+                    return c - '0';
+                }
+                if (c >= 'a' && c <= 'f') {
+                    return c - 'a' + 10;
+                }
+                if (c >= 'A' && c <= 'F') {
+                    return c - 'A' + 10;
+                }
+                return -1;
+            }
+
+            void AppendHex(std::string& out, std::uint64_t value)
+            {
+                char digits[16];
+                char* p = digits + sizeof(digits);
+                do {
+                    *--p = "0123456789abcdef"[value & 0xf];
+                    value >>= 4;
+                } while (value);
+                out.append(p, digits + sizeof(digits) - p);
+            }
+
+            std::string_view TrimOWS(std::string_view s)
+            {
+                while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+                    s.remove_prefix(1);
+                }
+                while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) {
+                    s.remove_suffix(1);
+                }
+                return s;
+            }
+        }
+
+        StaticFile::~StaticFile()
+        {
+            if (fd >= 0) {
+                CloseFile(fd);
+            }
+        }
+
+        bool StaticFile::NotModified(const Request& request) const
+        {
+            std::string_view if_none_match = request.GetHeader("If-None-Match");
+            if (!if_none_match.empty()) {
+                while (!if_none_match.empty()) {
+                    std::size_t comma = if_none_match.find(',');
+                    std::string_view tag = TrimOWS(if_none_match.substr(0, comma));
+                    if (tag == "*") {
+                        return true;
+                    }
+                    if (tag.substr(0, 2) == "W/") {
+                        tag.remove_prefix(2);
+                    }
+                    if (tag == etag) {
+                        return true;
+                    }
+                    if (comma == std::string_view::npos) {
+                        break;
+                    }
+                    if_none_match.remove_prefix(comma + 1);
+                }
+                return false;
+            }
+            std::string_view if_modified_since = request.GetHeader("If-Modified-Since");
+            std::time_t since = 0;
+            return !if_modified_since.empty() && ParseHttpDate(if_modified_since, since) && mtime <= since;
+        }
+
+        std::string_view ContentType(std::string_view path)
+        {
+            static const std::pair<std::string_view, std::string_view> kTypes[] = {
+                { "html", "text/html; charset=UTF-8" },
+                { "htm", "text/html; charset=UTF-8" },
+                { "css", "text/css; charset=UTF-8" },
+                { "js", "text/javascript; charset=UTF-8" },
+                { "mjs", "text/javascript; charset=UTF-8" },
+                { "json", "application/json" },
+                { "txt", "text/plain; charset=UTF-8" },
+                { "xml", "application/xml" },
+                { "svg", "image/svg+xml" },
+                { "png", "image/png" },
+                { "jpg", "image/jpeg" },
+                { "jpeg", "image/jpeg" },
+                { "gif", "image/gif" },
+                { "webp", "image/webp" },
+                { "ico", "image/x-icon" },
+                { "wasm", "application/wasm" },
+                { "pdf", "application/pdf" },
+                { "woff", "font/woff" },
+                { "woff2", "font/woff2" },
+                { "mp4", "video/mp4" },
+            };
+            std::size_t dot = path.rfind('.');
+            std::size_t slash = path.rfind('/');
+            if (dot != std::string_view::npos && (slash == std::string_view::npos || dot > slash)) {
+                std::string_view ext = path.substr(dot + 1);
+                for (const auto& type : kTypes) {
+                    if (type.first.size() == ext.size()) {
+                        bool equal = true;
+                        for (std::size_t i = 0; i < ext.size() && equal; ++i) {
+                            char c = ext[i];
+                            equal = (c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c) == type.first[i];
+                        }
+                        if (equal) {
+                            return type.second;
+                        }
+                    }
+                }
+            }
+            return "application/octet-stream";
+        }
+
+        StaticFileCache::StaticFileCache(std::string root, std::size_t max_files, std::size_t max_inline_bytes, std::size_t inline_file_bytes) :
+            root_(std::move(root)),
+            max_files_(max_files),
+            max_inline_bytes_(max_inline_bytes),
+            inline_file_bytes_(inline_file_bytes)
+        {
+        }
+
+        bool StaticFileCache::ResolvePath(std::string_view path, std::string& full) const
+        {
+            full.assign(root_);
+            full.push_back('/');
+            std::size_t segment_start = full.size();
+            for (std::size_t i = 0; i <= path.size(); ++i) {
+                char c = i < path.size() ? path[i] : '/';
+                if (c == '%' && i + 2 < path.size() && HexValue(path[i + 1]) >= 0 && HexValue(path[i + 2]) >= 0) {
+                    c = static_cast<char>(HexValue(path[i + 1]) * 16 + HexValue(path[i + 2]));
+                    i += 2;
+                    // 解码出的 / 也按分隔符处理，与下方的 . 和 .. 检查一致
+                }
+                if (c == '\0' || c == '\\') {
+                    return false;
+                }
+                if (c == '/') {
+                    std::string_view segment(full.data() + segment_start, full.size() - segment_start);
+                    if (segment == "." || segment == "..") {
+                        return false;
+                    }
+                    if (i == path.size()) {
+                        break;
+                    }
+                    full.push_back('/');
+                    segment_start = full.size();
+                    continue;
+                }
+                full.push_back(c);
+            }
+            if (full.back() == '/') {
+                full.append("index.html");
+            }
+            return true;
+        }
+
+        std::shared_ptr<const StaticFile> StaticFileCache::Load(const std::string& full, const std::string& type_path, bool gzip) const
+        {
+            int fd = OpenFile(full);
+            if (fd < 0) {
+                return nullptr;
+            }
+            auto file = std::make_shared<StaticFile>();
+            file->fd = fd;
+            FileStat st;
+            if (StatFd(fd, st) != 0 || !IsRegular(st)) {
+                return nullptr;
+            }
+            file->size = static_cast<std::uint64_t>(st.st_size);
+            file->mtime = st.st_mtime;
+            file->inode = static_cast<std::uint64_t>(st.st_ino);
+
+            if (file->size <= inline_file_bytes_) {
+                file->content.resize(static_cast<std::size_t>(file->size));
+                std::size_t done = 0;
+                while (done < file->content.size()) {
+                    long long n = ReadFd(fd, &file->content[done], file->content.size() - done);
+                    if (n <= 0) {
+                        return nullptr; // 读取期间文件被截断，下次请求重新加载
+                    }
+                    done += static_cast<std::size_t>(n);
+                }
+                CloseFile(fd);
+                file->fd = -1;
+            }
+
+            file->etag.push_back('"');
+            AppendHex(file->etag, file->size);
+            file->etag.push_back('-');
+            AppendHex(file->etag, static_cast<std::uint64_t>(file->mtime));
+            file->etag.push_back('"');
+
+            char last_modified[kHttpDateLength + 1];
+            FormatHttpDate(file->mtime, last_modified);
+            std::string_view content_type = ContentType(type_path);
+            ResponseWriter validators(file->validators);
+            validators.Header("ETag", file->etag).Header("Last-Modified", std::string_view(last_modified, kHttpDateLength));
+            if (IsCompressible(content_type)) {
+                // 同一URL可能返回 .gz 版本，304 也要带上 Vary
+                validators.Header("Vary", "Accept-Encoding");
+            }
+            ResponseWriter headers(file->headers);
+            headers.Header("Content-Type", content_type).ContentLength(file->size);
+            if (gzip) {
+                headers.Header("Content-Encoding", "gzip");
+            }
+            headers.Headers(file->validators);
+            return file;
+        }
+
+        void StaticFileCache::Insert(const std::string& full, const std::shared_ptr<const StaticFile>& file)
+        {
+            auto it = entries_.find(full);
+            if (it != entries_.end()) {
+                Erase(it);
+            }
+            lru_.push_front(full);
+            entries_.emplace(full, Entry{ file, lru_.begin(), std::chrono::steady_clock::now() });
+            if (file) {
+                stats_.inline_bytes += file->content.size();
+            }
+            // 至少保留刚插入的项
+            while (entries_.size() > 1 && (entries_.size() > max_files_ || stats_.inline_bytes > max_inline_bytes_)) {
+                Erase(entries_.find(lru_.back()));
+                ++stats_.evictions;
+            }
+        }
+
+        void StaticFileCache::Erase(std::unordered_map<std::string, Entry>::iterator it)
+        {
+            // 正在发送的连接仍持有 shared_ptr，文件在发送完成后才关闭
+            if (it->second.file) {
+                stats_.inline_bytes -= it->second.file->content.size();
+            }
+            lru_.erase(it->second.lru);
+            entries_.erase(it);
+        }
+
+        std::shared_ptr<const StaticFile> StaticFileCache::Get(std::string_view path, bool accept_gzip)
+        {
+            std::string full;
+            if (!ResolvePath(path, full)) {
+                return nullptr;
+            }
+            if (accept_gzip && IsCompressible(ContentType(full))) {
+                // 键在路径后加 NUL，与直接请求 .gz 文件的缓存项区分
+                std::string key = full;
+                key.push_back('\0');
+                std::shared_ptr<const StaticFile> file = Lookup(key, full + ".gz", full, true);
+                if (file) {
+                    return file;
+                }
+            }
+            return Lookup(full, full, full, false);
+        }
+
+        std::shared_ptr<const StaticFile> StaticFileCache::Lookup(const std::string& key, const std::string& full, const std::string& type_path, bool gzip)
+        {
+            auto now = std::chrono::steady_clock::now();
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto it = entries_.find(key);
+                if (it != entries_.end() && now - it->second.checked < kFileRevalidateInterval) {
+                    ++stats_.hits;
+                    lru_.splice(lru_.begin(), lru_, it->second.lru);
+                    return it->second.file;
+                }
+            }
+            // stat 和加载文件都不持有锁
+            FileStat st;
+            bool exists = StatFile(full, st) == 0 && IsRegular(st);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto it = entries_.find(key);
+                if (it != entries_.end()) {
+                    const auto& file = it->second.file;
+                    if (exists ? file && SameFile(*file, st) : !file) {
+                        ++stats_.hits;
+                        it->second.checked = now;
+                        lru_.splice(lru_.begin(), lru_, it->second.lru);
+                        return file;
+                    }
+                    Erase(it);
+                }
+            }
+            if (!exists) {
+                if (gzip) {
+                    // 大多数文件没有 .gz 版本，记住不存在，避免每个请求多一次 stat
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    Insert(key, nullptr);
+                }
+                return nullptr;
+            }
+            std::shared_ptr<const StaticFile> file = Load(full, type_path, gzip);
+            if (!file) {
+                return nullptr;
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++stats_.misses;
+            Insert(key, file);
+            return file;
+        }
+
+        StaticFileCache::Stats StaticFileCache::GetStats() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            Stats stats = stats_;
+            stats.files = entries_.size();
+            return stats;
+        }
+    }
+}
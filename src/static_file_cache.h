@@ -0,0 +1,111 @@
+/// @file static_file_cache.h
+/// @brief 静态文件缓存：热点文件保持打开并预先生成响应头（ETag、Content-Length、Last-Modified），
+///        小文件内容直接缓存在内存中与响应头一起写出，大文件通过 IConnection::SendFile 发送；
+///        客户端接受 gzip 时优先返回预压缩的同名 .gz 文件
+/// @author Jyang.
+/// @date 2026-10-19
+/// @version 1.0
+
+#pragma once
+
+#include <http_parser.h>
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace jl {
+    namespace http {
+
+        constexpr std::size_t kDefaultMaxCachedFiles = 1024;                // 缓存的文件数（即保持打开的fd数）上限
+        constexpr std::size_t kDefaultMaxInlineBytes = 64 * 1024 * 1024;    // 内存中缓存的小文件内容总字节数上限
+        constexpr std::size_t kDefaultInlineFileBytes = 32 * 1024;          // 不超过该大小的文件内容缓存在内存中
+        constexpr std::chrono::milliseconds kFileRevalidateInterval(1000);  // 缓存项最多每隔该时间 stat 一次检查文件是否变化
+
+        /// @brief 缓存中的一个文件，创建后只读，可以被多个连接同时使用
+        struct StaticFile {
+            int fd = -1;                    // 大文件保持打开；内容在 content 中时为 -1
+            std::uint64_t size = 0;
+            std::time_t mtime = 0;
+            std::uint64_t inode = 0;
+            std::string etag;               // 带引号的强校验值
+            std::string validators;         // "ETag: ...\r\nLast-Modified: ...\r\n"，可压缩的类型还有 Vary，304 响应使用
+            std::string headers;            // Content-Type、Content-Length、.gz 版本的 Content-Encoding 和 validators，200 响应使用
+            std::string content;            // 小文件内容
+
+            StaticFile() = default;
+            StaticFile(const StaticFile&) = delete;
+            StaticFile& operator=(const StaticFile&) = delete;
+            ~StaticFile();
+
+            /// @brief 条件请求是否可以返回 304：有 If-None-Match 时只比较 ETag（弱比较），否则比较 If-Modified-Since
+            bool NotModified(const Request& request) const;
+        };
+
+        /// @brief 按扩展名返回 Content-Type，未知扩展名返回 application/octet-stream
+        std::string_view ContentType(std::string_view path);
+
+        /// @brief 按最近使用淘汰的静态文件缓存，线程安全
+        class StaticFileCache {
+        public:
+            struct Stats {
+                std::uint64_t hits = 0;
+                std::uint64_t misses = 0;           // 首次打开或文件变化后重新加载
+                std::uint64_t evictions = 0;
+                std::uint64_t inline_bytes = 0;     // 当前内存中缓存的文件内容字节数
+                std::size_t files = 0;
+            };
+
+            explicit StaticFileCache(std::string root, std::size_t max_files = kDefaultMaxCachedFiles,
+                std::size_t max_inline_bytes = kDefaultMaxInlineBytes, std::size_t inline_file_bytes = kDefaultInlineFileBytes);
+
+            /// @brief 查找文件
+            /// @param path 相对于根目录的URL路径（不含开头的 / 和查询串），支持百分号编码；为空或以 / 结尾时取 index.html
+            /// @param accept_gzip 客户端接受 gzip，可压缩类型的文件存在同名 .gz 文件时返回它（Content-Encoding: gzip）
+            /// @return 路径非法（含 . 或 .. 段、NUL、反斜杠）、文件不存在或不是普通文件时返回 nullptr
+            std::shared_ptr<const StaticFile> Get(std::string_view path, bool accept_gzip = false);
+
+            Stats GetStats() const;
+
+        private:
+            struct Entry {
+                std::shared_ptr<const StaticFile> file;         // .gz 版本不存在时为 nullptr
+                std::list<std::string>::iterator lru;
+                std::chrono::steady_clock::time_point checked;  // 上次确认文件未变化的时间
+            };
+
+            /// @brief URL路径转换为文件系统路径，非法时返回 false
+            bool ResolvePath(std::string_view path, std::string& full) const;
+
+            /// @brief 查找缓存项，过期时 stat 检查文件是否变化
+            /// @param key 缓存键，.gz 版本为原文件路径加 NUL
+            /// @param full 文件系统路径
+            /// @param type_path 按该路径的扩展名确定 Content-Type
+            std::shared_ptr<const StaticFile> Lookup(const std::string& key, const std::string& full, const std::string& type_path, bool gzip);
+
+            /// @brief 打开文件并生成缓存项，文件不存在或不是普通文件时返回 nullptr
+            std::shared_ptr<const StaticFile> Load(const std::string& full, const std::string& type_path, bool gzip) const;
+
+            /// @brief 插入缓存项并按上限淘汰最久未使用的项，调用方需持有 mutex_
+            void Insert(const std::string& full, const std::shared_ptr<const StaticFile>& file);
+
+            void Erase(std::unordered_map<std::string, Entry>::iterator it);
+
+        private:
+            const std::string root_;
+            const std::size_t max_files_;
+            const std::size_t max_inline_bytes_;
+            const std::size_t inline_file_bytes_;
+            mutable std::mutex mutex_;
+            std::list<std::string> lru_;    // 最近使用的在前
+            std::unordered_map<std::string, Entry> entries_;
+            Stats stats_;
+        };
+    }
+}
@@ -2,19 +2,37 @@
 
 #include <string>
 #include <mutex>
+#include <atomic>
+#include <algorithm>
 #include <chrono>
+#include <thread>
 #include <vector>
+#include <stdexcept>
 
 namespace jl
 {
     namespace util
     {
+        /// @brief 同一毫秒内的一段连续id：[first, first + count - 1]
+        struct IdBlock
+        {
+            std::int64_t first;
+            std::size_t count;
+
+            std::int64_t Last() const { return first + static_cast<std::int64_t>(count) - 1; }
+        };
+
         class IdGenerator
         {
         public:
             virtual std::int64_t GenerateId() = 0;
 
             virtual std::vector<std::int64_t> GenerateIds(std::size_t cnt) = 0;
+
+            /// @brief 预留 cnt 个id，按毫秒返回若干段连续id，每个毫秒只访问一次共享状态
+            virtual std::vector<IdBlock> ReserveRange(std::size_t cnt) = 0;
+
+            virtual ~IdGenerator() = default;
         };
 
         class Snowflake : public IdGenerator
@@ -30,7 +48,7 @@ namespace jl
             static constexpr int kSequenceBits = 12;
 
             static constexpr std::int64_t kMaxNodeId = (1 << kNodeIdBits) - 1;     // 1023
-            static constexpr std::int64_t kMaxSequence = (1 << kSequenceBits) - 1; // 4095
+            static constexpr std::int64_t kMaxSequence = (1 << kSequenceBits) - 1; // 4095，序列号取值 [0, 4095]
 
             static constexpr int kNodeIdShift = kSequenceBits;
             static constexpr int kTimestampShift = (kSequenceBits + kNodeIdBits);
@@ -70,7 +88,7 @@ namespace jl
                 // 同一毫秒内
                 if (timestamp == last_timestamp_)
                 {
-                    sequence_ = (sequence_ + 1) % kMaxSequence;
+                    sequence_ = (sequence_ + 1) & kMaxSequence;
                     if (sequence_ == 0)
                     {
                         timestamp = WaitNextMills(timestamp);
@@ -93,8 +111,23 @@ namespace jl
             std::vector<std::int64_t> GenerateIds(std::size_t cnt) override
             {
                 std::vector<std::int64_t> ids;
+                ids.reserve(cnt);
+                for (const IdBlock& block : ReserveRange(cnt))
+                {
+                    for (std::int64_t id = block.first; id <= block.Last(); ++id)
+                    {
+                        ids.emplace_back(id);
+                    }
+                }
+                return ids;
+            }
+
+            /// @brief 预留 cnt 个id，每个毫秒读一次时钟，取走该毫秒剩余的全部序列号
+            std::vector<IdBlock> ReserveRange(std::size_t cnt) override
+            {
+                std::vector<IdBlock> blocks;
                 std::lock_guard<std::mutex> lock(mutex_);
-                while (cnt-- > 0)
+                while (cnt > 0)
                 {
                     std::int64_t timestamp = CurrentTimeMillis();
                     // 时钟回拨检测
@@ -105,29 +138,29 @@ namespace jl
                         {
                             throw std::runtime_error("Clock moved backwards by" + std::to_string(offset) + "ms, refusing to generate ID.");
                         }
-                        // 小幅度回拨，等待追平
+                        // 小幅度回拨，等待追平；仍未追平时继续使用上一毫秒
                         std::this_thread::sleep_for(std::chrono::milliseconds(offset));
-                        timestamp = CurrentTimeMillis();
+                        timestamp = std::max(CurrentTimeMillis(), last_timestamp_);
                     }
-                    // 同一毫秒内
+                    std::int64_t first_sequence = 0;
                     if (timestamp == last_timestamp_)
                     {
-                        sequence_ = (sequence_ + 1) % kMaxSequence;
-                        if (sequence_ == 0)
+                        if (sequence_ == kMaxSequence)
                         {
                             timestamp = WaitNextMills(timestamp);
                         }
+                        else
+                        {
+                            first_sequence = sequence_ + 1;
+                        }
                     }
-                    else
-                    {
-                        // 不同毫秒，序列化重复
-                        sequence_ = 0;
-                    }
+                    std::size_t count = std::min<std::size_t>(cnt, static_cast<std::size_t>(kMaxSequence + 1 - first_sequence));
+                    sequence_ = first_sequence + static_cast<std::int64_t>(count) - 1;
                     last_timestamp_ = timestamp;
-                    std::int64_t id = ((last_timestamp_ - kTwepoch) << kTimestampShift) | (node_id_ << kNodeIdShift) | sequence_;
-                    ids.emplace_back(id);
+                    blocks.push_back(IdBlock{ ((timestamp - kTwepoch) << kTimestampShift) | (node_id_ << kNodeIdShift) | first_sequence, count });
+                    cnt -= count;
                 }
-                return ids;
+                return blocks;
             }
 
             std::int64_t NodeId() const
@@ -177,6 +210,244 @@ namespace jl
             std::mutex mutex_;
         };
 
+        /// @brief 无锁Snowflake：时间戳和序列号打包在一个64位原子变量中，每次分配一次CAS
+        ///        id格式与 Snowflake 相同；当前毫秒序列号用完或时钟小幅回拨时自旋等待，不持有锁
+        class AtomicSnowflake : public IdGenerator
+        {
+            static constexpr std::int64_t kTwepoch = 1609459200000;
+            static constexpr int kNodeIdBits = 10;
+            static constexpr int kSequenceBits = 12;
+            static constexpr std::int64_t kMaxNodeId = (1 << kNodeIdBits) - 1;
+            static constexpr std::int64_t kMaxSequence = (1 << kSequenceBits) - 1;
+            static constexpr int kNodeIdShift = kSequenceBits;
+            static constexpr int kTimestampShift = (kSequenceBits + kNodeIdBits);
+            static constexpr std::int64_t kMaxBackwardMs = 5;
+
+        public:
+            explicit AtomicSnowflake(std::int64_t node_id) :
+                node_id_(node_id),
+                state_(0)
+            {
+                if (node_id_ < 0 || node_id_ > kMaxNodeId)
+                {
+                    throw std::invalid_argument("Node ID out of range [0," + std::to_string(kMaxNodeId) + "]");
+                }
+            }
+
+            std::int64_t GenerateId() override
+            {
+                return ReserveBlock(1).first;
+            }
+
+            std::vector<std::int64_t> GenerateIds(std::size_t cnt) override
+            {
+                std::vector<std::int64_t> ids;
+                ids.reserve(cnt);
+                for (const IdBlock& block : ReserveRange(cnt))
+                {
+                    for (std::int64_t id = block.first; id <= block.Last(); ++id)
+                    {
+                        ids.emplace_back(id);
+                    }
+                }
+                return ids;
+            }
+
+            /// @brief 预留 cnt 个id，每个毫秒一次CAS
+            std::vector<IdBlock> ReserveRange(std::size_t cnt) override
+            {
+                std::vector<IdBlock> blocks;
+                while (cnt > 0)
+                {
+                    blocks.push_back(ReserveBlock(cnt));
+                    cnt -= blocks.back().count;
+                }
+                return blocks;
+            }
+
+            /// @brief 一次CAS在当前毫秒内预留最多 max_count 个连续序列号
+            /// @param max_count 最多预留的数量，实际数量受当前毫秒剩余序列号限制，至少为1
+            IdBlock ReserveBlock(std::size_t max_count)
+            {
+                const std::int64_t want = static_cast<std::int64_t>(max_count == 0 ? 1 : max_count);
+                // state_ = (相对 kTwepoch 的毫秒 << kSequenceBits) | 最后一个已分配的序列号
+                std::int64_t state = state_.load(std::memory_order_relaxed);
+                for (;;)
+                {
+                    const std::int64_t now = CurrentTimeMillis() - kTwepoch;
+                    const std::int64_t last_ts = state >> kSequenceBits;
+                    std::int64_t first;
+                    std::int64_t count;
+                    if (now > last_ts)
+                    {
+                        first = now << kSequenceBits;
+                        count = want < kMaxSequence + 1 ? want : kMaxSequence + 1;
+                    }
+                    else
+                    {
+                        if (last_ts - now > kMaxBackwardMs)
+                        {
+                            throw std::runtime_error("Clock moved backwards by" + std::to_string(last_ts - now) + "ms, refusing to generate ID.");
+                        }
+                        const std::int64_t available = kMaxSequence - (state & kMaxSequence);
+                        if (available == 0)
+                        {
+                            // 本毫秒已分配完（或时钟小幅回拨），等待时钟前进
+                            std::this_thread::yield();
+                            state = state_.load(std::memory_order_relaxed);
+                            continue;
+                        }
+                        first = state + 1;
+                        count = want < available ? want : available;
+                    }
+                    // 唯一性只依赖 state_ 自身的原子读改写，不需要与其他内存同步
+                    if (state_.compare_exchange_weak(state, first + count - 1, std::memory_order_relaxed))
+                    {
+                        return IdBlock{ ((first >> kSequenceBits) << kTimestampShift) | (node_id_ << kNodeIdShift) | (first & kMaxSequence),
+                                        static_cast<std::size_t>(count) };
+                    }
+                }
+            }
+
+            std::int64_t NodeId() const
+            {
+                return node_id_;
+            }
+
+        private:
+            static std::int64_t CurrentTimeMillis()
+            {
+                return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+            }
+
+        private:
+            const std::int64_t node_id_;
+            alignas(64) std::atomic<std::int64_t> state_;
+        };
+
+        /// @brief 线程本地分段的Snowflake：每个线程一次从共享的 AtomicSnowflake 预留一段序列号，之后在本线程内分配，
+        ///        大部分id不访问共享状态。进入新的毫秒时丢弃本线程剩余的序列号，保证id中的时间戳不落后于生成时间
+        class ThreadLocalSnowflake : public IdGenerator
+        {
+        public:
+            /// @param node_id 节点id
+            /// @param block_size 每个线程一次预留的序列号数量，越大共享状态竞争越少，但每毫秒可能浪费的序列号越多
+            explicit ThreadLocalSnowflake(std::int64_t node_id, std::size_t block_size = 64) :
+                generator_(node_id),
+                block_size_(block_size == 0 ? 1 : block_size),
+                instance_(NextInstance())
+            {
+            }
+
+            std::int64_t GenerateId() override
+            {
+                Cache& cache = LocalCache();
+                const std::int64_t millis = CurrentTimeMillis();
+                if (cache.instance != instance_ || cache.remaining == 0 || cache.millis < millis)
+                {
+                    IdBlock block = generator_.ReserveBlock(block_size_);
+                    cache.instance = instance_;
+                    cache.next = block.first;
+                    cache.remaining = block.count;
+                    cache.millis = millis;
+                }
+                --cache.remaining;
+                return cache.next++;
+            }
+
+            std::vector<std::int64_t> GenerateIds(std::size_t cnt) override
+            {
+                return generator_.GenerateIds(cnt);
+            }
+
+            std::vector<IdBlock> ReserveRange(std::size_t cnt) override
+            {
+                return generator_.ReserveRange(cnt);
+            }
+
+            std::int64_t NodeId() const
+            {
+                return generator_.NodeId();
+            }
+
+        private:
+            struct Cache
+            {
+                std::uint64_t instance = 0; // 所属生成器的实例序号，不用地址，避免新对象复用旧地址时沿用旧的序列号
+                std::int64_t next = 0;
+                std::size_t remaining = 0;
+                std::int64_t millis = 0;
+            };
+
+            static Cache& LocalCache()
+            {
+                static thread_local Cache cache;
+                return cache;
+            }
+
+            static std::uint64_t NextInstance()
+            {
+                static std::atomic<std::uint64_t> instance{ 0 };
+                return instance.fetch_add(1, std::memory_order_relaxed) + 1;
+            }
+
+            static std::int64_t CurrentTimeMillis()
+            {
+                return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+            }
+
+        private:
+            AtomicSnowflake generator_;
+            const std::size_t block_size_;
+            const std::uint64_t instance_;
+        };
+
+        /// @brief id缓存：一次从生成器预留一批id，之后 Next() 只在对象内递增，不读时钟也不访问共享状态，适合批量打标签。
+        ///        非线程安全，每个线程使用自己的实例（例如 thread_local）。id中的时间戳是预留时的时间，可能早于实际使用时间
+        class IdCache
+        {
+        public:
+            /// @param generator 生成器，生命周期需长于缓存
+            /// @param batch_size 每次预留的id数量
+            explicit IdCache(IdGenerator& generator, std::size_t batch_size = 4096) :
+                generator_(generator),
+                batch_size_(batch_size == 0 ? 1 : batch_size),
+                index_(0),
+                next_(0),
+                end_(0)
+            {
+            }
+
+            std::int64_t Next()
+            {
+                if (next_ == end_)
+                {
+                    Refill();
+                }
+                return next_++;
+            }
+
+        private:
+            void Refill()
+            {
+                if (index_ == blocks_.size())
+                {
+                    blocks_ = generator_.ReserveRange(batch_size_);
+                    index_ = 0;
+                }
+                const IdBlock& block = blocks_[index_++];
+                next_ = block.first;
+                end_ = block.Last() + 1;
+            }
+
+        private:
+            IdGenerator& generator_;
+            const std::size_t batch_size_;
+            std::vector<IdBlock> blocks_;
+            std::size_t index_;
+            std::int64_t next_;
+            std::int64_t end_;
+        };
 
         template<typename Generator, typename... Args>
         inline IdGenerator*  MakeIdGenerator(Args&&... args)
@@ -0,0 +1,478 @@
+#include "websocket.h"
+
+#include <http_response.h>
+#include <simd_scan.h>
+
+#include <cstring>
+
+namespace jl {
+    namespace ws {
+
+        namespace {
+            constexpr std::string_view kGuid = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+            inline std::uint32_t RotateLeft(std::uint32_t x, int n)
+            {
+                return (x << n) | (x >> (32 - n));
+            }
+
+            /// @brief SHA-1（RFC 3174），只用于握手，不作为安全用途
+            void Sha1(std::string_view data, std::uint8_t digest[20])
+            {
+                std::uint32_t h[5] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0 };
+                // 消息后补 0x80、若干 0 和 64 位长度，总长为 64 字节的倍数
+                std::string message(data);
+                const std::uint64_t bits = static_cast<std::uint64_t>(data.size()) * 8;
+                message.push_back(static_cast<char>(0x80));
+                while (message.size() % 64 != 56) {
+                    message.push_back('\0');
+                }
+                for (int i = 7; i >= 0; --i) {
+                    message.push_back(static_cast<char>(bits >> (i * 8)));
+                }
+                for (std::size_t block = 0; block < message.size(); block += 64) {
+                    std::uint32_t w[80];
+                    for (int i = 0; i < 16; ++i) {
+                        const unsigned char* p = reinterpret_cast<const unsigned char*>(message.data() + block + i * 4);
+                        w[i] = (std::uint32_t(p[0]) << 24) | (std::uint32_t(p[1]) << 16) | (std::uint32_t(p[2]) << 8) | p[3];
+                    }
+                    for (int i = 16; i < 80; ++i) {
+                        w[i] = RotateLeft(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+                    }
+                    std::uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+                    for (int i = 0; i < 80; ++i) {
+                        std::uint32_t f, k;
+                        if (i < 20) {
+                            f = (b & c) | (~b & d);
+                            k = 0x5a827999;
+                        }
+                        else if (i < 40) {
+                            f = b ^ c ^ d;
+                            k = 0x6ed9eba1;
+                        }
+                        else if (i < 60) {
+                            f = (b & c) | (b & d) | (c & d);
+                            k = 0x8f1bbcdc;
+                        }
+                        else {
+                            f = b ^ c ^ d;
+                            k = 0xca62c1d6;
+                        }
+                        std::uint32_t temp = RotateLeft(a, 5) + f + e + k + w[i];
+                        e = d;
+                        d = c;
+                        c = RotateLeft(b, 30);
+                        b = a;
+                        a = temp;
+                    }
+                    h[0] += a;
+                    h[1] += b;
+                    h[2] += c;
+                    h[3] += d;
+                    h[4] += e;
+                }
+                for (int i = 0; i < 5; ++i) {
+                    digest[i * 4] = static_cast<std::uint8_t>(h[i] >> 24);
+                    digest[i * 4 + 1] = static_cast<std::uint8_t>(h[i] >> 16);
+                    digest[i * 4 + 2] = static_cast<std::uint8_t>(h[i] >> 8);
+                    digest[i * 4 + 3] = static_cast<std::uint8_t>(h[i]);
+                }
+            }
+
+            void AppendBase64(std::string& out, const std::uint8_t* data, std::size_t len)
+            {
+                static const char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+                std::size_t i = 0;
+                for (; i + 3 <= len; i += 3) {
+                    std::uint32_t v = (std::uint32_t(data[i]) << 16) | (std::uint32_t(data[i + 1]) << 8) | data[i + 2];
+                    out.push_back(kAlphabet[(v >> 18) & 0x3f]);
+                    out.push_back(kAlphabet[(v >> 12) & 0x3f]);
+                    out.push_back(kAlphabet[(v >> 6) & 0x3f]);
+                    out.push_back(kAlphabet[v & 0x3f]);
+                }
+                if (i < len) {
+                    std::uint32_t v = std::uint32_t(data[i]) << 16;
+                    if (i + 1 < len) {
+                        v |= std::uint32_t(data[i + 1]) << 8;
+                    }
+                    out.push_back(kAlphabet[(v >> 18) & 0x3f]);
+                    out.push_back(kAlphabet[(v >> 12) & 0x3f]);
+                    out.push_back(i + 1 < len ? kAlphabet[(v >> 6) & 0x3f] : '=');
+                    out.push_back('=');
+                }
+            }
+
+            bool IsBase64Char(char c)
+            {
+                return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '+' || c == '/';
+            }
+
+            char ToLower(char c)
+            {
+                return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+            }
+
+            bool EqualsIgnoreCase(std::string_view a, std::string_view b)
+            {
+                if (a.size() != b.size()) {
+                    return false;
+                }
+                for (std::size_t i = 0; i < a.size(); ++i) {
+                    if (ToLower(a[i]) != ToLower(b[i])) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            /// @brief 逗号分隔的头部值中是否含有 token（不区分大小写）
+            bool HasToken(std::string_view value, std::string_view token)
+            {
+                while (!value.empty()) {
+                    std::size_t comma = value.find(',');
+                    std::string_view item = value.substr(0, comma);
+                    while (!item.empty() && (item.front() == ' ' || item.front() == '\t')) {
+                        item.remove_prefix(1);
+                    }
+                    while (!item.empty() && (item.back() == ' ' || item.back() == '\t')) {
+                        item.remove_suffix(1);
+                    }
+                    if (EqualsIgnoreCase(item, token)) {
+                        return true;
+                    }
+                    if (comma == std::string_view::npos) {
+                        break;
+                    }
+                    value.remove_prefix(comma + 1);
+                }
+                return false;
+            }
+
+            bool IsValidCloseCode(std::uint16_t code)
+            {
+                // 1004、1005、1006、1015 保留，不能出现在关闭帧中
+                return (code >= 1000 && code <= 1003) || (code >= 1007 && code <= 1011) || (code >= 3000 && code <= 4999);
+            }
+
+            void AppendHeader(std::string& out, std::uint8_t first, bool masked, std::uint64_t payload_len)
+            {
+                const std::uint8_t mask_bit = masked ? 0x80 : 0;
+                out.push_back(static_cast<char>(first));
+                if (payload_len < 126) {
+                    out.push_back(static_cast<char>(mask_bit | payload_len));
+                }
+                else if (payload_len <= 0xffff) {
+                    const char len[] = { static_cast<char>(mask_bit | 126), static_cast<char>(payload_len >> 8), static_cast<char>(payload_len) };
+                    out.append(len, sizeof(len));
+                }
+                else {
+                    char len[9] = { static_cast<char>(mask_bit | 127) };
+                    for (int i = 0; i < 8; ++i) {
+                        len[1 + i] = static_cast<char>(payload_len >> ((7 - i) * 8));
+                    }
+                    out.append(len, sizeof(len));
+                }
+            }
+
+            inline std::uint8_t FirstByte(Opcode opcode, bool fin)
+            {
+                return static_cast<std::uint8_t>((fin ? 0x80 : 0) | static_cast<std::uint8_t>(opcode));
+            }
+        }
+
+        bool IsUpgradeRequest(const http::Request& request)
+        {
+            if (request.method != "GET" || request.version_major != 1 || request.version_minor < 1) {
+                return false;
+            }
+            if (!HasToken(request.GetHeader("Upgrade"), "websocket") || !HasToken(request.GetHeader("Connection"), "upgrade")) {
+                return false;
+            }
+            if (request.GetHeader("Sec-WebSocket-Version") != "13") {
+                return false;
+            }
+            // 16 字节随机数的 base64，固定 24 个字符并以 "==" 结尾
+            std::string_view key = request.GetHeader("Sec-WebSocket-Key");
+            if (key.size() != 24 || key[22] != '=' || key[23] != '=') {
+                return false;
+            }
+            for (std::size_t i = 0; i < 22; ++i) {
+                if (!IsBase64Char(key[i])) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        std::string AcceptKey(std::string_view key)
+        {
+            std::string input;
+            input.reserve(key.size() + kGuid.size());
+            input.append(key);
+            input.append(kGuid);
+            std::uint8_t digest[20];
+            Sha1(input, digest);
+            std::string accept;
+            AppendBase64(accept, digest, sizeof(digest));
+            return accept;
+        }
+
+        void AppendHandshakeResponse(std::string& out, std::string_view key)
+        {
+            http::ResponseWriter(out)
+                .Status(101)
+                .Header("Upgrade", "websocket")
+                .Header("Connection", "Upgrade")
+                .Header("Sec-WebSocket-Accept", AcceptKey(key))
+                .EndHeaders();
+        }
+
+        void AppendFrameHeader(std::string& out, Opcode opcode, std::uint64_t payload_len, bool fin)
+        {
+            AppendHeader(out, FirstByte(opcode, fin), false, payload_len);
+        }
+
+        void AppendFrame(std::string& out, Opcode opcode, std::string_view payload, bool fin)
+        {
+            AppendHeader(out, FirstByte(opcode, fin), false, payload.size());
+            out.append(payload);
+        }
+
+        void AppendMaskedFrame(std::string& out, Opcode opcode, std::string_view payload, const std::uint8_t key[4], bool fin)
+        {
+            AppendHeader(out, FirstByte(opcode, fin), true, payload.size());
+            out.append(reinterpret_cast<const char*>(key), 4);
+            std::size_t start = out.size();
+            out.append(payload);
+            simd::XorMask(&out[start], payload.size(), key);
+        }
+
+        void AppendCloseFrame(std::string& out, CloseCode code, std::string_view reason)
+        {
+            if (reason.size() > kMaxControlPayload - 2) {
+                reason = reason.substr(0, kMaxControlPayload - 2);
+            }
+            const std::uint16_t value = static_cast<std::uint16_t>(code);
+            AppendHeader(out, FirstByte(Opcode::kClose, true), false, 2 + reason.size());
+            out.push_back(static_cast<char>(value >> 8));
+            out.push_back(static_cast<char>(value));
+            out.append(reason);
+        }
+
+        bool ParseClosePayload(std::string_view payload, CloseCode& code, std::string_view& reason)
+        {
+            reason = {};
+            if (payload.empty()) {
+                code = CloseCode::kNoStatus;
+                return true;
+            }
+            if (payload.size() == 1) {
+                return false;
+            }
+            std::uint16_t value = static_cast<std::uint16_t>((static_cast<std::uint8_t>(payload[0]) << 8) | static_cast<std::uint8_t>(payload[1]));
+            if (!IsValidCloseCode(value)) {
+                return false;
+            }
+            code = static_cast<CloseCode>(value);
+            reason = payload.substr(2);
+            return IsValidUtf8(reason);
+        }
+
+        bool IsValidUtf8(std::string_view text)
+        {
+            const unsigned char* p = reinterpret_cast<const unsigned char*>(text.data());
+            const unsigned char* end = p + text.size();
+            while (p < end) {
+                // ASCII 按 8 字节跳过
+                if (end - p >= 8) {
+                    std::uint64_t word;
+                    std::memcpy(&word, p, sizeof(word));
+                    if ((word & 0x8080808080808080ULL) == 0) {
+                        p += 8;
+                        continue;
+                    }
+                }
+                unsigned char c = *p;
+                if (c < 0x80) {
+                    ++p;
+                    continue;
+                }
+                std::size_t n;
+                std::uint32_t min;
+                std::uint32_t code;
+                if ((c & 0xe0) == 0xc0) {
+                    n = 1, min = 0x80, code = c & 0x1f;
+                }
+                else if ((c & 0xf0) == 0xe0) {
+                    n = 2, min = 0x800, code = c & 0x0f;
+                }
+                else if ((c & 0xf8) == 0xf0) {
+                    n = 3, min = 0x10000, code = c & 0x07;
+                }
+                else {
+                    return false;
+                }
+                if (static_cast<std::size_t>(end - p) <= n) {
+                    return false;
+                }
+                for (std::size_t i = 1; i <= n; ++i) {
+                    if ((p[i] & 0xc0) != 0x80) {
+                        return false;
+                    }
+                    code = (code << 6) | (p[i] & 0x3f);
+                }
+                // 拒绝过长编码、代理对和超出 U+10FFFF 的码点
+                if (code < min || code > 0x10ffff || (code >= 0xd800 && code <= 0xdfff)) {
+                    return false;
+                }
+                p += n + 1;
+            }
+            return true;
+        }
+
+        MessageParser::MessageParser(bool require_mask, std::uint64_t max_message_bytes) :
+            require_mask_(require_mask),
+            max_message_bytes_(max_message_bytes),
+            fragmented_(false),
+            fragment_opcode_(Opcode::kText),
+            error_(CloseCode::kNormal)
+        {
+        }
+
+        http::ParseStatus MessageParser::Fail(CloseCode code)
+        {
+            error_ = code;
+            return http::ParseStatus::kError;
+        }
+
+        http::ParseStatus MessageParser::Parse(char* data, std::size_t len, std::size_t& consumed, Message& message)
+        {
+            consumed = 0;
+            while (true) {
+                char* p = data + consumed;
+                const std::size_t remaining = len - consumed;
+                if (remaining < 2) {
+                    return http::ParseStatus::kNeedMore;
+                }
+                const std::uint8_t b0 = static_cast<std::uint8_t>(p[0]);
+                const std::uint8_t b1 = static_cast<std::uint8_t>(p[1]);
+                const bool fin = (b0 & 0x80) != 0;
+                const Opcode opcode = static_cast<Opcode>(b0 & 0x0f);
+                const bool masked = (b1 & 0x80) != 0;
+                // 没有协商扩展，RSV 位必须为 0
+                if ((b0 & 0x70) != 0) {
+                    return Fail(CloseCode::kProtocolError);
+                }
+                switch (opcode) {
+                case Opcode::kContinuation:
+                case Opcode::kText:
+                case Opcode::kBinary:
+                case Opcode::kClose:
+                case Opcode::kPing:
+                case Opcode::kPong:
+                    break;
+                default:
+                    return Fail(CloseCode::kProtocolError);
+                }
+                if (masked != require_mask_) {
+                    return Fail(CloseCode::kProtocolError);
+                }
+
+                std::size_t header = 2;
+                std::uint64_t payload_len = b1 & 0x7f;
+                if (payload_len == 126) {
+                    if (remaining < 4) {
+                        return http::ParseStatus::kNeedMore;
+                    }
+                    payload_len = (static_cast<std::uint64_t>(static_cast<std::uint8_t>(p[2])) << 8) | static_cast<std::uint8_t>(p[3]);
+                    header = 4;
+                }
+                else if (payload_len == 127) {
+                    if (remaining < 10) {
+                        return http::ParseStatus::kNeedMore;
+                    }
+                    payload_len = 0;
+                    for (int i = 0; i < 8; ++i) {
+                        payload_len = (payload_len << 8) | static_cast<std::uint8_t>(p[2 + i]);
+                    }
+                    if (payload_len >> 63) {
+                        return Fail(CloseCode::kProtocolError);
+                    }
+                    header = 10;
+                }
+                std::uint8_t key[4] = {};
+                if (masked) {
+                    if (remaining < header + 4) {
+                        return http::ParseStatus::kNeedMore;
+                    }
+                    std::memcpy(key, p + header, 4);
+                    header += 4;
+                }
+
+                if (IsControl(opcode)) {
+                    if (!fin || payload_len > kMaxControlPayload) {
+                        return Fail(CloseCode::kProtocolError);
+                    }
+                }
+                else {
+                    if ((opcode == Opcode::kContinuation) != fragmented_) {
+                        return Fail(CloseCode::kProtocolError);
+                    }
+                    if ((fragmented_ ? fragments_.size() : 0) + payload_len > max_message_bytes_) {
+                        return Fail(CloseCode::kMessageTooBig);
+                    }
+                }
+                if (remaining - header < payload_len) {
+                    return http::ParseStatus::kNeedMore;
+                }
+
+                char* payload = p + header;
+                const std::size_t size = static_cast<std::size_t>(payload_len);
+                if (masked) {
+                    simd::XorMask(payload, size, key);
+                }
+                consumed += header + size;
+
+                if (IsControl(opcode)) {
+                    if (opcode == Opcode::kClose) {
+                        CloseCode code;
+                        std::string_view reason;
+                        if (!ParseClosePayload(std::string_view(payload, size), code, reason)) {
+                            // 原因不是 UTF-8 时为 1007，长度或状态码非法时为协议错误
+                            bool bad_reason = size > 2 && !IsValidUtf8(std::string_view(payload + 2, size - 2));
+                            return Fail(bad_reason ? CloseCode::kInvalidPayload : CloseCode::kProtocolError);
+                        }
+                    }
+                    message.opcode = opcode;
+                    message.payload = std::string_view(payload, size);
+                    return http::ParseStatus::kComplete;
+                }
+                if (!fragmented_ && fin) {
+                    if (opcode == Opcode::kText && !IsValidUtf8(std::string_view(payload, size))) {
+                        return Fail(CloseCode::kInvalidPayload);
+                    }
+                    message.opcode = opcode;
+                    message.payload = std::string_view(payload, size);
+                    return http::ParseStatus::kComplete;
+                }
+                if (!fragmented_) {
+                    fragmented_ = true;
+                    fragment_opcode_ = opcode;
+                    fragments_.assign(payload, size);
+                }
+                else {
+                    fragments_.append(payload, size);
+                }
+                if (fin) {
+                    fragmented_ = false;
+                    if (fragment_opcode_ == Opcode::kText && !IsValidUtf8(fragments_)) {
+                        return Fail(CloseCode::kInvalidPayload);
+                    }
+                    message.opcode = fragment_opcode_;
+                    message.payload = fragments_;
+                    return http::ParseStatus::kComplete;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,112 @@
+/// @file websocket.h
+/// @brief WebSocket（RFC 6455）：升级握手、帧解析和序列化。
+///        解析器直接在调用方的接收缓冲区上工作，负载原地去掩码后以视图返回，未分片的消息不拷贝
+/// @author Jyang.
+/// @date 2026-10-19
+/// @version 1.0
+
+#pragma once
+
+#include <http_parser.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace jl {
+    namespace ws {
+
+        constexpr std::size_t kMaxControlPayload = 125;
+        constexpr std::uint64_t kDefaultMaxMessageBytes = 16 * 1024 * 1024;    // 单条消息（分片合并后）的最大字节数
+
+        enum class Opcode : std::uint8_t {
+            kContinuation = 0x0,
+            kText = 0x1,
+            kBinary = 0x2,
+            kClose = 0x8,
+            kPing = 0x9,
+            kPong = 0xa,
+        };
+
+        /// @brief 关闭帧状态码（RFC 6455 7.4.1）
+        enum class CloseCode : std::uint16_t {
+            kNormal = 1000,
+            kGoingAway = 1001,
+            kProtocolError = 1002,
+            kUnsupportedData = 1003,
+            kNoStatus = 1005,           // 只用于表示收到的关闭帧没有状态码，不能发送
+            kInvalidPayload = 1007,     // 文本消息不是合法的 UTF-8
+            kPolicyViolation = 1008,
+            kMessageTooBig = 1009,
+            kInternalError = 1011,
+        };
+
+        inline bool IsControl(Opcode opcode)
+        {
+            return (static_cast<std::uint8_t>(opcode) & 0x8) != 0;
+        }
+
+        /// @brief 请求是否为合法的 WebSocket 升级请求：GET、HTTP/1.1、Upgrade: websocket、
+        ///        Connection 含 upgrade、Sec-WebSocket-Version: 13、Sec-WebSocket-Key 为 16 字节的 base64
+        bool IsUpgradeRequest(const http::Request& request);
+
+        /// @brief Sec-WebSocket-Accept 的值：base64(SHA-1(key + GUID))
+        std::string AcceptKey(std::string_view key);
+
+        /// @brief 101 Switching Protocols 响应追加到 out
+        void AppendHandshakeResponse(std::string& out, std::string_view key);
+
+        /// @brief 帧头追加到 out，调用方随后追加 payload_len 字节的负载。服务端发出的帧不带掩码
+        void AppendFrameHeader(std::string& out, Opcode opcode, std::uint64_t payload_len, bool fin = true);
+
+        /// @brief 完整的帧追加到 out
+        void AppendFrame(std::string& out, Opcode opcode, std::string_view payload, bool fin = true);
+
+        /// @brief 带掩码的帧追加到 out，客户端发出的帧必须带掩码
+        void AppendMaskedFrame(std::string& out, Opcode opcode, std::string_view payload, const std::uint8_t key[4], bool fin = true);
+
+        /// @brief 关闭帧追加到 out，负载为状态码和原因
+        void AppendCloseFrame(std::string& out, CloseCode code, std::string_view reason = {});
+
+        /// @brief 解析关闭帧负载，没有状态码时返回 kNoStatus；负载非法时返回 false
+        bool ParseClosePayload(std::string_view payload, CloseCode& code, std::string_view& reason);
+
+        /// @brief 是否为合法的 UTF-8，ASCII 部分按 8 字节快速跳过
+        bool IsValidUtf8(std::string_view text);
+
+        /// @brief 一条完整的消息。数据消息已合并分片；控制帧（ping/pong/close）可以出现在分片之间，单独返回
+        struct Message {
+            Opcode opcode = Opcode::kText;
+            std::string_view payload;   // 指向接收缓冲区或解析器的分片合并缓冲区，下一次调用 Parse 前有效
+        };
+
+        /// @brief 增量式消息解析器。
+        ///        调用方每次传入缓冲区中未消费的数据（可写，负载原地去掩码），一次解析出至多一条消息；
+        ///        返回后调用方从缓冲区移除 consumed 字节。帧不完整时不消费，等待更多数据。
+        ///        未分片的消息直接返回缓冲区中的视图；分片消息的各片段复制到内部缓冲区，收到最后一片时返回
+        class MessageParser {
+        public:
+            /// @param require_mask 服务端要求客户端的帧带掩码（RFC 6455 5.1），客户端解析服务端的帧时为 false
+            explicit MessageParser(bool require_mask = true, std::uint64_t max_message_bytes = kDefaultMaxMessageBytes);
+
+            /// @brief 解析
+            /// @param consumed 输出本次消费的字节数
+            /// @return kComplete 表示 message 有效；kNeedMore 表示需要更多数据（可能已消费了中间分片）；kError 见 Error()
+            http::ParseStatus Parse(char* data, std::size_t len, std::size_t& consumed, Message& message);
+
+            /// @brief 出错时应在关闭帧中发送的状态码
+            CloseCode Error() const { return error_; }
+
+        private:
+            http::ParseStatus Fail(CloseCode code);
+
+        private:
+            const bool require_mask_;
+            const std::uint64_t max_message_bytes_;
+            bool fragmented_;           // 正在接收分片消息
+            Opcode fragment_opcode_;    // 分片消息的类型
+            std::string fragments_;     // 已收到的分片负载
+            CloseCode error_;
+        };
+    }
+}
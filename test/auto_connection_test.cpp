@@ -0,0 +1,113 @@
+// 单端口协议识别测试：服务端使用 MakeAutoConnection echo，
+// 分别用普通TCP客户端、SSL客户端和“等待服务端先发数据”的客户端连接同一端口
+#include <acceptor.h>
+#include <connection.h>
+#include <global.h>
+#include <logger.h>
+#include <assert.h>
+#include <iostream>
+#include <thread>
+
+constexpr unsigned short kPort = 12347;
+const std::string kGreeting = "hello\n";
+
+std::atomic<int> gPlainCnt = 0;
+std::atomic<int> gSSLCnt = 0;
+
+void OnConnCreated(const std::shared_ptr<jl::IConnection>& conn)
+{
+    (conn->IsSSL() ? gSSLCnt : gPlainCnt).fetch_add(1);
+    conn->SetHandshakeCallback([](const std::shared_ptr<jl::IConnection>& conn) {
+        conn->Write(kGreeting);
+        conn->Read();
+        });
+    conn->SetMessageCommingCallback([](const std::shared_ptr<jl::IConnection>& conn, const std::string& data) {
+        conn->Write(data);
+        });
+    conn->SetWriteFinishCallback([](const std::shared_ptr<jl::IConnection>& conn, std::size_t) {
+        conn->Read();
+        });
+    conn->Handshake();
+}
+
+template <typename Stream>
+void Echo(Stream& stream, const std::string& message)
+{
+    std::string reply(message.size(), '\0');
+    asio::write(stream, asio::buffer(message));
+    asio::read(stream, asio::buffer(&reply[0], reply.size()));
+    assert(reply == message);
+}
+
+int main(int argc, char const *argv[])
+{
+    auto& global = jl::Global::Instance();
+    global.SetCRTFilePath("./resource/server.crt");
+    global.SetPrivateKeyPath("./resource/server.key");
+    global.SetPasswordCallback([](std::size_t, jl::ssl::context::password_purpose) { return ""; });
+    if (!global.InitSSLContext()) {
+        return 1;
+    }
+
+    asio::io_context ioct;
+    auto acceptor = std::make_shared<jl::Acceptor>(ioct, "127.0.0.1", kPort);
+    acceptor->SetConnEstablishCallback([](jl::net::socket&& socket) {
+        jl::MakeAutoConnection(std::move(socket), OnConnCreated);
+        });
+    acceptor->DoAccept();
+    auto work = asio::make_work_guard(ioct);
+    std::vector<std::thread> io_threads;
+    for (int i = 0; i < 2; ++i) {
+        io_threads.emplace_back([&]() { ioct.run(); });
+    }
+
+    asio::io_context client_ioct;
+    jl::net::endpoint endpoint(asio::ip::make_address("127.0.0.1"), kPort);
+
+    // 普通TCP：客户端先发数据，首字节不是TLS握手
+    {
+        jl::net::socket socket(client_ioct);
+        socket.connect(endpoint);
+        asio::write(socket, asio::buffer("ping\n", 5));
+        std::string reply(kGreeting.size() + 5, '\0');
+        asio::read(socket, asio::buffer(&reply[0], reply.size()));
+        assert(reply == kGreeting + "ping\n");
+        Echo(socket, "plain message\n");
+    }
+
+    // SSL
+    {
+        asio::ssl::context ctx(asio::ssl::context::tls_client);
+        ctx.set_verify_mode(asio::ssl::verify_none);
+        asio::ssl::stream<jl::net::socket> stream(client_ioct, ctx);
+        stream.lowest_layer().connect(endpoint);
+        stream.handshake(asio::ssl::stream_base::client);
+        std::string greeting(kGreeting.size(), '\0');
+        asio::read(stream, asio::buffer(&greeting[0], greeting.size()));
+        assert(greeting == kGreeting);
+        Echo(stream, "ssl message\n");
+    }
+
+    // 客户端不发数据，超时后按普通连接处理，服务端先发问候
+    {
+        jl::net::socket socket(client_ioct);
+        socket.connect(endpoint);
+        auto start = std::chrono::steady_clock::now();
+        std::string greeting(kGreeting.size(), '\0');
+        asio::read(socket, asio::buffer(&greeting[0], greeting.size()));
+        assert(greeting == kGreeting);
+        assert(std::chrono::steady_clock::now() - start >= jl::kProtocolSniffTimeout - std::chrono::milliseconds(100));
+    }
+
+    std::cout << "plain: " << gPlainCnt.load() << ", ssl: " << gSSLCnt.load() << std::endl;
+    assert(gPlainCnt == 2);
+    assert(gSSLCnt == 1);
+
+    work.reset();
+    ioct.stop();
+    for (auto& t : io_threads) {
+        t.join();
+    }
+    std::cout << "auto connection test passed." << std::endl;
+    return 0;
+}
@@ -0,0 +1,361 @@
+// 回显吞吐和延迟测试客户端，服务端为 echo_server（同一端口接受明文和TLS）
+// usage: echo_bench [host] [port] [options]
+//   -c <n>           连接数（默认 64）
+//   -m <n>           每个连接同时在途的消息数（默认 16）
+//   -s <sizes>       消息字节数，逗号分隔，每个大小各测一轮（默认 64,1024,16384）
+//   -d <seconds>     每轮统计时长（默认 5），之前先预热 -w 秒（默认 1）
+//   -t <n>           客户端线程数，每个线程一个 io_context（默认 CPU 核数）
+//   --transport <plain|tls|both>  默认两种都测
+//   --json           每轮输出一行 JSON，便于脚本收集
+// 每个连接始终保持 m 条消息在途：回显收齐一条就补发一条（闭环）。延迟为从写出到收齐回显，
+// 记录在每个线程各自的 LatencyHistogram 中，结束后合并输出 p50/p99/p99.9/max 以及 msgs/s、bytes/s。
+// 闭环压测在服务端停顿时会少发请求，掩盖尾延迟；按固定速率发送的开环压测见 tcp_client --rate
+#include <latency_histogram.h>
+#include <asio.hpp>
+#include <asio/ssl.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using asio::ip::tcp;
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t kReadBufferSize = 64 * 1024;
+
+struct BenchConfig {
+    std::string host = "127.0.0.1";
+    std::string port = "12345";
+    int connections = 64;
+    int inflight = 16;
+    std::vector<std::size_t> sizes{ 64, 1024, 16384 };
+    double seconds = 5;
+    double warmup = 1;
+    int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    bool plain = true;
+    bool tls = true;
+    bool json = false;
+};
+
+// 统计窗口，以 Clock 的纳秒计；窗口外完成的消息不计入
+std::atomic<std::int64_t> gWindowBegin{ 0 };
+std::atomic<std::int64_t> gWindowEnd{ 0 };
+
+std::int64_t NowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+/// @brief 每个线程一个 io_context，线程内的连接共用一个直方图，不需要加锁
+struct Worker {
+    asio::io_context ioct;
+    jl::util::LatencyHistogram histogram;
+    std::uint64_t messages = 0;
+    std::uint64_t bytes = 0;
+    std::uint64_t errors = 0;
+    std::thread thread;
+};
+
+template <typename Stream>
+struct IsSslStream : std::false_type {};
+
+template <typename Stream>
+struct IsSslStream<asio::ssl::stream<Stream>> : std::true_type {};
+
+template <typename Stream>
+class EchoClient : public std::enable_shared_from_this<EchoClient<Stream>> {
+public:
+    /// @param payload 所有连接共享的发送数据，至少 inflight * size 字节
+    template <typename... Args>
+    EchoClient(Worker& worker, const std::string& payload, std::size_t size, int inflight, Args&&... args) :
+        stream_(worker.ioct, std::forward<Args>(args)...),
+        worker_(worker),
+        payload_(payload),
+        size_(size),
+        sent_at_(static_cast<std::size_t>(inflight)),
+        head_(0),
+        outstanding_(0),
+        to_send_(static_cast<std::size_t>(inflight)),
+        received_(0),
+        writing_(false)
+    {
+    }
+
+    /// @brief 同步连接并完成TLS握手，在开始计时之前调用
+    bool Connect(const tcp::resolver::results_type& endpoints)
+    {
+        std::error_code ec;
+        asio::connect(stream_.lowest_layer(), endpoints, ec);
+        if (ec) {
+            std::cerr << "connect failed: " << ec.message() << "\n";
+            return false;
+        }
+        stream_.lowest_layer().set_option(tcp::no_delay(true));
+        if constexpr (IsSslStream<Stream>::value) {
+            stream_.handshake(asio::ssl::stream_base::client, ec);
+            if (ec) {
+                std::cerr << "handshake failed: " << ec.message() << "\n";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void Start()
+    {
+        Flush();
+        Read();
+    }
+
+private:
+    /// @brief 把所有待发送的消息合并成一次写，写出时间记为这些消息的发送时间
+    void Flush()
+    {
+        if (writing_ || to_send_ == 0) {
+            return;
+        }
+        const std::size_t n = to_send_;
+        to_send_ = 0;
+        const std::int64_t now = NowNs();
+        for (std::size_t i = 0; i < n; ++i) {
+            sent_at_[(head_ + outstanding_) % sent_at_.size()] = now;
+            ++outstanding_;
+        }
+        writing_ = true;
+        auto self = this->shared_from_this();
+        asio::async_write(stream_, asio::buffer(payload_.data(), n * size_), [self](std::error_code ec, std::size_t) {
+            self->writing_ = false;
+            if (ec) {
+                ++self->worker_.errors;
+                return;
+            }
+            self->Flush();
+            });
+    }
+
+    void Read()
+    {
+        auto self = this->shared_from_this();
+        stream_.async_read_some(asio::buffer(buffer_), [self](std::error_code ec, std::size_t length) {
+            if (ec) {
+                ++self->worker_.errors;
+                return;
+            }
+            self->OnRead(length);
+            });
+    }
+
+    void OnRead(std::size_t length)
+    {
+        // 回显是字节流，按发送顺序每收齐 size_ 字节完成一条消息
+        received_ += length;
+        const std::int64_t now = NowNs();
+        const bool counted = now >= gWindowBegin.load(std::memory_order_relaxed) && now < gWindowEnd.load(std::memory_order_relaxed);
+        while (received_ >= size_ && outstanding_ > 0) {
+            received_ -= size_;
+            if (counted) {
+                worker_.histogram.Record(static_cast<std::uint64_t>(now - sent_at_[head_]));
+                ++worker_.messages;
+                worker_.bytes += size_;
+            }
+            head_ = (head_ + 1) % sent_at_.size();
+            --outstanding_;
+            ++to_send_;
+        }
+        Flush();
+        Read();
+    }
+
+private:
+    Stream stream_;
+    Worker& worker_;
+    const std::string& payload_;
+    const std::size_t size_;
+    std::vector<std::int64_t> sent_at_;     // 在途消息的发送时间，环形队列
+    std::size_t head_;                      // 最早的在途消息
+    std::size_t outstanding_;               // 已写出、还没收齐回显的消息数
+    std::size_t to_send_;                   // 等待写出的消息数
+    std::size_t received_;                  // 最早的在途消息已收到的字节数
+    bool writing_;
+    std::array<char, kReadBufferSize> buffer_;
+};
+
+struct RunResult {
+    jl::util::LatencyHistogram histogram;
+    std::uint64_t messages = 0;
+    std::uint64_t bytes = 0;
+    std::uint64_t errors = 0;
+    double seconds = 0;
+};
+
+/// @brief 以 tls 指定的传输方式、size 字节的消息测一轮
+bool Run(const BenchConfig& config, bool tls, std::size_t size, RunResult& result)
+{
+    asio::ssl::context ssl_ctx(asio::ssl::context::tls_client);
+    ssl_ctx.set_verify_mode(asio::ssl::verify_none);
+    const std::string payload(size * static_cast<std::size_t>(config.inflight), 'x');
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int i = 0; i < config.threads; ++i) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    auto endpoints = tcp::resolver(workers[0]->ioct).resolve(config.host, config.port);
+    using PlainClient = EchoClient<tcp::socket>;
+    using TlsClient = EchoClient<asio::ssl::stream<tcp::socket>>;
+    std::vector<std::shared_ptr<PlainClient>> plain_clients;
+    std::vector<std::shared_ptr<TlsClient>> tls_clients;
+    for (int i = 0; i < config.connections; ++i) {
+        Worker& worker = *workers[static_cast<std::size_t>(i) % workers.size()];
+        if (tls) {
+            auto client = std::make_shared<TlsClient>(worker, payload, size, config.inflight, ssl_ctx);
+            if (!client->Connect(endpoints)) {
+                return false;
+            }
+            tls_clients.push_back(std::move(client));
+        }
+        else {
+            auto client = std::make_shared<PlainClient>(worker, payload, size, config.inflight);
+            if (!client->Connect(endpoints)) {
+                return false;
+            }
+            plain_clients.push_back(std::move(client));
+        }
+    }
+
+    for (auto& client : plain_clients) {
+        client->Start();
+    }
+    for (auto& client : tls_clients) {
+        client->Start();
+    }
+    const std::int64_t now = NowNs();
+    const std::int64_t warmup = static_cast<std::int64_t>(config.warmup * 1e9);
+    const std::int64_t duration = static_cast<std::int64_t>(config.seconds * 1e9);
+    gWindowBegin = now + warmup;
+    gWindowEnd = now + warmup + duration;
+    for (auto& worker : workers) {
+        Worker* w = worker.get();
+        w->thread = std::thread([w]() { w->ioct.run(); });
+    }
+    std::this_thread::sleep_for(std::chrono::nanoseconds(warmup + duration));
+    for (auto& worker : workers) {
+        worker->ioct.stop();
+        worker->thread.join();
+        result.histogram.Merge(worker->histogram);
+        result.messages += worker->messages;
+        result.bytes += worker->bytes;
+        result.errors += worker->errors;
+    }
+    result.seconds = config.seconds;
+    return true;
+}
+
+void Print(const BenchConfig& config, bool tls, std::size_t size, const RunResult& result)
+{
+    const auto& h = result.histogram;
+    const double msgs = result.messages / result.seconds;
+    const double bytes = result.bytes / result.seconds;
+    if (config.json) {
+        std::printf("{\"transport\":\"%s\",\"connections\":%d,\"inflight\":%d,\"size\":%zu,\"seconds\":%.3f,"
+            "\"messages\":%llu,\"errors\":%llu,\"msgs_per_sec\":%.1f,\"bytes_per_sec\":%.1f,"
+            "\"latency_us\":{\"mean\":%.2f,\"p50\":%.2f,\"p99\":%.2f,\"p999\":%.2f,\"max\":%.2f}}\n",
+            tls ? "tls" : "plain", config.connections, config.inflight, size, result.seconds,
+            static_cast<unsigned long long>(result.messages), static_cast<unsigned long long>(result.errors), msgs, bytes,
+            h.Mean() / 1e3, h.Percentile(50) / 1e3, h.Percentile(99) / 1e3, h.Percentile(99.9) / 1e3, h.Max() / 1e3);
+    }
+    else {
+        std::printf("%-5s %7zuB  %10.0f msgs/s  %9.2f MB/s  latency us: p50 %8.1f  p99 %8.1f  p99.9 %8.1f  max %8.1f  (%llu msgs, %llu errors)\n",
+            tls ? "tls" : "plain", size, msgs, bytes / (1024 * 1024),
+            h.Percentile(50) / 1e3, h.Percentile(99) / 1e3, h.Percentile(99.9) / 1e3, h.Max() / 1e3,
+            static_cast<unsigned long long>(result.messages), static_cast<unsigned long long>(result.errors));
+    }
+    std::fflush(stdout);
+}
+
+std::vector<std::size_t> ParseSizes(const std::string& text)
+{
+    std::vector<std::size_t> sizes;
+    std::size_t begin = 0;
+    while (begin < text.size()) {
+        std::size_t end = text.find(',', begin);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+        if (end > begin) {
+            sizes.push_back(std::stoul(text.substr(begin, end - begin)));
+        }
+        begin = end + 1;
+    }
+    return sizes;
+}
+
+int main(int argc, char const *argv[])
+{
+    BenchConfig config;
+    int positional = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-c" && i + 1 < argc) {
+            config.connections = std::stoi(argv[++i]);
+        }
+        else if (arg == "-m" && i + 1 < argc) {
+            config.inflight = std::stoi(argv[++i]);
+        }
+        else if (arg == "-s" && i + 1 < argc) {
+            config.sizes = ParseSizes(argv[++i]);
+        }
+        else if (arg == "-d" && i + 1 < argc) {
+            config.seconds = std::stod(argv[++i]);
+        }
+        else if (arg == "-w" && i + 1 < argc) {
+            config.warmup = std::stod(argv[++i]);
+        }
+        else if (arg == "-t" && i + 1 < argc) {
+            config.threads = std::stoi(argv[++i]);
+        }
+        else if (arg == "--transport" && i + 1 < argc) {
+            std::string transport = argv[++i];
+            config.plain = transport != "tls";
+            config.tls = transport != "plain";
+        }
+        else if (arg == "--json") {
+            config.json = true;
+        }
+        else if (positional == 0) {
+            config.host = arg;
+            ++positional;
+        }
+        else {
+            config.port = arg;
+            ++positional;
+        }
+    }
+    if (config.connections <= 0 || config.inflight <= 0 || config.threads <= 0 || config.sizes.empty()) {
+        std::cerr << "invalid arguments\n";
+        return 1;
+    }
+    if (!config.json) {
+        std::printf("target %s:%s, %d connections x %d in flight, %d threads, %.1fs per run after %.1fs warmup\n",
+            config.host.c_str(), config.port.c_str(), config.connections, config.inflight, config.threads, config.seconds, config.warmup);
+    }
+    for (bool tls : { false, true }) {
+        if ((tls && !config.tls) || (!tls && !config.plain)) {
+            continue;
+        }
+        for (std::size_t size : config.sizes) {
+            RunResult result;
+            if (!Run(config, tls, size, result)) {
+                return 1;
+            }
+            Print(config, tls, size, result);
+        }
+    }
+    return 0;
+}
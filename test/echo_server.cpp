@@ -1,6 +1,84 @@
+// 回显服务端，配合 echo_bench 测试吞吐和延迟
+// usage: echo_server [port] [-t io_threads]
+// 同一端口同时接受明文和TLS连接（MakeAutoConnection），证书为 ./resource/server.crt
+// 收到的数据原样写回，写出的同时继续读取；积压超过 kMaxPendingBytes 时暂停读取，由写完成回调恢复
 #include <server.h>
+#include <global.h>
 #include <logger.h>
 #include <timer.h>
+#include <algorithm>
+#include <mutex>
+
+constexpr std::size_t kMaxPendingBytes = 1024 * 1024;   // 每个连接已提交但未写完的字节数上限
+constexpr std::size_t kIdleTimeout = 10000;             // 毫秒
+
+class EchoSession : public std::enable_shared_from_this<EchoSession>
+{
+public:
+    explicit EchoSession(const std::shared_ptr<jl::IConnection>& conn) :
+        conn_(conn), timer_(std::make_shared<jl::Timer>(conn)), pending_bytes_(0), paused_(false)
+    {
+    }
+
+    void Start()
+    {
+        // 回调持有会话，连接关闭后随连接一起释放
+        auto self = shared_from_this();
+        std::weak_ptr<jl::IConnection> weak = conn_;
+        timer_->SetCallback([weak]() {
+            if (auto conn = weak.lock()) {
+                LOG_ERROR("Connection timeout");
+                conn->Close();
+            }
+            });
+        conn_->SetHandshakeCallback([self](const std::shared_ptr<jl::IConnection>& conn) {
+            self->timer_->Wait(kIdleTimeout);
+            conn->Read();
+            });
+        conn_->SetMessageCommingCallback([self](const std::shared_ptr<jl::IConnection>& conn, const std::string& buffer) {
+            self->timer_->Cancel();
+            bool read = false;
+            {
+                // 读完成和写完成回调可能在不同的io线程中并发执行
+                std::lock_guard<std::mutex> lock(self->mutex_);
+                self->pending_bytes_ += buffer.size();
+                conn->Write(buffer);
+                read = self->pending_bytes_ < kMaxPendingBytes;
+                self->paused_ = !read;
+            }
+            if (read) {
+                conn->Read();
+            }
+            self->timer_->Wait(kIdleTimeout);
+            });
+        conn_->SetWriteFinishCallback([self](const std::shared_ptr<jl::IConnection>& conn, std::size_t bytes_transferred) {
+            bool read = false;
+            {
+                std::lock_guard<std::mutex> lock(self->mutex_);
+                self->pending_bytes_ -= std::min(self->pending_bytes_, bytes_transferred);
+                read = self->paused_ && self->pending_bytes_ < kMaxPendingBytes;
+                if (read) {
+                    self->paused_ = false;
+                }
+            }
+            if (read) {
+                conn->Read();
+            }
+            });
+        conn_->SetConnCloseCallback([self](const std::shared_ptr<jl::IConnection>&) {
+            self->timer_->Cancel();
+            self->conn_.reset();
+            });
+        conn_->Handshake();
+    }
+
+private:
+    std::shared_ptr<jl::IConnection> conn_;
+    std::shared_ptr<jl::Timer> timer_;
+    std::mutex mutex_;
+    std::size_t pending_bytes_;
+    bool paused_;       // 积压过多，暂停了读取
+};
 
 class EchoServer
 {
@@ -8,44 +86,17 @@ public:
     EchoServer(asio::io_context &ioct, const std::string &ip, unsigned short port) : tcp_server_(ioct, ip, port) {
         tcp_server_.DoAwaitStop();
         tcp_server_.SetConnEstablishCallback([=](jl::net::socket&& socket){
-            auto conn = jl::MakeConnection(std::move(socket));
-            auto timer = std::make_shared<jl::Timer>(conn);
-            std::weak_ptr<jl::IConnection> weak = conn;
-            timer->SetCallback([weak]() {
-                auto conn = weak.lock();
-                LOG_ERROR("TimeoutCallback");
-                if (conn) {
-                    conn->Close();
-                }
-                });
-
-			conn->SetMessageCommingCallback([=](const std::shared_ptr<jl::IConnection>& conn, const std::string& buffer) {
-                timer->Cancel();
-                std::string data(static_cast<const char*>(buffer.data()),buffer.size());
-                LOG_DEBUG("MessageCommingCallback: {}", data);
-                conn->Write(data+"1");
-                conn->Write(data+"2");
-                conn->Write(data+"3");
-                timer->Wait(10000);
-                });
-            conn->SetWriteFinishCallback([=](const std::shared_ptr<jl::IConnection>& conn, std::size_t read_bytes) {
-                timer->Cancel();
-                LOG_DEBUG("WriteFinishCallback");
-                conn->Read();
-                timer->Wait(10000);
-                });
-            conn->SetConnCloseCallback([=](const std::shared_ptr<jl::IConnection>& conn) {
-                LOG_DEBUG("CloseCallback");
+            // 小消息往返时不等待 Nagle 合并
+            std::error_code ec;
+            socket.set_option(asio::ip::tcp::no_delay(true), ec);
+            jl::MakeAutoConnection(std::move(socket), [](const std::shared_ptr<jl::IConnection>& conn) {
+                std::make_shared<EchoSession>(conn)->Start();
                 });
-            //conn->ReadUntil("world");
-            timer->Wait(10000);
-            conn->Read();
-
         });
 
     }
 
-    void Start() { tcp_server_.Start(); }
+    void Start(std::size_t thread_cnt) { tcp_server_.Start(thread_cnt); }
 
 private:
     jl::Server tcp_server_;
@@ -53,9 +104,29 @@ private:
 
 int main(int argc, char const *argv[])
 {
+    unsigned short port = 12345;
+    std::size_t thread_cnt = std::thread::hardware_concurrency();
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-t" && i + 1 < argc) {
+            thread_cnt = std::stoul(argv[++i]);
+        }
+        else {
+            port = static_cast<unsigned short>(std::stoul(arg));
+        }
+    }
+
+    auto& global = jl::Global::Instance();
+    global.SetCRTFilePath("./resource/server.crt");
+    global.SetPrivateKeyPath("./resource/server.key");
+    global.SetPasswordCallback([](std::size_t, jl::ssl::context::password_purpose) { return ""; });
+    if (!global.InitSSLContext()) {
+        LOG_ERROR("TLS disabled, certificate not found");
+    }
+
     asio::io_context ioct;
-    EchoServer server(ioct, "127.0.0.1", 12345);
-    //data("hello world", 11);
-    server.Start();
+    EchoServer server(ioct, "127.0.0.1", port);
+    LOG_INFO("Echo server on port {}, io threads: {}", port, thread_cnt);
+    server.Start(thread_cnt);
     return 0;
 }
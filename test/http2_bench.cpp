@@ -0,0 +1,353 @@
+// HTTP/2 吞吐和内存测试，服务端和客户端在同一进程内，走明文TCP（h2c prior knowledge）
+// usage: http2_bench [seconds] [connections] [idle_connections]
+// 1. 吞吐：每个客户端连接一次发出 N 个并发流的请求，收齐所有响应后再发下一批，
+//    对比 N=1（等同于 HTTP/1.1 逐个请求）与多路复用时的 streams/s
+// 2. 内存：建立大量完成过一次请求的空闲连接，统计服务端每个连接的 ServerSession 与接收缓冲区占用，
+//    以及进程 RSS 的增量（包含同进程客户端的内存）
+#include <acceptor.h>
+#include <connection.h>
+#include <http2.h>
+#include <assert.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+constexpr unsigned short kPort = 12348;
+constexpr std::size_t kMaxPendingWriteBytes = 256 * 1024;
+constexpr std::uint32_t kClientWindow = 16 * 1024 * 1024;
+
+const auto gBody = std::make_shared<const std::string>("<html><body>hello, h2</body></html>");
+
+class H2Session;
+std::mutex gSessionsMutex;
+std::vector<std::weak_ptr<H2Session>> gSessions;
+
+class H2Session : public std::enable_shared_from_this<H2Session> {
+public:
+    explicit H2Session(const std::shared_ptr<jl::IConnection>& conn) : conn_(conn), pending_bytes_(0)
+    {
+        session_.SetRequestCallback([this](std::uint32_t stream_id, const jl::http::Request&, std::string_view) {
+            headers_.clear();
+            headers_.push_back(jl::http::Header{ "content-type", "text/html; charset=UTF-8" });
+            headers_.push_back(jl::http::Header{ "content-length", length_ });
+            session_.Respond(stream_id, 200, headers_, *gBody, gBody);
+            });
+    }
+
+    void Start()
+    {
+        // 回调持有会话，连接关闭后 conn_ 置空打破引用环
+        auto self = shared_from_this();
+        conn_->SetMessageCommingCallback([self](const std::shared_ptr<jl::IConnection>& conn, const std::string& data) {
+            bool closed;
+            {
+                std::lock_guard<std::mutex> lock(self->mutex_);
+                self->buffer_.append(data);
+                closed = self->Process();
+            }
+            // Close 会同步回调关闭回调，不能持有锁
+            if (closed) {
+                conn->Close();
+            }
+            else {
+                conn->Read();
+            }
+            });
+        conn_->SetWriteFinishCallback([self](const std::shared_ptr<jl::IConnection>& conn, std::size_t bytes) {
+            bool closed;
+            {
+                std::lock_guard<std::mutex> lock(self->mutex_);
+                self->pending_bytes_ -= bytes;
+                closed = self->Flush();
+            }
+            if (closed) {
+                conn->Close();
+            }
+            });
+        conn_->SetConnCloseCallback([self](const std::shared_ptr<jl::IConnection>&) {
+            std::lock_guard<std::mutex> lock(self->mutex_);
+            self->conn_.reset();
+            });
+        {
+            std::lock_guard<std::mutex> lock(gSessionsMutex);
+            gSessions.push_back(self);
+        }
+        conn_->Read();
+    }
+
+    /// @brief 服务端为这个连接保留的内存：会话对象、引擎和接收缓冲区
+    std::size_t MemoryUsage()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return sizeof(*this) + session_.MemoryUsage() + buffer_.capacity() + headers_.capacity() * sizeof(jl::http::Header);
+    }
+
+private:
+    /// @return 连接已结束，调用方释放锁后关闭连接
+    bool Process()
+    {
+        std::size_t consumed = 0;
+        session_.Receive(buffer_.data(), buffer_.size(), consumed);
+        buffer_.erase(0, consumed);
+        return Flush();
+    }
+
+    bool Flush()
+    {
+        if (!conn_) {
+            return false;
+        }
+        session_.Flush(pending_bytes_ < kMaxPendingWriteBytes ? kMaxPendingWriteBytes - pending_bytes_ : 0);
+        std::string& output = session_.Output();
+        if (!output.empty()) {
+            pending_bytes_ += output.size();
+            conn_->Write(output);
+            output.clear();
+        }
+        return session_.Closed() && pending_bytes_ == 0;
+    }
+
+private:
+    std::mutex mutex_;
+    std::shared_ptr<jl::IConnection> conn_;
+    jl::http2::ServerSession session_;
+    std::string buffer_;
+    std::vector<jl::http::Header> headers_;
+    const std::string length_ = std::to_string(gBody->size());
+    std::size_t pending_bytes_;
+};
+
+// 阻塞客户端：一次发出一批 HEADERS，读取帧直到这一批的流全部结束
+class Client {
+public:
+    explicit Client(asio::io_context& ioct) : socket_(ioct), next_stream_id_(1), unacked_data_(0)
+    {
+        socket_.connect(asio::ip::tcp::endpoint(asio::ip::make_address("127.0.0.1"), kPort));
+        socket_.set_option(asio::ip::tcp::no_delay(true));
+        out_.assign(jl::http2::kClientPreface);
+        jl::http2::AppendSettings(out_, { { jl::http2::SettingId::kEnablePush, 0 }, { jl::http2::SettingId::kInitialWindowSize, kClientWindow } });
+        jl::http2::AppendWindowUpdate(out_, 0, kClientWindow - jl::http2::kDefaultWindowSize);
+        asio::write(socket_, asio::buffer(out_));
+    }
+
+    /// @brief 发出 streams 个 GET 请求并等待全部响应，返回收到的响应体字节数
+    std::size_t Batch(int streams)
+    {
+        out_.clear();
+        for (int i = 0; i < streams; ++i) {
+            block_.clear();
+            encoder_.Encode(block_, ":method", "GET");
+            encoder_.Encode(block_, ":scheme", "http");
+            encoder_.Encode(block_, ":path", "/bench");
+            encoder_.Encode(block_, ":authority", "127.0.0.1");
+            jl::http2::AppendFrameHeader(out_, static_cast<std::uint32_t>(block_.size()), jl::http2::FrameType::kHeaders,
+                jl::http2::flags::kEndHeaders | jl::http2::flags::kEndStream, next_stream_id_);
+            out_.append(block_);
+            next_stream_id_ += 2;
+        }
+        asio::write(socket_, asio::buffer(out_));
+
+        std::size_t body_bytes = 0;
+        int remaining = streams;
+        while (remaining > 0) {
+            const jl::http2::FrameHeader header = NextFrame();
+            const char* payload = buffer_.data() + offset_ + jl::http2::kFrameHeaderSize;
+            switch (header.type) {
+            case jl::http2::FrameType::kHeaders:
+            {
+                // 解码以保持与服务端编码器的动态表同步
+                fields_.clear();
+                bool ok = decoder_.Decode(std::string_view(payload, header.length), fields_);
+                assert(ok && (header.flags & jl::http2::flags::kEndHeaders));
+                (void)ok;
+                break;
+            }
+            case jl::http2::FrameType::kData:
+                body_bytes += header.length;
+                unacked_data_ += header.length;
+                break;
+            case jl::http2::FrameType::kSettings:
+                if (!(header.flags & jl::http2::flags::kAck)) {
+                    std::string ack;
+                    jl::http2::AppendFrameHeader(ack, 0, jl::http2::FrameType::kSettings, jl::http2::flags::kAck, 0);
+                    asio::write(socket_, asio::buffer(ack));
+                }
+                break;
+            default:
+                assert(header.type == jl::http2::FrameType::kWindowUpdate);
+                break;
+            }
+            if ((header.type == jl::http2::FrameType::kHeaders || header.type == jl::http2::FrameType::kData)
+                && (header.flags & jl::http2::flags::kEndStream)) {
+                --remaining;
+            }
+            offset_ += jl::http2::kFrameHeaderSize + header.length;
+        }
+        // 连接窗口用掉一半时补充
+        if (unacked_data_ > kClientWindow / 2) {
+            std::string update;
+            jl::http2::AppendWindowUpdate(update, 0, static_cast<std::uint32_t>(unacked_data_));
+            asio::write(socket_, asio::buffer(update));
+            unacked_data_ = 0;
+        }
+        return body_bytes;
+    }
+
+    void Close()
+    {
+        socket_.close();
+    }
+
+private:
+    jl::http2::FrameHeader NextFrame()
+    {
+        while (true) {
+            const std::size_t available = buffer_.size() - offset_;
+            if (available >= jl::http2::kFrameHeaderSize) {
+                jl::http2::FrameHeader header = jl::http2::ParseFrameHeader(buffer_.data() + offset_);
+                if (available >= jl::http2::kFrameHeaderSize + header.length) {
+                    return header;
+                }
+            }
+            buffer_.erase(0, offset_);
+            offset_ = 0;
+            std::size_t n = socket_.read_some(asio::buffer(chunk_));
+            buffer_.append(chunk_, n);
+        }
+    }
+
+private:
+    asio::ip::tcp::socket socket_;
+    jl::http2::HpackEncoder encoder_;
+    jl::http2::HpackDecoder decoder_;
+    std::vector<jl::http2::HeaderField> fields_;
+    std::uint32_t next_stream_id_;
+    std::size_t unacked_data_;
+    std::string out_;
+    std::string block_;
+    std::string buffer_;
+    std::size_t offset_ = 0;
+    char chunk_[64 * 1024];
+};
+
+void BenchStreams(double seconds, int connections, int streams)
+{
+    std::atomic<std::size_t> total{ 0 };
+    std::atomic<bool> stop{ false };
+    std::vector<std::thread> clients;
+    auto start = std::chrono::steady_clock::now();
+    for (int c = 0; c < connections; ++c) {
+        clients.emplace_back([&]() {
+            asio::io_context ioct;
+            auto client = std::make_unique<Client>(ioct);
+            std::size_t n = 0;
+            while (!stop) {
+                std::size_t bytes = client->Batch(streams);
+                assert(bytes == gBody->size() * streams);
+                (void)bytes;
+                n += streams;
+            }
+            total += n;
+            client->Close();
+            });
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop = true;
+    for (auto& t : clients) {
+        t.join();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%3d connections x %4d concurrent streams %12.0f streams/s\n", connections, streams, total / elapsed);
+}
+
+std::size_t ResidentBytes()
+{
+    std::ifstream statm("/proc/self/statm");
+    std::size_t size = 0, resident = 0;
+    statm >> size >> resident;
+    return resident * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+}
+
+/// @brief 所有存活的服务端会话占用的内存总和
+std::size_t SessionMemory(std::size_t& sessions)
+{
+    std::lock_guard<std::mutex> lock(gSessionsMutex);
+    std::size_t bytes = 0;
+    sessions = 0;
+    for (const auto& weak : gSessions) {
+        if (auto session = weak.lock()) {
+            bytes += session->MemoryUsage();
+            ++sessions;
+        }
+    }
+    return bytes;
+}
+
+void BenchIdleMemory(int connections)
+{
+    {
+        std::lock_guard<std::mutex> lock(gSessionsMutex);
+        gSessions.clear();
+    }
+    const std::size_t rss_before = ResidentBytes();
+    asio::io_context ioct;
+    std::vector<std::unique_ptr<Client>> clients;
+    for (int i = 0; i < connections; ++i) {
+        clients.push_back(std::make_unique<Client>(ioct));
+        clients.back()->Batch(1);
+    }
+    const std::size_t rss_after = ResidentBytes();
+    std::size_t sessions = 0;
+    const std::size_t bytes = SessionMemory(sessions);
+    assert(sessions == static_cast<std::size_t>(connections));
+    std::printf("%d idle connections: server session %zu bytes/connection, process RSS +%zu bytes/connection (client included)\n",
+        connections, bytes / sessions, (rss_after > rss_before ? rss_after - rss_before : 0) / connections);
+    for (auto& client : clients) {
+        client->Close();
+    }
+}
+
+int main(int argc, char const* argv[])
+{
+    double seconds = argc > 1 ? std::stod(argv[1]) : 3.0;
+    int connections = argc > 2 ? std::stoi(argv[2]) : 4;
+    int idle_connections = argc > 3 ? std::stoi(argv[3]) : 1000;
+
+    asio::io_context ioct;
+    auto acceptor = std::make_shared<jl::Acceptor>(ioct, "127.0.0.1", kPort);
+    acceptor->SetConnEstablishCallback([&](jl::net::socket&& socket) {
+        socket.set_option(asio::ip::tcp::no_delay(true));
+        std::make_shared<H2Session>(jl::MakeConnection(std::move(socket)))->Start();
+        });
+    acceptor->DoAccept();
+    auto guard = asio::make_work_guard(ioct);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < connections; ++i) {
+        workers.emplace_back([&]() { ioct.run(); });
+    }
+
+    for (int streams : { 1, 16, 100 }) {
+        BenchStreams(seconds, 1, streams);
+    }
+    for (int streams : { 1, 16, 100 }) {
+        BenchStreams(seconds, connections, streams);
+    }
+    BenchIdleMemory(idle_connections);
+
+    ioct.stop();
+    for (auto& t : workers) {
+        t.join();
+    }
+    {
+        std::lock_guard<std::mutex> lock(gSessionsMutex);
+        gSessions.clear();
+    }
+    return 0;
+}
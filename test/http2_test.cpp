@@ -0,0 +1,686 @@
+// HTTP/2 测试：HPACK 整数、Huffman 和 RFC 7541 附录 C 的示例，编解码往返和动态表大小更新；
+// ServerSession 的请求分发、请求体、多路复用、流量控制、CONTINUATION、并发流上限和各种协议错误
+#include <http2.h>
+#include <assert.h>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+using jl::http2::ErrorCode;
+using jl::http2::FrameHeader;
+using jl::http2::FrameType;
+using jl::http2::HeaderField;
+using jl::http2::HpackDecoder;
+using jl::http2::HpackEncoder;
+using jl::http2::ServerSession;
+using jl::http2::SettingId;
+namespace flags = jl::http2::flags;
+
+std::string Hex(const std::string& hex)
+{
+    std::string out;
+    for (std::size_t i = 0; i + 1 < hex.size(); ) {
+        if (hex[i] == ' ') {
+            ++i;
+            continue;
+        }
+        out.push_back(static_cast<char>(std::stoi(hex.substr(i, 2), nullptr, 16)));
+        i += 2;
+    }
+    return out;
+}
+
+void TestInteger()
+{
+    // RFC 7541 C.1
+    std::string out;
+    jl::http2::AppendInteger(out, 0, 5, 10);
+    assert(out == Hex("0a"));
+    out.clear();
+    jl::http2::AppendInteger(out, 0, 5, 1337);
+    assert(out == Hex("1f 9a 0a"));
+    out.clear();
+    jl::http2::AppendInteger(out, 0, 8, 42);
+    assert(out == Hex("2a"));
+}
+
+void TestHuffman()
+{
+    // RFC 7541 C.4.1 和 C.6.1
+    std::string out;
+    jl::http2::HuffmanEncode(out, "www.example.com");
+    assert(out == Hex("f1e3 c2e5 f23a 6ba0 ab90 f4ff"));
+    assert(jl::http2::HuffmanEncodedSize("www.example.com") == out.size());
+    out.clear();
+    jl::http2::HuffmanEncode(out, "Mon, 21 Oct 2013 20:13:21 GMT");
+    assert(out == Hex("d07a be94 1054 d444 a820 0595 040b 8166 e082 a62d 1bff"));
+
+    // 所有字节值的往返
+    std::mt19937 rng(7);
+    for (int round = 0; round < 200; ++round) {
+        std::string text(rng() % 64, '\0');
+        for (auto& c : text) {
+            c = static_cast<char>(rng());
+        }
+        std::string encoded, decoded;
+        jl::http2::HuffmanEncode(encoded, text);
+        bool ok = jl::http2::HuffmanDecode(encoded, decoded);
+        assert(ok && decoded == text);
+    }
+    // 填充超过7位，填充不是全1
+    std::string decoded;
+    bool ok = jl::http2::HuffmanDecode(Hex("f1e3 c2e5 f23a 6ba0 ab90 f4ff ff"), decoded);
+    assert(!ok);
+    decoded.clear();
+    ok = jl::http2::HuffmanDecode(Hex("f1e3 c2e5 f23a 6ba0 ab90 f4fe"), decoded);
+    assert(!ok);
+}
+
+std::map<std::string, std::string> ToMap(const std::vector<HeaderField>& fields)
+{
+    std::map<std::string, std::string> map;
+    for (const auto& field : fields) {
+        map[field.name] = field.value;
+    }
+    return map;
+}
+
+void TestDecoderExamples()
+{
+    // RFC 7541 C.4：同一连接上的三个请求，使用 Huffman 编码，动态表在请求之间共享
+    HpackDecoder decoder;
+    std::vector<HeaderField> fields;
+    bool ok = decoder.Decode(Hex("8286 8441 8cf1 e3c2 e5f2 3a6b a0ab 90f4 ff"), fields);
+    assert(ok);
+    assert(fields.size() == 4 && fields[0].name == ":method" && fields[0].value == "GET");
+    assert(fields[3].name == ":authority" && fields[3].value == "www.example.com");
+    assert(decoder.Table().Size() == 57);
+
+    fields.clear();
+    ok = decoder.Decode(Hex("8286 84be 5886 a8eb 1064 9cbf"), fields);
+    assert(ok);
+    assert(fields.size() == 5 && fields[3].value == "www.example.com" && fields[4].name == "cache-control" && fields[4].value == "no-cache");
+    assert(decoder.Table().Size() == 110);
+
+    fields.clear();
+    ok = decoder.Decode(Hex("8287 85bf 4088 25a8 49e9 5ba9 7d7f 8925 a849 e95b b8e8 b4bf"), fields);
+    assert(ok);
+    auto map = ToMap(fields);
+    assert(map[":scheme"] == "https" && map[":path"] == "/index.html" && map["custom-key"] == "custom-value");
+    assert(decoder.Table().Size() == 164 && decoder.Table().Count() == 3);
+
+    // 索引越界、超过上限的动态表大小更新、头部块中间的大小更新、截断的字符串
+    HpackDecoder bad;
+    ok = bad.Decode(Hex("ff 00"), fields);
+    assert(!ok);
+    ok = bad.Decode(Hex("3f e2 1f"), fields);              // 4097 > 4096
+    assert(!ok);
+    ok = bad.Decode(Hex("82 20"), fields);
+    assert(!ok);
+    ok = bad.Decode(Hex("40 05 61 62"), fields);
+    assert(!ok);
+}
+
+void TestEncoderRoundTrip()
+{
+    HpackEncoder encoder;
+    HpackDecoder decoder;
+    std::mt19937 rng(11);
+    const char* names[] = { ":status", "content-type", "x-request-id", "cache-control", "date", "etag", "Server" };
+    for (int block = 0; block < 300; ++block) {
+        if (block == 100) {
+            encoder.SetMaxTableSize(0);
+            encoder.SetMaxTableSize(256);
+        }
+        std::vector<HeaderField> expected;
+        std::string out;
+        for (int i = 0; i < 6; ++i) {
+            std::string name = names[rng() % 7];
+            std::string value = std::to_string(rng() % 5);
+            encoder.Encode(out, name, value, name == "x-request-id");
+            for (auto& c : name) {
+                c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+            }
+            expected.push_back(HeaderField{ name, value });
+        }
+        std::vector<HeaderField> fields;
+        bool ok = decoder.Decode(out, fields);
+        assert(ok);
+        assert(fields.size() == expected.size());
+        for (std::size_t i = 0; i < fields.size(); ++i) {
+            assert(fields[i].name == expected[i].name && fields[i].value == expected[i].value);
+        }
+        assert(decoder.Table().Size() == encoder.Table().Size());
+        if (block > 100) {
+            assert(decoder.Table().MaxSize() == 256);
+        }
+    }
+
+    // 同样的响应头第二次编码时命中静态表或动态表，每个字段一个字节；content-length 不加入动态表
+    HpackEncoder fresh;
+    std::string first, second;
+    for (std::string* out : { &first, &second }) {
+        fresh.Encode(*out, ":status", "200");
+        fresh.Encode(*out, "content-type", "text/html; charset=UTF-8");
+        fresh.Encode(*out, "server", "jl_tcpserver");
+        fresh.Encode(*out, "content-length", "1234");
+    }
+    assert(second.size() == 3 + 2 + 4 && second.size() < first.size() / 3);
+}
+
+// 测试用的客户端：手工构造帧，解析服务端输出的帧
+struct Frame {
+    FrameHeader header;
+    std::string payload;
+};
+
+class TestClient {
+public:
+    explicit TestClient(ServerSession& server) : server_(server)
+    {
+        data_.append(jl::http2::kClientPreface);
+        jl::http2::AppendSettings(data_, {});
+    }
+
+    /// @brief 用客户端的编码器编码头部块，与服务端的动态表保持一致
+    std::string Block(const std::vector<std::pair<std::string, std::string>>& headers)
+    {
+        std::string block;
+        for (const auto& header : headers) {
+            encoder_.Encode(block, header.first, header.second);
+        }
+        return block;
+    }
+
+    void Headers(std::uint32_t stream_id, const std::vector<std::pair<std::string, std::string>>& headers, bool end_stream = true)
+    {
+        std::string block = Block(headers);
+        jl::http2::AppendFrameHeader(data_, static_cast<std::uint32_t>(block.size()), FrameType::kHeaders,
+            flags::kEndHeaders | (end_stream ? flags::kEndStream : 0), stream_id);
+        data_.append(block);
+    }
+
+    void Get(std::uint32_t stream_id, const std::string& path)
+    {
+        Headers(stream_id, { { ":method", "GET" }, { ":scheme", "http" }, { ":path", path }, { ":authority", "example.com" } });
+    }
+
+    void Data(std::uint32_t stream_id, const std::string& data, bool end_stream)
+    {
+        jl::http2::AppendFrameHeader(data_, static_cast<std::uint32_t>(data.size()), FrameType::kData, end_stream ? flags::kEndStream : 0, stream_id);
+        data_.append(data);
+    }
+
+    void Raw(const std::string& data)
+    {
+        data_.append(data);
+    }
+
+    /// @brief 把已构造的数据交给服务端，收集服务端输出的帧
+    jl::http::ParseStatus Send()
+    {
+        std::size_t consumed = 0;
+        jl::http::ParseStatus status = server_.Receive(data_.data(), data_.size(), consumed);
+        data_.erase(0, consumed);
+        Collect();
+        return status;
+    }
+
+    void Collect()
+    {
+        server_.Flush(SIZE_MAX);
+        input_.append(server_.Output());
+        server_.Output().clear();
+        while (input_.size() >= jl::http2::kFrameHeaderSize) {
+            FrameHeader header = jl::http2::ParseFrameHeader(input_.data());
+            assert(input_.size() >= jl::http2::kFrameHeaderSize + header.length);
+            frames_.push_back(Frame{ header, input_.substr(jl::http2::kFrameHeaderSize, header.length) });
+            input_.erase(0, jl::http2::kFrameHeaderSize + header.length);
+        }
+    }
+
+    /// @brief 取出下一个指定类型的帧，跳过其他类型
+    bool Next(FrameType type, Frame& frame)
+    {
+        for (std::size_t i = 0; i < frames_.size(); ++i) {
+            if (frames_[i].header.type == type) {
+                frame = frames_[i];
+                frames_.erase(frames_.begin() + i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::map<std::string, std::string> DecodeHeaders(const Frame& frame)
+    {
+        std::vector<HeaderField> fields;
+        bool ok = decoder_.Decode(frame.payload, fields);
+        assert(ok);
+        (void)ok;
+        return ToMap(fields);
+    }
+
+    /// @brief 指定流收到的所有 DATA 负载
+    std::string Body(std::uint32_t stream_id, bool& ended)
+    {
+        std::string body;
+        ended = false;
+        for (auto it = frames_.begin(); it != frames_.end(); ) {
+            if (it->header.type == FrameType::kData && it->header.stream_id == stream_id) {
+                body += it->payload;
+                ended = ended || (it->header.flags & flags::kEndStream);
+                it = frames_.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+        return body;
+    }
+
+    std::uint32_t ErrorOf(const Frame& frame)
+    {
+        const std::string& p = frame.payload;
+        std::size_t offset = frame.header.type == FrameType::kGoAway ? 4 : 0;
+        return (std::uint32_t(static_cast<unsigned char>(p[offset])) << 24) | (std::uint32_t(static_cast<unsigned char>(p[offset + 1])) << 16)
+            | (std::uint32_t(static_cast<unsigned char>(p[offset + 2])) << 8) | static_cast<unsigned char>(p[offset + 3]);
+    }
+
+    std::vector<Frame>& Frames() { return frames_; }
+
+private:
+    ServerSession& server_;
+    HpackEncoder encoder_;
+    HpackDecoder decoder_;
+    std::string data_;
+    std::string input_;
+    std::vector<Frame> frames_;
+};
+
+struct Received {
+    std::uint32_t stream_id;
+    std::string method;
+    std::string target;
+    std::string host;
+    std::string body;
+};
+
+void Capture(ServerSession& server, std::vector<Received>& requests)
+{
+    server.SetRequestCallback([&](std::uint32_t stream_id, const jl::http::Request& request, std::string_view body) {
+        assert(request.version_major == 2);
+        requests.push_back(Received{ stream_id, std::string(request.method), std::string(request.target), std::string(request.GetHeader("Host")), std::string(body) });
+        });
+}
+
+void TestRequestResponse()
+{
+    ServerSession server;
+    std::vector<Received> requests;
+    Capture(server, requests);
+    TestClient client(server);
+    client.Get(1, "/hello?x=1");
+    jl::http::ParseStatus status = client.Send();
+    assert(status == jl::http::ParseStatus::kNeedMore);
+
+    // 服务端的 SETTINGS、对客户端 SETTINGS 的 ACK 和调大连接窗口的 WINDOW_UPDATE
+    Frame frame;
+    bool found = client.Next(FrameType::kSettings, frame);
+    assert(found && frame.header.flags == 0);
+    found = client.Next(FrameType::kSettings, frame);
+    assert(found && frame.header.flags == flags::kAck);
+    found = client.Next(FrameType::kWindowUpdate, frame);
+    assert(found && frame.header.stream_id == 0);
+
+    assert(requests.size() == 1);
+    assert(requests[0].stream_id == 1 && requests[0].method == "GET" && requests[0].target == "/hello?x=1" && requests[0].host == "example.com");
+
+    server.Respond(1, 200, { { "Content-Type", "text/plain" }, { "Connection", "keep-alive" } }, "hello, h2");
+    client.Collect();
+    found = client.Next(FrameType::kHeaders, frame);
+    assert(found && frame.header.stream_id == 1 && (frame.header.flags & flags::kEndHeaders));
+    auto headers = client.DecodeHeaders(frame);
+    assert(headers[":status"] == "200" && headers["content-type"] == "text/plain" && headers.count("connection") == 0);
+    bool ended;
+    std::string body = client.Body(1, ended);
+    assert(body == "hello, h2" && ended);
+    assert(server.GetStats().open_streams == 0 && server.GetStats().streams == 1);
+
+    // 带请求体的 POST，请求体分成多个 DATA 帧
+    client.Headers(3, { { ":method", "POST" }, { ":scheme", "http" }, { ":path", "/upload" }, { "content-length", "11" } }, false);
+    client.Data(3, "hello ", false);
+    client.Send();
+    assert(requests.size() == 1);
+    client.Data(3, "world", true);
+    client.Send();
+    assert(requests.size() == 2 && requests[1].method == "POST" && requests[1].body == "hello world");
+    server.Respond(3, 204, {}, {});
+    client.Collect();
+    found = client.Next(FrameType::kHeaders, frame);
+    assert(found && (frame.header.flags & flags::kEndStream));
+    headers = client.DecodeHeaders(frame);
+    assert(headers[":status"] == "204");
+}
+
+void TestMultiplexing()
+{
+    ServerSession server;
+    std::vector<Received> requests;
+    Capture(server, requests);
+    TestClient client(server);
+    for (std::uint32_t id = 1; id <= 9; id += 2) {
+        client.Get(id, "/item/" + std::to_string(id));
+    }
+    client.Send();
+    assert(requests.size() == 5);
+    // 逆序回应，每个响应体都超过一帧，多个流的 DATA 帧交错发送
+    std::string big(40000, 'x');
+    for (auto it = requests.rbegin(); it != requests.rend(); ++it) {
+        server.Respond(it->stream_id, 200, {}, big);
+    }
+    client.Collect();
+    std::vector<std::uint32_t> order;
+    for (const auto& frame : client.Frames()) {
+        if (frame.header.type == FrameType::kData) {
+            assert(frame.header.length <= jl::http2::kDefaultMaxFrameSize);
+            order.push_back(frame.header.stream_id);
+        }
+    }
+    // 连接初始窗口 65535，轮流发送，每个流一帧后窗口耗尽
+    assert(order.size() == 4);
+    assert(order[0] == 9 && order[1] == 7 && order[2] == 5 && order[3] == 3);
+    std::map<std::uint32_t, std::string> bodies;
+    for (std::uint32_t id = 1; id <= 9; id += 2) {
+        bool ended;
+        bodies[id] = client.Body(id, ended);
+    }
+    assert(bodies[1].empty() && bodies[9].size() == jl::http2::kDefaultMaxFrameSize);
+
+    // 连接窗口调大后发完所有响应
+    std::string update;
+    jl::http2::AppendWindowUpdate(update, 0, 1 << 20);
+    client.Raw(update);
+    client.Send();
+    for (std::uint32_t id = 1; id <= 9; id += 2) {
+        bool ended;
+        bodies[id] += client.Body(id, ended);
+        // 流的初始窗口 65535 足够
+        assert(bodies[id] == big && ended);
+    }
+    assert(server.GetStats().open_streams == 0 && !server.HasPendingData());
+}
+
+void TestFlowControl()
+{
+    ServerSession server;
+    std::vector<Received> requests;
+    Capture(server, requests);
+    TestClient client(server);
+    // 客户端把流的初始窗口设为 10
+    std::string settings;
+    jl::http2::AppendSettings(settings, { { SettingId::kInitialWindowSize, 10 } });
+    client.Raw(settings);
+    client.Get(1, "/");
+    client.Send();
+    server.Respond(1, 200, {}, std::string(25, 'a'));
+    client.Collect();
+    bool ended;
+    std::string body = client.Body(1, ended);
+    assert(body == std::string(10, 'a') && !ended);
+
+    std::string update;
+    jl::http2::AppendWindowUpdate(update, 1, 10);
+    client.Raw(update);
+    client.Send();
+    body = client.Body(1, ended);
+    assert(body == std::string(10, 'a') && !ended);
+
+    // 调大初始窗口对已打开的流生效
+    settings.clear();
+    jl::http2::AppendSettings(settings, { { SettingId::kInitialWindowSize, 1000 } });
+    client.Raw(settings);
+    client.Send();
+    body = client.Body(1, ended);
+    assert(body == std::string(5, 'a') && ended);
+    assert(server.GetStats().open_streams == 0);
+
+    // 流窗口溢出
+    client.Get(3, "/");
+    client.Send();
+    server.Respond(3, 200, {}, std::string(5000, 'b'));
+    update.clear();
+    jl::http2::AppendWindowUpdate(update, 3, jl::http2::kMaxWindowSize);
+    client.Raw(update);
+    client.Send();
+    Frame frame;
+    bool found = client.Next(FrameType::kRstStream, frame);
+    assert(found && frame.header.stream_id == 3);
+    assert(client.ErrorOf(frame) == static_cast<std::uint32_t>(ErrorCode::kFlowControlError));
+}
+
+void TestBodyReader()
+{
+    ServerSession server;
+    std::vector<Received> requests;
+    Capture(server, requests);
+    TestClient client(server);
+    std::string settings;
+    jl::http2::AppendSettings(settings, { { SettingId::kInitialWindowSize, 20000 } });
+    client.Raw(settings);
+    client.Get(1, "/big");
+    client.Send();
+    // 响应体按需读取，只读取窗口允许发送的部分
+    std::string big(50000, '\0');
+    for (std::size_t i = 0; i < big.size(); ++i) {
+        big[i] = static_cast<char>('a' + i % 26);
+    }
+    std::uint64_t read_bytes = 0;
+    server.Respond(1, 200, {}, big.size(), [&](std::uint64_t offset, char* out, std::size_t size) {
+        assert(offset + size <= big.size());
+        std::memcpy(out, big.data() + offset, size);
+        read_bytes += size;
+        return true;
+        });
+    client.Collect();
+    bool ended;
+    std::string body = client.Body(1, ended);
+    assert(body == big.substr(0, 20000) && !ended && read_bytes == 20000);
+
+    std::string update;
+    jl::http2::AppendWindowUpdate(update, 1, 40000);
+    client.Raw(update);
+    client.Send();
+    body += client.Body(1, ended);
+    assert(body == big && ended && read_bytes == big.size());
+    assert(server.GetStats().open_streams == 0 && !server.HasPendingData());
+
+    // 读取失败时以 RST_STREAM(INTERNAL_ERROR) 结束流
+    client.Get(3, "/broken");
+    client.Send();
+    server.Respond(3, 200, {}, 100, [](std::uint64_t, char*, std::size_t) { return false; });
+    client.Collect();
+    Frame frame;
+    bool found = client.Next(FrameType::kRstStream, frame);
+    assert(found && frame.header.stream_id == 3);
+    assert(client.ErrorOf(frame) == static_cast<std::uint32_t>(ErrorCode::kInternalError));
+    body = client.Body(3, ended);
+    assert(body.empty() && !ended);
+    assert(server.GetStats().open_streams == 0);
+}
+
+void TestContinuationAndLimits()
+{
+    jl::http2::Settings settings;
+    settings.max_concurrent_streams = 2;
+    settings.max_body_bytes = 100;
+    ServerSession server(settings);
+    std::vector<Received> requests;
+    Capture(server, requests);
+    TestClient client(server);
+
+    // 头部块拆成 HEADERS 和两个 CONTINUATION
+    std::string block = client.Block({ { ":method", "GET" }, { ":scheme", "http" }, { ":path", "/continued" }, { "x-long", std::string(100, 'v') } });
+    std::string raw;
+    jl::http2::AppendFrameHeader(raw, 10, FrameType::kHeaders, flags::kEndStream, 1);
+    raw.append(block, 0, 10);
+    jl::http2::AppendFrameHeader(raw, 20, FrameType::kContinuation, 0, 1);
+    raw.append(block, 10, 20);
+    jl::http2::AppendFrameHeader(raw, static_cast<std::uint32_t>(block.size() - 30), FrameType::kContinuation, flags::kEndHeaders, 1);
+    raw.append(block, 30, std::string::npos);
+    client.Raw(raw);
+    client.Send();
+    assert(requests.size() == 1 && requests[0].target == "/continued");
+
+    // 超过并发流上限（流 1 还没有回应）
+    client.Get(3, "/");
+    client.Get(5, "/");
+    client.Send();
+    Frame frame;
+    bool found = client.Next(FrameType::kRstStream, frame);
+    assert(found && frame.header.stream_id == 5);
+    assert(client.ErrorOf(frame) == static_cast<std::uint32_t>(ErrorCode::kRefusedStream));
+    assert(server.GetStats().refused_streams == 1);
+
+    // 对端取消流之后回应被忽略
+    std::string rst;
+    jl::http2::AppendRstStream(rst, 3, ErrorCode::kCancel);
+    client.Raw(rst);
+    client.Send();
+    server.Respond(3, 200, {}, "ignored");
+    client.Collect();
+    found = client.Next(FrameType::kHeaders, frame);
+    assert(!found);
+    server.Respond(1, 200, {}, "ok");
+    client.Collect();
+    found = client.Next(FrameType::kHeaders, frame);
+    assert(found && frame.header.stream_id == 1);
+
+    // 请求体超过上限时回应 413，并以 RST_STREAM(NO_ERROR) 通知客户端不必再发送
+    client.Headers(7, { { ":method", "POST" }, { ":scheme", "http" }, { ":path", "/big" } }, false);
+    client.Data(7, std::string(150, 'z'), false);
+    client.Send();
+    found = client.Next(FrameType::kHeaders, frame);
+    assert(found && frame.header.stream_id == 7);
+    auto headers = client.DecodeHeaders(frame);
+    assert(headers[":status"] == "413");
+    found = client.Next(FrameType::kRstStream, frame);
+    assert(found && frame.header.stream_id == 7);
+    assert(client.ErrorOf(frame) == static_cast<std::uint32_t>(ErrorCode::kNoError));
+    assert(requests.size() == 2);
+
+    // 大写的头部名称是流错误。伪头部使用静态表索引，字面量不加入动态表，不影响客户端编码器的状态
+    std::string upper;
+    std::string upper_block = Hex("82 86 84");
+    jl::http2::AppendInteger(upper_block, 0x00, 4, 0);
+    jl::http2::AppendString(upper_block, "X-Upper");
+    jl::http2::AppendString(upper_block, "1");
+    jl::http2::AppendFrameHeader(upper, static_cast<std::uint32_t>(upper_block.size()), FrameType::kHeaders, flags::kEndHeaders | flags::kEndStream, 9);
+    upper.append(upper_block);
+    client.Raw(upper);
+    client.Send();
+    found = client.Next(FrameType::kRstStream, frame);
+    assert(found && frame.header.stream_id == 9);
+
+    // PING 原样回应
+    std::string ping;
+    jl::http2::AppendFrameHeader(ping, 8, FrameType::kPing, 0, 0);
+    ping.append("12345678");
+    client.Raw(ping);
+    client.Send();
+    found = client.Next(FrameType::kPing, frame);
+    assert(found && frame.header.flags == flags::kAck && frame.payload == "12345678");
+}
+
+ErrorCode ConnectionError(const std::string& frames, bool with_preface = true)
+{
+    ServerSession server;
+    std::string data = with_preface ? std::string(jl::http2::kClientPreface) : std::string();
+    data.append(frames);
+    std::size_t consumed;
+    jl::http::ParseStatus status = server.Receive(data.data(), data.size(), consumed);
+    assert(status == jl::http::ParseStatus::kError);
+    assert(server.Closed());
+    const std::string& out = server.Output();
+    std::size_t offset = 0;
+    while (offset < out.size()) {
+        FrameHeader header = jl::http2::ParseFrameHeader(out.data() + offset);
+        if (header.type == FrameType::kGoAway) {
+            const unsigned char* p = reinterpret_cast<const unsigned char*>(out.data() + offset + jl::http2::kFrameHeaderSize + 4);
+            return static_cast<ErrorCode>((std::uint32_t(p[0]) << 24) | (std::uint32_t(p[1]) << 16) | (std::uint32_t(p[2]) << 8) | p[3]);
+        }
+        offset += jl::http2::kFrameHeaderSize + header.length;
+    }
+    assert(false);
+    return ErrorCode::kNoError;
+}
+
+void TestConnectionErrors()
+{
+    assert(ConnectionError("GET / HTTP/1.1\r\n\r\n", false) == ErrorCode::kProtocolError);
+    std::string frame;
+    // 偶数流 ID
+    HpackEncoder encoder;
+    std::string block;
+    encoder.Encode(block, ":method", "GET");
+    jl::http2::AppendFrameHeader(frame, static_cast<std::uint32_t>(block.size()), FrameType::kHeaders, flags::kEndHeaders, 2);
+    frame.append(block);
+    assert(ConnectionError(frame) == ErrorCode::kProtocolError);
+    // 流 0 上的 DATA
+    frame.clear();
+    jl::http2::AppendFrameHeader(frame, 1, FrameType::kData, 0, 0);
+    frame.push_back('x');
+    assert(ConnectionError(frame) == ErrorCode::kProtocolError);
+    // 超过 SETTINGS_MAX_FRAME_SIZE
+    frame.clear();
+    jl::http2::AppendFrameHeader(frame, jl::http2::kDefaultMaxFrameSize + 1, FrameType::kData, 0, 1);
+    assert(ConnectionError(frame) == ErrorCode::kFrameSizeError);
+    // 无法解码的头部块
+    frame.clear();
+    jl::http2::AppendFrameHeader(frame, 2, FrameType::kHeaders, flags::kEndHeaders, 1);
+    frame.append("\xff\x00", 2);
+    assert(ConnectionError(frame) == ErrorCode::kCompressionError);
+    // 头部块未结束时收到其他帧
+    frame.clear();
+    jl::http2::AppendFrameHeader(frame, static_cast<std::uint32_t>(block.size()), FrameType::kHeaders, 0, 1);
+    frame.append(block);
+    jl::http2::AppendFrameHeader(frame, 8, FrameType::kPing, 0, 0);
+    frame.append(8, '\0');
+    assert(ConnectionError(frame) == ErrorCode::kProtocolError);
+    // SETTINGS 长度不是6的倍数，非法的初始窗口
+    frame.clear();
+    jl::http2::AppendFrameHeader(frame, 5, FrameType::kSettings, 0, 0);
+    frame.append(5, '\0');
+    assert(ConnectionError(frame) == ErrorCode::kFrameSizeError);
+    frame.clear();
+    jl::http2::AppendSettings(frame, { { SettingId::kInitialWindowSize, 0x80000000u } });
+    assert(ConnectionError(frame) == ErrorCode::kFlowControlError);
+    // 连接窗口的 WINDOW_UPDATE 增量为0
+    frame.clear();
+    jl::http2::AppendWindowUpdate(frame, 0, 0);
+    assert(ConnectionError(frame) == ErrorCode::kProtocolError);
+    // 客户端发送 PUSH_PROMISE
+    frame.clear();
+    jl::http2::AppendFrameHeader(frame, 4, FrameType::kPushPromise, flags::kEndHeaders, 1);
+    frame.append(4, '\0');
+    assert(ConnectionError(frame) == ErrorCode::kProtocolError);
+}
+
+int main()
+{
+    TestInteger();
+    TestHuffman();
+    TestDecoderExamples();
+    TestEncoderRoundTrip();
+    TestRequestResponse();
+    TestMultiplexing();
+    TestFlowControl();
+    TestBodyReader();
+    TestContinuationAndLimits();
+    TestConnectionErrors();
+    std::cout << "http2_test passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,174 @@
+// 响应压缩测试：Accept-Encoding 协商、可压缩类型判断、gzip/deflate 压缩结果可以解压还原，
+// CompressionCache 在计算线程池中压缩、命中缓存和合并同一内容的并发压缩
+#include <http_compress.h>
+#include <compute_pool.hpp>
+#include <assert.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef ENABLE_ZLIB
+#include <zlib.h>
+
+using jl::http::CompressionCache;
+using jl::http::ContentEncoding;
+
+std::string Inflate(const std::string& data, ContentEncoding encoding)
+{
+    z_stream stream{};
+    // windowBits 加 16 只接受 gzip 格式，否则只接受 zlib 格式
+    int ret = inflateInit2(&stream, encoding == ContentEncoding::kGzip ? 15 + 16 : 15);
+    assert(ret == Z_OK);
+    std::string out(1 << 20, '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    stream.avail_out = static_cast<uInt>(out.size());
+    ret = inflate(&stream, Z_FINISH);
+    assert(ret == Z_STREAM_END);
+    out.resize(stream.total_out);
+    inflateEnd(&stream);
+    return out;
+}
+
+void TestNegotiate()
+{
+    assert(jl::http::NegotiateEncoding("") == ContentEncoding::kIdentity);
+    assert(jl::http::NegotiateEncoding("gzip") == ContentEncoding::kGzip);
+    assert(jl::http::NegotiateEncoding("gzip, deflate, br") == ContentEncoding::kGzip);
+    assert(jl::http::NegotiateEncoding("deflate") == ContentEncoding::kDeflate);
+    assert(jl::http::NegotiateEncoding("GZIP;q=0.5, deflate") == ContentEncoding::kDeflate);
+    assert(jl::http::NegotiateEncoding("gzip;q=0, deflate;q=0") == ContentEncoding::kIdentity);
+    assert(jl::http::NegotiateEncoding("br, identity") == ContentEncoding::kIdentity);
+    assert(jl::http::NegotiateEncoding("*") == ContentEncoding::kGzip);
+    assert(jl::http::NegotiateEncoding("*;q=0.1, gzip;q=0") == ContentEncoding::kDeflate);
+    assert(jl::http::NegotiateEncoding("x-gzip ; q=1.0") == ContentEncoding::kGzip);
+    assert(jl::http::EncodingName(ContentEncoding::kGzip) == "gzip");
+    assert(jl::http::EncodingName(ContentEncoding::kIdentity).empty());
+}
+
+void TestCompressible()
+{
+    assert(jl::http::IsCompressible("text/html; charset=UTF-8"));
+    assert(jl::http::IsCompressible("Text/CSS"));
+    assert(jl::http::IsCompressible("application/json"));
+    assert(jl::http::IsCompressible("application/problem+json"));
+    assert(jl::http::IsCompressible("image/svg+xml"));
+    assert(!jl::http::IsCompressible("image/png"));
+    assert(!jl::http::IsCompressible("application/octet-stream"));
+    assert(!jl::http::IsCompressible("text/"));
+}
+
+void TestCompress()
+{
+    std::string text;
+    for (int i = 0; i < 2000; ++i) {
+        text += "<li>item " + std::to_string(i) + "</li>\n";
+    }
+    for (ContentEncoding encoding : { ContentEncoding::kGzip, ContentEncoding::kDeflate }) {
+        std::string out = "prefix";
+        assert(jl::http::Compress(encoding, text, out));
+        assert(out.compare(0, 6, "prefix") == 0);
+        std::string compressed = out.substr(6);
+        assert(compressed.size() < text.size() / 4);
+        if (encoding == ContentEncoding::kGzip) {
+            assert(static_cast<unsigned char>(compressed[0]) == 0x1f && static_cast<unsigned char>(compressed[1]) == 0x8b);
+        }
+        assert(Inflate(compressed, encoding) == text);
+    }
+    std::string out;
+    assert(!jl::http::Compress(ContentEncoding::kIdentity, text, out) && out.empty());
+}
+
+// 等待若干个回调完成
+class Waiter {
+public:
+    void Done(const CompressionCache::Result& result)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        results_.push_back(result);
+        cond_.notify_all();
+    }
+
+    std::vector<CompressionCache::Result> Wait(std::size_t count)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        bool ok = cond_.wait_for(lock, std::chrono::seconds(10), [&]() { return results_.size() >= count; });
+        assert(ok);
+        (void)ok;
+        return results_;
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::vector<CompressionCache::Result> results_;
+};
+
+void TestCache()
+{
+    auto cache = std::make_shared<CompressionCache>(64 * 1024);
+    auto body = std::make_shared<const std::string>(std::string(100000, 'a') + "end");
+    auto key = CompressionCache::MakeKey(ContentEncoding::kGzip, *body);
+    assert(!cache->Find(key));
+
+    // 同一内容的并发请求只压缩一次
+    Waiter waiter;
+    for (int i = 0; i < 8; ++i) {
+        cache->CompressAsync(key, body, [&](const CompressionCache::Result& result) { waiter.Done(result); });
+    }
+    auto results = waiter.Wait(8);
+    for (const auto& result : results) {
+        assert(result && result == results[0]);
+    }
+    assert(Inflate(*results[0], ContentEncoding::kGzip) == *body);
+
+    auto found = cache->Find(key);
+    assert(found == results[0]);
+    // 不同编码是不同的缓存项
+    assert(!cache->Find(CompressionCache::MakeKey(ContentEncoding::kDeflate, *body)));
+
+    auto stats = cache->GetStats();
+    assert(stats.misses == 1);
+    assert(stats.hits + stats.coalesced == 8);  // 其余 7 个请求合并或在压缩完成后命中，加上上面的 Find
+    assert(stats.entries == 1 && stats.bytes == found->size() + 2 * key.digest.size());
+    assert(stats.input_bytes == body->size() && stats.output_bytes == found->size());
+
+    // 超过容量时淘汰最久未使用的项
+    Waiter more;
+    std::vector<CompressionCache::Key> keys;
+    for (int i = 0; i < 200; ++i) {
+        std::string data;
+        for (int j = 0; j < 2000; ++j) {
+            data += std::to_string(i * 7919 + j * 104729);
+        }
+        auto shared = std::make_shared<const std::string>(std::move(data));
+        keys.push_back(CompressionCache::MakeKey(ContentEncoding::kDeflate, *shared));
+        cache->CompressAsync(keys.back(), shared, [&](const CompressionCache::Result& result) { more.Done(result); });
+    }
+    more.Wait(200);
+    stats = cache->GetStats();
+    assert(stats.evictions > 0 && stats.bytes <= 64 * 1024);
+    assert(!cache->Find(key));
+}
+
+#endif
+
+int main()
+{
+#ifndef ENABLE_ZLIB
+    std::cout << "http_compress_test skipped: built without ENABLE_ZLIB" << std::endl;
+#else
+    TestNegotiate();
+    TestCompressible();
+    TestCompress();
+    TestCache();
+    std::cout << "http_compress_test passed" << std::endl;
+    jl::ComputeThreadPool::GetInstance().Stop();
+#endif
+    return 0;
+}
@@ -0,0 +1,298 @@
+// HTTP请求解析器测试：任意位置拆包、头部限制、非法请求、chunked 请求体解码
+#include <http_parser.h>
+#include <assert.h>
+#include <iostream>
+#include <string>
+
+using jl::http::ChunkedDecoder;
+using jl::http::ParseError;
+using jl::http::ParseStatus;
+using jl::http::RequestParser;
+
+const std::string kRequest =
+    "POST /api/items?id=42 HTTP/1.1\r\n"
+    "Host: example.com\r\n"
+    "User-Agent: curl/8.0\r\n"
+    "Content-Type:application/json\r\n"
+    "Content-Length: 13\r\n"
+    "X-Empty:\r\n"
+    "\r\n"
+    "{\"name\":\"jl\"}";
+
+void CheckRequest(const RequestParser& parser, const std::string& buffer)
+{
+    const auto& request = parser.GetRequest();
+    assert(request.method == "POST");
+    assert(request.target == "/api/items?id=42");
+    assert(request.version_major == 1 && request.version_minor == 1);
+    assert(request.headers.size() == 5);
+    assert(request.GetHeader("host") == "example.com");
+    assert(request.GetHeader("CONTENT-TYPE") == "application/json");
+    assert(request.GetHeader("x-empty").empty());
+    assert(request.GetHeader("missing").data() == nullptr);
+    assert(request.has_content_length && request.content_length == 13);
+    assert(request.keep_alive && !request.chunked);
+    assert(buffer.substr(parser.HeaderBytes()) == "{\"name\":\"jl\"}");
+    // 视图指向缓冲区本身
+    assert(request.method.data() == buffer.data());
+}
+
+// 在每个位置把请求拆成两段，模拟两次读取
+void TestSplitEverywhere()
+{
+    for (std::size_t split = 0; split <= kRequest.size(); ++split) {
+        RequestParser parser;
+        std::string buffer;
+        buffer.append(kRequest, 0, split);
+        ParseStatus status = parser.Parse(buffer.data(), buffer.size());
+        std::size_t header_end = kRequest.find("\r\n\r\n") + 4;
+        assert(status == (split >= header_end ? ParseStatus::kComplete : ParseStatus::kNeedMore));
+        buffer.append(kRequest, split, std::string::npos);
+        status = parser.Parse(buffer.data(), buffer.size());
+        assert(status == ParseStatus::kComplete);
+        assert(parser.HeaderBytes() == header_end);
+        CheckRequest(parser, buffer);
+    }
+}
+
+// 每次只追加一个字节
+void TestByteByByte()
+{
+    RequestParser parser;
+    std::string buffer;
+    ParseStatus status = ParseStatus::kNeedMore;
+    for (char c : kRequest) {
+        buffer.push_back(c);
+        if (status != ParseStatus::kComplete) {
+            status = parser.Parse(buffer.data(), buffer.size());
+        }
+    }
+    assert(status == ParseStatus::kComplete);
+    CheckRequest(parser, buffer);
+}
+
+ParseStatus ParseOnce(const std::string& data, RequestParser& parser)
+{
+    return parser.Parse(data.data(), data.size());
+}
+
+ParseError GetError(const std::string& data)
+{
+    RequestParser parser;
+    ParseStatus status = ParseOnce(data, parser);
+    assert(status != ParseStatus::kNeedMore);
+    return parser.Error();
+}
+
+void TestSemantics()
+{
+    // 请求行之前的空行、裸LF
+    {
+        RequestParser parser;
+        std::string data = "\r\n\nGET / HTTP/1.0\nConnection: keep-alive\n\n";
+        ParseStatus status = ParseOnce(data, parser);
+        assert(status == ParseStatus::kComplete);
+        assert(parser.GetRequest().method == "GET");
+        assert(parser.GetRequest().version_minor == 0);
+        assert(parser.GetRequest().keep_alive);
+        assert(parser.HeaderBytes() == data.size());
+    }
+    {
+        RequestParser parser;
+        ParseStatus status = ParseOnce("GET / HTTP/1.0\r\n\r\n", parser);
+        assert(status == ParseStatus::kComplete);
+        assert(!parser.GetRequest().keep_alive);
+    }
+    {
+        RequestParser parser;
+        ParseStatus status = ParseOnce("GET / HTTP/1.1\r\nConnection: Upgrade, close\r\n\r\n", parser);
+        assert(status == ParseStatus::kComplete);
+        assert(!parser.GetRequest().keep_alive);
+    }
+    {
+        RequestParser parser;
+        ParseStatus status = ParseOnce("POST / HTTP/1.1\r\nTransfer-Encoding: gzip, chunked\r\n\r\n", parser);
+        assert(status == ParseStatus::kComplete);
+        assert(parser.GetRequest().chunked);
+    }
+    // 一致的重复 Content-Length 可以接受
+    {
+        RequestParser parser;
+        ParseStatus status = ParseOnce("POST / HTTP/1.1\r\nContent-Length: 5\r\ncontent-length: 5\r\n\r\n", parser);
+        assert(status == ParseStatus::kComplete);
+        assert(parser.GetRequest().content_length == 5);
+    }
+    // Reset 后可以解析下一个请求
+    {
+        RequestParser parser;
+        std::string data = "GET /a HTTP/1.1\r\n\r\n";
+        ParseStatus status = ParseOnce(data, parser);
+        assert(status == ParseStatus::kComplete);
+        parser.Reset();
+        data = "GET /b HTTP/1.1\r\nHost: x\r\n\r\n";
+        status = ParseOnce(data, parser);
+        assert(status == ParseStatus::kComplete);
+        assert(parser.GetRequest().target == "/b");
+        assert(parser.GetRequest().headers.size() == 1);
+    }
+}
+
+void TestErrors()
+{
+    assert(GetError("GET /\r\n\r\n") == ParseError::kBadRequest);
+    assert(GetError("GET  / HTTP/1.1\r\n\r\n") == ParseError::kBadRequest);
+    assert(GetError("G(T / HTTP/1.1\r\n\r\n") == ParseError::kBadRequest);
+    assert(GetError("GET / HTTP/1.1 \r\n\r\n") == ParseError::kBadRequest);
+    assert(GetError("GET / HTTX/1.1\r\n\r\n") == ParseError::kBadRequest);
+    assert(GetError("GET / HTTP/2.0\r\n\r\n") == ParseError::kVersionNotSupported);
+    assert(GetError("GET / HTTP/1.1\r\nNoColon\r\n\r\n") == ParseError::kBadRequest);
+    assert(GetError("GET / HTTP/1.1\r\nHost : x\r\n\r\n") == ParseError::kBadRequest);
+    assert(GetError("GET / HTTP/1.1\r\nHost: x\r\n folded\r\n\r\n") == ParseError::kBadRequest);
+    assert(GetError("GET / HTTP/1.1\r\nHost: a\x01" "b\r\n\r\n") == ParseError::kBadRequest);
+    assert(GetError("POST / HTTP/1.1\r\nContent-Length: 1x\r\n\r\n") == ParseError::kBadRequest);
+    assert(GetError("POST / HTTP/1.1\r\nContent-Length: -1\r\n\r\n") == ParseError::kBadRequest);
+    assert(GetError("POST / HTTP/1.1\r\nContent-Length: 99999999999999999999\r\n\r\n") == ParseError::kBadRequest);
+    assert(GetError("POST / HTTP/1.1\r\nContent-Length: 1\r\nContent-Length: 2\r\n\r\n") == ParseError::kBadRequest);
+    // 请求走私：TE 与 CL 同时出现、最后的编码不是 chunked
+    assert(GetError("POST / HTTP/1.1\r\nContent-Length: 1\r\nTransfer-Encoding: chunked\r\n\r\n") == ParseError::kBadRequest);
+    assert(GetError("POST / HTTP/1.1\r\nTransfer-Encoding: chunked, gzip\r\n\r\n") == ParseError::kBadRequest);
+    assert(jl::http::StatusCode(ParseError::kBadRequest) == 400);
+    assert(jl::http::StatusCode(ParseError::kHeaderTooLarge) == 431);
+    assert(jl::http::StatusCode(ParseError::kVersionNotSupported) == 505);
+}
+
+void TestLimits()
+{
+    // 没有结束标记时，数据达到上限即失败，不会无限等待
+    {
+        RequestParser parser(64, 8);
+        std::string data = "GET /" + std::string(100, 'a');
+        ParseStatus status = ParseOnce(data.substr(0, 63), parser);
+        assert(status == ParseStatus::kNeedMore);
+        status = ParseOnce(data, parser);
+        assert(status == ParseStatus::kError);
+        assert(parser.Error() == ParseError::kHeaderTooLarge);
+    }
+    // 结束标记刚好在上限内
+    {
+        std::string data = "GET / HTTP/1.1\r\n\r\n";
+        RequestParser parser(data.size(), 8);
+        ParseStatus status = ParseOnce(data + "body", parser);
+        assert(status == ParseStatus::kComplete);
+    }
+    {
+        std::string data = "GET / HTTP/1.1\r\n\r\n";
+        RequestParser parser(data.size() - 1, 8);
+        ParseStatus status = ParseOnce(data, parser);
+        assert(status == ParseStatus::kError);
+        assert(parser.Error() == ParseError::kHeaderTooLarge);
+    }
+    // 头部个数
+    {
+        std::string data = "GET / HTTP/1.1\r\n";
+        for (int i = 0; i < 4; ++i) {
+            data += "X-" + std::to_string(i) + ": v\r\n";
+        }
+        data += "\r\n";
+        RequestParser ok(1024, 4);
+        ParseStatus status = ParseOnce(data, ok);
+        assert(status == ParseStatus::kComplete);
+        RequestParser too_many(1024, 3);
+        status = ParseOnce(data, too_many);
+        assert(status == ParseStatus::kError);
+        assert(too_many.Error() == ParseError::kHeaderTooLarge);
+    }
+}
+
+const std::string kChunkedBody =
+    "5\r\nhello\r\n"
+    "1;name=value\r\n \r\n"
+    "A\r\n0123456789\r\n"
+    "0\r\n"
+    "Trailer-Field: x\r\n"
+    "\r\n";
+const std::string kNextRequest = "GET /next HTTP/1.1\r\n\r\n";
+
+// 以 split 为界分两次解码，返回拼接的请求体；结束块之后的数据不应被消费
+std::string DecodeInTwoParts(const std::string& data, std::size_t split)
+{
+    ChunkedDecoder decoder;
+    std::string body;
+    auto on_data = [&](std::string_view piece) { body.append(piece.data(), piece.size()); };
+    std::size_t consumed = 0;
+    ParseStatus status = decoder.Decode(data.data(), split, consumed, on_data);
+    assert(status != ParseStatus::kError);
+    if (status == ParseStatus::kNeedMore) {
+        assert(consumed == split);
+        std::size_t rest = 0;
+        status = decoder.Decode(data.data() + split, data.size() - split, rest, on_data);
+        consumed += rest;
+    }
+    assert(status == ParseStatus::kComplete);
+    assert(data.substr(consumed) == kNextRequest);
+    assert(decoder.BodyBytes() == body.size());
+    return body;
+}
+
+void TestChunked()
+{
+    const std::string data = kChunkedBody + kNextRequest;
+    for (std::size_t split = 0; split <= kChunkedBody.size(); ++split) {
+        assert(DecodeInTwoParts(data, split) == "hello 0123456789");
+    }
+
+    // 每次一个字节
+    {
+        ChunkedDecoder decoder;
+        std::string body;
+        ParseStatus status = ParseStatus::kNeedMore;
+        for (char c : kChunkedBody) {
+            std::size_t consumed = 0;
+            status = decoder.Decode(&c, 1, consumed, [&](std::string_view piece) { body.append(piece.data(), piece.size()); });
+            assert(consumed == 1);
+        }
+        assert(status == ParseStatus::kComplete);
+        assert(body == "hello 0123456789");
+    }
+
+    auto decode_error = [](const std::string& data, ChunkedDecoder decoder = ChunkedDecoder()) {
+        std::size_t consumed = 0;
+        ParseStatus status = decoder.Decode(data.data(), data.size(), consumed, [](std::string_view) {});
+        assert(status == ParseStatus::kError);
+        return decoder.Error();
+    };
+    assert(decode_error("x\r\n") == ParseError::kBadRequest);
+    assert(decode_error("\r\n") == ParseError::kBadRequest);
+    assert(decode_error("5\r\nhelloXX") == ParseError::kBadRequest);
+    assert(decode_error("5\nhello\r\n") == ParseError::kBadRequest);
+    assert(decode_error("ffffffffffffffff\r\n") == ParseError::kPayloadTooLarge);
+    assert(decode_error("5\r\nhello\r\n5\r\n", ChunkedDecoder(8)) == ParseError::kPayloadTooLarge);
+    assert(decode_error("0\r\nX: " + std::string(100, 'a') + "\r\n\r\n", ChunkedDecoder(8, 64)) == ParseError::kHeaderTooLarge);
+    assert(jl::http::StatusCode(ParseError::kPayloadTooLarge) == 413);
+
+    // 编码
+    std::string out;
+    jl::http::AppendChunk(out, "hello");
+    jl::http::AppendChunk(out, "");
+    jl::http::AppendChunk(out, std::string(26, 'z'));
+    out.append(jl::http::kLastChunk);
+    assert(out == "5\r\nhello\r\n1a\r\n" + std::string(26, 'z') + "\r\n0\r\n\r\n");
+    ChunkedDecoder decoder;
+    std::string body;
+    std::size_t consumed = 0;
+    ParseStatus status = decoder.Decode(out.data(), out.size(), consumed, [&](std::string_view piece) { body.append(piece.data(), piece.size()); });
+    assert(status == ParseStatus::kComplete);
+    assert(body == "hello" + std::string(26, 'z'));
+}
+
+int main(int argc, char const *argv[])
+{
+    TestSplitEverywhere();
+    TestByteByByte();
+    TestSemantics();
+    TestErrors();
+    TestLimits();
+    TestChunked();
+    std::cout << "http parser test passed." << std::endl;
+    return 0;
+}
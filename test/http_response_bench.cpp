@@ -0,0 +1,139 @@
+// HTTP响应序列化吞吐测试
+// usage: http_response_bench [seconds]
+// 对比原 GetHttpResponse（stringstream 拼接、fmt::format 复制、每次 localtime + put_time 格式化时间）
+// 与 ResponseWriter 写入复用缓冲区（Date 每秒格式化一次），输出 responses/s 和每个响应的内存分配次数
+#include "http_server/http_utils.h"
+
+#include <http_parser.h>
+#include <http_response.h>
+#include <assert.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+
+std::atomic<std::size_t> gAllocations{ 0 };
+
+void* operator new(std::size_t size)
+{
+    gAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+// 原 http_utils.h 的实现
+std::string LegacyCurrentTimeStr()
+{
+    auto now = std::chrono::system_clock::now();
+    auto time = std::chrono::system_clock::to_time_t(now);
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch() % 1000).count();
+    std::stringstream ss;
+    ss << std::put_time(std::localtime(&time), "%Y-%m-%d %H:%M:%S");
+    ss << '.' << std::setfill('0') << std::setw(3) << ms;
+    return ss.str();
+}
+
+std::string LegacyGetHttpResponse(const jl::http::Request& request, bool keep_alive)
+{
+    std::stringstream request_stream;
+    request_stream << request.method << ' ' << request.target << " HTTP/" << request.version_major << '.' << request.version_minor << "\r\n<br>";
+    for (const auto& header : request.headers) {
+        request_stream << header.name << ": " << header.value << "\r\n<br>";
+    }
+    request_stream << "\r\n<br>";
+    std::string request_string = fmt::format("<html><body>{}</body></html>", request_stream.str());
+    std::stringstream response_stream;
+    response_stream << "HTTP/1.1 200 OK\r\n";
+    response_stream << "Content-Type: text/html; charset=UTF-8" << "\r\n";
+    response_stream << "Date: " << LegacyCurrentTimeStr() << "\r\n";
+    response_stream << "Content-Length: " << request_string.size() << "\r\n";
+    response_stream << "Connection: " << (keep_alive ? "keep-alive" : "close") << "\r\n";
+    response_stream << "\r\n";
+    response_stream << request_string;
+    return response_stream.str();
+}
+
+template <typename Func>
+void Bench(const char* name, double seconds, Func func)
+{
+    std::size_t responses = 0;
+    std::size_t bytes = 0;
+    std::size_t allocations = gAllocations.load();
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0;
+    while (elapsed < seconds) {
+        for (int i = 0; i < 1000; ++i) {
+            bytes += func();
+        }
+        responses += 1000;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    allocations = gAllocations.load() - allocations;
+    std::cout << "  " << name << ": " << responses / elapsed / 1e6 << " M responses/s, " << elapsed * 1e9 / responses << " ns/response, "
+              << static_cast<double>(allocations) / responses << " allocations/response (" << bytes / responses << " bytes)" << std::endl;
+}
+
+int main(int argc, char const *argv[])
+{
+    double seconds = argc > 1 ? std::stod(argv[1]) : 1.0;
+    const std::string requests[] = {
+        "GET / HTTP/1.1\r\n"
+        "Host: localhost:8080\r\n"
+        "User-Agent: curl/8.5.0\r\n"
+        "Accept: */*\r\n"
+        "\r\n",
+        "GET /static/js/app.4f2c1a.js HTTP/1.1\r\n"
+        "Host: www.example.com\r\n"
+        "Connection: keep-alive\r\n"
+        "User-Agent: Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/124.0.0.0 Safari/537.36\r\n"
+        "Accept: */*\r\n"
+        "Referer: https://www.example.com/index.html\r\n"
+        "Accept-Encoding: gzip, deflate, br, zstd\r\n"
+        "Accept-Language: zh-CN,zh;q=0.9,en;q=0.8\r\n"
+        "\r\n",
+    };
+    for (const std::string& data : requests) {
+        jl::http::RequestParser parser;
+        auto status = parser.Parse(data.data(), data.size());
+        assert(status == jl::http::ParseStatus::kComplete);
+        const jl::http::Request& request = parser.GetRequest();
+        std::cout << request.target << " (" << request.headers.size() << " headers)" << std::endl;
+
+        Bench("stringstream + fmt   ", seconds, [&]() {
+            return LegacyGetHttpResponse(request, true).size();
+            });
+
+        std::string out;
+        Bench("ResponseWriter reused", seconds, [&]() {
+            out.clear();
+            AppendHttpResponse(out, request, true);
+            return out.size();
+            });
+
+        // 响应体长度按 RequestEchoSize 预先计算，需要与实际写出的一致
+        std::size_t head = out.find("\r\n\r\n") + 4;
+        std::size_t pos = out.find("Content-Length: ") + 16;
+        assert(std::stoul(out.substr(pos)) == out.size() - head);
+        (void)head;
+        (void)pos;
+    }
+    std::cout << "Date: " << jl::http::HttpDate() << std::endl;
+    return 0;
+}
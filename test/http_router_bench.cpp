@@ -0,0 +1,141 @@
+// 路由查找耗时测试
+// usage: http_router_bench [seconds]
+// 路由为 REST 风格（每个资源 4 条：列表、详情 GET/PUT、子资源），路由数从 16 增长到 16k，
+// 对比编译后的前缀树与逐条比较路径段的线性匹配，输出每次查找的 ns，前缀树的耗时应不随路由数增长
+#include <http_router.h>
+#include <assert.h>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// 逐条尝试每个路由的线性匹配
+class LinearRouter {
+public:
+    void Add(const std::string& method, const std::string& pattern)
+    {
+        Route route{ method, {} };
+        std::size_t pos = 1;
+        while (true) {
+            std::size_t slash = pattern.find('/', pos);
+            route.segments.push_back(pattern.substr(pos, slash - pos));
+            if (slash == std::string::npos) {
+                break;
+            }
+            pos = slash + 1;
+        }
+        routes_.push_back(std::move(route));
+    }
+
+    std::size_t Match(std::string_view method, std::string_view path, jl::http::RouteParams&) const
+    {
+        std::string_view segments[16];
+        std::size_t count = 0;
+        path.remove_prefix(1);
+        while (count < 16) {
+            std::size_t slash = path.find('/');
+            segments[count++] = path.substr(0, slash);
+            if (slash == std::string_view::npos) {
+                break;
+            }
+            path.remove_prefix(slash + 1);
+        }
+        for (std::size_t i = 0; i < routes_.size(); ++i) {
+            const Route& route = routes_[i];
+            if (route.method != method || route.segments.size() != count) {
+                continue;
+            }
+            bool ok = true;
+            for (std::size_t s = 0; s < count && ok; ++s) {
+                const std::string& pattern = route.segments[s];
+                ok = (!pattern.empty() && pattern[0] == ':') ? !segments[s].empty() : pattern == segments[s];
+            }
+            if (ok) {
+                return i;
+            }
+        }
+        return static_cast<std::size_t>(-1);
+    }
+
+private:
+    struct Route {
+        std::string method;
+        std::vector<std::string> segments;
+    };
+    std::vector<Route> routes_;
+};
+
+template <typename Func>
+double Bench(const std::vector<std::pair<std::string, std::string>>& requests, double seconds, Func func)
+{
+    std::size_t lookups = 0;
+    std::size_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0;
+    while (elapsed < seconds) {
+        for (const auto& request : requests) {
+            checksum += func(request.first, request.second);
+        }
+        lookups += requests.size();
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    if (checksum == 0x5eed) {
+        std::cout << "";
+    }
+    return elapsed * 1e9 / lookups;
+}
+
+int main(int argc, char const *argv[])
+{
+    double seconds = argc > 1 ? std::stod(argv[1]) : 0.5;
+    std::mt19937 rng(7);
+    for (std::size_t route_count : { 16, 256, 1024, 4096, 16384 }) {
+        jl::http::RouteTable table;
+        LinearRouter linear;
+        auto add = [&](const char* method, const std::string& pattern) {
+            table.Add(method, pattern);
+            linear.Add(method, pattern);
+        };
+        std::size_t resources = route_count / 4;
+        for (std::size_t i = 0; i < resources; ++i) {
+            std::string base = "/api/v1/resource" + std::to_string(i);
+            add("GET", base);
+            add("GET", base + "/:id");
+            add("PUT", base + "/:id");
+            add("GET", base + "/:id/items/:item");
+        }
+        table.Compile();
+
+        // 请求均匀分布在所有资源上
+        std::vector<std::pair<std::string, std::string>> requests;
+        for (int i = 0; i < 4096; ++i) {
+            std::string base = "/api/v1/resource" + std::to_string(rng() % resources);
+            switch (rng() % 4) {
+            case 0: requests.emplace_back("GET", base); break;
+            case 1: requests.emplace_back("GET", base + "/" + std::to_string(rng() % 100000)); break;
+            case 2: requests.emplace_back("PUT", base + "/" + std::to_string(rng() % 100000) + "?v=2"); break;
+            default: requests.emplace_back("GET", base + "/" + std::to_string(rng() % 100000) + "/items/" + std::to_string(rng() % 100)); break;
+            }
+        }
+
+        jl::http::RouteParams params;
+        double trie = Bench(requests, seconds, [&](const std::string& method, const std::string& target) {
+            std::size_t route = 0;
+            jl::http::RouteStatus status = table.Match(method, target, route, params);
+            assert(status == jl::http::RouteStatus::kFound);
+            return route + params.Size() + static_cast<std::size_t>(status);
+            });
+        std::cout << table.Size() << " routes: trie " << trie << " ns/lookup";
+        // 线性匹配在路由多时很慢，缩短测试时间
+        double scan = Bench(requests, route_count > 1024 ? seconds / 4 : seconds, [&](const std::string& method, const std::string& target) {
+            std::string_view path(target);
+            path = path.substr(0, path.find('?'));
+            std::size_t route = linear.Match(method, path, params);
+            assert(route != static_cast<std::size_t>(-1));
+            return route;
+            });
+        std::cout << ", linear " << scan << " ns/lookup" << std::endl;
+    }
+    return 0;
+}
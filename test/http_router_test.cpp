@@ -0,0 +1,164 @@
+// 路由测试：普通段、参数、通配符的匹配与优先级，回溯，404/405，非法模式
+#include <http_router.h>
+#include <assert.h>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using jl::http::RouteParams;
+using jl::http::RouteStatus;
+using jl::http::RouteTable;
+
+std::size_t Expect(const RouteTable& table, const char* method, const char* target, RouteParams& params)
+{
+    std::size_t route = 0;
+    RouteStatus status = table.Match(method, target, route, params);
+    assert(status == RouteStatus::kFound);
+    (void)status;
+    return route;
+}
+
+RouteStatus Status(const RouteTable& table, const char* method, const char* target)
+{
+    std::size_t route = 0;
+    RouteParams params;
+    return table.Match(method, target, route, params);
+}
+
+bool Throws(const char* method, const char* pattern)
+{
+    RouteTable table;
+    try {
+        table.Add(method, pattern);
+        table.Compile();
+    }
+    catch (const std::runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+void TestMatch()
+{
+    RouteTable table;
+    std::size_t root = table.Add("GET", "/");
+    std::size_t users = table.Add("GET", "/users");
+    std::size_t me = table.Add("GET", "/users/me");
+    std::size_t user = table.Add("GET", "/users/:id");
+    std::size_t update = table.Add("PUT", "/users/:id");
+    std::size_t post = table.Add("GET", "/users/:id/posts/:post");
+    std::size_t files = table.Add("GET", "/files/*path");
+    std::size_t readme = table.Add("GET", "/files/README");
+    std::size_t any = table.Add("*", "/any");
+    std::size_t trailing = table.Add("GET", "/dir/");
+    std::size_t backtrack = table.Add("GET", "/users/me/settings/x");
+    std::size_t profile = table.Add("GET", "/users/:id/settings/profile");
+    table.Compile();
+
+    RouteParams params;
+    assert(Expect(table, "GET", "/", params) == root && params.Size() == 0);
+    assert(Expect(table, "GET", "/users", params) == users);
+    assert(Expect(table, "GET", "/users/me", params) == me);  // 普通段优先于参数
+    assert(Expect(table, "GET", "/users/42", params) == user && params.Get("id") == "42");
+    assert(Expect(table, "PUT", "/users/42", params) == update && params.Get("id") == "42");
+    assert(Expect(table, "GET", "/users/7/posts/abc?x=1", params) == post);
+    assert(params.Size() == 2 && params.Name(0) == "id" && params.Value(0) == "7" && params.Get("post") == "abc");
+    assert(Expect(table, "GET", "/files/a/b/c.txt", params) == files && params.Get("path") == "a/b/c.txt");
+    assert(Expect(table, "GET", "/files/", params) == files && params.Get("path").empty());
+    assert(Expect(table, "GET", "/files/README", params) == readme);
+    assert(Expect(table, "DELETE", "/any", params) == any);
+    assert(Expect(table, "GET", "/dir/", params) == trailing);
+    assert(Expect(table, "GET", "/users/me/settings/x", params) == backtrack);
+    // 普通段 me 的分支匹配失败后回溯到参数分支
+    assert(Expect(table, "GET", "/users/me/settings/profile", params) == profile && params.Get("id") == "me");
+    assert(params.Get("missing").empty());
+
+    assert(Status(table, "GET", "/nope") == RouteStatus::kNotFound);
+    assert(Status(table, "GET", "/users/") == RouteStatus::kNotFound);     // 参数不匹配空段
+    assert(Status(table, "GET", "/dir") == RouteStatus::kNotFound);
+    assert(Status(table, "GET", "/files") == RouteStatus::kNotFound);
+    assert(Status(table, "GET", "/users/1/posts") == RouteStatus::kNotFound);
+    assert(Status(table, "GET", "http://example.com/") == RouteStatus::kNotFound);
+    assert(Status(table, "POST", "/users/42") == RouteStatus::kMethodNotAllowed);
+    assert(Status(table, "POST", "/files/x") == RouteStatus::kMethodNotAllowed);
+    assert(Status(table, "get", "/users") == RouteStatus::kMethodNotAllowed);  // 方法区分大小写
+}
+
+void TestWideNode()
+{
+    // 子节点较多时使用哈希表
+    RouteTable table;
+    for (int i = 0; i < 200; ++i) {
+        table.Add("GET", "/svc" + std::to_string(i) + "/item/:id");
+    }
+    table.Add("GET", "/:tenant/item/:id");
+    table.Compile();
+    RouteParams params;
+    for (int i = 0; i < 200; ++i) {
+        assert(Expect(table, "GET", ("/svc" + std::to_string(i) + "/item/x").c_str(), params) == static_cast<std::size_t>(i));
+        assert(params.Get("id") == "x");
+    }
+    assert(Expect(table, "GET", "/svc200/item/y", params) == 200 && params.Get("tenant") == "svc200");
+    assert(Status(table, "GET", "/svc1/other/x") == RouteStatus::kNotFound);
+}
+
+void TestRouter()
+{
+    jl::http::Router<int> router;
+    router.Add("GET", "/a/:x", 1);
+    router.Add("POST", "/a/:x", 2);
+    router.Compile();
+    RouteParams params;
+    RouteStatus status;
+    const int* handler = router.Match("POST", "/a/1", params, status);
+    assert(handler && *handler == 2 && status == RouteStatus::kFound);
+    assert(!router.Match("GET", "/b", params, status) && status == RouteStatus::kNotFound);
+    assert(!router.Match("PUT", "/a/1", params, status) && status == RouteStatus::kMethodNotAllowed);
+    (void)handler;
+}
+
+void TestInvalid()
+{
+    assert(Throws("GET", "users"));
+    assert(Throws("GET", ""));
+    assert(Throws("", "/"));
+    assert(Throws("GET", "/a/:"));
+    assert(Throws("GET", "/a/*rest/b"));
+    assert(Throws("GET", "/:a/:b/:c/:d/:e/:f/:g/:h/:i"));
+    assert(!Throws("GET", "/:a/:b/:c/:d/:e/:f/:g/*h"));
+
+    RouteTable table;
+    table.Add("GET", "/a/:x");
+    table.Add("GET", "/a/:y");
+    bool duplicate = false;
+    try {
+        table.Compile();
+    }
+    catch (const std::runtime_error&) {
+        duplicate = true;
+    }
+    assert(duplicate);
+
+    RouteTable compiled;
+    compiled.Compile();
+    bool after_compile = false;
+    try {
+        compiled.Add("GET", "/");
+    }
+    catch (const std::runtime_error&) {
+        after_compile = true;
+    }
+    assert(after_compile);
+    (void)duplicate;
+    (void)after_compile;
+}
+
+int main(int argc, char const *argv[])
+{
+    TestMatch();
+    TestWideNode();
+    TestRouter();
+    TestInvalid();
+    std::cout << "http router test passed." << std::endl;
+    return 0;
+}
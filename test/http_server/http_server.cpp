@@ -1,17 +1,118 @@
 #include "http_server.h"
 
+#include <cstdio>
+
+namespace {
+	constexpr std::chrono::milliseconds kDynamicCacheTtl(1000);     // 示例动态路由的响应缓存时间
+
+	/// @brief 注册示例路由，启动时编译一次，之后所有会话只读共享
+	std::shared_ptr<const HttpRouter> MakeRouter(const std::shared_ptr<jl::http::StaticFileCache>& files,
+		const std::shared_ptr<jl::http::CompressionCache>& compression, const std::shared_ptr<jl::http::ResponseCache>& cache)
+	{
+		auto router = std::make_shared<HttpRouter>();
+		auto serve_file = [files](const jl::http::Request& request, const jl::http::RouteParams& params, std::string_view, HttpResponse& response)
+			{
+				// 存在预压缩的 .gz 文件时直接发送，不在线压缩
+				bool gzip = jl::http::NegotiateEncoding(request.GetHeader("Accept-Encoding")) == jl::http::ContentEncoding::kGzip;
+				response.file = files->Get(params.Get("path"), gzip);
+				if (!response.file) {
+					response.status = 404;
+					response.content_type = "text/plain; charset=UTF-8";
+					response.body.append("Not Found");
+				}
+			};
+		router->Add("GET", "/static/*path", HttpRoute{ serve_file });
+		router->Add("HEAD", "/static/*path", HttpRoute{ serve_file });
+		router->Add("GET", "/hello/:name", HttpRoute{ [](const jl::http::Request&, const jl::http::RouteParams& params, std::string_view, HttpResponse& response)
+			{
+				response.content_type = "text/plain; charset=UTF-8";
+				response.body.append("Hello, ");
+				response.body.append(params.Get("name"));
+			}, kDynamicCacheTtl });
+		router->Add("GET", "/users/:id/posts/:post", HttpRoute{ [](const jl::http::Request&, const jl::http::RouteParams& params, std::string_view, HttpResponse& response)
+			{
+				response.content_type = "application/json";
+				response.body.append("{\"user\":\"");
+				response.body.append(params.Get("id"));
+				response.body.append("\",\"post\":\"");
+				response.body.append(params.Get("post"));
+				response.body.append("\"}");
+			}, kDynamicCacheTtl });
+		// 有请求体的请求在请求体收齐后调用处理函数
+		router->Add("POST", "/users/:id/posts", HttpRoute{ [](const jl::http::Request&, const jl::http::RouteParams& params, std::string_view body, HttpResponse& response)
+			{
+				char bytes[24];
+				const int size = std::snprintf(bytes, sizeof(bytes), "%zu", body.size());
+				response.status = 201;
+				response.content_type = "application/json";
+				response.body.append("{\"user\":\"");
+				response.body.append(params.Get("id"));
+				response.body.append("\",\"bytes\":");
+				response.body.append(bytes, static_cast<std::size_t>(size));
+				response.body.append("}");
+			} });
+		// 响应缓存和压缩缓存的计数
+		router->Add("GET", "/stats", HttpRoute{ [compression, cache](const jl::http::Request&, const jl::http::RouteParams&, std::string_view, HttpResponse& response)
+			{
+				const jl::http::ResponseCache::Stats responses = cache->GetStats();
+				const jl::http::CompressionCache::Stats compressed = compression->GetStats();
+				char text[512];
+				const int size = std::snprintf(text, sizeof(text),
+					"{\"response_cache\":{\"hits\":%llu,\"misses\":%llu,\"coalesced\":%llu,\"expired\":%llu,\"evictions\":%llu,"
+					"\"hit_ratio\":%.4f,\"hit_bytes\":%llu,\"bytes\":%zu,\"entries\":%zu},"
+					"\"compression_cache\":{\"hits\":%llu,\"misses\":%llu,\"coalesced\":%llu,\"bytes\":%zu,\"entries\":%zu}}",
+					static_cast<unsigned long long>(responses.hits), static_cast<unsigned long long>(responses.misses),
+					static_cast<unsigned long long>(responses.coalesced), static_cast<unsigned long long>(responses.expired),
+					static_cast<unsigned long long>(responses.evictions), responses.HitRatio(),
+					static_cast<unsigned long long>(responses.hit_bytes), responses.bytes, responses.entries,
+					static_cast<unsigned long long>(compressed.hits), static_cast<unsigned long long>(compressed.misses),
+					static_cast<unsigned long long>(compressed.coalesced), compressed.bytes, compressed.entries);
+				response.content_type = "application/json";
+				response.body.append(text, static_cast<std::size_t>(size));
+			} });
+		// 其余请求回显请求行、头部和请求体。HTTP/1.1 的请求体边收边回显，不在内存中累积
+		auto echo = [](const jl::http::Request& request, const jl::http::RouteParams&, std::string_view body, HttpResponse& response)
+			{
+				response.body.append("<html><body>");
+				AppendRequestEcho(response.body, request);
+				response.body.append(body.data(), body.size());
+				response.body.append("</body></html>");
+			};
+		auto echo_stream = [](const jl::http::Request& request, const jl::http::RouteParams&, HttpChunkWriter& writer)
+			{
+				std::string head("<html><body>");
+				head.reserve(head.size() + RequestEchoSize(request));
+				AppendRequestEcho(head, request);
+				writer.Write(head);
+				return HttpBodyCallbacks{
+					[](std::string_view chunk, HttpChunkWriter& writer) { writer.Write(chunk); },
+					[](HttpChunkWriter& writer) { writer.Write("</body></html>"); } };
+			};
+		router->Add("*", "/*path", HttpRoute{ echo, std::chrono::milliseconds(0), echo_stream });
+		router->Compile();
+		return router;
+	}
+}
+
 HttpServer::HttpServer(const std::string& ip, unsigned short port) :
 	tcp_server_(ioct_, ip, port),
-	id_generator_(jl::util::MakeIdGenerator<jl::util::Snowflake>(1))
+	id_generator_(jl::util::MakeIdGenerator<jl::util::AtomicSnowflake>(1)),
+	files_(std::make_shared<jl::http::StaticFileCache>("./www")),
+	compression_(std::make_shared<jl::http::CompressionCache>()),
+	cache_(std::make_shared<jl::http::ResponseCache>()),
+	router_(MakeRouter(files_, compression_, cache_))
 {
 	tcp_server_.SetConnEstablishCallback([=](jl::net::socket&& socket)
 		{
-			std::shared_ptr<jl::IConnection> conn = jl::MakeSSLConnection(std::move(socket));
-			std::int64_t session_id = id_generator_->GenerateId();
-			std::shared_ptr<HttpSession> session = std::make_shared<HttpSession>(shared_from_this(), session_id, conn);
-			this->AppendSession(session_id, session);
-			session->Start();
-			LOG_INFO("New connection comming.");
+			// 同一端口同时接受 HTTPS 和明文连接，明文连接可以使用 h2c（prior knowledge）
+			jl::MakeAutoConnection(std::move(socket), [=](const std::shared_ptr<jl::IConnection>& conn)
+				{
+					std::int64_t session_id = id_generator_->GenerateId();
+					std::shared_ptr<HttpSession> session = std::make_shared<HttpSession>(shared_from_this(), session_id, conn, router_, compression_, cache_);
+					this->AppendSession(session_id, session);
+					session->Start();
+					LOG_INFO("New connection comming.");
+				});
 		}
 	);
 }
@@ -29,12 +130,39 @@ void HttpServer::AppendSession(std::int64_t session_id, const std::shared_ptr<Ht
 
 void HttpServer::RemoveSession(std::int64_t session_id)
 {
+	{
+		std::lock_guard<std::mutex> lock(chat_mutex_);
+		chat_.erase(session_id);
+	}
 	std::lock_guard<std::mutex> lock(session_mutex_);
 	if (sessions_.find(session_id) != sessions_.end()) {
 		sessions_.erase(session_id);
 	}
 }
 
+void HttpServer::JoinChat(std::int64_t session_id, const std::shared_ptr<HttpSession>& session)
+{
+	std::lock_guard<std::mutex> lock(chat_mutex_);
+	chat_.emplace(session_id, session);
+}
+
+void HttpServer::Broadcast(const std::shared_ptr<const std::string>& frame)
+{
+	std::vector<std::shared_ptr<HttpSession>> members;
+	{
+		std::lock_guard<std::mutex> lock(chat_mutex_);
+		members.reserve(chat_.size());
+		for (const auto& member : chat_) {
+			if (auto session = member.second.lock()) {
+				members.push_back(std::move(session));
+			}
+		}
+	}
+	for (const auto& session : members) {
+		session->SendShared(frame);
+	}
+}
+
 void HttpServer::Stop()
 {
     tcp_server_.Stop();
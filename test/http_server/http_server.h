@@ -19,12 +19,23 @@ public:
 
     void RemoveSession(std::int64_t session_id);
 
+    void JoinChat(std::int64_t session_id, const std::shared_ptr<HttpSession>& session);
+
+    /// @brief 把同一个帧发给所有 /chat 连接
+    void Broadcast(const std::shared_ptr<const std::string>& frame);
+
     void Stop();
 
 private:
     std::unique_ptr<jl::util::IdGenerator> id_generator_;
+    std::shared_ptr<jl::http::StaticFileCache> files_;  // ./www 下的静态文件，通过 /static/ 访问
+    std::shared_ptr<jl::http::CompressionCache> compression_;
+    std::shared_ptr<jl::http::ResponseCache> cache_;    // 可缓存路由的响应，所有会话共享
+    std::shared_ptr<const HttpRouter> router_;
     std::mutex session_mutex_;
     std::map<std::int64_t, std::shared_ptr<HttpSession>> sessions_;
+    std::mutex chat_mutex_;
+    std::map<std::int64_t, std::weak_ptr<HttpSession>> chat_;
     asio::io_context ioct_;
     jl::Server tcp_server_;
 };
@@ -1,7 +1,19 @@
 #include "http_session.h"
 
 #include <http_server.h>
+#include <simd_scan.h>
 #include <util.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <unistd.h>
+
+constexpr std::size_t kMaxInFlightWrites = 16;              // 每个连接已提交但未写完的写操作数上限
+constexpr std::size_t kMaxPendingWriteBytes = 256 * 1024;   // 每个连接已提交但未写完的字节数上限
+constexpr std::size_t kMaxBroadcastBacklog = 4 * 1024 * 1024; // 广播消息积压超过该字节数的 WebSocket 连接视为慢消费者，直接断开
+constexpr std::size_t kHttpIdleTimeout = 10000;              // 毫秒
+constexpr std::size_t kPersistentIdleTimeout = 120000;       // WebSocket 和 HTTP/2 为长连接，空闲超时更长
+constexpr std::size_t kBodySliceBytes = 16 * 1024;           // 流式请求体每次交给回调的最大字节数，之间检查写出积压
 
 void HttpSession::Start()
 {
@@ -9,82 +21,50 @@ void HttpSession::Start()
     conn_->SetHandshakeCallback(
         [=](const std::shared_ptr<jl::IConnection>& conn)
         {
-            conn->ReadUntil("\r\n");
+            auto self = weak.lock();
+            if (self) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                Process();
+            }
         });
     conn_->SetMessageCommingCallback(
         [=](const std::shared_ptr<jl::IConnection>& conn, const std::string& buffer)
         {
             auto self = weak.lock();
             if (self) {
-                timer_->Cancel();
-                if (state_ == State::kRequestLine)
                 {
-                    request_.request_line_ = buffer;
-#ifdef _DEBUG
-                    LOG_INFO("{}:{}> Request line: {}", remote_ip_, remote_port_, buffer);
-#endif
-                    state_ = State::kHeaders;
-                    conn->ReadUntil("\r\n");
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    timer_->Cancel();
+                    reading_ = false;
+                    buffer_.append(buffer);
+                    Process();
+                    timer_->Wait(IdleTimeout());
                 }
-                else if (state_ == State::kHeaders)
-                {
-#ifdef _DEBUG
-                    LOG_INFO("{}:{}> Header: {}", remote_ip_, remote_port_, buffer);
-#endif
-                    if (buffer.size() > 0) // 读取到空行，头部读取完毕
-                    {
-                        std::string key = buffer.substr(0, buffer.find(":"));
-                        std::string value = buffer.substr(buffer.find(":") + 2); // 跳过空格和冒号
-                        request_.headers_[key] = value;
-                        conn->ReadUntil("\r\n");
-                    }
-                    else
-                    {
-                        if (request_.headers_.find("Content-Length") != request_.headers_.end()) // 有Content-Length字段，读取body
-                        {
-                            state_ = State::kBody;
-                            int content_length = std::stol(request_.headers_["Content-Length"]); // 获取Content-Length字段的值 fix: stol bug
-                            conn->ReadN(content_length);                                // 读取body
-                        }
-                        // else if (headers_.find("Transfer-Encoding") != headers_.end()) // 有Transfer-Encoding字段，读取body (暂时不支持)
-                        // {
-                        // }
-                        else // 没有Content-Length、Transfer-Encoding字段，说明没有request body
-                        {
-                            state_ = State::kDone;
-                            std::string response = GetHttpResponse(request_);
-                            conn->Write(response);
-                        }
-                    }
-                }
-            }
-            else if (state_ == State::kBody)
-            {
-                state_ = State::kDone;
-                request_.body_ = buffer;
-#ifdef _DEBUG
-                LOG_INFO("{}:{}> Request body: {}", remote_ip_, remote_port_, buffer);
-#endif // DEBUG
-                std::string response = GetHttpResponse(request_);
-                conn->Write(response);
+                FlushBroadcasts();
             }
-            else
-            {
-                assert(false);
-            }
-            timer_->Wait(10000);
         });
 
     conn_->SetWriteFinishCallback([=](const std::shared_ptr<jl::IConnection>& conn, std::size_t bytes_transferred)
         {
             auto self = weak.lock();
             if (self) {
-                timer_->Cancel();
-                assert(state_ == State::kDone);
-                state_ = State::kRequestLine;
-                conn->ReadUntil("\r\n");
-                timer_->Wait(10000);
-                //LOG_INFO("Write finish: {}", bytes_transferred); 
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    timer_->Cancel();
+                    assert(in_flight_ > 0 && pending_bytes_ >= bytes_transferred);
+                    --in_flight_;
+                    pending_bytes_ -= bytes_transferred;
+                    if (closing_) {
+                        if (in_flight_ == 0 && !deferred_) {
+                            conn->Close();
+                        }
+                        return;
+                    }
+                    Process(); // 可能因为达到在途上限暂停了解析或读取
+                    timer_->Wait(IdleTimeout());
+                    //LOG_INFO("Write finish: {}", bytes_transferred); 
+                }
+                FlushBroadcasts();
             }
         });
     conn_->SetConnCloseCallback([=](const std::shared_ptr<jl::IConnection>& conn)
@@ -105,7 +85,7 @@ void HttpSession::Start()
                 self->OnTimeout();
             };
         });
-    timer_->Wait(10000);
+    timer_->Wait(kHttpIdleTimeout);
     //conn_->ReadUntil("\r\n");
     conn_->Handshake();
 }
@@ -115,6 +95,1012 @@ HttpSession::~HttpSession()
     LOG_ERROR("HttpSession destruct");
 }
 
+void HttpSession::Process()
+{
+    while (!closing_ && !deferred_ && in_flight_ < kMaxInFlightWrites && pending_bytes_ < kMaxPendingWriteBytes)
+    {
+        if (websocket_)
+        {
+            if (!ProcessWebSocket())
+            {
+                break;
+            }
+            continue;
+        }
+        if (h2_)
+        {
+            ProcessHttp2();
+            break;
+        }
+        if (!protocol_known_)
+        {
+            // 连接的第一个请求以 HTTP/2 连接前言开头时切换到 h2c；前言不完整时等待更多数据
+            const std::size_t size = buffer_.size() - consumed_;
+            const std::size_t n = std::min(size, jl::http2::kClientPreface.size());
+            if (jl::http2::kClientPreface.compare(0, n, std::string_view(buffer_.data() + consumed_, n)) == 0)
+            {
+                if (n < jl::http2::kClientPreface.size())
+                {
+                    break;
+                }
+                StartHttp2();
+                continue;
+            }
+            protocol_known_ = true;
+        }
+        if (body_active_)
+        {
+            if (!ProcessBody())
+            {
+                break;
+            }
+            continue;
+        }
+        const char* data = buffer_.data() + consumed_;
+        const std::size_t size = buffer_.size() - consumed_;
+        jl::http::ParseStatus status = parser_.Parse(data, size);
+        if (status == jl::http::ParseStatus::kNeedMore)
+        {
+            break;
+        }
+        if (status == jl::http::ParseStatus::kError)
+        {
+            int code = jl::http::StatusCode(parser_.Error());
+            LOG_ERROR("{}:{}> Bad request, status {}", remote_ip_, remote_port_, code);
+            Reply(code);
+            break;
+        }
+        const auto& request = parser_.GetRequest();
+        if (request.content_length > jl::http::kDefaultMaxBodyBytes)
+        {
+            Reply(413);
+            break;
+        }
+#ifdef _DEBUG
+        LOG_INFO("{}:{}> Request: {} {}", remote_ip_, remote_port_, request.method, request.target);
+#endif
+        const bool has_body = request.chunked || request.content_length > 0;
+        jl::http::RouteStatus route_status;
+        const HttpRoute* route = router_->Match(request.method, request.target, params_, route_status);
+        if (!route && has_body)
+        {
+            // 请求体没有读取，无法继续解析后续请求
+            Reply(route_status == jl::http::RouteStatus::kMethodNotAllowed ? 405 : 404);
+            break;
+        }
+        if (!has_body && jl::ws::IsUpgradeRequest(request))
+        {
+            std::string_view path = request.target.substr(0, request.target.find('?'));
+            if (path == "/ws" || path == "/chat")
+            {
+                Upgrade(request, path == "/chat");
+                consumed_ += parser_.HeaderBytes();
+                parser_.Reset();
+                continue;
+            }
+        }
+        if (!has_body && route && route->cache_ttl.count() > 0 && (request.method == "GET" || request.method == "HEAD"))
+        {
+            if (!ServeCached(request, *route))
+            {
+                // 请求留在 buffer_ 中，等待的响应到达后重新解析
+                parser_.Reset();
+                break;
+            }
+        }
+        else if (!has_body)
+        {
+            // HTTP/1.1 默认长连接，HTTP/1.0 需要 Connection: keep-alive
+            closing_ = !request.keep_alive;
+            Handle(request, route, route_status);
+            out_.clear();
+            if (response_.file)
+            {
+                SendStaticFile(request);
+            }
+            else
+            {
+                SendResponse(request);
+            }
+        }
+        else
+        {
+            // 客户端等待 100 Continue 时先回应，不必等它超时后才发送请求体
+            constexpr std::string_view kContinue = "100-continue";
+            std::string_view expect = request.GetHeader("Expect");
+            if (request.version_minor >= 1 && expect.size() == kContinue.size() && jl::simd::EqualsNoCase(expect.data(), kContinue.data(), kContinue.size()))
+            {
+                out_.assign("HTTP/1.1 100 Continue\r\n\r\n");
+                Send(out_);
+            }
+            body_active_ = true;
+            body_chunked_ = request.chunked;
+            body_remaining_ = request.content_length;
+            decoder_.Reset();
+            body_streaming_ = static_cast<bool>(route->stream);
+            if (body_streaming_)
+            {
+                // 请求体不在内存中累积，收到多少交给回调多少；响应头随回调的第一次写出发出
+                out_.clear();
+                stream_writer_.Begin(request.version_minor >= 1, request.keep_alive);
+                body_callbacks_ = route->stream(request, params_, stream_writer_);
+                if (!out_.empty())
+                {
+                    Send(out_);
+                }
+            }
+            else
+            {
+                // 请求体收齐后再交给处理函数。请求和路由参数的视图指向 buffer_，请求头留在 buffer_ 中，收齐后重新解析
+                request_start_ = consumed_;
+                body_.clear();
+            }
+        }
+        consumed_ += parser_.HeaderBytes();
+        parser_.Reset();
+    }
+    // 一次性移除已处理的数据，避免每个请求移动一次剩余数据；正在接收请求体的请求从请求头开始保留
+    const std::size_t processed = body_active_ && !body_streaming_ ? request_start_ : consumed_;
+    if (processed > 0)
+    {
+        buffer_.erase(0, processed);
+        consumed_ -= processed;
+        request_start_ -= std::min(request_start_, processed);
+    }
+    // 响应写出的同时继续读取后续数据；达到在途上限时暂停读取，由写完成回调恢复
+    if (!closing_ && !deferred_ && in_flight_ < kMaxInFlightWrites && pending_bytes_ < kMaxPendingWriteBytes && !reading_)
+    {
+        reading_ = true;
+        conn_->Read();
+    }
+}
+
+bool HttpSession::ProcessBody()
+{
+    if (body_streaming_)
+    {
+        return StreamBody();
+    }
+    const char* data = buffer_.data() + consumed_;
+    const std::size_t size = buffer_.size() - consumed_;
+    if (body_chunked_)
+    {
+        std::size_t used = 0;
+        jl::http::ParseStatus status = decoder_.Decode(data, size, used, [this](std::string_view piece) { body_.append(piece.data(), piece.size()); });
+        // 解码后的请求体在 body_ 中，不再保留原始的 chunked 数据，consumed_ 停在请求体开头
+        buffer_.erase(consumed_, used);
+        if (status == jl::http::ParseStatus::kError)
+        {
+            int code = jl::http::StatusCode(decoder_.Error());
+            LOG_ERROR("{}:{}> Bad chunked body, status {}", remote_ip_, remote_port_, code);
+            body_active_ = false;
+            Reply(code);
+            return false;
+        }
+        if (status != jl::http::ParseStatus::kComplete)
+        {
+            return false;
+        }
+    }
+    else
+    {
+        std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(size, body_remaining_));
+        consumed_ += n;
+        body_remaining_ -= n;
+        if (body_remaining_ > 0)
+        {
+            return false;
+        }
+    }
+    body_active_ = false;
+    // 请求头没有变化，重新解析一定完整
+    parser_.Reset();
+    jl::http::ParseStatus status = parser_.Parse(buffer_.data() + request_start_, consumed_ - request_start_);
+    assert(status == jl::http::ParseStatus::kComplete);
+    (void)status;
+    const auto& request = parser_.GetRequest();
+    std::string_view body = body_chunked_ ? std::string_view(body_) :
+        std::string_view(buffer_.data() + request_start_ + parser_.HeaderBytes(), static_cast<std::size_t>(request.content_length));
+    jl::http::RouteStatus route_status;
+    const HttpRoute* route = router_->Match(request.method, request.target, params_, route_status);
+    closing_ = !request.keep_alive;
+    Handle(request, route, route_status, body);
+    out_.clear();
+    if (response_.file)
+    {
+        SendStaticFile(request);
+    }
+    else
+    {
+        SendResponse(request);
+    }
+    parser_.Reset();
+    return true;
+}
+
+bool HttpSession::StreamBody()
+{
+    out_.clear();
+    auto on_data = [this](std::string_view piece)
+    {
+        if (body_callbacks_.on_body)
+        {
+            body_callbacks_.on_body(piece, stream_writer_);
+        }
+    };
+    bool finished = false;
+    // 分片交付，回调写出的数据积压超过上限时停下，写出后由写完成回调继续
+    while (!finished && consumed_ < buffer_.size() && stream_writer_.Writable())
+    {
+        const char* data = buffer_.data() + consumed_;
+        const std::size_t size = std::min(buffer_.size() - consumed_, kBodySliceBytes);
+        if (body_chunked_)
+        {
+            std::size_t used = 0;
+            jl::http::ParseStatus status = decoder_.Decode(data, size, used, on_data);
+            consumed_ += used;
+            if (status == jl::http::ParseStatus::kError)
+            {
+                int code = jl::http::StatusCode(decoder_.Error());
+                LOG_ERROR("{}:{}> Bad chunked body, status {}", remote_ip_, remote_port_, code);
+                body_active_ = false;
+                body_callbacks_ = HttpBodyCallbacks();
+                if (!stream_writer_.HeadSent())
+                {
+                    Reply(code);
+                    return false;
+                }
+                // 响应头已经发出，无法再返回错误状态码，只能关闭连接
+                if (!out_.empty())
+                {
+                    Send(out_);
+                }
+                closing_ = true;
+                if (in_flight_ == 0)
+                {
+                    conn_->Close();
+                }
+                return false;
+            }
+            finished = status == jl::http::ParseStatus::kComplete;
+        }
+        else
+        {
+            std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(size, body_remaining_));
+            on_data(std::string_view(data, n));
+            consumed_ += n;
+            body_remaining_ -= n;
+            finished = body_remaining_ == 0;
+        }
+    }
+    if (finished)
+    {
+        if (body_callbacks_.on_end)
+        {
+            body_callbacks_.on_end(stream_writer_);
+        }
+        stream_writer_.End();
+        // 释放回调捕获的请求状态
+        body_callbacks_ = HttpBodyCallbacks();
+        body_active_ = false;
+        closing_ = !stream_writer_.KeepAlive();
+    }
+    if (!out_.empty())
+    {
+        Send(out_);
+    }
+    return finished;
+}
+
+void HttpSession::StreamWriter::Begin(bool chunked, bool keep_alive)
+{
+    status_ = 200;
+    content_type_.assign("text/html; charset=UTF-8");
+    head_sent_ = false;
+    chunked_ = chunked;
+    keep_alive_ = keep_alive && chunked;
+}
+
+void HttpSession::StreamWriter::Head(int status, std::string_view content_type)
+{
+    if (head_sent_)
+    {
+        LOG_WARN("Response head already sent, status {} ignored", status);
+        return;
+    }
+    status_ = status;
+    content_type_.assign(content_type.data(), content_type.size());
+}
+
+void HttpSession::StreamWriter::Write(std::string_view data)
+{
+    if (data.empty())
+    {
+        return;
+    }
+    SendHead();
+    if (chunked_)
+    {
+        jl::http::AppendChunk(session_.out_, data);
+    }
+    else
+    {
+        session_.out_.append(data.data(), data.size());
+    }
+}
+
+bool HttpSession::StreamWriter::Writable() const
+{
+    return session_.pending_bytes_ + session_.out_.size() < kMaxPendingWriteBytes;
+}
+
+void HttpSession::StreamWriter::End()
+{
+    SendHead();
+    if (chunked_)
+    {
+        session_.out_.append(jl::http::kLastChunk);
+    }
+}
+
+void HttpSession::StreamWriter::SendHead()
+{
+    if (!head_sent_)
+    {
+        head_sent_ = true;
+        AppendStreamingResponseHead(session_.out_, status_, content_type_, chunked_, keep_alive_);
+    }
+}
+
+void HttpSession::Upgrade(const jl::http::Request& request, bool chat)
+{
+    out_.clear();
+    jl::ws::AppendHandshakeResponse(out_, request.GetHeader("Sec-WebSocket-Key"));
+    Send(out_);
+    websocket_ = true;
+    if (chat)
+    {
+        auto server = server_.lock();
+        if (server)
+        {
+            server->JoinChat(session_id_, shared_from_this());
+        }
+    }
+    chat_ = chat;
+    LOG_INFO("{}:{}> WebSocket {}", remote_ip_, remote_port_, chat ? "chat" : "echo");
+}
+
+bool HttpSession::ProcessWebSocket()
+{
+    std::size_t used = 0;
+    jl::ws::Message message;
+    jl::http::ParseStatus status = ws_parser_.Parse(&buffer_[0] + consumed_, buffer_.size() - consumed_, used, message);
+    consumed_ += used;
+    if (status == jl::http::ParseStatus::kNeedMore)
+    {
+        return false;
+    }
+    out_.clear();
+    if (status == jl::http::ParseStatus::kError)
+    {
+        LOG_ERROR("{}:{}> Bad WebSocket frame, close code {}", remote_ip_, remote_port_, static_cast<int>(ws_parser_.Error()));
+        jl::ws::AppendCloseFrame(out_, ws_parser_.Error());
+        Send(out_);
+        closing_ = true;
+        return false;
+    }
+    switch (message.opcode)
+    {
+    case jl::ws::Opcode::kPing:
+        jl::ws::AppendFrame(out_, jl::ws::Opcode::kPong, message.payload);
+        Send(out_);
+        break;
+    case jl::ws::Opcode::kPong:
+        break;
+    case jl::ws::Opcode::kClose:
+    {
+        // 回应关闭帧后关闭连接
+        jl::ws::CloseCode code;
+        std::string_view reason;
+        jl::ws::ParseClosePayload(message.payload, code, reason);
+        jl::ws::AppendCloseFrame(out_, code == jl::ws::CloseCode::kNoStatus ? jl::ws::CloseCode::kNormal : code);
+        Send(out_);
+        closing_ = true;
+        return false;
+    }
+    default:
+        if (chat_)
+        {
+            // 帧只序列化一次，所有接收者共享，释放锁后再分发
+            auto frame = std::make_shared<std::string>();
+            jl::ws::AppendFrame(*frame, message.opcode, message.payload);
+            broadcasts_.push_back(std::move(frame));
+        }
+        else
+        {
+            jl::ws::AppendFrame(out_, message.opcode, message.payload);
+            Send(out_);
+        }
+        break;
+    }
+    return true;
+}
+
+void HttpSession::FlushBroadcasts()
+{
+    std::vector<std::shared_ptr<const std::string>> frames;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (broadcasts_.empty())
+        {
+            return;
+        }
+        frames.swap(broadcasts_);
+    }
+    auto server = server_.lock();
+    if (server)
+    {
+        for (const auto& frame : frames)
+        {
+            server->Broadcast(frame);
+        }
+    }
+}
+
+void HttpSession::SendShared(const std::shared_ptr<const std::string>& frame)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closing_ || !websocket_)
+    {
+        return;
+    }
+    if (pending_bytes_ > kMaxBroadcastBacklog)
+    {
+        LOG_ERROR("{}:{}> WebSocket consumer too slow, {} bytes pending", remote_ip_, remote_port_, pending_bytes_);
+        closing_ = true;
+        conn_->Close();
+        return;
+    }
+    Send(frame);
+}
+
+void HttpSession::Handle(const jl::http::Request& request, const HttpRoute* route, jl::http::RouteStatus route_status, std::string_view body)
+{
+    response_.status = 200;
+    response_.content_type = "text/html; charset=UTF-8";
+    response_.body.clear();
+    response_.file.reset();
+    if (route)
+    {
+        route->handler(request, params_, body, response_);
+    }
+    else
+    {
+        response_.status = route_status == jl::http::RouteStatus::kMethodNotAllowed ? 405 : 404;
+        response_.content_type = "text/plain; charset=UTF-8";
+        response_.body.append(jl::http::ReasonPhrase(response_.status));
+    }
+}
+
+std::shared_ptr<const jl::http::CachedResponse> HttpSession::Generate(const jl::http::Request& request, const HttpRoute& route)
+{
+    Handle(request, &route, jl::http::RouteStatus::kFound);
+    if (response_.file)
+    {
+        cache_->Complete(cache_key_, nullptr, std::chrono::milliseconds(0));
+        return nullptr;
+    }
+    const bool compressible = response_.body.size() >= jl::http::kMinCompressBytes && jl::http::IsCompressible(response_.content_type);
+    auto cached = jl::http::MakeCachedResponse(response_.status, response_.content_type, std::move(response_.body),
+        compressible ? "Vary: Accept-Encoding\r\n" : "");
+    response_.body.clear();
+    // 只缓存 200，其他状态只交给合并等待的请求
+    cache_->Complete(cache_key_, cached, response_.status == 200 ? route.cache_ttl : std::chrono::milliseconds(0));
+    return cached;
+}
+
+bool HttpSession::ServeCached(const jl::http::Request& request, const HttpRoute& route)
+{
+    std::shared_ptr<const jl::http::CachedResponse> cached;
+    if (awaited_ready_)
+    {
+        awaited_ready_ = false;
+        cached = std::move(awaited_);
+        awaited_.reset();
+    }
+    else
+    {
+        cache_->MakeKey(request, cache_key_);
+        jl::http::ResponseCache::LookupStatus status = cache_->Lookup(cache_key_, cached);
+        while (status == jl::http::ResponseCache::LookupStatus::kPending)
+        {
+            std::weak_ptr<HttpSession> weak = shared_from_this();
+            asio::any_io_executor executor = conn_->GetExecutor();
+            const bool waiting = cache_->Wait(cache_key_, [weak, executor](const jl::http::ResponseCache::Entry& response)
+                {
+                    // 在生成方的线程中回调，切换到本连接的io线程
+                    asio::post(executor, [weak, response]()
+                        {
+                            auto self = weak.lock();
+                            if (!self)
+                            {
+                                return;
+                            }
+                            {
+                                std::lock_guard<std::mutex> lock(self->mutex_);
+                                self->deferred_ = false;
+                                self->awaited_ = response;
+                                self->awaited_ready_ = true;
+                                self->Process();
+                            }
+                            self->FlushBroadcasts();
+                        });
+                });
+            if (waiting)
+            {
+                deferred_ = true;
+                return false;
+            }
+            status = cache_->Lookup(cache_key_, cached);
+        }
+        if (status == jl::http::ResponseCache::LookupStatus::kMiss)
+        {
+            cached = Generate(request, route);
+            if (!cached)
+            {
+                closing_ = !request.keep_alive;
+                out_.clear();
+                SendStaticFile(request);
+                return true;
+            }
+        }
+    }
+    closing_ = !request.keep_alive;
+    out_.clear();
+    if (cached)
+    {
+        SendCached(request, cached);
+        return true;
+    }
+    // 等待的生成方返回了文件，文件不进入缓存，自己调用处理函数
+    Handle(request, &route, jl::http::RouteStatus::kFound);
+    if (response_.file)
+    {
+        SendStaticFile(request);
+    }
+    else
+    {
+        SendResponse(request);
+    }
+    return true;
+}
+
+void HttpSession::SendCached(const jl::http::Request& request, const std::shared_ptr<const jl::http::CachedResponse>& cached)
+{
+    const bool head = request.method == "HEAD";
+    const bool compressible = cached->body.size() >= jl::http::kMinCompressBytes && jl::http::IsCompressible(cached->content_type);
+    if (compressible && jl::http::NegotiateEncoding(request.GetHeader("Accept-Encoding")) != jl::http::ContentEncoding::kIdentity)
+    {
+        // 压缩结果在 CompressionCache 中，这里按处理函数的输出处理
+        response_.status = cached->status;
+        response_.content_type = cached->content_type;
+        response_.body.assign(cached->body);
+        SendResponse(request);
+        return;
+    }
+    if (request.keep_alive && !head)
+    {
+        // 所有连接共享同一份序列化好的响应
+        Send(jl::http::SharedWire(cached));
+        return;
+    }
+    if (compressible)
+    {
+        AppendEncodedResponse(out_, cached->status, cached->content_type, jl::http::ContentEncoding::kIdentity, cached->body, request.keep_alive, head);
+    }
+    else
+    {
+        response_.status = cached->status;
+        response_.content_type = cached->content_type;
+        response_.body.assign(cached->body);
+        AppendResponse(out_, response_, request.keep_alive, head);
+    }
+    Send(out_);
+}
+
+void HttpSession::StartHttp2()
+{
+    protocol_known_ = true;
+    h2_ = std::make_unique<jl::http2::ServerSession>();
+    // 回调在 h2_->Receive 中执行，此时已持有 mutex_
+    h2_->SetRequestCallback([this](std::uint32_t stream_id, const jl::http::Request& request, std::string_view body)
+        {
+            OnHttp2Request(stream_id, request, body);
+        });
+    LOG_INFO("{}:{}> HTTP/2", remote_ip_, remote_port_);
+}
+
+void HttpSession::ProcessHttp2()
+{
+    std::size_t used = 0;
+    jl::http::ParseStatus status = h2_->Receive(buffer_.data() + consumed_, buffer_.size() - consumed_, used);
+    consumed_ += used;
+    if (status == jl::http::ParseStatus::kError)
+    {
+        LOG_ERROR("{}:{}> HTTP/2 connection error", remote_ip_, remote_port_);
+    }
+    FlushHttp2();
+}
+
+void HttpSession::OnHttp2Request(std::uint32_t stream_id, const jl::http::Request& request, std::string_view body)
+{
+#ifdef _DEBUG
+    LOG_INFO("{}:{}> Request: {} {} (stream {})", remote_ip_, remote_port_, request.method, request.target, stream_id);
+#endif
+    jl::http::RouteStatus route_status;
+    const HttpRoute* route = router_->Match(request.method, request.target, params_, route_status);
+    const bool head = request.method == "HEAD";
+    const jl::http::ContentEncoding accepted = jl::http::NegotiateEncoding(request.GetHeader("Accept-Encoding"));
+    if (body.empty() && route && route->cache_ttl.count() > 0 && (request.method == "GET" || head))
+    {
+        RespondHttp2Cached(stream_id, request, *route, accepted);
+        return;
+    }
+    if (!body.empty() && route && route->stream)
+    {
+        // 请求体已经完整地在内存中，回调一次收到整个请求体；输出收集到 response_，响应长度已知
+        response_.status = 200;
+        response_.content_type = "text/html; charset=UTF-8";
+        response_.body.clear();
+        response_.file.reset();
+        HttpResponseCollector collector(response_);
+        HttpBodyCallbacks callbacks = route->stream(request, params_, collector);
+        if (callbacks.on_body)
+        {
+            callbacks.on_body(body, collector);
+        }
+        if (callbacks.on_end)
+        {
+            callbacks.on_end(collector);
+        }
+        RespondHttp2(stream_id, head, accepted);
+        return;
+    }
+    Handle(request, route, route_status, body);
+    if (response_.file)
+    {
+        RespondHttp2File(stream_id, request);
+    }
+    else
+    {
+        RespondHttp2(stream_id, head, accepted);
+    }
+}
+
+void HttpSession::RespondHttp2(std::uint32_t stream_id, bool head, jl::http::ContentEncoding accepted)
+{
+    const bool compressible = response_.body.size() >= jl::http::kMinCompressBytes && jl::http::IsCompressible(response_.content_type);
+    const jl::http::ContentEncoding encoding = compressible ? accepted : jl::http::ContentEncoding::kIdentity;
+    if (encoding == jl::http::ContentEncoding::kIdentity)
+    {
+        // 没有 owner 时 h2_ 把响应体复制到连接的内存池中，response_.body 保留容量给下一个请求复用
+        RespondHttp2Body(stream_id, response_.status, response_.content_type, compressible, encoding, head, response_.body, nullptr);
+        return;
+    }
+    const auto key = jl::http::CompressionCache::MakeKey(encoding, response_.body);
+    if (auto compressed = compression_->Find(key))
+    {
+        RespondHttp2Body(stream_id, response_.status, response_.content_type, true, encoding, head, *compressed, compressed);
+        return;
+    }
+    // 流之间没有顺序要求，压缩期间继续处理其他流
+    std::weak_ptr<HttpSession> weak = shared_from_this();
+    auto body = std::make_shared<const std::string>(std::move(response_.body));
+    response_.body.clear();
+    const int status = response_.status;
+    const std::string content_type(response_.content_type);
+    asio::any_io_executor executor = conn_->GetExecutor();
+    compression_->CompressAsync(key, body, [=](const jl::http::CompressionCache::Result& compressed)
+        {
+            asio::post(executor, [=]()
+                {
+                    auto self = weak.lock();
+                    if (!self)
+                    {
+                        return;
+                    }
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (closing_)
+                    {
+                        return;
+                    }
+                    if (compressed)
+                    {
+                        RespondHttp2Body(stream_id, status, content_type, true, encoding, head, *compressed, compressed);
+                    }
+                    else
+                    {
+                        RespondHttp2Body(stream_id, status, content_type, true, jl::http::ContentEncoding::kIdentity, head, *body, body);
+                    }
+                    FlushHttp2();
+                });
+        });
+}
+
+void HttpSession::RespondHttp2Cached(std::uint32_t stream_id, const jl::http::Request& request, const HttpRoute& route, jl::http::ContentEncoding accepted)
+{
+    const bool head = request.method == "HEAD";
+    cache_->MakeKey(request, cache_key_);
+    std::shared_ptr<const jl::http::CachedResponse> cached;
+    jl::http::ResponseCache::LookupStatus status = cache_->Lookup(cache_key_, cached);
+    while (status == jl::http::ResponseCache::LookupStatus::kPending)
+    {
+        // 流之间没有顺序要求，等待期间继续处理其他流。请求的视图在回调返回后失效，生成方返回文件时需要再次处理请求，保存副本
+        std::weak_ptr<HttpSession> weak = shared_from_this();
+        asio::any_io_executor executor = conn_->GetExecutor();
+        auto owned = std::make_shared<const OwnedRequest>(request);
+        const bool waiting = cache_->Wait(cache_key_, [=](const jl::http::ResponseCache::Entry& response)
+            {
+                asio::post(executor, [=]()
+                    {
+                        auto self = weak.lock();
+                        if (!self)
+                        {
+                            return;
+                        }
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        if (closing_)
+                        {
+                            return;
+                        }
+                        if (response)
+                        {
+                            RespondHttp2Entry(stream_id, head, accepted, response);
+                        }
+                        else
+                        {
+                            // 生成方返回了文件，文件不进入缓存，与 HTTP/1.1 一样自己调用处理函数
+                            const jl::http::Request& waited = owned->Get();
+                            jl::http::RouteStatus route_status;
+                            const HttpRoute* matched = router_->Match(waited.method, waited.target, params_, route_status);
+                            Handle(waited, matched, route_status);
+                            if (response_.file)
+                            {
+                                RespondHttp2File(stream_id, waited);
+                            }
+                            else
+                            {
+                                RespondHttp2(stream_id, head, accepted);
+                            }
+                        }
+                        FlushHttp2();
+                    });
+            });
+        if (waiting)
+        {
+            return;
+        }
+        status = cache_->Lookup(cache_key_, cached);
+    }
+    if (status == jl::http::ResponseCache::LookupStatus::kMiss)
+    {
+        cached = Generate(request, route);
+        if (!cached)
+        {
+            RespondHttp2File(stream_id, request);
+            return;
+        }
+    }
+    RespondHttp2Entry(stream_id, head, accepted, cached);
+}
+
+void HttpSession::RespondHttp2Entry(std::uint32_t stream_id, bool head, jl::http::ContentEncoding accepted, const std::shared_ptr<const jl::http::CachedResponse>& cached)
+{
+    const bool compressible = cached->body.size() >= jl::http::kMinCompressBytes && jl::http::IsCompressible(cached->content_type);
+    if (compressible && accepted != jl::http::ContentEncoding::kIdentity)
+    {
+        response_.status = cached->status;
+        response_.content_type = cached->content_type;
+        response_.body.assign(cached->body);
+        RespondHttp2(stream_id, head, accepted);
+        return;
+    }
+    RespondHttp2Body(stream_id, cached->status, cached->content_type, compressible, jl::http::ContentEncoding::kIdentity, head, cached->body, cached);
+}
+
+void HttpSession::RespondHttp2Body(std::uint32_t stream_id, int status, std::string_view content_type, bool vary, jl::http::ContentEncoding encoding,
+    bool head, std::string_view body, std::shared_ptr<const void> owner)
+{
+    char length[24];
+    const int length_size = std::snprintf(length, sizeof(length), "%zu", body.size());
+    h2_headers_.clear();
+    h2_headers_.push_back(jl::http::Header{ "content-type", content_type });
+    h2_headers_.push_back(jl::http::Header{ "date", jl::http::HttpDate() });
+    if (encoding != jl::http::ContentEncoding::kIdentity)
+    {
+        h2_headers_.push_back(jl::http::Header{ "content-encoding", jl::http::EncodingName(encoding) });
+    }
+    if (vary)
+    {
+        h2_headers_.push_back(jl::http::Header{ "vary", "Accept-Encoding" });
+    }
+    h2_headers_.push_back(jl::http::Header{ "content-length", std::string_view(length, static_cast<std::size_t>(length_size)) });
+    h2_->Respond(stream_id, status, h2_headers_, head ? std::string_view() : body, std::move(owner));
+}
+
+void HttpSession::RespondHttp2File(std::uint32_t stream_id, const jl::http::Request& request)
+{
+    std::shared_ptr<const jl::http::StaticFile> file = std::move(response_.file);
+    h2_headers_.clear();
+    h2_headers_.push_back(jl::http::Header{ "date", jl::http::HttpDate() });
+    if (file->NotModified(request))
+    {
+        AppendHeaderLines(h2_headers_, file->validators);
+        h2_->Respond(stream_id, 304, h2_headers_, std::string_view());
+        return;
+    }
+    AppendHeaderLines(h2_headers_, file->headers);
+    if (request.method == "HEAD")
+    {
+        h2_->Respond(stream_id, 200, h2_headers_, std::string_view());
+        return;
+    }
+    if (file->fd < 0)
+    {
+        // 小文件内容在内存中，文件对象持有到发送完
+        h2_->Respond(stream_id, 200, h2_headers_, file->content, file);
+        return;
+    }
+    // 文件不整体读入内存：h2_ 在窗口允许发送时按帧读取，文件对象持有到流结束
+    h2_->Respond(stream_id, 200, h2_headers_, static_cast<std::uint64_t>(file->size), [file](std::uint64_t offset, char* out, std::size_t size)
+        {
+            std::size_t done = 0;
+            while (done < size)
+            {
+                ssize_t n = ::pread(file->fd, out + done, size - done, static_cast<off_t>(offset + done));
+                if (n < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if (n <= 0)
+                {
+                    LOG_ERROR("Read static file failed at offset {}", offset + done);
+                    return false;
+                }
+                done += static_cast<std::size_t>(n);
+            }
+            return true;
+        });
+}
+
+void HttpSession::FlushHttp2()
+{
+    h2_->Flush(pending_bytes_ < kMaxPendingWriteBytes ? kMaxPendingWriteBytes - pending_bytes_ : 0);
+    std::string& output = h2_->Output();
+    if (!output.empty())
+    {
+        Send(output);
+        output.clear();
+    }
+    if (h2_->Closed() && !closing_)
+    {
+        closing_ = true;
+        if (in_flight_ == 0)
+        {
+            conn_->Close();
+        }
+    }
+}
+
+std::size_t HttpSession::IdleTimeout() const
+{
+    return websocket_ || h2_ ? kPersistentIdleTimeout : kHttpIdleTimeout;
+}
+
+void HttpSession::SendResponse(const jl::http::Request& request)
+{
+    const bool head = request.method == "HEAD";
+    const bool compressible = response_.body.size() >= jl::http::kMinCompressBytes && jl::http::IsCompressible(response_.content_type);
+    if (!compressible)
+    {
+        AppendResponse(out_, response_, request.keep_alive, head);
+        Send(out_);
+        return;
+    }
+    const jl::http::ContentEncoding encoding = jl::http::NegotiateEncoding(request.GetHeader("Accept-Encoding"));
+    if (encoding == jl::http::ContentEncoding::kIdentity)
+    {
+        AppendEncodedResponse(out_, response_.status, response_.content_type, encoding, response_.body, request.keep_alive, head);
+        Send(out_);
+        return;
+    }
+    const auto key = jl::http::CompressionCache::MakeKey(encoding, response_.body);
+    if (auto compressed = compression_->Find(key))
+    {
+        AppendEncodedResponse(out_, response_.status, response_.content_type, encoding, *compressed, request.keep_alive, head);
+        Send(out_);
+        return;
+    }
+    // 不在io线程中压缩；压缩完成前暂停解析和读取，由完成回调恢复
+    deferred_ = true;
+    std::weak_ptr<HttpSession> weak = shared_from_this();
+    auto body = std::make_shared<const std::string>(std::move(response_.body));
+    const int status = response_.status;
+    const std::string content_type(response_.content_type);
+    const bool keep_alive = request.keep_alive;
+    asio::any_io_executor executor = conn_->GetExecutor();
+    compression_->CompressAsync(key, body, [=](const jl::http::CompressionCache::Result& compressed)
+        {
+            asio::post(executor, [=]()
+                {
+                    auto self = weak.lock();
+                    if (!self)
+                    {
+                        return;
+                    }
+                    {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        deferred_ = false;
+                        out_.clear();
+                        if (compressed)
+                        {
+                            AppendEncodedResponse(out_, status, content_type, encoding, *compressed, keep_alive, head);
+                        }
+                        else
+                        {
+                            AppendEncodedResponse(out_, status, content_type, jl::http::ContentEncoding::kIdentity, *body, keep_alive, head);
+                        }
+                        Send(out_);
+                        Process();  // 后续请求可能已升级为 WebSocket
+                    }
+                    FlushBroadcasts();
+                });
+        });
+}
+
+void HttpSession::SendStaticFile(const jl::http::Request& request)
+{
+    std::shared_ptr<const jl::http::StaticFile> file = std::move(response_.file); // 不在会话中保留文件，缓存淘汰后可以尽快关闭
+    if (!AppendFileResponseHead(out_, *file, request, request.keep_alive))
+    {
+        Send(out_);
+        return;
+    }
+    if (file->fd < 0)
+    {
+        // 小文件内容在内存中，与响应头一次写出
+        out_.append(file->content);
+        Send(out_);
+        return;
+    }
+    Send(out_);
+    ++in_flight_;
+    pending_bytes_ += static_cast<std::size_t>(file->size);
+    conn_->SendFile(jl::FileSegment{ file->fd, 0, static_cast<std::size_t>(file->size), file });
+}
+
+void HttpSession::Send(const std::string& message)
+{
+    ++in_flight_;
+    pending_bytes_ += message.size();
+    conn_->Write(message);
+}
+
+void HttpSession::Send(const std::shared_ptr<const std::string>& message)
+{
+    ++in_flight_;
+    pending_bytes_ += message->size();
+    conn_->Write(message);
+}
+
+void HttpSession::Reply(int status)
+{
+    closing_ = true;
+    out_.clear();
+    AppendErrorResponse(out_, status);
+    Send(out_);
+}
+
 void HttpSession::OnTimeout()
 {
     LOG_ERROR("{}:{}> Connection timeout.", remote_ip_, remote_port_);
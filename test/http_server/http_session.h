@@ -1,48 +1,210 @@
 #pragma once
 
 #include <http_utils.h>
+#include <http2.h>
 #include <timer.h>
 #include <util.h>
+#include <websocket.h>
 
 #include <connection.h>
+#include <mutex>
 
 class HttpServer;
 
 class HttpSession :public std::enable_shared_from_this<HttpSession> {
-    enum class State {
-        kRequestLine,
-        kHeaders,
-        kBody,
-        kDone,
-    };
-
 public:
-    HttpSession(const std::shared_ptr<HttpServer>& server, std::int64_t id, const std::shared_ptr<jl::IConnection>& conn) :
-        state_(State::kRequestLine),
+    HttpSession(const std::shared_ptr<HttpServer>& server, std::int64_t id, const std::shared_ptr<jl::IConnection>& conn, const std::shared_ptr<const HttpRouter>& router,
+        const std::shared_ptr<jl::http::CompressionCache>& compression, const std::shared_ptr<jl::http::ResponseCache>& cache) :
         server_(server),
+        router_(router),
+        compression_(compression),
+        cache_(cache),
         session_id_(id),
         conn_(conn),
         timer_(std::make_shared<jl::Timer>(conn)),
         remote_ip_(conn->GetRemoteEndpoint().address().to_string()),
-        remote_port_(conn->GetRemoteEndpoint().port())
+        remote_port_(conn->GetRemoteEndpoint().port()),
+        consumed_(0),
+        in_flight_(0),
+        pending_bytes_(0),
+        reading_(false),
+        closing_(false),
+        deferred_(false),
+        awaited_ready_(false),
+        websocket_(false),
+        chat_(false),
+        body_active_(false),
+        body_chunked_(false),
+        body_remaining_(0),
+        request_start_(0),
+        body_streaming_(false),
+        stream_writer_(*this),
+        protocol_known_(false)
     {
     }
 
     void Start();
+
+    /// @brief 发送广播帧，帧在所有接收者之间共享；积压过多的慢消费者直接断开
+    void SendShared(const std::shared_ptr<const std::string>& frame);
     
     ~HttpSession();
 
 private:
     void OnTimeout();
 
+    /// @brief 依次处理 buffer_ 中的请求并按顺序写出响应，有请求体的请求在请求体收齐后分发；未达到在途上限时继续读取。调用方需持有 mutex_
+    void Process();
+
+    /// @brief 接收 buffer_ 中当前请求的请求体，收齐后重新解析留在 buffer_ 中的请求头并交给处理函数
+    /// @return 请求已处理，可以继续解析下一个请求
+    bool ProcessBody();
+
+    /// @brief 把 buffer_ 中当前请求的请求体片段交给流式路由的回调，积压超过上限时暂停，写出后由 Process 继续
+    /// @return 请求体已结束，响应已写完，可以继续解析下一个请求
+    bool StreamBody();
+
+    /// @brief 回应 WebSocket 升级请求，之后的数据按帧解析。/ws 回显消息，/chat 把消息广播给所有 /chat 连接
+    void Upgrade(const jl::http::Request& request, bool chat);
+
+    /// @brief 处理 buffer_ 中的一条 WebSocket 消息
+    /// @return 处理了一条消息，可以继续
+    bool ProcessWebSocket();
+
+    /// @brief 分发 Process 期间产生的广播帧。其他连接的 SendShared 需要它们自己的锁，必须在释放 mutex_ 之后调用
+    void FlushBroadcasts();
+
+    std::size_t IdleTimeout() const;
+
+    /// @brief 路由未匹配时生成 404/405，否则以请求体 body 调用处理函数，结果在 response_ 中。HTTP/1.1 和 HTTP/2 共用
+    void Handle(const jl::http::Request& request, const HttpRoute* route, jl::http::RouteStatus route_status, std::string_view body = std::string_view());
+
+    /// @brief 调用可缓存路由的处理函数并结束 cache_ 中 cache_key_ 的生成，返回写入缓存的响应；处理函数返回文件时为空，文件留在 response_ 中
+    std::shared_ptr<const jl::http::CachedResponse> Generate(const jl::http::Request& request, const HttpRoute& route);
+
+    /// @brief 以 cache_ 回应可缓存路由的 GET/HEAD 请求，未命中时生成并写入缓存
+    /// @return false 表示同一个键正在由其他请求生成，结果到达后重新解析并处理该请求
+    bool ServeCached(const jl::http::Request& request, const HttpRoute& route);
+
+    /// @brief 写出缓存的响应。以原样发送时共享序列化好的 wire，否则与 SendResponse 相同地协商编码
+    void SendCached(const jl::http::Request& request, const std::shared_ptr<const jl::http::CachedResponse>& cached);
+
+    /// @brief 连接以 HTTP/2 连接前言开头（h2c prior knowledge），之后的数据交给 h2_
+    void StartHttp2();
+
+    /// @brief 把 buffer_ 中的数据交给 h2_，请求在回调中分发
+    void ProcessHttp2();
+
+    /// @brief HTTP/2 请求收齐，与 HTTP/1.1 相同地分发给处理函数；流式路由的回调一次收到整个请求体，输出收集后回应
+    void OnHttp2Request(std::uint32_t stream_id, const jl::http::Request& request, std::string_view body);
+
+    /// @brief 以 response_ 回应 HTTP/2 流，可压缩时按客户端接受的编码 accepted 压缩，与 SendResponse 一样使用共享的压缩缓存
+    void RespondHttp2(std::uint32_t stream_id, bool head, jl::http::ContentEncoding accepted);
+
+    /// @brief 可缓存路由的 HTTP/2 请求：命中时直接回应，其他流正在生成时等待结果，未命中时生成并写入缓存
+    void RespondHttp2Cached(std::uint32_t stream_id, const jl::http::Request& request, const HttpRoute& route, jl::http::ContentEncoding accepted);
+
+    /// @brief 以缓存的响应回应 HTTP/2 流，原样发送时响应体由缓存项持有，不复制
+    void RespondHttp2Entry(std::uint32_t stream_id, bool head, jl::http::ContentEncoding accepted, const std::shared_ptr<const jl::http::CachedResponse>& cached);
+
+    /// @brief 生成 HTTP/2 响应头并回应，body 在发送完之前由 owner 持有，owner 为空时复制
+    void RespondHttp2Body(std::uint32_t stream_id, int status, std::string_view content_type, bool vary, jl::http::ContentEncoding encoding,
+        bool head, std::string_view body, std::shared_ptr<const void> owner);
+
+    /// @brief 以静态文件回应 HTTP/2 流。DATA 帧需要分帧，无法 sendfile，大文件由 h2_ 在流量控制窗口打开时按帧读取
+    void RespondHttp2File(std::uint32_t stream_id, const jl::http::Request& request);
+
+    /// @brief 按写出上限取出 h2_ 的待发送数据写到连接上；h2_ 结束后关闭连接
+    void FlushHttp2();
+
+    /// @brief 写出处理函数生成的响应，客户端接受压缩且内容可压缩时发送压缩后的响应体。
+    ///        压缩结果不在缓存中时交给计算线程池，完成后在io线程中写出并继续处理后续请求
+    void SendResponse(const jl::http::Request& request);
+
+    /// @brief 处理函数返回了静态文件：小文件与响应头一起写出，大文件在响应头之后 SendFile
+    void SendStaticFile(const jl::http::Request& request);
+
+    /// @brief 提交一次写，计入在途响应数和字节数
+    void Send(const std::string& message);
+
+    /// @brief 提交一次共享数据的写，数据不复制
+    void Send(const std::shared_ptr<const std::string>& message);
+
+    /// @brief 请求非法，写出错误响应后不再处理后续请求
+    void Reply(int status);
+
+private:
+    /// @brief 流式路由的响应写出器，写出的数据追加到 out_，每批请求体片段交付后由会话一起发出
+    class StreamWriter : public HttpChunkWriter {
+    public:
+        explicit StreamWriter(HttpSession& session) : session_(session), status_(200), head_sent_(false), chunked_(true), keep_alive_(true) {}
+
+        void Head(int status, std::string_view content_type) override;
+        void Write(std::string_view data) override;
+        bool Writable() const override;
+
+        /// @brief 开始一个新的流式响应，chunked 为 false 时（HTTP/1.0）响应以关闭连接结束
+        void Begin(bool chunked, bool keep_alive);
+
+        /// @brief 请求体结束，发出还没发出的响应头和结束块
+        void End();
+
+        bool HeadSent() const { return head_sent_; }
+        bool KeepAlive() const { return keep_alive_; }
+
+    private:
+        void SendHead();
+
+    private:
+        HttpSession& session_;
+        int status_;
+        std::string content_type_;
+        bool head_sent_;
+        bool chunked_;
+        bool keep_alive_;
+    };
+
 private:
     std::int64_t session_id_;
     std::shared_ptr<jl::Timer> timer_;
     const std::string remote_ip_;
     const unsigned short remote_port_;
-    State state_;
     std::shared_ptr<jl::IConnection> conn_;
-    HttpRequest request_;
+    std::mutex mutex_;              // 读完成和写完成回调可能在不同的io线程中并发执行
+    std::string buffer_;            // 收到的请求数据，parser_ 中的视图指向这里
+    std::size_t consumed_;          // buffer_ 中已处理完的字节数
+    jl::http::RequestParser parser_;
+    std::string out_;               // 复用的响应序列化缓冲区，Write 会复制数据，写出后即可清空
+    std::shared_ptr<const HttpRouter> router_;  // 启动时编译好的路由，所有会话共享
+    std::shared_ptr<jl::http::CompressionCache> compression_;  // 所有会话共享的压缩结果缓存
+    std::shared_ptr<jl::http::ResponseCache> cache_;           // 所有会话共享的响应缓存
+    std::string cache_key_;         // 复用的缓存键
+    jl::http::RouteParams params_;
+    HttpResponse response_;         // 复用的处理函数输出
+    std::size_t in_flight_;         // 已提交但还没写完的写操作数
+    std::size_t pending_bytes_;     // 已提交但还没写完的字节数，超过上限时暂停读取，由写完成回调恢复
+    bool reading_;                  // 有未完成的 Read
+    bool closing_;                  // 不再处理新请求，在途响应写完后关闭连接
+    bool deferred_;                 // 当前响应正在计算线程中压缩或等待其他连接生成，完成前不处理后续请求，保证响应顺序
+    bool awaited_ready_;            // 等待的响应已到达 awaited_，重新解析的请求直接使用它
+    std::shared_ptr<const jl::http::CachedResponse> awaited_;
+    bool websocket_;                // 已升级为 WebSocket
+    bool chat_;                     // WebSocket 消息广播给所有 /chat 连接，否则回显
+    jl::ws::MessageParser ws_parser_;
+    std::vector<std::shared_ptr<const std::string>> broadcasts_;   // 待分发的广播帧
+    // 正在接收的请求体。请求头留在 buffer_ 中，请求体收齐后重新解析
+    bool body_active_;
+    bool body_chunked_;             // 请求体为 chunked 编码，由 decoder_ 解码到 body_；否则按 Content-Length 留在 buffer_ 中
+    std::uint64_t body_remaining_;  // Content-Length 请求体剩余字节数
+    std::size_t request_start_;     // 当前请求的请求头在 buffer_ 中的偏移
+    std::string body_;              // 解码后的 chunked 请求体
+    jl::http::ChunkedDecoder decoder_;
+    bool body_streaming_;           // 路由设置了 stream，请求体片段交给 body_callbacks_，不保留请求头
+    HttpBodyCallbacks body_callbacks_;
+    StreamWriter stream_writer_;
+    bool protocol_known_;           // 已确定不是 HTTP/2 连接前言
+    std::unique_ptr<jl::http2::ServerSession> h2_;
+    std::vector<jl::http::Header> h2_headers_;  // 复用的 HTTP/2 响应头
     //HttpResponse response_;
     std::weak_ptr<HttpServer> server_;
 };
@@ -1,55 +1,245 @@
 #pragma once
 
+#include <http_compress.h>
+#include <http_parser.h>
+#include <http_response.h>
+#include <http_router.h>
+#include <response_cache.h>
+#include <static_file_cache.h>
 #include <logger.h>
-#include <string>
-#include <unordered_map>
-#include <sstream>
 #include <chrono>
-#include <ctime>
-#include <iomanip>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
 
-struct HttpRequest{
-    std::string request_line_;
-    std::unordered_map<std::string, std::string> headers_;
-    std::string body_;
+/// @brief 处理函数生成的响应，由会话序列化并决定 Connection 头部
+struct HttpResponse {
+    int status = 200;
+    std::string_view content_type = "text/html; charset=UTF-8";
+    std::string body;
+    std::shared_ptr<const jl::http::StaticFile> file;  // 设置时响应为该文件，忽略 status、content_type 和 body
 };
 
-struct HttpResponse {
-    std::string response_line_;
-    std::unordered_map<std::string, std::string> headers_;
-    std::string body_;
+/// @brief 请求的处理函数，请求体收齐后调用，没有请求体时 body 为空。params、request 和 body 中的视图只在调用期间有效
+using HttpHandler = std::function<void(const jl::http::Request& request, const jl::http::RouteParams& params, std::string_view body, HttpResponse& response)>;
+
+/// @brief 流式响应的写出接口，由会话实现。响应头在第一次 Write（或请求体结束）时发出，
+///        HTTP/1.1 每次 Write 作为一个 chunk 发送；HTTP/1.0 不支持 chunked，直接发送并以关闭连接结束响应
+class HttpChunkWriter {
+public:
+    virtual ~HttpChunkWriter() = default;
+
+    /// @brief 设置响应状态码和类型，需在第一次 Write 之前调用，默认 200 text/html
+    virtual void Head(int status, std::string_view content_type) = 0;
+
+    /// @brief 写出一段响应体，空数据忽略
+    virtual void Write(std::string_view data) = 0;
+
+    /// @brief 已提交未写完的数据是否低于上限。超过上限后会话暂停交付请求体片段和读取，写出后继续，处理函数不必自己等待
+    virtual bool Writable() const = 0;
+};
+
+/// @brief 一个请求的请求体回调。on_body 依次收到请求体片段，片段只在调用期间有效；on_end 在请求体结束时调用，之后会话结束响应
+struct HttpBodyCallbacks {
+    std::function<void(std::string_view chunk, HttpChunkWriter& writer)> on_body;
+    std::function<void(HttpChunkWriter& writer)> on_end;
+};
+
+/// @brief 流式处理请求体的路由回调，收到请求头后调用，返回该请求的请求体回调，回调可以捕获这个请求自己的状态。
+///        request 和 params 中的视图只在调用期间有效
+using HttpStreamHandler = std::function<HttpBodyCallbacks(const jl::http::Request& request, const jl::http::RouteParams& params, HttpChunkWriter& writer)>;
+
+/// @brief 把流式路由的输出收集到 response 中，用于请求体已经完整在内存中的请求（HTTP/2），响应长度已知后一次回应
+class HttpResponseCollector : public HttpChunkWriter {
+public:
+    explicit HttpResponseCollector(HttpResponse& response) : response_(response) {}
+
+    void Head(int status, std::string_view content_type) override {
+        response_.status = status;
+        content_type_.assign(content_type.data(), content_type.size());
+        response_.content_type = content_type_;
+    }
+
+    void Write(std::string_view data) override { response_.body.append(data.data(), data.size()); }
+
+    bool Writable() const override { return true; }
+
+private:
+    HttpResponse& response_;
+    std::string content_type_;  // response_.content_type 指向这里，收集器需要在响应发出前一直有效
+};
+
+/// @brief 路由项。cache_ttl 大于0时 GET/HEAD 的 200 响应写入 ResponseCache，处理函数只能依赖方法和请求目标。
+///        设置 stream 时有请求体的请求不在内存中累积，请求体边收边交给 stream 返回的回调；没有请求体的请求总是交给 handler
+struct HttpRoute {
+    HttpHandler handler;
+    std::chrono::milliseconds cache_ttl{ 0 };
+    HttpStreamHandler stream{};
+};
+
+using HttpRouter = jl::http::Router<HttpRoute>;
+
+/// @brief 请求行和头部的副本，视图指向自己持有的数据，用于在请求回调返回之后再处理这个请求（例如等到其他流生成了响应）
+class OwnedRequest {
+public:
+    explicit OwnedRequest(const jl::http::Request& request) : request_(request) {
+        std::size_t size = request.method.size() + request.target.size();
+        for (const auto& header : request.headers) {
+            size += header.name.size() + header.value.size();
+        }
+        // 一次分配，之后追加不会移动数据，视图可以边追加边指向 data_
+        data_.reserve(size);
+        request_.method = Append(request.method);
+        request_.target = Append(request.target);
+        for (auto& header : request_.headers) {
+            header.name = Append(header.name);
+            header.value = Append(header.value);
+        }
+    }
+
+    OwnedRequest(const OwnedRequest&) = delete;
+    OwnedRequest& operator=(const OwnedRequest&) = delete;
+
+    const jl::http::Request& Get() const { return request_; }
+
+private:
+    std::string_view Append(std::string_view value) {
+        const std::size_t offset = data_.size();
+        data_.append(value.data(), value.size());
+        return std::string_view(data_.data() + offset, value.size());
+    }
+
+private:
+    std::string data_;
+    jl::http::Request request_;
 };
 
-inline std::string GetCurrentTimeStr() {
-    auto now = std::chrono::system_clock::now();
-    auto time = std::chrono::system_clock::to_time_t(now);
-
-    // 获取毫秒部分
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        now.time_since_epoch() % 1000
-    ).count();
-
-    std::stringstream ss;
-    ss << std::put_time(std::localtime(&time), "%Y-%m-%d %H:%M:%S");
-    ss << '.' << std::setfill('0') << std::setw(3) << ms;
-    return ss.str();
-}
-
-inline std::string GetHttpResponse(const HttpRequest& request) {
-    std::stringstream request_stream;
-    request_stream << request.request_line_ << "\r\n<br>";
-    for (auto& it = request.headers_.begin(); it != request.headers_.end(); ++it) {
-        request_stream << it->first << ": " << it->second << "\r\n<br>";
-    }
-    request_stream << "\r\n<br>";
-    request_stream << request.body_;
-    std::string request_string = fmt::format("<html><body>{}</body></html>", request_stream.str());
-    std::stringstream response_stream;
-    response_stream << "HTTP/1.1 200 OK\r\n";
-    response_stream << "Content-Type: text/html; charset=UTF-8" << "\r\n";
-    response_stream << "Date: " << GetCurrentTimeStr() << "\r\n";
-    response_stream << "Content-Length: " << request_string.size() << "\r\n";
-    response_stream << "\r\n";
-    response_stream << request_string;
-    return response_stream.str();
-}
\ No newline at end of file
+/// @brief 请求行和头部回显为html片段的字节数，与 AppendRequestEcho 的输出一致
+inline std::size_t RequestEchoSize(const jl::http::Request& request) {
+    constexpr std::size_t kBreak = sizeof("\r\n<br>") - 1;
+    std::size_t size = request.method.size() + 1 + request.target.size() + sizeof(" HTTP/1.1") - 1 + kBreak + kBreak;
+    for (const auto& header : request.headers) {
+        size += header.name.size() + 2 + header.value.size() + kBreak;
+    }
+    return size;
+}
+
+/// @brief 把请求行和头部回显为html片段，追加到 out
+inline void AppendRequestEcho(std::string& out, const jl::http::Request& request) {
+    const char version[] = { 'H', 'T', 'T', 'P', '/', static_cast<char>('0' + request.version_major), '.', static_cast<char>('0' + request.version_minor) };
+    out.append(request.method);
+    out.push_back(' ');
+    out.append(request.target);
+    out.push_back(' ');
+    out.append(version, sizeof(version));
+    out.append("\r\n<br>");
+    for (const auto& header : request.headers) {
+        out.append(header.name);
+        out.append(": ");
+        out.append(header.value);
+        out.append("\r\n<br>");
+    }
+    out.append("\r\n<br>");
+}
+
+/// @brief 没有请求体的请求，完整响应追加到 out
+inline void AppendHttpResponse(std::string& out, const jl::http::Request& request, bool keep_alive) {
+    constexpr std::string_view kBodyBegin = "<html><body>";
+    constexpr std::string_view kBodyEnd = "</body></html>";
+    jl::http::ResponseWriter(out)
+        .Status(200)
+        .Header("Content-Type", "text/html; charset=UTF-8")
+        .Date()
+        .ContentLength(kBodyBegin.size() + RequestEchoSize(request) + kBodyEnd.size())
+        .Connection(keep_alive)
+        .EndHeaders()
+        .Body(kBodyBegin);
+    AppendRequestEcho(out, request);
+    out.append(kBodyEnd);
+}
+
+/// @brief 处理函数生成的响应追加到 out，HEAD 请求不带响应体
+inline void AppendResponse(std::string& out, const HttpResponse& response, bool keep_alive, bool head) {
+    jl::http::ResponseWriter writer(out);
+    writer.Status(response.status)
+        .Header("Content-Type", response.content_type)
+        .Date()
+        .ContentLength(response.body.size())
+        .Connection(keep_alive)
+        .EndHeaders();
+    if (!head) {
+        writer.Body(response.body);
+    }
+}
+
+/// @brief 可压缩的响应追加到 out，body 为按 encoding 压缩后的响应体（kIdentity 时为原响应体），HEAD 请求不带响应体。
+///        响应随 Accept-Encoding 变化，总是带上 Vary
+inline void AppendEncodedResponse(std::string& out, int status, std::string_view content_type, jl::http::ContentEncoding encoding,
+    std::string_view body, bool keep_alive, bool head) {
+    jl::http::ResponseWriter writer(out);
+    writer.Status(status)
+        .Header("Content-Type", content_type)
+        .Date();
+    if (encoding != jl::http::ContentEncoding::kIdentity) {
+        writer.Header("Content-Encoding", jl::http::EncodingName(encoding));
+    }
+    writer.Header("Vary", "Accept-Encoding")
+        .ContentLength(body.size())
+        .Connection(keep_alive)
+        .EndHeaders();
+    if (!head) {
+        writer.Body(body);
+    }
+}
+
+/// @brief 静态文件的响应头追加到 out，条件请求命中时为 304；返回是否需要发送文件内容
+inline bool AppendFileResponseHead(std::string& out, const jl::http::StaticFile& file, const jl::http::Request& request, bool keep_alive) {
+    jl::http::ResponseWriter writer(out);
+    if (file.NotModified(request)) {
+        writer.Status(304).Date().Connection(keep_alive).Headers(file.validators).EndHeaders();
+        return false;
+    }
+    writer.Status(200).Date().Connection(keep_alive).Headers(file.headers).EndHeaders();
+    return request.method != "HEAD";
+}
+
+/// @brief 把 "Name: value\r\n" 形式的头部行（StaticFile::headers、validators）拆成头部追加到 headers，视图指向 lines
+inline void AppendHeaderLines(std::vector<jl::http::Header>& headers, std::string_view lines) {
+    while (!lines.empty()) {
+        std::size_t end = lines.find("\r\n");
+        std::string_view line = lines.substr(0, end);
+        lines.remove_prefix(end == std::string_view::npos ? lines.size() : end + 2);
+        std::size_t colon = line.find(':');
+        if (colon == std::string_view::npos) {
+            continue;
+        }
+        std::string_view value = line.substr(colon + 1);
+        while (!value.empty() && value.front() == ' ') {
+            value.remove_prefix(1);
+        }
+        headers.push_back(jl::http::Header{ line.substr(0, colon), value });
+    }
+}
+
+/// @brief 流式响应的响应头追加到 out，chunked 为 false 时以关闭连接表示响应结束
+inline void AppendStreamingResponseHead(std::string& out, int status, std::string_view content_type, bool chunked, bool keep_alive) {
+    jl::http::ResponseWriter writer(out);
+    writer.Status(status)
+        .Header("Content-Type", content_type)
+        .Date();
+    if (chunked) {
+        writer.Header("Transfer-Encoding", "chunked");
+    }
+    writer.Connection(keep_alive).EndHeaders();
+}
+
+/// @brief 请求非法时的响应，发送后关闭连接
+inline void AppendErrorResponse(std::string& out, int status) {
+    jl::http::ResponseWriter(out)
+        .Status(status)
+        .Date()
+        .ContentLength(0)
+        .Connection(false)
+        .EndHeaders();
+}
@@ -0,0 +1,107 @@
+// Snowflake id生成吞吐测试
+// usage: id_bench [threads] [seconds]
+// 分别测试 Snowflake(互斥锁)、AtomicSnowflake(无锁CAS)、ThreadLocalSnowflake(线程本地分段) 的多线程 ids/s，
+// 批量接口 GenerateIds/IdCache 的吞吐，并检查所有id唯一、序列号用满 [0, 4095]
+// 注意：id格式限制每个节点每毫秒最多 4096 个id，多线程吞吐的上限是 4096000 ids/s
+#include <util.h>
+#include <assert.h>
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// make_worker() 在每个线程中调用一次，返回的函数每次向 out 追加一批id
+template <typename MakeWorker>
+void Run(const char* name, int thread_cnt, int seconds, MakeWorker make_worker)
+{
+    std::vector<std::vector<std::int64_t>> ids(thread_cnt);
+    std::atomic<bool> stop = false;
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < thread_cnt; ++t) {
+        threads.emplace_back([&, t]() {
+            auto& local = ids[t];
+            local.reserve(1 << 22);
+            auto worker = make_worker();
+            while (!stop.load(std::memory_order_relaxed)) {
+                worker(local);
+            }
+            });
+    }
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    stop = true;
+    for (auto& t : threads) {
+        t.join();
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<std::int64_t> all;
+    for (auto& local : ids) {
+        all.insert(all.end(), local.begin(), local.end());
+    }
+    std::sort(all.begin(), all.end());
+    assert(std::adjacent_find(all.begin(), all.end()) == all.end());
+    std::int64_t max_sequence = 0;
+    for (std::int64_t id : all) {
+        max_sequence = std::max(max_sequence, jl::util::Snowflake::Parse(id).sequence);
+    }
+    // 每毫秒最多 4096 个id，吞吐达到上限时序列号应能用到 4095
+    std::cout << name << ": " << all.size() / secs << " ids/s, "
+              << secs * 1e9 * thread_cnt / all.size() << " ns/id per thread, max sequence " << max_sequence << std::endl;
+}
+
+template <typename Generator>
+void Bench(const char* name, int thread_cnt, int seconds)
+{
+    std::unique_ptr<jl::util::IdGenerator> generator(jl::util::MakeIdGenerator<Generator>(1));
+    Run(name, thread_cnt, seconds, [&]() {
+        return [&](std::vector<std::int64_t>& out) {
+            for (int i = 0; i < 256; ++i) {
+                out.push_back(generator->GenerateId());
+            }
+        };
+        });
+}
+
+// IdCache 从已预留的范围中取id的开销，不含预留时等待时钟的时间
+void BenchCacheHandout(std::size_t cnt)
+{
+    jl::util::AtomicSnowflake generator(1);
+    jl::util::IdCache cache(generator, cnt);
+    std::int64_t sum = cache.Next(); // 预留
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 1; i < cnt; ++i) {
+        sum += cache.Next();
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "IdCache handout     : " << ns / (cnt - 1) << " ns/id (" << cnt << " ids reserved, checksum " << (sum & 0xff) << ")" << std::endl;
+}
+
+int main(int argc, char const *argv[])
+{
+    int thread_cnt = argc > 1 ? std::stoi(argv[1]) : 4;
+    int seconds = argc > 2 ? std::stoi(argv[2]) : 2;
+    std::cout << "threads: " << thread_cnt << ", upper bound: " << 4096 * 1000 << " ids/s per node" << std::endl;
+    Bench<jl::util::Snowflake>("Snowflake           ", thread_cnt, seconds);
+    Bench<jl::util::AtomicSnowflake>("AtomicSnowflake     ", thread_cnt, seconds);
+    Bench<jl::util::ThreadLocalSnowflake>("ThreadLocalSnowflake", thread_cnt, seconds);
+
+    jl::util::Snowflake snowflake(1);
+    Run("Snowflake::GenerateIds(4096)", thread_cnt, seconds, [&]() {
+        return [&](std::vector<std::int64_t>& out) {
+            auto ids = snowflake.GenerateIds(4096);
+            out.insert(out.end(), ids.begin(), ids.end());
+        };
+        });
+    jl::util::AtomicSnowflake atomic_snowflake(1);
+    Run("IdCache(AtomicSnowflake)    ", thread_cnt, seconds, [&]() {
+        return [cache = std::make_shared<jl::util::IdCache>(atomic_snowflake)](std::vector<std::int64_t>& out) {
+            for (int i = 0; i < 256; ++i) {
+                out.push_back(cache->Next());
+            }
+        };
+        });
+    BenchCacheHandout(1 << 20);
+    return 0;
+}
@@ -0,0 +1,94 @@
+// 延迟直方图测试：百分位与排序后精确值的相对误差在精度之内，最小值、最大值、均值准确，
+// 超出上限的值计入最后一个桶，多个线程各自记录后合并与单个直方图记录全部值的结果相同
+#include <latency_histogram.h>
+#include <assert.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using jl::util::LatencyHistogram;
+
+void TestExactSmallValues()
+{
+    // 小于子桶数的值没有误差
+    LatencyHistogram histogram(1000000, 3);
+    for (std::uint64_t v = 1; v <= 1000; ++v) {
+        histogram.Record(v);
+    }
+    assert(histogram.Count() == 1000 && histogram.Min() == 1 && histogram.Max() == 1000);
+    assert(histogram.Percentile(50) == 500 && histogram.Percentile(99) == 990 && histogram.Percentile(100) == 1000);
+    assert(histogram.Percentile(0) == 1);
+    assert(std::abs(histogram.Mean() - 500.5) < 1e-9);
+}
+
+void TestRelativeError()
+{
+    // 对数正态分布的延迟，跨越多个数量级
+    std::mt19937_64 rng(42);
+    std::lognormal_distribution<double> distribution(11.0, 1.5);
+    LatencyHistogram histogram;
+    std::vector<std::uint64_t> values;
+    for (int i = 0; i < 200000; ++i) {
+        const std::uint64_t v = static_cast<std::uint64_t>(distribution(rng)) + 1;
+        values.push_back(v);
+        histogram.Record(v);
+    }
+    std::sort(values.begin(), values.end());
+    for (double p : { 1.0, 25.0, 50.0, 90.0, 99.0, 99.9, 99.99 }) {
+        const std::uint64_t exact = values[static_cast<std::size_t>(std::ceil(p / 100.0 * values.size())) - 1];
+        const std::uint64_t approx = histogram.Percentile(p);
+        assert(approx >= exact && static_cast<double>(approx - exact) <= exact * 1e-3 + 1);
+    }
+    assert(histogram.Max() == values.back() && histogram.Percentile(100) == values.back());
+    assert(histogram.Min() == values.front());
+}
+
+void TestOverflow()
+{
+    LatencyHistogram histogram(10000, 2);
+    histogram.Record(5);
+    histogram.Record(1000000);
+    assert(histogram.Count() == 2 && histogram.Max() == 1000000);
+    assert(histogram.Percentile(50) == 5);
+    // 超出上限的值计入最后一个桶，百分位不超过真实最大值
+    assert(histogram.Percentile(100) >= 10000 && histogram.Percentile(100) <= 1000000);
+}
+
+void TestMerge()
+{
+    std::mt19937_64 rng(7);
+    std::uniform_int_distribution<std::uint64_t> distribution(1, 50000000);
+    LatencyHistogram all;
+    std::vector<LatencyHistogram> parts(4);
+    for (int i = 0; i < 100000; ++i) {
+        const std::uint64_t v = distribution(rng);
+        all.Record(v);
+        parts[i % parts.size()].Record(v);
+    }
+    LatencyHistogram merged;
+    for (const auto& part : parts) {
+        merged.Merge(part);
+    }
+    assert(merged.Count() == all.Count() && merged.Min() == all.Min() && merged.Max() == all.Max());
+    assert(merged.Mean() == all.Mean());
+    for (double p : { 50.0, 99.0, 99.9 }) {
+        assert(merged.Percentile(p) == all.Percentile(p));
+    }
+    merged.Reset();
+    assert(merged.Count() == 0 && merged.Max() == 0 && merged.Percentile(99) == 0);
+    merged.RecordValues(300, 10);
+    assert(merged.Count() == 10 && merged.Percentile(50) == 300);
+}
+
+int main()
+{
+    TestExactSmallValues();
+    TestRelativeError();
+    TestOverflow();
+    TestMerge();
+    std::cout << "latency_histogram_test passed" << std::endl;
+    return 0;
+}
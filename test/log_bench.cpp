@@ -0,0 +1,61 @@
+// 日志调用开销对比：LOG_INFO(spdlog异步队列) vs LOG_FAST_INFO(每线程二进制环形缓冲区)
+// 控制台sink也会输出，建议: ./log_bench [threads] [calls] [block|drop_newest|drop_oldest] > /dev/null
+#include <binary_log.h>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <chrono>
+
+template <typename Func>
+double RunBench(int thread_cnt, int calls, Func&& func)
+{
+    std::vector<std::thread> threads;
+    std::vector<double> ns_per_call(thread_cnt, 0);
+    for (int t = 0; t < thread_cnt; ++t) {
+        threads.emplace_back([&, t]() {
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < calls; ++i) {
+                func(t, i);
+            }
+            auto end = std::chrono::steady_clock::now();
+            ns_per_call[t] = std::chrono::duration<double, std::nano>(end - start).count() / calls;
+            });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    double sum = 0;
+    for (double v : ns_per_call) {
+        sum += v;
+    }
+    return sum / thread_cnt;
+}
+
+int main(int argc, char const *argv[])
+{
+    int thread_cnt = argc > 1 ? std::stoi(argv[1]) : 4;
+    int calls = argc > 2 ? std::stoi(argv[2]) : 200000;
+    std::string policy = argc > 3 ? argv[3] : "block";
+    if (policy == "drop_newest") {
+        jl::SetLogOverflowPolicy(jl::LogOverflowPolicy::kDropNewest);
+    }
+    else if (policy == "drop_oldest") {
+        jl::SetLogOverflowPolicy(jl::LogOverflowPolicy::kDropOldest);
+    }
+    std::string remote = "192.168.100.200";
+
+    double spdlog_ns = RunBench(thread_cnt, calls, [&](int t, int i) {
+        LOG_INFO("{}:{} OnRead message:{} seq:{}", remote, 40000 + t, "Connection reset by peer", i);
+        });
+    jl::Logger::GetInstance().Flush();
+
+    double binary_ns = RunBench(thread_cnt, calls, [&](int t, int i) {
+        LOG_FAST_INFO("{}:{} OnRead message:{} seq:{}", remote, 40000 + t, "Connection reset by peer", i);
+        });
+    jl::FlushBinaryLog();
+
+    std::cerr << "threads: " << thread_cnt << ", calls/thread: " << calls << ", policy: " << policy << "\n"
+              << "  LOG_INFO      : " << spdlog_ns << " ns/call, overrun: " << jl::GetAsyncLogOverrunCount() << "\n"
+              << "  LOG_FAST_INFO : " << binary_ns << " ns/call, dropped: " << jl::GetBinaryLogDroppedCount() << "\n";
+    return 0;
+}
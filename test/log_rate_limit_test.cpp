@@ -0,0 +1,116 @@
+// 错误日志限流测试：大量客户端连接后立即RST，服务端每个连接的OnRead都会走错误日志路径，
+// 验证日志文件中该调用点的输出条数受 kErrorLogPerSecond 限制；突发结束后调用点不再有日志，被抑制的条数仍由定时汇总输出
+#include <acceptor.h>
+#include <connection.h>
+#include <logger.h>
+#include <assert.h>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <chrono>
+
+constexpr unsigned short kPort = 12346;
+constexpr int kFloodSeconds = 3;
+constexpr std::uint32_t kLocalRate = 5;
+constexpr std::uint64_t kLocalFlood = 1000;
+
+/// @brief 统计日志文件中同时包含 pattern 和 site 的行数，sum 累加 "suppressed N" 中的 N。
+///        flush 为 false 时不调用 Logger::Flush，只能看到定时汇总和定时刷新写出的内容
+std::size_t CountLines(const std::string& pattern, bool flush = true, const std::string& site = std::string(), std::uint64_t* sum = nullptr)
+{
+    if (flush) {
+        jl::Logger::GetInstance().Flush();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    std::ifstream file("./logs/jl_tcpserver.txt");
+    std::size_t cnt = 0;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.find(pattern) != std::string::npos && line.find(site) != std::string::npos) {
+            ++cnt;
+            std::size_t pos = line.find("suppressed ");
+            if (sum && pos != std::string::npos) {
+                *sum += std::stoull(line.substr(pos + sizeof("suppressed ") - 1));
+            }
+        }
+    }
+    return cnt;
+}
+
+/// @brief 同一个调用点连续写 n 条日志
+void FloodLocalSite(std::uint64_t n)
+{
+    for (std::uint64_t i = 0; i < n; ++i) {
+        LOG_ERROR_LIMIT(kLocalRate, "local flood {}", i);
+    }
+}
+
+int main(int argc, char const *argv[])
+{
+    asio::io_context ioct;
+    auto acceptor = std::make_shared<jl::Acceptor>(ioct, "127.0.0.1", kPort);
+    std::atomic<int> accepted = 0;
+    acceptor->SetConnEstablishCallback([&](jl::net::socket&& socket) {
+        accepted.fetch_add(1, std::memory_order_relaxed);
+        jl::MakeConnection(std::move(socket))->Read();
+        });
+    acceptor->DoAccept();
+    auto work = asio::make_work_guard(ioct);
+    std::vector<std::thread> io_threads;
+    for (int i = 0; i < 4; ++i) {
+        io_threads.emplace_back([&]() { ioct.run(); });
+    }
+
+    std::size_t error_before = CountLines("OnRead message");
+    std::size_t suppressed_before = CountLines("suppressed", true, "connection.cpp");
+    std::uint64_t local_before = 0;
+    std::size_t local_lines_before = CountLines("local flood");
+    CountLines("suppressed", true, "log_rate_limit_test.cpp", &local_before);
+
+    // 连接后设置 SO_LINGER(0) 再关闭，服务端读到 connection reset
+    int clients = 0;
+    asio::io_context client_ioct;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(kFloodSeconds);
+    while (std::chrono::steady_clock::now() < deadline) {
+        jl::net::socket socket(client_ioct);
+        std::error_code ec;
+        socket.connect(jl::net::endpoint(asio::ip::make_address("127.0.0.1"), kPort), ec);
+        if (ec) {
+            continue;
+        }
+        socket.set_option(asio::socket_base::linger(true, 0));
+        socket.close(ec);
+        ++clients;
+    }
+    FloodLocalSite(kLocalFlood);
+
+    // 突发之后两个调用点都不再有日志，也不调用 Logger::Flush：汇总由每秒一次的定时汇总写出，文件由 spdlog 的定时刷新写出
+    std::this_thread::sleep_for(std::chrono::seconds(4));
+    std::size_t suppressed = CountLines("suppressed", false, "connection.cpp") - suppressed_before;
+    std::uint64_t local_suppressed = 0;
+    CountLines("suppressed", false, "log_rate_limit_test.cpp", &local_suppressed);
+    local_suppressed -= local_before;
+    std::size_t local_lines = CountLines("local flood", false) - local_lines_before;
+    std::size_t errors = CountLines("OnRead message") - error_before;
+    std::cout << "clients: " << clients << ", accepted: " << accepted.load()
+              << ", error lines: " << errors << ", summary lines: " << suppressed
+              << ", local lines: " << local_lines << ", local suppressed: " << local_suppressed << std::endl;
+
+    // 每个窗口最多 kErrorLogPerSecond 条，时间跨度最多 kFloodSeconds + 3 个窗口
+    assert(clients > static_cast<int>(jl::kErrorLogPerSecond * (kFloodSeconds + 3)));
+    assert(errors > 0);
+    assert(errors <= jl::kErrorLogPerSecond * (kFloodSeconds + 3));
+    assert(suppressed > 0);
+    // 放行的条数加上汇总的抑制条数等于写入的条数，一条也没有丢
+    assert(local_lines > 0 && local_lines <= kLocalRate * 2);
+    assert(local_lines + local_suppressed == kLocalFlood);
+
+    work.reset();
+    ioct.stop();
+    for (auto& t : io_threads) {
+        t.join();
+    }
+    std::cout << "log rate limit test passed." << std::endl;
+    return 0;
+}
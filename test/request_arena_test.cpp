@@ -0,0 +1,218 @@
+// 每个请求的堆分配次数测试：替换全局 operator new 计数，预热后统计稳定状态下每个请求的分配次数
+// 1. RequestArena：分配只移动指针，Reset 一次性释放；初始块扩大后不再向堆申请内存
+// 2. HTTP/1.1：解析、路由、处理函数生成响应体、序列化响应，缓冲区复用后为0次
+// 3. HTTP/2：ServerSession 解码请求头、分发、回应、发送 DATA，请求头在 RequestArena 中，流在连接的内存池中
+#include <http2.h>
+#include <http_parser.h>
+#include <http_response.h>
+#include <http_router.h>
+#include <request_arena.h>
+#include <assert.h>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+static std::size_t gAllocations = 0;
+
+void* operator new(std::size_t size)
+{
+    ++gAllocations;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+constexpr int kWarmup = 100;
+constexpr int kRequests = 10000;
+
+void TestArena()
+{
+    jl::http::RequestArena arena(256, 64 * 1024);
+    const std::string text(100, 'a');
+    auto fill = [&](jl::http::RequestArena& arena) {
+        for (int i = 0; i < 20; ++i) {
+            std::string_view copy = arena.Copy(text);
+            assert(copy == text && copy.data() != text.data());
+        }
+        std::pmr::vector<int> numbers(arena.Resource());
+        numbers.resize(100);
+    };
+
+    // 第一次超出初始块，Reset 后初始块扩大
+    fill(arena);
+    assert(arena.GetStats().overflow_allocations > 0);
+    arena.Reset();
+    assert(arena.Capacity() > 256);
+    const std::size_t capacity = arena.Capacity();
+
+    gAllocations = 0;
+    for (int i = 0; i < kRequests; ++i) {
+        fill(arena);
+        arena.Reset();
+    }
+    assert(gAllocations == 0);
+    assert(arena.Capacity() == capacity);
+
+    // 初始块不超过上限，超出的部分每次向堆申请，Reset 时释放
+    jl::http::RequestArena bounded(256, 1024);
+    fill(bounded);
+    bounded.Reset();
+    const std::uint64_t overflows = bounded.GetStats().overflow_allocations;
+    fill(bounded);
+    bounded.Reset();
+    assert(bounded.GetStats().overflow_allocations > overflows);
+    assert(bounded.Capacity() == 1024);
+    std::cout << "arena: initial block " << capacity << " bytes, 0 allocations/request" << std::endl;
+}
+
+void TestHttp1()
+{
+    using Handler = std::function<void(const jl::http::Request&, const jl::http::RouteParams&, std::string&)>;
+    jl::http::Router<Handler> router;
+    router.Add("GET", "/users/:id/posts/:post", [](const jl::http::Request&, const jl::http::RouteParams& params, std::string& body) {
+        body.append("{\"user\":\"");
+        body.append(params.Get("id"));
+        body.append("\",\"post\":\"");
+        body.append(params.Get("post"));
+        body.append("\"}");
+        });
+    router.Compile();
+
+    const std::string request_text =
+        "GET /users/12345/posts/67890?sort=desc HTTP/1.1\r\n"
+        "Host: www.example.com\r\n"
+        "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko)\r\n"
+        "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+        "Accept-Language: en-US,en;q=0.5\r\n"
+        "Accept-Encoding: gzip, deflate, br\r\n"
+        "Cookie: session=0123456789abcdef0123456789abcdef; theme=dark\r\n"
+        "Connection: keep-alive\r\n"
+        "\r\n";
+    jl::http::RequestParser parser;
+    jl::http::RouteParams params;
+    std::string body;
+    std::string out;
+    auto serve = [&]() {
+        jl::http::ParseStatus status = parser.Parse(request_text.data(), request_text.size());
+        assert(status == jl::http::ParseStatus::kComplete);
+        (void)status;
+        const auto& request = parser.GetRequest();
+        jl::http::RouteStatus route_status;
+        const Handler* handler = router.Match(request.method, request.target, params, route_status);
+        assert(handler);
+        body.clear();
+        (*handler)(request, params, body);
+        out.clear();
+        jl::http::ResponseWriter(out)
+            .Status(200)
+            .Header("Content-Type", "application/json")
+            .Date()
+            .ContentLength(body.size())
+            .Connection(request.keep_alive)
+            .EndHeaders()
+            .Body(body);
+        parser.Reset();
+    };
+    for (int i = 0; i < kWarmup; ++i) {
+        serve();
+    }
+    gAllocations = 0;
+    for (int i = 0; i < kRequests; ++i) {
+        serve();
+    }
+    std::printf("http/1.1: %.3f allocations/request\n", static_cast<double>(gAllocations) / kRequests);
+    assert(gAllocations == 0);
+}
+
+void TestHttp2()
+{
+    const auto body = std::make_shared<const std::string>("{\"user\":\"12345\",\"post\":\"67890\"}");
+    const std::string length = std::to_string(body->size());
+    jl::http2::ServerSession session;
+    std::vector<jl::http::Header> headers;
+    std::size_t responses = 0;
+    session.SetRequestCallback([&](std::uint32_t stream_id, const jl::http::Request& request, std::string_view) {
+        assert(request.method == "GET" && request.GetHeader("user-agent").size() > 15);
+        headers.clear();
+        headers.push_back(jl::http::Header{ "content-type", "application/json" });
+        headers.push_back(jl::http::Header{ "content-length", length });
+        session.Respond(stream_id, 200, headers, *body, body);
+        ++responses;
+        });
+
+    // 客户端的帧在计数之前全部编码好，每批16个并发流
+    constexpr int kBatch = 16;
+    const int total = kWarmup + kRequests;
+    jl::http2::HpackEncoder encoder;
+    std::string preface(jl::http2::kClientPreface);
+    jl::http2::AppendSettings(preface, {});
+    jl::http2::AppendWindowUpdate(preface, 0, jl::http2::kMaxWindowSize - jl::http2::kDefaultWindowSize);
+    std::vector<std::string> batches;
+    std::string block;
+    std::uint32_t stream_id = 1;
+    for (int i = 0; i < total; i += kBatch) {
+        std::string frames;
+        for (int j = 0; j < kBatch; ++j, stream_id += 2) {
+            block.clear();
+            encoder.Encode(block, ":method", "GET");
+            encoder.Encode(block, ":scheme", "https");
+            encoder.Encode(block, ":path", "/users/12345/posts/" + std::to_string(stream_id) + "?sort=desc");
+            encoder.Encode(block, ":authority", "www.example.com");
+            encoder.Encode(block, "user-agent", "Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko)");
+            encoder.Encode(block, "accept", "text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8");
+            encoder.Encode(block, "accept-encoding", "gzip, deflate, br");
+            encoder.Encode(block, "cookie", "session=0123456789abcdef0123456789abcdef; theme=dark");
+            jl::http2::AppendFrameHeader(frames, static_cast<std::uint32_t>(block.size()), jl::http2::FrameType::kHeaders,
+                jl::http2::flags::kEndHeaders | jl::http2::flags::kEndStream, stream_id);
+            frames.append(block);
+        }
+        batches.push_back(std::move(frames));
+    }
+
+    auto feed = [&](const std::string& data) {
+        std::size_t consumed = 0;
+        jl::http::ParseStatus status = session.Receive(data.data(), data.size(), consumed);
+        assert(status == jl::http::ParseStatus::kNeedMore && consumed == data.size());
+        (void)status;
+        session.Flush(256 * 1024);
+        session.Output().clear();
+    };
+    feed(preface);
+    const int warmup_batches = kWarmup / kBatch + 1;
+    for (int i = 0; i < warmup_batches; ++i) {
+        feed(batches[i]);
+    }
+    const std::size_t warmup_responses = responses;
+    gAllocations = 0;
+    for (std::size_t i = warmup_batches; i < batches.size(); ++i) {
+        feed(batches[i]);
+    }
+    const std::size_t requests = responses - warmup_responses;
+    assert(requests == (batches.size() - warmup_batches) * kBatch && session.GetStats().open_streams == 0);
+    std::printf("http/2: %.3f allocations/request, %zu bytes/connection\n", static_cast<double>(gAllocations) / requests, session.MemoryUsage());
+    assert(gAllocations == 0);
+}
+
+int main()
+{
+    TestArena();
+    TestHttp1();
+    TestHttp2();
+    std::cout << "request_arena_test passed" << std::endl;
+    return 0;
+}
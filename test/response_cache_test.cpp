@@ -0,0 +1,220 @@
+// 响应缓存测试：缓存键包含方法、请求目标和 Vary 头部，命中、TTL 过期、按容量淘汰，
+// 多个线程并发未命中同一个键时只有一个执行处理函数，其余等待同一个响应；缓存的 wire 共享不复制
+#include <response_cache.h>
+#include <assert.h>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using jl::http::CachedResponse;
+using jl::http::ResponseCache;
+
+jl::http::Request MakeRequest(std::string_view method, std::string_view target, std::string_view language)
+{
+    jl::http::Request request;
+    request.method = method;
+    request.target = target;
+    request.headers.push_back(jl::http::Header{ "Accept-Language", language });
+    return request;
+}
+
+void TestKey()
+{
+    ResponseCache cache({ "Accept-Language" });
+    std::string a, b, c, d;
+    cache.MakeKey(MakeRequest("GET", "/hello?x=1", "en"), a);
+    cache.MakeKey(MakeRequest("GET", "/hello?x=1", "zh"), b);
+    cache.MakeKey(MakeRequest("HEAD", "/hello?x=1", "en"), c);
+    cache.MakeKey(MakeRequest("GET", "/hello?x=2", "en"), d);
+    assert(a != b && a != c && a != d);
+    std::string again;
+    cache.MakeKey(MakeRequest("GET", "/hello?x=1", "en"), again);
+    assert(again == a);
+}
+
+void TestHitAndExpire()
+{
+    ResponseCache cache;
+    ResponseCache::Entry response;
+    ResponseCache::LookupStatus status = cache.Lookup("GET /a", response);
+    assert(status == ResponseCache::LookupStatus::kMiss);
+    auto generated = jl::http::MakeCachedResponse(200, "text/plain", "hello");
+    assert(generated->wire.find("HTTP/1.1 200 OK\r\n") == 0 && generated->wire.find("Content-Length: 5\r\n") != std::string::npos);
+    assert(generated->wire.compare(generated->wire.size() - 9, 9, "\r\n\r\nhello") == 0);
+    cache.Complete("GET /a", generated, std::chrono::milliseconds(50));
+
+    status = cache.Lookup("GET /a", response);
+    assert(status == ResponseCache::LookupStatus::kHit);
+    assert(response == generated);
+    // wire 与缓存项共用引用计数
+    auto wire = jl::http::SharedWire(response);
+    assert(wire.get() == &generated->wire && wire.use_count() == generated.use_count());
+
+    // ttl 为0的响应不写入缓存
+    status = cache.Lookup("GET /b", response);
+    assert(status == ResponseCache::LookupStatus::kMiss);
+    cache.Complete("GET /b", jl::http::MakeCachedResponse(200, "text/plain", "b"), std::chrono::milliseconds(0));
+    status = cache.Lookup("GET /b", response);
+    assert(status == ResponseCache::LookupStatus::kMiss);
+    cache.Complete("GET /b", nullptr, std::chrono::milliseconds(0));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(80));
+    status = cache.Lookup("GET /a", response);
+    assert(status == ResponseCache::LookupStatus::kMiss);
+    cache.Complete("GET /a", nullptr, std::chrono::milliseconds(0));
+
+    ResponseCache::Stats stats = cache.GetStats();
+    assert(stats.hits == 1 && stats.misses == 4 && stats.expired == 1 && stats.entries == 0 && stats.bytes == 0);
+    assert(stats.hit_bytes == 5);
+}
+
+void TestEviction()
+{
+    // 单分片，容量约为3个响应
+    const std::string body(1000, 'x');
+    const std::size_t size = jl::http::MakeCachedResponse(200, "text/plain", body)->Size();
+    ResponseCache cache({}, size * 3 + size / 2, 1);
+    ResponseCache::Entry response;
+    for (const char* key : { "1", "2", "3" }) {
+        ResponseCache::LookupStatus status = cache.Lookup(key, response);
+        assert(status == ResponseCache::LookupStatus::kMiss);
+        cache.Complete(key, jl::http::MakeCachedResponse(200, "text/plain", body), std::chrono::seconds(60));
+    }
+    // 访问 1 之后插入 4，淘汰最久未使用的 2
+    ResponseCache::LookupStatus status = cache.Lookup("1", response);
+    assert(status == ResponseCache::LookupStatus::kHit);
+    status = cache.Lookup("4", response);
+    assert(status == ResponseCache::LookupStatus::kMiss);
+    cache.Complete("4", jl::http::MakeCachedResponse(200, "text/plain", body), std::chrono::seconds(60));
+    status = cache.Lookup("2", response);
+    assert(status == ResponseCache::LookupStatus::kMiss);
+    cache.Complete("2", nullptr, std::chrono::milliseconds(0));
+    status = cache.Lookup("1", response);
+    assert(status == ResponseCache::LookupStatus::kHit);
+    status = cache.Lookup("3", response);
+    assert(status == ResponseCache::LookupStatus::kHit);
+    ResponseCache::Stats stats = cache.GetStats();
+    assert(stats.evictions == 1 && stats.entries == 3 && stats.bytes == size * 3);
+
+    // 大于分片容量的响应不缓存
+    status = cache.Lookup("big", response);
+    assert(status == ResponseCache::LookupStatus::kMiss);
+    cache.Complete("big", jl::http::MakeCachedResponse(200, "text/plain", std::string(size * 4, 'y')), std::chrono::seconds(60));
+    assert(cache.GetStats().entries == 3);
+}
+
+void TestCoalescing()
+{
+    ResponseCache cache;
+    constexpr int kThreads = 16;
+    std::atomic<int> handler_runs{ 0 };
+    std::atomic<int> waiting{ 0 };
+    std::atomic<int> received{ 0 };
+    std::atomic<bool> release{ false };
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kThreads; ++i) {
+        threads.emplace_back([&]() {
+            ResponseCache::Entry response;
+            ResponseCache::LookupStatus status = cache.Lookup("GET /slow", response);
+            if (status == ResponseCache::LookupStatus::kMiss) {
+                ++handler_runs;
+                // 等其他线程都合并进来后再完成
+                while (!release) {
+                    std::this_thread::yield();
+                }
+                cache.Complete("GET /slow", jl::http::MakeCachedResponse(200, "text/plain", "expensive"), std::chrono::seconds(60));
+                ++received;
+            }
+            else {
+                assert(status == ResponseCache::LookupStatus::kPending);
+                bool ok = cache.Wait("GET /slow", [&](const ResponseCache::Entry& result) {
+                    assert(result && result->body == "expensive");
+                    ++received;
+                    });
+                assert(ok);
+                (void)ok;
+                ++waiting;
+            }
+            });
+    }
+    while (waiting < kThreads - 1) {
+        std::this_thread::yield();
+    }
+    release = true;
+    for (auto& t : threads) {
+        t.join();
+    }
+    assert(handler_runs == 1 && received == kThreads);
+    ResponseCache::Stats stats = cache.GetStats();
+    assert(stats.misses == 1 && stats.coalesced == kThreads - 1 && stats.entries == 1);
+    assert(stats.HitRatio() > 0.9);
+
+    // 不可缓存的响应也交给合并的请求，但不写入缓存
+    ResponseCache::Entry response;
+    ResponseCache::Entry delivered;
+    ResponseCache::LookupStatus status = cache.Lookup("GET /nocache", response);
+    assert(status == ResponseCache::LookupStatus::kMiss);
+    status = cache.Lookup("GET /nocache", response);
+    assert(status == ResponseCache::LookupStatus::kPending);
+    bool ok = cache.Wait("GET /nocache", [&](const ResponseCache::Entry& result) { delivered = result; });
+    assert(ok);
+    auto generated = jl::http::MakeCachedResponse(200, "text/plain", "once");
+    cache.Complete("GET /nocache", generated, std::chrono::milliseconds(0));
+    assert(delivered == generated);
+    // 生成已经结束时 Wait 返回 false，调用方重新查找
+    ok = cache.Wait("GET /nocache", [](const ResponseCache::Entry&) { assert(false); });
+    assert(!ok);
+    status = cache.Lookup("GET /nocache", response);
+    assert(status == ResponseCache::LookupStatus::kMiss);
+    cache.Complete("GET /nocache", nullptr, std::chrono::milliseconds(0));
+}
+
+void TestConcurrentShards()
+{
+    // 多线程混合读写不同的键，统计数之和与请求数一致
+    ResponseCache cache({}, 1024 * 1024, 8);
+    constexpr int kThreads = 8;
+    constexpr int kOps = 20000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t]() {
+            std::string key;
+            for (int i = 0; i < kOps; ++i) {
+                key = "GET /item/" + std::to_string((i * 7 + t) % 200);
+                ResponseCache::Entry response;
+                // 等待时生成已经结束则重新查找
+                ResponseCache::LookupStatus status;
+                do {
+                    status = cache.Lookup(key, response);
+                } while (status == ResponseCache::LookupStatus::kPending && !cache.Wait(key, [](const ResponseCache::Entry&) {}));
+                if (status == ResponseCache::LookupStatus::kMiss) {
+                    cache.Complete(key, jl::http::MakeCachedResponse(200, "text/plain", key), std::chrono::seconds(60));
+                }
+                else if (status == ResponseCache::LookupStatus::kHit) {
+                    assert(response->body == key);
+                }
+            }
+            });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    ResponseCache::Stats stats = cache.GetStats();
+    assert(stats.hits + stats.misses + stats.coalesced == static_cast<std::uint64_t>(kThreads) * kOps);
+    assert(stats.entries == 200 && stats.misses >= 200);
+    std::cout << "hit ratio " << stats.HitRatio() << ", " << stats.entries << " entries, " << stats.bytes << " bytes" << std::endl;
+}
+
+int main()
+{
+    TestKey();
+    TestHitAndExpire();
+    TestEviction();
+    TestCoalescing();
+    TestConcurrentShards();
+    std::cout << "response_cache_test passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,172 @@
+// 向量化扫描吞吐测试
+// usage: simd_scan_bench [seconds]
+// 对比原路径（asio read_until 的逐字节分隔符匹配、逐字节查表校验）与 scalar/SSE2/AVX2 各级别，
+// x86 上以 rdtsc 计数输出 bytes/cycle，其他平台输出 bytes/ns；最后对比各级别下 RequestParser 的解析吞吐
+#include <http_parser.h>
+#include <simd_scan.h>
+#include <algorithm>
+#include <assert.h>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define JL_HAS_RDTSC 1
+#endif
+
+using jl::simd::Level;
+
+std::uint64_t Ticks()
+{
+#ifdef JL_HAS_RDTSC
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+const char* kUnit =
+#ifdef JL_HAS_RDTSC
+    "bytes/cycle";
+#else
+    "bytes/ns";
+#endif
+
+std::size_t gChecksum = 0;
+
+// func 处理一遍 bytes 字节，返回值计入校验和防止被优化掉
+void Bench(const std::string& name, std::size_t bytes, double seconds, const std::function<std::size_t()>& func)
+{
+    std::size_t rounds = 0;
+    std::uint64_t ticks = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < seconds) {
+        std::uint64_t t0 = Ticks();
+        for (int i = 0; i < 100; ++i) {
+            gChecksum += func();
+        }
+        ticks += Ticks() - t0;
+        rounds += 100;
+    }
+    std::cout << "  " << name << ": " << static_cast<double>(bytes) * rounds / ticks << " " << kUnit << std::endl;
+}
+
+// asio::read_until(streambuf, string) 的查找方式：逐字节比较分隔符首字节，再逐字节比较剩余部分
+const char* AsioStyleSearch(const char* begin, const char* end, const std::string& sep)
+{
+    return std::search(begin, end, sep.begin(), sep.end());
+}
+
+bool TableIsToken(const char* begin, const char* end)
+{
+    static const std::string kExtra = "!#$%&'*+-.^_`|~";
+    for (const char* p = begin; p < end; ++p) {
+        char c = *p;
+        bool ok = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || kExtra.find(c) != std::string::npos;
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char const *argv[])
+{
+    double seconds = argc > 1 ? std::stod(argv[1]) : 0.5;
+    Level supported = jl::simd::SupportedLevel();
+    std::cout << "supported level: " << jl::simd::LevelName(supported) << ", unit: " << kUnit << std::endl;
+
+    // 一段典型请求头，长度约 560 字节，逐行查找 \r\n
+    const std::string headers =
+        "GET /static/js/app.4f2c1a.js HTTP/1.1\r\n"
+        "Host: www.example.com\r\n"
+        "Connection: keep-alive\r\n"
+        "User-Agent: Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/124.0.0.0 Safari/537.36\r\n"
+        "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8\r\n"
+        "Referer: https://www.example.com/index.html\r\n"
+        "Accept-Encoding: gzip, deflate, br, zstd\r\n"
+        "Accept-Language: zh-CN,zh;q=0.9,en;q=0.8\r\n"
+        "Cookie: session=" + std::string(128, 'a') + "\r\n"
+        "\r\n";
+    // 长行：4KB 无分隔符数据后跟 \r\n，例如大 Cookie 或行协议中的长消息
+    const std::string long_line = std::string(4096, 'x') + "\r\n";
+    const std::string long_token = std::string(2048, 'X') + std::string(2048, 'y');
+    std::string long_upper = long_token;
+    std::transform(long_upper.begin(), long_upper.end(), long_upper.begin(), [](char c) { return static_cast<char>(std::toupper(c)); });
+    const std::string crlf = "\r\n";
+
+    auto count_lines = [&](const std::function<const char*(const char*, const char*)>& find) {
+        std::size_t lines = 0;
+        const char* p = headers.data();
+        const char* end = p + headers.size();
+        while ((p = find(p, end)) != end) {
+            p += 2;
+            ++lines;
+        }
+        return lines;
+    };
+
+    std::cout << "delimiter \\r\\n, header lines (" << headers.size() << " bytes)" << std::endl;
+    Bench("asio read_until (std::search)", headers.size(), seconds, [&]() {
+        return count_lines([&](const char* b, const char* e) { return AsioStyleSearch(b, e, crlf); });
+        });
+    for (int level = 0; level <= static_cast<int>(supported); ++level) {
+        jl::simd::SetLevel(static_cast<Level>(level));
+        Bench(std::string("FindSequence ") + jl::simd::LevelName(static_cast<Level>(level)), headers.size(), seconds, [&]() {
+            return count_lines([&](const char* b, const char* e) { return jl::simd::FindSequence(b, e, "\r\n", 2); });
+            });
+    }
+
+    std::cout << "delimiter \\r\\n, long line (" << long_line.size() << " bytes)" << std::endl;
+    Bench("asio read_until (std::search)", long_line.size(), seconds, [&]() {
+        return static_cast<std::size_t>(AsioStyleSearch(long_line.data(), long_line.data() + long_line.size(), crlf) - long_line.data());
+        });
+    for (int level = 0; level <= static_cast<int>(supported); ++level) {
+        jl::simd::SetLevel(static_cast<Level>(level));
+        Bench(std::string("FindSequence ") + jl::simd::LevelName(static_cast<Level>(level)), long_line.size(), seconds, [&]() {
+            return static_cast<std::size_t>(jl::simd::FindSequence(long_line.data(), long_line.data() + long_line.size(), "\r\n", 2) - long_line.data());
+            });
+    }
+
+    std::cout << "token validation (" << long_token.size() << " bytes)" << std::endl;
+    Bench("byte loop", long_token.size(), seconds, [&]() {
+        return static_cast<std::size_t>(TableIsToken(long_token.data(), long_token.data() + long_token.size()));
+        });
+    for (int level = 0; level <= static_cast<int>(supported); ++level) {
+        jl::simd::SetLevel(static_cast<Level>(level));
+        Bench(std::string("FindNonToken ") + jl::simd::LevelName(static_cast<Level>(level)), long_token.size(), seconds, [&]() {
+            return static_cast<std::size_t>(jl::simd::FindNonToken(long_token.data(), long_token.data() + long_token.size()) - long_token.data());
+            });
+        Bench(std::string("FindNonFieldValue ") + jl::simd::LevelName(static_cast<Level>(level)), long_token.size(), seconds, [&]() {
+            return static_cast<std::size_t>(jl::simd::FindNonFieldValue(long_token.data(), long_token.data() + long_token.size()) - long_token.data());
+            });
+    }
+
+    std::cout << "case-insensitive compare (" << long_token.size() << " bytes)" << std::endl;
+    for (int level = 0; level <= static_cast<int>(supported); ++level) {
+        jl::simd::SetLevel(static_cast<Level>(level));
+        Bench(std::string("EqualsNoCase ") + jl::simd::LevelName(static_cast<Level>(level)), long_token.size(), seconds, [&]() {
+            return static_cast<std::size_t>(jl::simd::EqualsNoCase(long_token.data(), long_upper.data(), long_token.size()));
+            });
+    }
+
+    std::cout << "RequestParser (" << headers.size() << " bytes)" << std::endl;
+    jl::http::RequestParser parser;
+    for (int level = 0; level <= static_cast<int>(supported); ++level) {
+        jl::simd::SetLevel(static_cast<Level>(level));
+        Bench(std::string("Parse ") + jl::simd::LevelName(static_cast<Level>(level)), headers.size(), seconds, [&]() {
+            parser.Reset();
+            auto status = parser.Parse(headers.data(), headers.size());
+            assert(status == jl::http::ParseStatus::kComplete);
+            return parser.GetRequest().headers.size() + static_cast<std::size_t>(status);
+            });
+    }
+    std::cout << "checksum " << (gChecksum & 0xff) << std::endl;
+    return 0;
+}
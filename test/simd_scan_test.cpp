@@ -0,0 +1,136 @@
+// 向量化扫描测试：各级别实现在所有长度和对齐方式下与标量实现结果一致（含 WebSocket 掩码异或）
+#include <simd_scan.h>
+#include <assert.h>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using jl::simd::Level;
+
+const std::uint8_t kMaskKey[4] = { 0x37, 0xfa, 0x21, 0x3d };
+
+struct Results {
+    std::vector<std::ptrdiff_t> values;
+
+    void Add(const char* found, const char* begin) { values.push_back(found - begin); }
+    void Add(bool equal) { values.push_back(equal); }
+};
+
+// 以当前级别对同一组输入运行全部扫描函数
+Results RunAll(const std::vector<std::string>& inputs)
+{
+    const std::string seps[] = { "\r\n", "\r\n\r\n", ":", "--boundary" };
+    Results results;
+    for (const std::string& input : inputs) {
+        // 在不同起始偏移和长度上运行，覆盖向量块的首尾
+        for (std::size_t offset = 0; offset < 33 && offset <= input.size(); ++offset) {
+            const char* begin = input.data() + offset;
+            const char* end = input.data() + input.size();
+            results.Add(jl::simd::FindByte(begin, end, '\n'), begin);
+            results.Add(jl::simd::FindByte(begin, end, ':'), begin);
+            for (const std::string& sep : seps) {
+                results.Add(jl::simd::FindSequence(begin, end, sep.data(), sep.size()), begin);
+            }
+            results.Add(jl::simd::FindNonToken(begin, end), begin);
+            results.Add(jl::simd::FindNonFieldValue(begin, end), begin);
+            std::string upper(begin, end);
+            for (char& c : upper) {
+                if (c >= 'a' && c <= 'z') {
+                    c = static_cast<char>(c - 'a' + 'A');
+                }
+            }
+            results.Add(jl::simd::EqualsNoCase(begin, upper.data(), upper.size()));
+            if (!upper.empty()) {
+                upper.back() ^= 0x01;
+                results.Add(jl::simd::EqualsNoCase(begin, upper.data(), upper.size()));
+            }
+            // 起始偏移同时作为掩码偏移，覆盖分段去掩码的情况
+            std::string masked(begin, end);
+            jl::simd::XorMask(&masked[0], masked.size(), kMaskKey, offset);
+            for (char c : masked) {
+                results.values.push_back(static_cast<unsigned char>(c));
+            }
+        }
+    }
+    return results;
+}
+
+std::vector<std::string> MakeInputs()
+{
+    std::vector<std::string> inputs;
+    std::mt19937 rng(42);
+    const std::string token_chars = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789-!#$%&'*+.^_`|~";
+    for (std::size_t len = 0; len <= 130; ++len) {
+        // 大部分是token字符，随机插入分隔符、控制字符和高位字节
+        std::string s(len, 'a');
+        for (char& c : s) {
+            c = token_chars[rng() % token_chars.size()];
+        }
+        inputs.push_back(s);
+        if (len > 0) {
+            std::string mixed = s;
+            const char specials[] = { '\r', '\n', ':', ' ', '\t', '\x01', '\x7f', '\x80', '\xff', '@', '[', '`', '{' };
+            for (int i = 0; i < 3; ++i) {
+                mixed[rng() % len] = specials[rng() % sizeof(specials)];
+            }
+            inputs.push_back(mixed);
+            std::string line = s;
+            line[rng() % len] = '\r';
+            if (len > 1) {
+                line[len - 1] = '\n';
+                line[len - 2] = '\r';
+            }
+            inputs.push_back(line);
+        }
+    }
+    inputs.push_back(std::string(100, '-') + "-boundary");
+    inputs.push_back(std::string(64, '\r') + "\r\n\r\n");
+    return inputs;
+}
+
+int main(int argc, char const *argv[])
+{
+    std::vector<std::string> inputs = MakeInputs();
+    Level supported = jl::simd::SupportedLevel();
+    std::cout << "supported level: " << jl::simd::LevelName(supported) << std::endl;
+
+    assert(jl::simd::SetLevel(Level::kScalar) == Level::kScalar);
+    Results expected = RunAll(inputs);
+
+    for (Level level : { Level::kSSE2, Level::kAVX2 }) {
+        if (static_cast<int>(level) > static_cast<int>(supported)) {
+            continue;
+        }
+        assert(jl::simd::SetLevel(level) == level);
+        assert(jl::simd::ActiveLevel() == level);
+        Results results = RunAll(inputs);
+        assert(results.values == expected.values);
+        std::cout << jl::simd::LevelName(level) << ": " << results.values.size() << " results match scalar" << std::endl;
+    }
+
+    // 结果的语义抽查
+    jl::simd::SetLevel(supported);
+    const std::string line = "Content-Type: text/html\r\n";
+    const char* begin = line.data();
+    const char* end = begin + line.size();
+    assert(jl::simd::FindSequence(begin, end, "\r\n", 2) == end - 2);
+    assert(jl::simd::FindByte(begin, end, ':') == begin + 12);
+    assert(jl::simd::FindNonToken(begin, end) == begin + 12);
+    assert(jl::simd::FindNonFieldValue(begin, end) == end - 2);
+    assert(jl::simd::EqualsNoCase(begin, "CONTENT-TYPE", 12));
+    assert(!jl::simd::EqualsNoCase(begin, "CONTENT_TYPE", 12));
+    // RFC 6455 5.7 示例："Hello" 使用掩码 37 fa 21 3d
+    char hello[] = "Hello";
+    jl::simd::XorMask(hello, 5, kMaskKey);
+    assert(std::string(hello, 5) == "\x7f\x9f\x4d\x51\x58");
+    // 分两段去掩码与一次去掩码结果相同
+    std::string payload(1000, 'p');
+    std::string whole = payload;
+    jl::simd::XorMask(&whole[0], whole.size(), kMaskKey);
+    jl::simd::XorMask(&payload[0], 333, kMaskKey);
+    jl::simd::XorMask(&payload[333], payload.size() - 333, kMaskKey, 333);
+    assert(payload == whole);
+    std::cout << "simd scan test passed." << std::endl;
+    return 0;
+}
@@ -3,12 +3,22 @@
 #include <connection.h>
 #include <global.h>
 
+// usage: ssl_connection_test [-t io_threads] [--legacy | --dhe] [--ktls] [--hs-threads n] [--hs-max n] [--tickets n]
+//   默认使用新的TLS配置（TLS1.2~1.3，ECDHE优先，不加载DH参数）
+//   --legacy 旧的默认配置：仅TLS1.2，OpenSSL默认套件，加载dh2048.pem
+//   --dhe    强制有限域DHE密钥交换，用于对比每次握手生成DH密钥的开销
+//   --ktls   握手后尝试把加解密卸载到内核（需要 modprobe tls）
+//   --hs-threads 握手线程数，0 表示在io线程上握手
+//   --hs-max 同时进行的握手数上限，0 表示不限制
+//   --tickets TLS1.3 每次握手后发送的 session ticket 个数，默认1（OpenSSL 默认2）
+// 配合 ssl_handshake_bench 测试握手吞吐，单核对比可以用 taskset -c 0 ./ssl_connection_test -t 1
+
 std::atomic<int> gConnCnt = 0;
 
 class SSLServer
 {
 public:
-    SSLServer(asio::io_context &ioct, const std::string &ip, unsigned short port) : tcp_server_(ioct, ip, port) {   
+    SSLServer(asio::io_context &ioct, const std::string &ip, unsigned short port) : tcp_server_(ioct, ip, port) {
         tcp_server_.DoAwaitStop();
         tcp_server_.SetConnEstablishCallback([=](jl::net::socket&& socket) {
             // conn->SetTimeout(2);
@@ -29,14 +39,14 @@ public:
                 conn->Read();
             });
             ssl_connction->SetConnCloseCallback([](const std::shared_ptr<jl::IConnection>& conn){
-                LOG_INFO("conn close");
+                LOG_DEBUG("conn close");
             });
             ssl_connction->Handshake();
         });
 
     }
 
-    void Start() { tcp_server_.Start(); }
+    void Start(std::size_t thread_cnt) { tcp_server_.Start(thread_cnt); }
 
 private:
     jl::Server tcp_server_;
@@ -44,9 +54,63 @@ private:
 
 int main(int argc, char const *argv[])
 {
+    std::size_t thread_cnt = std::thread::hardware_concurrency() * 2;
+    std::string mode = "default";
+    bool kernel_tls = false;
+    std::size_t hs_threads = 0, hs_max = 0;
+    std::size_t tickets = 1;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-t" && i + 1 < argc) {
+            thread_cnt = std::stoul(argv[++i]);
+        }
+        else if (arg == "--legacy" || arg == "--dhe") {
+            mode = arg.substr(2);
+        }
+        else if (arg == "--ktls") {
+            kernel_tls = true;
+        }
+        else if (arg == "--hs-threads" && i + 1 < argc) {
+            hs_threads = std::stoul(argv[++i]);
+        }
+        else if (arg == "--hs-max" && i + 1 < argc) {
+            hs_max = std::stoul(argv[++i]);
+        }
+        else if (arg == "--tickets" && i + 1 < argc) {
+            tickets = std::stoul(argv[++i]);
+        }
+    }
+
+    auto& global = jl::Global::Instance();
+    global.SetCRTFilePath("./resource/server.crt");
+    global.SetPrivateKeyPath("./resource/server.key");
+    global.SetPasswordCallback([](std::size_t, jl::ssl::context::password_purpose) { return ""; });
+    if (mode == "legacy") {
+        global.SetProtocolVersion(TLS1_2_VERSION, TLS1_2_VERSION);
+        global.SetCipherList("DEFAULT");
+        global.SetGroups("");
+        global.SetTmpDhPath("./resource/dh2048.pem");
+    }
+    else if (mode == "dhe") {
+        global.SetProtocolVersion(TLS1_2_VERSION, TLS1_2_VERSION);
+        global.SetCipherList("DHE-RSA-AES128-GCM-SHA256:DHE-RSA-AES256-GCM-SHA384");
+        global.SetTmpDhPath("./resource/dh2048.pem");
+    }
+    global.SetSessionTicket(true, 3600, tickets);
+    global.SetKernelTLS(kernel_tls);
+    global.SetHandshakeOptions(hs_threads, hs_max, 10);
+    if (!global.InitSSLContext()) {
+        return 1;
+    }
+    LOG_INFO("TLS config: {}, io threads: {}", mode, thread_cnt);
+
     asio::io_context ioct;
     SSLServer server(ioct, "127.0.0.1", 12345);
-    server.Start();
-    LOG_INFO("Connection count: {}", gConnCnt.load());
+    server.Start(thread_cnt);
+    auto stats = global.GetSSLStats();
+    LOG_INFO("Connection count: {}, full handshakes: {}, resumed handshakes: {}, ktls tx: {}, ktls rx: {}, "
+        "handshakes rejected: {}, handshakes timeout: {}",
+        gConnCnt.load(), stats.full_handshakes, stats.resumed_handshakes, stats.ktls_tx, stats.ktls_rx,
+        stats.handshakes_rejected, stats.handshakes_timeout);
     return 0;
 }
@@ -0,0 +1,107 @@
+// TLS握手吞吐测试客户端，服务端为 ssl_connection_test
+// usage: ssl_handshake_bench [host] [port] [handshakes] [threads] [echo_conns]
+// 每次握手都使用新的SSL对象、不复用session，统计完整握手的 handshakes/s 和平均延迟
+// echo_conns > 0 时另开若干条已建立的连接持续做64字节echo，统计握手风暴期间已建立连接的往返延迟分布
+#include <asio.hpp>
+#include <asio/ssl.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+int main(int argc, char const *argv[])
+{
+    std::string host = argc > 1 ? argv[1] : "127.0.0.1";
+    std::string port = argc > 2 ? argv[2] : "12345";
+    int total = argc > 3 ? std::stoi(argv[3]) : 2000;
+    int thread_cnt = argc > 4 ? std::stoi(argv[4]) : 4;
+    int echo_conns = argc > 5 ? std::stoi(argv[5]) : 0;
+
+    asio::io_context ioct;
+    asio::ssl::context ctx(asio::ssl::context::tls_client);
+    ctx.set_verify_mode(asio::ssl::verify_none);
+    SSL_CTX_set_session_cache_mode(ctx.native_handle(), SSL_SESS_CACHE_OFF);
+    auto endpoints = asio::ip::tcp::resolver(ioct).resolve(host, port);
+
+    std::atomic<int> next = 0;
+    std::atomic<int> success = 0;
+    std::atomic<int> fail = 0;
+    std::atomic<long long> latency_us = 0;
+    std::string protocol, cipher;
+    std::mutex mutex;
+
+    std::atomic<bool> storm_done = false;
+    std::vector<long long> echo_us;
+    std::vector<std::thread> echo_threads;
+    for (int e = 0; e < echo_conns; ++e) {
+        echo_threads.emplace_back([&]() {
+            asio::ssl::stream<asio::ip::tcp::socket> stream(ioct, ctx);
+            asio::connect(stream.lowest_layer(), endpoints);
+            stream.lowest_layer().set_option(asio::ip::tcp::no_delay(true));
+            stream.handshake(asio::ssl::stream_base::client);
+            std::vector<long long> samples;
+            char msg[64] = {}, reply[64];
+            while (!storm_done) {
+                auto begin = std::chrono::steady_clock::now();
+                asio::write(stream, asio::buffer(msg));
+                asio::read(stream, asio::buffer(reply));
+                samples.push_back(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count());
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            echo_us.insert(echo_us.end(), samples.begin(), samples.end());
+            });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_cnt; ++t) {
+        threads.emplace_back([&]() {
+            while (next.fetch_add(1) < total) {
+                asio::ssl::stream<asio::ip::tcp::socket> stream(ioct, ctx);
+                std::error_code ec;
+                auto begin = std::chrono::steady_clock::now();
+                asio::connect(stream.lowest_layer(), endpoints, ec);
+                if (!ec) {
+                    stream.handshake(asio::ssl::stream_base::client, ec);
+                }
+                auto end = std::chrono::steady_clock::now();
+                if (ec) {
+                    fail.fetch_add(1);
+                    continue;
+                }
+                success.fetch_add(1);
+                latency_us.fetch_add(std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count());
+                if (protocol.empty()) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    protocol = SSL_get_version(stream.native_handle());
+                    cipher = SSL_get_cipher_name(stream.native_handle());
+                }
+                stream.lowest_layer().close(ec);
+            }
+            });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    storm_done = true;
+    for (auto& t : echo_threads) {
+        t.join();
+    }
+
+    std::cout << "protocol:    " << protocol << " " << cipher << "\n"
+              << "handshakes:  " << success.load() << " ok, " << fail.load() << " failed\n"
+              << "throughput:  " << success.load() / secs << " handshakes/s\n"
+              << "avg latency: " << (success.load() ? latency_us.load() / success.load() : 0) << " us\n";
+    if (!echo_us.empty()) {
+        std::sort(echo_us.begin(), echo_us.end());
+        auto pct = [&](double p) { return echo_us[std::min(echo_us.size() - 1, static_cast<std::size_t>(p * echo_us.size()))]; };
+        std::cout << "echo rtt:    " << echo_us.size() << " samples, p50 " << pct(0.5) << " us, p99 " << pct(0.99)
+                  << " us, max " << echo_us.back() << " us\n";
+    }
+    return 0;
+}
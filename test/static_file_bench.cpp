@@ -0,0 +1,283 @@
+// 静态文件吞吐测试，服务端和客户端在同一进程内，走明文TCP（大文件使用 sendfile）
+// usage: static_file_bench [seconds] [client_threads]
+// 两种负载：大量小文件（2000 个 1-8KB 文件随机访问）和少量大文件（4 个 16MB 文件），
+// 对比 StaticFileCache（小文件内容与响应头一次写出，大文件保持打开并 SendFile）
+// 与每个请求都打开文件、读入 string 再写出，输出 requests/s 和 MB/s
+#include <acceptor.h>
+#include <connection.h>
+#include <http_parser.h>
+#include <http_response.h>
+#include <static_file_cache.h>
+#include <assert.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+constexpr unsigned short kPort = 12346;
+constexpr int kSmallFiles = 2000;
+constexpr int kLargeFiles = 4;
+constexpr std::size_t kLargeFileBytes = 16 * 1024 * 1024;
+
+std::atomic<bool> gUseCache{ true };
+
+// 每个请求都从磁盘读取整个文件
+bool ReadWholeFile(const std::string& path, std::string& content)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    in.seekg(0, std::ios::end);
+    content.resize(static_cast<std::size_t>(in.tellg()));
+    in.seekg(0);
+    in.read(&content[0], content.size());
+    return static_cast<bool>(in);
+}
+
+// 最小的 keep-alive 文件服务：一次处理缓冲区中的完整请求，写完后继续读
+class FileSession : public std::enable_shared_from_this<FileSession> {
+public:
+    FileSession(const std::shared_ptr<jl::IConnection>& conn, const std::shared_ptr<jl::http::StaticFileCache>& cache, const std::string& root) :
+        conn_(conn), cache_(cache), root_(root), writes_(0)
+    {
+    }
+
+    void Start()
+    {
+        // 回调持有会话，连接关闭后 conn_ 置空打破引用环
+        auto self = shared_from_this();
+        conn_->SetMessageCommingCallback([self](const std::shared_ptr<jl::IConnection>&, const std::string& data) {
+            self->buffer_.append(data);
+            self->Process();
+            });
+        conn_->SetWriteFinishCallback([self](const std::shared_ptr<jl::IConnection>&, std::size_t) {
+            if (--self->writes_ == 0) {
+                self->Process();
+            }
+            });
+        conn_->SetConnCloseCallback([self](const std::shared_ptr<jl::IConnection>&) {
+            self->conn_.reset();
+            });
+        conn_->Read();
+    }
+
+private:
+    void Process()
+    {
+        while (conn_ && writes_ == 0) {
+            jl::http::ParseStatus status = parser_.Parse(buffer_.data(), buffer_.size());
+            if (status == jl::http::ParseStatus::kNeedMore) {
+                conn_->Read();
+                return;
+            }
+            if (status == jl::http::ParseStatus::kError) {
+                conn_->Close();
+                return;
+            }
+            std::string_view path = parser_.GetRequest().target;
+            path.remove_prefix(1);
+            Respond(path);
+            buffer_.erase(0, parser_.HeaderBytes());
+            parser_.Reset();
+        }
+    }
+
+    void Respond(std::string_view path)
+    {
+        out_.clear();
+        jl::http::ResponseWriter writer(out_);
+        if (gUseCache) {
+            auto file = cache_->Get(path);
+            if (!file) {
+                writer.Status(404).Date().ContentLength(0).EndHeaders();
+                Write();
+                return;
+            }
+            writer.Status(200).Date().Headers(file->headers).EndHeaders();
+            if (file->fd < 0) {
+                writer.Body(file->content);
+                Write();
+                return;
+            }
+            Write();
+            ++writes_;
+            conn_->SendFile(jl::FileSegment{ file->fd, 0, static_cast<std::size_t>(file->size), file });
+            return;
+        }
+        if (!ReadWholeFile(root_ + "/" + std::string(path), content_)) {
+            writer.Status(404).Date().ContentLength(0).EndHeaders();
+            Write();
+            return;
+        }
+        writer.Status(200).Date()
+            .Header("Content-Type", jl::http::ContentType(path))
+            .ContentLength(content_.size())
+            .EndHeaders()
+            .Body(content_);
+        Write();
+    }
+
+    void Write()
+    {
+        ++writes_;
+        conn_->Write(out_);
+    }
+
+private:
+    std::shared_ptr<jl::IConnection> conn_;
+    std::shared_ptr<jl::http::StaticFileCache> cache_;
+    const std::string& root_;
+    jl::http::RequestParser parser_;
+    std::string buffer_;
+    std::string out_;
+    std::string content_;
+    int writes_;
+};
+
+// 阻塞客户端：发送 GET 后读完整个响应
+class Client {
+public:
+    explicit Client(asio::io_context& ioct) : socket_(ioct)
+    {
+        socket_.connect(asio::ip::tcp::endpoint(asio::ip::make_address("127.0.0.1"), kPort));
+        socket_.set_option(asio::ip::tcp::no_delay(true));
+    }
+
+    std::size_t Get(const std::string& path)
+    {
+        std::string request = "GET /" + path + " HTTP/1.1\r\nHost: bench\r\n\r\n";
+        asio::write(socket_, asio::buffer(request));
+        std::size_t end;
+        while ((end = buffer_.find("\r\n\r\n")) == std::string::npos) {
+            Fill();
+        }
+        assert(buffer_.compare(0, 12, "HTTP/1.1 200") == 0);
+        std::size_t pos = buffer_.find("Content-Length: ");
+        assert(pos != std::string::npos && pos < end);
+        std::size_t length = std::stoull(buffer_.substr(pos + 16, 20));
+        std::size_t total = end + 4 + length;
+        while (buffer_.size() < total) {
+            if (total - buffer_.size() > sizeof(chunk_)) {
+                // 大响应体直接丢弃，不拷贝进 buffer_
+                std::size_t skip = asio::read(socket_, asio::buffer(chunk_), asio::transfer_exactly(std::min(sizeof(chunk_), total - buffer_.size())));
+                total -= skip;
+                continue;
+            }
+            Fill();
+        }
+        buffer_.erase(0, total);
+        return length;
+    }
+
+private:
+    void Fill()
+    {
+        std::size_t n = socket_.read_some(asio::buffer(chunk_));
+        buffer_.append(chunk_, n);
+    }
+
+private:
+    asio::ip::tcp::socket socket_;
+    std::string buffer_;
+    char chunk_[256 * 1024];
+};
+
+void Bench(const char* name, double seconds, int threads, const std::vector<std::string>& paths)
+{
+    std::atomic<std::size_t> requests{ 0 };
+    std::atomic<std::size_t> bytes{ 0 };
+    std::atomic<bool> stop{ false };
+    std::vector<std::thread> clients;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; ++t) {
+        clients.emplace_back([&, t]() {
+            asio::io_context ioct;
+            auto client = std::make_unique<Client>(ioct);
+            std::mt19937 rng(t);
+            std::size_t n = 0, b = 0;
+            while (!stop) {
+                b += client->Get(paths[rng() % paths.size()]);
+                ++n;
+            }
+            requests += n;
+            bytes += b;
+            });
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop = true;
+    for (auto& t : clients) {
+        t.join();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%-34s %10.0f requests/s %10.1f MB/s\n", name, requests / elapsed, bytes / elapsed / (1024 * 1024));
+}
+
+void WriteFile(const std::string& path, std::size_t size, std::mt19937& rng)
+{
+    std::string content(size, '\0');
+    for (auto& c : content) {
+        c = static_cast<char>(rng());
+    }
+    std::ofstream(path, std::ios::binary).write(content.data(), content.size());
+}
+
+int main(int argc, char const* argv[])
+{
+    double seconds = argc > 1 ? std::stod(argv[1]) : 3.0;
+    int threads = argc > 2 ? std::stoi(argv[2]) : 4;
+
+    std::string root = "static_file_bench_www";
+    std::system(("rm -rf " + root + " && mkdir -p " + root).c_str());
+    std::mt19937 rng(42);
+    std::vector<std::string> small, large;
+    for (int i = 0; i < kSmallFiles; ++i) {
+        small.push_back("s" + std::to_string(i) + ".css");
+        WriteFile(root + "/" + small.back(), 1024 + rng() % (7 * 1024), rng);
+    }
+    for (int i = 0; i < kLargeFiles; ++i) {
+        large.push_back("l" + std::to_string(i) + ".bin");
+        WriteFile(root + "/" + large.back(), kLargeFileBytes, rng);
+    }
+
+    asio::io_context ioct;
+    auto cache = std::make_shared<jl::http::StaticFileCache>(root, kSmallFiles + kLargeFiles);
+    auto acceptor = std::make_shared<jl::Acceptor>(ioct, "127.0.0.1", kPort);
+    acceptor->SetConnEstablishCallback([&](jl::net::socket&& socket) {
+        socket.set_option(asio::ip::tcp::no_delay(true));
+        std::make_shared<FileSession>(jl::MakeConnection(std::move(socket)), cache, root)->Start();
+        });
+    acceptor->DoAccept();
+    auto guard = asio::make_work_guard(ioct);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back([&]() { ioct.run(); });
+    }
+
+    gUseCache = false;
+    Bench("small files, read per request", seconds, threads, small);
+    gUseCache = true;
+    Bench("small files, cached", seconds, threads, small);
+    gUseCache = false;
+    Bench("large files, read per request", seconds, threads, large);
+    gUseCache = true;
+    Bench("large files, cached fd + sendfile", seconds, threads, large);
+
+    auto stats = cache->GetStats();
+    std::printf("cache: %zu files, %llu hits, %llu misses, %llu evictions, %llu inline bytes\n", stats.files,
+        static_cast<unsigned long long>(stats.hits), static_cast<unsigned long long>(stats.misses),
+        static_cast<unsigned long long>(stats.evictions), static_cast<unsigned long long>(stats.inline_bytes));
+
+    ioct.stop();
+    for (auto& t : workers) {
+        t.join();
+    }
+    std::system(("rm -rf " + root).c_str());
+    return 0;
+}
@@ -1,3 +1,4 @@
+#include <latency_histogram.h>
 #include <asio.hpp>
 #include <iostream>
 #include <vector>
@@ -8,6 +9,10 @@
 #include <csignal>
 #include <chrono>
 #include <cstring>
+#include <cstdio>
+#include <deque>
+#include <future>
+#include <algorithm>
 
 using asio::ip::tcp;
 
@@ -162,6 +167,483 @@ private:
     std::atomic<int> &fail_count_;
 };
 
+// ---------------- 开环压测 ----------------
+// 按目标速率在固定的计划时间发送消息，不等待前一条的回显（服务端为 echo_server）。
+// 延迟从计划发送时间算起：服务端停顿时发送端照常按计划排队，排队时间计入延迟，不会掩盖尾延迟（coordinated omission）
+
+constexpr std::int64_t kPacerSpinNs = 50 * 1000;         // 定时器提前唤醒，最后这段时间自旋等待，减小发送时间的抖动
+constexpr std::size_t kMaxWriteBatch = 64;               // 单次写合并的最大消息数
+constexpr std::size_t kMaxBacklogPerConn = 64 * 1024;    // 每个连接排队的消息数上限，超过时丢弃并计数
+constexpr std::int64_t kStartDelayNs = 200 * 1000 * 1000;  // 开始调度前留给建立初始连接的时间
+constexpr std::int64_t kDrainNs = 1000 * 1000 * 1000;      // 调度结束后等待在途回显的时间
+
+std::int64_t NowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct OpenLoopConfig
+{
+    double rate = 1000;             // 目标消息数/秒，所有连接合计
+    int connections = 100;          // 同时保持的连接数
+    std::string payload;            // 一条消息，回显收齐 payload.size() 字节为完成
+    double seconds = 10;            // 统计时长
+    double warmup = 1;              // 统计前的预热时长
+    int requests_per_conn = 0;      // 大于0时每个连接发送这么多条消息后关闭，同时建立新连接（连接抖动）
+    int workers = 1;                // 调度器数，每个调度器在自己的 strand 上负责一部分连接和速率
+};
+
+struct OpenLoopResult
+{
+    jl::util::LatencyHistogram latency;     // 计划发送时间到收齐回显，未完成的按结束时间计入
+    jl::util::LatencyHistogram send_lag;    // 实际写出时间晚于计划时间的部分，反映调度器和连接排队
+    jl::util::LatencyHistogram connect;     // 建立连接的耗时
+    std::uint64_t scheduled = 0;            // 以下计数只包含计划时间在统计窗口内的消息
+    std::uint64_t completed = 0;
+    std::uint64_t delivered = 0;            // 在统计窗口内收齐的消息（不论计划时间），除以时长为实际吞吐
+    std::uint64_t incomplete = 0;           // 结束时仍未收齐回显
+    std::uint64_t dropped = 0;              // 连接积压超过上限，没有发送
+    std::uint64_t failed = 0;               // 所在连接出错
+    std::uint64_t connects = 0;
+    std::uint64_t connect_errors = 0;
+    std::uint64_t closes = 0;
+    double seconds = 0;
+
+    void Merge(const OpenLoopResult &other)
+    {
+        latency.Merge(other.latency);
+        send_lag.Merge(other.send_lag);
+        connect.Merge(other.connect);
+        scheduled += other.scheduled;
+        completed += other.completed;
+        delivered += other.delivered;
+        incomplete += other.incomplete;
+        dropped += other.dropped;
+        failed += other.failed;
+        connects += other.connects;
+        connect_errors += other.connect_errors;
+        closes += other.closes;
+    }
+};
+
+class OpenLoopWorker;
+
+// 开环压测的一条连接，所有操作在所属调度器的 strand 上执行
+class OpenLoopConnection : public std::enable_shared_from_this<OpenLoopConnection>
+{
+public:
+    explicit OpenLoopConnection(const std::shared_ptr<OpenLoopWorker> &worker);
+
+    void Connect(const tcp::resolver::results_type &endpoints);
+
+    /// @brief 分配一条计划在 intended 发送的消息，连接建立前先排队
+    void Enqueue(std::int64_t intended);
+
+    /// @brief 不再分配消息，在途消息收齐后关闭
+    void Retire();
+
+    /// @brief 压测结束，未完成的消息计入 incomplete 后关闭
+    void Abort(std::int64_t now);
+
+    bool Failed() const { return failed_; }
+    std::size_t Assigned() const { return assigned_; }
+    std::size_t Backlog() const { return pending_.size() + inflight_.size(); }
+
+private:
+    void OnConnect(std::error_code ec);
+    void Flush();
+    void DoRead();
+    void OnRead(std::error_code ec, size_t length);
+    void Fail();
+    void Close();
+
+    std::shared_ptr<OpenLoopWorker> worker_;
+    tcp::socket socket_;
+    std::int64_t connect_begin_ = 0;
+    std::deque<std::int64_t> pending_;      // 还没写出的消息的计划时间
+    std::deque<std::int64_t> inflight_;     // 已写出、还没收齐回显的消息的计划时间
+    std::size_t assigned_ = 0;
+    std::size_t received_ = 0;              // 最早的在途消息已收到的字节数
+    bool open_ = false;
+    bool writing_ = false;
+    bool retiring_ = false;
+    bool failed_ = false;
+    std::array<char, 16 * 1024> buffer_;
+};
+
+// 开环调度器：在 strand 上按计划时间把消息轮流分配给自己的连接，统计只在本 strand 上修改，不需要加锁
+class OpenLoopWorker : public std::enable_shared_from_this<OpenLoopWorker>
+{
+public:
+    /// @param index 调度器序号，第 k 条消息的计划时间为 begin + (k * count + index) / rate，各调度器交错发送
+    OpenLoopWorker(asio::io_context &io_context, const OpenLoopConfig &config, const tcp::resolver::results_type &endpoints,
+                   const std::shared_ptr<const std::string> &batch, int index, int connections)
+        : strand_(asio::make_strand(io_context)),
+          timer_(strand_),
+          config_(config),
+          endpoints_(endpoints),
+          batch_(batch),
+          index_(index),
+          connection_count_(connections) {}
+
+    /// @brief 建立初始连接并从 begin 开始调度，[window_begin, window_end) 内计划的消息计入统计，window_end 后停止调度
+    void Start(std::int64_t begin, std::int64_t window_begin, std::int64_t window_end)
+    {
+        auto self = shared_from_this();
+        asio::post(strand_, [self, begin, window_begin, window_end]()
+                   {
+                       self->window_begin_ = window_begin;
+                       self->window_end_ = window_end;
+                       self->interval_ = 1e9 * self->config_.workers / self->config_.rate;
+                       self->first_ = static_cast<double>(begin) + 1e9 * self->index_ / self->config_.rate;
+                       for (int i = 0; i < self->connection_count_; ++i)
+                       {
+                           self->slots_.push_back(self->NewConnection());
+                       }
+                       self->next_ = begin;
+                       self->Tick();
+                   });
+    }
+
+    /// @brief 停止调度，未完成的消息按当前时间计入延迟，返回本调度器的统计
+    std::future<OpenLoopResult> Finish()
+    {
+        auto promise = std::make_shared<std::promise<OpenLoopResult>>();
+        auto self = shared_from_this();
+        asio::post(strand_, [self, promise]()
+                   {
+                       self->finished_ = true;
+                       self->timer_.cancel();
+                       const std::int64_t now = NowNs();
+                       for (auto &conn : self->slots_)
+                       {
+                           conn->Abort(now);
+                       }
+                       for (auto &conn : self->retiring_)
+                       {
+                           conn->Abort(now);
+                       }
+                       // 连接持有调度器，清空后打破引用环
+                       self->slots_.clear();
+                       self->retiring_.clear();
+                       promise->set_value(std::move(self->result_));
+                   });
+        return promise->get_future();
+    }
+
+    bool Finished() const { return finished_; }
+    bool Counted(std::int64_t intended) const { return intended >= window_begin_ && intended < window_end_; }
+    const asio::any_io_executor &Strand() const { return strand_; }
+    const std::string &Batch() const { return *batch_; }
+    std::size_t MessageSize() const { return config_.payload.size(); }
+    OpenLoopResult &Result() { return result_; }
+
+    /// @brief 收齐一条消息的回显
+    void Complete(std::int64_t intended, std::int64_t now)
+    {
+        if (Counted(intended))
+        {
+            ++result_.completed;
+            result_.latency.Record(static_cast<std::uint64_t>(now - intended));
+        }
+        if (Counted(now))
+        {
+            ++result_.delivered;
+        }
+    }
+
+    /// @brief 连接关闭或出错后从待关闭列表中移除
+    void Remove(const OpenLoopConnection *conn)
+    {
+        auto it = std::find_if(retiring_.begin(), retiring_.end(), [conn](const auto &item)
+                               { return item.get() == conn; });
+        if (it != retiring_.end())
+        {
+            retiring_.erase(it);
+        }
+    }
+
+private:
+    std::shared_ptr<OpenLoopConnection> NewConnection()
+    {
+        auto conn = std::make_shared<OpenLoopConnection>(shared_from_this());
+        conn->Connect(endpoints_);
+        return conn;
+    }
+
+    /// @brief 分配所有计划时间已到的消息，再等待下一条的计划时间。晚于计划唤醒时一次补齐，计划时间不变
+    void Tick()
+    {
+        if (finished_)
+        {
+            return;
+        }
+        std::int64_t now = NowNs();
+        if (next_ - now > 0 && next_ - now <= kPacerSpinNs)
+        {
+            while (NowNs() < next_)
+            {
+            }
+            now = NowNs();
+        }
+        while (next_ <= now && next_ < window_end_)
+        {
+            Dispatch(next_);
+            ++sequence_;
+            next_ = static_cast<std::int64_t>(first_ + interval_ * sequence_);
+        }
+        if (next_ >= window_end_)
+        {
+            return;
+        }
+        auto self = shared_from_this();
+        timer_.expires_at(std::chrono::steady_clock::time_point(std::chrono::nanoseconds(next_ - kPacerSpinNs)));
+        timer_.async_wait([self](std::error_code ec)
+                          {
+                              if (!ec)
+                                  self->Tick();
+                          });
+    }
+
+    void Dispatch(std::int64_t intended)
+    {
+        if (Counted(intended))
+        {
+            ++result_.scheduled;
+        }
+        const std::size_t slot = next_slot_++ % slots_.size();
+        if (slots_[slot]->Failed())
+        {
+            slots_[slot] = NewConnection();
+        }
+        auto &conn = slots_[slot];
+        if (conn->Backlog() >= kMaxBacklogPerConn)
+        {
+            if (Counted(intended))
+            {
+                ++result_.dropped;
+            }
+            return;
+        }
+        conn->Enqueue(intended);
+        if (config_.requests_per_conn > 0 && conn->Assigned() >= static_cast<std::size_t>(config_.requests_per_conn))
+        {
+            // 旧连接收齐回显后关闭，新连接同时开始建立
+            conn->Retire();
+            if (!conn->Failed())
+            {
+                retiring_.push_back(conn);
+            }
+            conn = NewConnection();
+        }
+    }
+
+    asio::any_io_executor strand_;
+    asio::steady_timer timer_;
+    const OpenLoopConfig config_;
+    const tcp::resolver::results_type endpoints_;
+    const std::shared_ptr<const std::string> batch_;   // kMaxWriteBatch 条消息连在一起，写出时取前 n 条，所有调度器共享
+    const int index_;
+    const int connection_count_;
+    std::vector<std::shared_ptr<OpenLoopConnection>> slots_;
+    std::vector<std::shared_ptr<OpenLoopConnection>> retiring_;    // 不再分配消息、等待在途回显的连接
+    std::size_t next_slot_ = 0;
+    double first_ = 0;                      // 本调度器第一条消息的计划时间
+    double interval_ = 0;                   // 本调度器相邻两条消息的计划间隔
+    std::uint64_t sequence_ = 0;
+    std::int64_t next_ = 0;
+    std::int64_t window_begin_ = 0;
+    std::int64_t window_end_ = 0;
+    bool finished_ = false;
+    OpenLoopResult result_;
+};
+
+OpenLoopConnection::OpenLoopConnection(const std::shared_ptr<OpenLoopWorker> &worker)
+    : worker_(worker), socket_(worker->Strand()) {}
+
+void OpenLoopConnection::Connect(const tcp::resolver::results_type &endpoints)
+{
+    // socket 的执行器为调度器的 strand，完成回调都在 strand 上执行
+    connect_begin_ = NowNs();
+    asio::async_connect(socket_, endpoints,
+                        [self = shared_from_this()](std::error_code ec, tcp::endpoint)
+                        {
+                            self->OnConnect(ec);
+                        });
+}
+
+void OpenLoopConnection::OnConnect(std::error_code ec)
+{
+    if (worker_->Finished())
+    {
+        return;
+    }
+    OpenLoopResult &result = worker_->Result();
+    if (ec)
+    {
+        ++result.connect_errors;
+        Fail();
+        return;
+    }
+    const std::int64_t now = NowNs();
+    if (worker_->Counted(now))
+    {
+        ++result.connects;
+        result.connect.Record(static_cast<std::uint64_t>(now - connect_begin_));
+    }
+    socket_.set_option(tcp::no_delay(true), ec);
+    open_ = true;
+    DoRead();
+    Flush();
+}
+
+void OpenLoopConnection::Enqueue(std::int64_t intended)
+{
+    ++assigned_;
+    pending_.push_back(intended);
+    Flush();
+}
+
+void OpenLoopConnection::Retire()
+{
+    retiring_ = true;
+    if (open_ && pending_.empty() && inflight_.empty())
+    {
+        Close();
+    }
+}
+
+void OpenLoopConnection::Abort(std::int64_t now)
+{
+    OpenLoopResult &result = worker_->Result();
+    for (const auto *queue : {&pending_, &inflight_})
+    {
+        for (std::int64_t intended : *queue)
+        {
+            if (worker_->Counted(intended))
+            {
+                ++result.incomplete;
+                result.latency.Record(static_cast<std::uint64_t>(std::max<std::int64_t>(0, now - intended)));
+            }
+        }
+    }
+    pending_.clear();
+    inflight_.clear();
+    std::error_code ec;
+    socket_.close(ec);
+}
+
+void OpenLoopConnection::Flush()
+{
+    if (!open_ || writing_ || pending_.empty())
+    {
+        return;
+    }
+    // 积压的消息合并成一次写；写出时间晚于计划时间的部分计入 send_lag
+    const std::size_t n = std::min(pending_.size(), kMaxWriteBatch);
+    const std::int64_t now = NowNs();
+    OpenLoopResult &result = worker_->Result();
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        const std::int64_t intended = pending_.front();
+        pending_.pop_front();
+        if (worker_->Counted(intended))
+        {
+            result.send_lag.Record(static_cast<std::uint64_t>(std::max<std::int64_t>(0, now - intended)));
+        }
+        inflight_.push_back(intended);
+    }
+    writing_ = true;
+    asio::async_write(socket_, asio::buffer(worker_->Batch().data(), n * worker_->MessageSize()),
+                      [self = shared_from_this()](std::error_code ec, size_t)
+                      {
+                          self->writing_ = false;
+                          if (self->worker_->Finished())
+                          {
+                              return;
+                          }
+                          if (ec)
+                          {
+                              self->Fail();
+                              return;
+                          }
+                          self->Flush();
+                      });
+}
+
+void OpenLoopConnection::DoRead()
+{
+    socket_.async_read_some(asio::buffer(buffer_),
+                            [self = shared_from_this()](std::error_code ec, size_t length)
+                            {
+                                self->OnRead(ec, length);
+                            });
+}
+
+void OpenLoopConnection::OnRead(std::error_code ec, size_t length)
+{
+    if (worker_->Finished() || failed_)
+    {
+        return;
+    }
+    if (ec)
+    {
+        Fail();
+        return;
+    }
+    // 回显是字节流，按发送顺序每收齐一条消息的字节数完成一条
+    received_ += length;
+    const std::size_t size = worker_->MessageSize();
+    const std::int64_t now = NowNs();
+    while (received_ >= size && !inflight_.empty())
+    {
+        received_ -= size;
+        worker_->Complete(inflight_.front(), now);
+        inflight_.pop_front();
+    }
+    if (retiring_ && pending_.empty() && inflight_.empty())
+    {
+        Close();
+        return;
+    }
+    DoRead();
+}
+
+void OpenLoopConnection::Fail()
+{
+    OpenLoopResult &result = worker_->Result();
+    for (const auto *queue : {&pending_, &inflight_})
+    {
+        for (std::int64_t intended : *queue)
+        {
+            if (worker_->Counted(intended))
+            {
+                ++result.failed;
+            }
+        }
+    }
+    pending_.clear();
+    inflight_.clear();
+    failed_ = true;
+    open_ = false;
+    std::error_code ec;
+    socket_.close(ec);
+    worker_->Remove(this);
+}
+
+void OpenLoopConnection::Close()
+{
+    if (worker_->Counted(NowNs()))
+    {
+        ++worker_->Result().closes;
+    }
+    open_ = false;
+    std::error_code ec;
+    socket_.shutdown(tcp::socket::shutdown_both, ec);
+    socket_.close(ec);
+    worker_->Remove(this);
+}
+
 // 连接管理器
 class ConnectionManager
 {
@@ -206,6 +688,54 @@ public:
         }
     }
 
+    /// @brief 开环压测一轮：建立 config.connections 条连接，按 config.rate 在计划时间发送，统计窗口结束后等待在途回显
+    bool RunOpenLoop(const std::string &host, const std::string &port, const OpenLoopConfig &config, OpenLoopResult &result)
+    {
+        std::error_code ec;
+        auto endpoints = tcp::resolver(io_context_).resolve(host, port, ec);
+        if (ec)
+        {
+            std::cerr << "Resolve failed: " << ec.message() << "\n";
+            return false;
+        }
+        auto batch = std::make_shared<std::string>();
+        for (std::size_t i = 0; i < kMaxWriteBatch; ++i)
+        {
+            batch->append(config.payload);
+        }
+        const int workers = std::max(1, std::min(config.workers, config.connections));
+        OpenLoopConfig worker_config = config;
+        worker_config.workers = workers;
+        std::vector<std::shared_ptr<OpenLoopWorker>> schedulers;
+        for (int i = 0; i < workers; ++i)
+        {
+            const int connections = config.connections / workers + (i < config.connections % workers ? 1 : 0);
+            schedulers.push_back(std::make_shared<OpenLoopWorker>(io_context_, worker_config, endpoints, batch, i, connections));
+        }
+        const std::int64_t begin = NowNs() + kStartDelayNs;
+        const std::int64_t window_begin = begin + static_cast<std::int64_t>(config.warmup * 1e9);
+        const std::int64_t window_end = window_begin + static_cast<std::int64_t>(config.seconds * 1e9);
+        for (auto &scheduler : schedulers)
+        {
+            scheduler->Start(begin, window_begin, window_end);
+        }
+        while (!g_stop_flag && NowNs() < window_end + kDrainNs)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        if (g_stop_flag)
+        {
+            // io_context 已经停止，不再收集结果
+            return false;
+        }
+        for (auto &scheduler : schedulers)
+        {
+            result.Merge(scheduler->Finish().get());
+        }
+        result.seconds = config.seconds;
+        return true;
+    }
+
     void PrintStats() const
     {
         std::cout << "\n═══════════════════════════════════════\n"
@@ -236,10 +766,111 @@ void PrintUsage(const char *program_name)
               << "  --timeout <seconds>    Connection timeout (default: 10)\n"
               << "  --delay <ms>           Delay per 100 connections (default: 0)\n"
               << "  -h, --help             Show this help\n\n"
+              << "Open-loop mode (echo server, e.g. echo_server):\n"
+              << "  --rate <n>             Send n messages/s across all connections on a fixed schedule\n"
+              << "  --ramp <from:to:step>  Step the rate up until the server saturates, report the knee\n"
+              << "  --duration <seconds>   Measured time per rate (default: 10)\n"
+              << "  --warmup <seconds>     Unmeasured time before each rate (default: 1)\n"
+              << "  --size <bytes>         Message size when -m is not given (default: 64)\n"
+              << "  --churn <n>            Close each connection after n messages, opening a new one\n"
+              << "  --slo <ms>             p99 latency above this also counts as saturated\n"
+              << "  --json                 Print one JSON line per rate\n\n"
               << "Examples:\n"
               << "  " << program_name << " 127.0.0.1 8080\n"
               << "  " << program_name << " 192.168.1.100 9999 -c 5000 -t 8 -m \"ping\"\n"
-              << "  " << program_name << " example.com 80 -c 10000 --delay 50\n";
+              << "  " << program_name << " example.com 80 -c 10000 --delay 50\n"
+              << "  " << program_name << " 127.0.0.1 12345 -c 50 --rate 20000 --size 256\n"
+              << "  " << program_name << " 127.0.0.1 12345 -c 50 --ramp 10000:200000:10000 --slo 5\n"
+              << "  " << program_name << " 127.0.0.1 12345 -c 200 --rate 5000 --churn 10\n";
+}
+
+// 一轮开环压测是否已饱和：窗口内的实际吞吐低于目标（排队在增长）、有消息没有完成或丢弃，或 p99 超过 slo
+bool Saturated(const OpenLoopConfig &config, const OpenLoopResult &result, double slo_ms)
+{
+    const double achieved = result.delivered / result.seconds;
+    const std::uint64_t lost = result.incomplete + result.dropped + result.failed;
+    return achieved < config.rate * 0.95 || lost > result.scheduled / 100 ||
+           (slo_ms > 0 && result.latency.Percentile(99) > slo_ms * 1e6);
+}
+
+void PrintOpenLoop(const OpenLoopConfig &config, const OpenLoopResult &result, bool saturated, bool json)
+{
+    const auto &l = result.latency;
+    const double achieved = result.delivered / result.seconds;
+    if (json)
+    {
+        std::printf("{\"rate\":%.1f,\"achieved\":%.1f,\"connections\":%d,\"size\":%zu,\"churn\":%d,\"seconds\":%.3f,"
+                    "\"scheduled\":%llu,\"completed\":%llu,\"incomplete\":%llu,\"dropped\":%llu,\"failed\":%llu,"
+                    "\"connects_per_sec\":%.1f,\"closes_per_sec\":%.1f,\"connect_errors\":%llu,\"saturated\":%s,"
+                    "\"latency_us\":{\"mean\":%.2f,\"p50\":%.2f,\"p99\":%.2f,\"p999\":%.2f,\"max\":%.2f},"
+                    "\"send_lag_us\":{\"p50\":%.2f,\"p99\":%.2f,\"max\":%.2f},"
+                    "\"connect_us\":{\"p50\":%.2f,\"p99\":%.2f,\"max\":%.2f}}\n",
+                    config.rate, achieved, config.connections, config.payload.size(), config.requests_per_conn, result.seconds,
+                    static_cast<unsigned long long>(result.scheduled), static_cast<unsigned long long>(result.completed),
+                    static_cast<unsigned long long>(result.incomplete), static_cast<unsigned long long>(result.dropped),
+                    static_cast<unsigned long long>(result.failed), result.connects / result.seconds, result.closes / result.seconds,
+                    static_cast<unsigned long long>(result.connect_errors), saturated ? "true" : "false",
+                    l.Mean() / 1e3, l.Percentile(50) / 1e3, l.Percentile(99) / 1e3, l.Percentile(99.9) / 1e3, l.Max() / 1e3,
+                    result.send_lag.Percentile(50) / 1e3, result.send_lag.Percentile(99) / 1e3, result.send_lag.Max() / 1e3,
+                    result.connect.Percentile(50) / 1e3, result.connect.Percentile(99) / 1e3, result.connect.Max() / 1e3);
+    }
+    else
+    {
+        std::printf("rate %9.0f  achieved %9.0f msgs/s  latency us: p50 %9.1f  p99 %9.1f  p99.9 %9.1f  max %9.1f  "
+                    "send lag p99 %8.1f  lost %llu%s\n",
+                    config.rate, achieved, l.Percentile(50) / 1e3, l.Percentile(99) / 1e3, l.Percentile(99.9) / 1e3, l.Max() / 1e3,
+                    result.send_lag.Percentile(99) / 1e3,
+                    static_cast<unsigned long long>(result.incomplete + result.dropped + result.failed), saturated ? "  SATURATED" : "");
+        if (config.requests_per_conn > 0)
+        {
+            std::printf("               churn: %.0f connects/s, %.0f closes/s, connect p50 %.1f us, p99 %.1f us, %llu connect errors\n",
+                        result.connects / result.seconds, result.closes / result.seconds,
+                        result.connect.Percentile(50) / 1e3, result.connect.Percentile(99) / 1e3,
+                        static_cast<unsigned long long>(result.connect_errors));
+        }
+    }
+    std::fflush(stdout);
+}
+
+/// @brief 开环压测：固定速率测一轮，或按 ramp 逐级提高速率，第一次饱和时停止并输出拐点
+int RunOpenLoop(const std::string &host, const std::string &port, int thread_count, OpenLoopConfig config,
+                const std::vector<double> &rates, double slo_ms, bool json)
+{
+    ConnectionManager manager(io_context, thread_count);
+    if (!json)
+    {
+        std::printf("open loop %s:%s, %d connections, %zu-byte messages, %d schedulers, %.1fs per rate after %.1fs warmup\n",
+                    host.c_str(), port.c_str(), config.connections, config.payload.size(), config.workers, config.seconds, config.warmup);
+    }
+    double knee = 0;
+    for (double rate : rates)
+    {
+        config.rate = rate;
+        OpenLoopResult result;
+        if (!manager.RunOpenLoop(host, port, config, result))
+        {
+            return 1;
+        }
+        const bool saturated = Saturated(config, result, slo_ms);
+        PrintOpenLoop(config, result, saturated, json);
+        if (saturated)
+        {
+            break;
+        }
+        knee = rate;
+    }
+    if (rates.size() > 1 && !json)
+    {
+        if (knee > 0)
+        {
+            std::printf("saturation knee: %.0f msgs/s is the highest rate sustained\n", knee);
+        }
+        else
+        {
+            std::printf("saturation knee: below %.0f msgs/s\n", rates.front());
+        }
+    }
+    return 0;
 }
 
 int main(int argc, char *argv[])
@@ -251,6 +882,11 @@ int main(int argc, char *argv[])
     std::string message;
     int timeout_seconds = 10;
     int delay_ms = 0;
+    OpenLoopConfig open_loop;
+    std::vector<double> rates;      // 不为空时为开环模式
+    std::size_t size = 64;
+    double slo_ms = 0;
+    bool json = false;
 
     // 解析命令行
     for (int i = 1; i < argc; ++i)
@@ -290,6 +926,48 @@ int main(int argc, char *argv[])
         {
             delay_ms = std::stoi(argv[i]);
         }
+        else if (arg == "--rate" && ++i < argc)
+        {
+            rates.assign(1, std::stod(argv[i]));
+        }
+        else if (arg == "--ramp" && ++i < argc)
+        {
+            double from = 0, to = 0, step = 0;
+            if (std::sscanf(argv[i], "%lf:%lf:%lf", &from, &to, &step) != 3 || from <= 0 || step <= 0)
+            {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+            rates.clear();
+            for (double rate = from; rate <= to; rate += step)
+            {
+                rates.push_back(rate);
+            }
+        }
+        else if (arg == "--duration" && ++i < argc)
+        {
+            open_loop.seconds = std::stod(argv[i]);
+        }
+        else if (arg == "--warmup" && ++i < argc)
+        {
+            open_loop.warmup = std::stod(argv[i]);
+        }
+        else if (arg == "--size" && ++i < argc)
+        {
+            size = std::stoul(argv[i]);
+        }
+        else if (arg == "--churn" && ++i < argc)
+        {
+            open_loop.requests_per_conn = std::stoi(argv[i]);
+        }
+        else if (arg == "--slo" && ++i < argc)
+        {
+            slo_ms = std::stod(argv[i]);
+        }
+        else if (arg == "--json")
+        {
+            json = true;
+        }
     }
 
     if (host.empty() || port.empty())
@@ -302,6 +980,19 @@ int main(int argc, char *argv[])
     std::signal(SIGINT, SignalHandler);
     std::signal(SIGTERM, SignalHandler);
 
+    if (!rates.empty())
+    {
+        if (rates.front() <= 0 || connection_count <= 0 || open_loop.seconds <= 0 || (message.empty() && size == 0))
+        {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+        open_loop.connections = connection_count;
+        open_loop.workers = std::max(1, thread_count);
+        open_loop.payload = message.empty() ? std::string(size, 'x') : message;
+        return RunOpenLoop(host, port, thread_count, open_loop, rates, slo_ms, json);
+    }
+
 #ifdef _WIN32
     // // Windows 需要 WSAStartup
     // WSADATA wsa_data;
@@ -0,0 +1,333 @@
+// WebSocket 吞吐测试，服务端和客户端在同一进程内，走明文TCP，省略升级握手直接收发帧
+// usage: websocket_bench [seconds] [client_threads] [subscribers]
+// 1. 回显：每个客户端发送带掩码的帧并等待回显，分别测试 64B 小帧和 64KB 大帧的 messages/s
+// 2. 广播：一个发布者发送消息，服务端转发给所有订阅者，对比所有接收者共享同一个序列化好的帧
+//    与为每个接收者各序列化一份，输出订阅者收到的 messages/s
+// 3. 去掩码：逐字节异或与 simd::XorMask 各实现的 GB/s
+#include <acceptor.h>
+#include <connection.h>
+#include <simd_scan.h>
+#include <websocket.h>
+#include <assert.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+constexpr unsigned short kPort = 12347;
+constexpr std::size_t kSmallFrame = 64;
+constexpr std::size_t kLargeFrame = 64 * 1024;
+constexpr int kBroadcastBatch = 64;     // 发布者每发送一批，等待所有订阅者收齐后再发下一批
+
+enum class Mode {
+    kEcho,
+    kBroadcastShared,
+    kBroadcastCopy,
+};
+
+std::atomic<Mode> gMode{ Mode::kEcho };
+
+class WsSession;
+std::mutex gSubscribersMutex;
+std::vector<std::shared_ptr<WsSession>> gSubscribers;
+
+class WsSession : public std::enable_shared_from_this<WsSession> {
+public:
+    explicit WsSession(const std::shared_ptr<jl::IConnection>& conn) : conn_(conn)
+    {
+    }
+
+    void Start()
+    {
+        // 回调持有会话，连接关闭后 conn_ 置空打破引用环
+        auto self = shared_from_this();
+        conn_->SetMessageCommingCallback([self](const std::shared_ptr<jl::IConnection>&, const std::string& data) {
+            self->buffer_.append(data);
+            self->Process();
+            if (self->conn_) {
+                self->conn_->Read();
+            }
+            });
+        conn_->SetConnCloseCallback([self](const std::shared_ptr<jl::IConnection>&) {
+            self->conn_.reset();
+            });
+        conn_->Read();
+    }
+
+    void Send(const std::shared_ptr<const std::string>& frame)
+    {
+        if (conn_) {
+            conn_->Write(frame);
+        }
+    }
+
+    void Send(const std::string& frame)
+    {
+        if (conn_) {
+            conn_->Write(frame);
+        }
+    }
+
+private:
+    void Process()
+    {
+        std::size_t offset = 0;
+        jl::ws::Message message;
+        std::size_t consumed;
+        while (conn_) {
+            jl::http::ParseStatus status = parser_.Parse(&buffer_[0] + offset, buffer_.size() - offset, consumed, message);
+            offset += consumed;
+            if (status == jl::http::ParseStatus::kNeedMore) {
+                break;
+            }
+            if (status == jl::http::ParseStatus::kError) {
+                conn_->Close();
+                return;
+            }
+            if (message.opcode == jl::ws::Opcode::kPing) {
+                // 第一条消息为 ping 的连接是订阅者
+                std::lock_guard<std::mutex> lock(gSubscribersMutex);
+                gSubscribers.push_back(shared_from_this());
+                continue;
+            }
+            if (gMode == Mode::kEcho) {
+                out_.clear();
+                jl::ws::AppendFrame(out_, message.opcode, message.payload);
+                conn_->Write(out_);
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(gSubscribersMutex);
+            if (gMode == Mode::kBroadcastShared) {
+                auto frame = std::make_shared<std::string>();
+                jl::ws::AppendFrame(*frame, message.opcode, message.payload);
+                for (const auto& subscriber : gSubscribers) {
+                    subscriber->Send(frame);
+                }
+            }
+            else {
+                for (const auto& subscriber : gSubscribers) {
+                    out_.clear();
+                    jl::ws::AppendFrame(out_, message.opcode, message.payload);
+                    subscriber->Send(out_);
+                }
+            }
+        }
+        buffer_.erase(0, offset);
+    }
+
+private:
+    std::shared_ptr<jl::IConnection> conn_;
+    jl::ws::MessageParser parser_;
+    std::string buffer_;
+    std::string out_;
+};
+
+// 阻塞客户端：发送带掩码的帧，读取服务端不带掩码的帧
+class Client {
+public:
+    explicit Client(asio::io_context& ioct) : socket_(ioct), parser_(false)
+    {
+        socket_.connect(asio::ip::tcp::endpoint(asio::ip::make_address("127.0.0.1"), kPort));
+        socket_.set_option(asio::ip::tcp::no_delay(true));
+    }
+
+    void Send(jl::ws::Opcode opcode, const std::string& payload)
+    {
+        static const std::uint8_t key[4] = { 0x9d, 0x2c, 0x41, 0xe7 };
+        out_.clear();
+        jl::ws::AppendMaskedFrame(out_, opcode, payload, key);
+        asio::write(socket_, asio::buffer(out_));
+    }
+
+    /// @brief 读取一条消息，返回负载长度
+    std::size_t Receive()
+    {
+        jl::ws::Message message;
+        std::size_t consumed;
+        while (true) {
+            jl::http::ParseStatus status = parser_.Parse(&buffer_[0] + offset_, buffer_.size() - offset_, consumed, message);
+            offset_ += consumed;
+            if (status == jl::http::ParseStatus::kComplete) {
+                return message.payload.size();
+            }
+            assert(status == jl::http::ParseStatus::kNeedMore);
+            buffer_.erase(0, offset_);
+            offset_ = 0;
+            std::size_t n = socket_.read_some(asio::buffer(chunk_));
+            buffer_.append(chunk_, n);
+        }
+    }
+
+    void Close()
+    {
+        socket_.close();
+    }
+
+private:
+    asio::ip::tcp::socket socket_;
+    jl::ws::MessageParser parser_;
+    std::string out_;
+    std::string buffer_;
+    std::size_t offset_ = 0;
+    char chunk_[256 * 1024];
+};
+
+void BenchEcho(double seconds, int threads, std::size_t frame_bytes)
+{
+    gMode = Mode::kEcho;
+    std::atomic<std::size_t> messages{ 0 };
+    std::atomic<bool> stop{ false };
+    std::vector<std::thread> clients;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; ++t) {
+        clients.emplace_back([&]() {
+            asio::io_context ioct;
+            auto client = std::make_unique<Client>(ioct);
+            const std::string payload(frame_bytes, 'e');
+            std::size_t n = 0;
+            while (!stop) {
+                client->Send(jl::ws::Opcode::kBinary, payload);
+                std::size_t size = client->Receive();
+                assert(size == frame_bytes);
+                (void)size;
+                ++n;
+            }
+            messages += n;
+            client->Close();
+            });
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop = true;
+    for (auto& t : clients) {
+        t.join();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("echo %6zuB frames %25s %10.0f messages/s %10.1f MB/s\n", frame_bytes, "",
+        messages / elapsed, messages * frame_bytes / elapsed / (1024 * 1024));
+}
+
+void BenchBroadcast(const char* name, Mode mode, double seconds, int subscribers, std::size_t frame_bytes)
+{
+    gMode = mode;
+    {
+        std::lock_guard<std::mutex> lock(gSubscribersMutex);
+        gSubscribers.clear();
+    }
+    std::atomic<std::size_t> received{ 0 };
+    std::vector<std::thread> threads;
+    for (int i = 0; i < subscribers; ++i) {
+        threads.emplace_back([&]() {
+            asio::io_context ioct;
+            auto client = std::make_unique<Client>(ioct);
+            client->Send(jl::ws::Opcode::kPing, "");
+            while (client->Receive() > 0) {
+                ++received;
+            }
+            client->Close();
+            });
+    }
+    while (true) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        std::lock_guard<std::mutex> lock(gSubscribersMutex);
+        if (static_cast<int>(gSubscribers.size()) == subscribers) {
+            break;
+        }
+    }
+
+    asio::io_context ioct;
+    auto publisher = std::make_unique<Client>(ioct);
+    const std::string payload(frame_bytes, 'b');
+    std::size_t sent = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::duration<double>(seconds);
+    while (std::chrono::steady_clock::now() < deadline) {
+        for (int i = 0; i < kBroadcastBatch; ++i) {
+            publisher->Send(jl::ws::Opcode::kBinary, payload);
+        }
+        sent += kBroadcastBatch;
+        while (received < sent * subscribers) {
+            std::this_thread::yield();
+        }
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    // 空消息通知订阅者退出
+    publisher->Send(jl::ws::Opcode::kBinary, "");
+    for (auto& t : threads) {
+        t.join();
+    }
+    publisher->Close();
+    std::printf("broadcast %6zuB x %3d, %-16s %10.0f messages/s %10.1f MB/s\n", frame_bytes, subscribers, name,
+        received / elapsed, received * frame_bytes / elapsed / (1024 * 1024));
+}
+
+void ByteLoopXorMask(char* data, std::size_t n, const std::uint8_t key[4])
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        data[i] = static_cast<char>(data[i] ^ key[i & 3]);
+    }
+}
+
+template <typename Fn>
+void BenchUnmask(const char* name, Fn&& fn)
+{
+    const std::uint8_t key[4] = { 0x9d, 0x2c, 0x41, 0xe7 };
+    std::string data(kLargeFrame, 'm');
+    const int rounds = 20000;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i) {
+        fn(&data[0], data.size(), key);
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("unmask 64KB, %-10s %10.2f GB/s (check %d)\n", name, static_cast<double>(rounds) * data.size() / elapsed / 1e9, data[123]);
+}
+
+int main(int argc, char const* argv[])
+{
+    double seconds = argc > 1 ? std::stod(argv[1]) : 3.0;
+    int threads = argc > 2 ? std::stoi(argv[2]) : 4;
+    int subscribers = argc > 3 ? std::stoi(argv[3]) : 32;
+
+    asio::io_context ioct;
+    auto acceptor = std::make_shared<jl::Acceptor>(ioct, "127.0.0.1", kPort);
+    acceptor->SetConnEstablishCallback([&](jl::net::socket&& socket) {
+        socket.set_option(asio::ip::tcp::no_delay(true));
+        // 默认 4KB 读缓冲区下一个 64KB 帧需要读16次
+        std::make_shared<WsSession>(jl::MakeConnection(std::move(socket), kLargeFrame * 2))->Start();
+        });
+    acceptor->DoAccept();
+    auto guard = asio::make_work_guard(ioct);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back([&]() { ioct.run(); });
+    }
+
+    BenchEcho(seconds, threads, kSmallFrame);
+    BenchEcho(seconds, threads, kLargeFrame);
+    for (std::size_t frame_bytes : { kSmallFrame, kLargeFrame }) {
+        BenchBroadcast("shared frame", Mode::kBroadcastShared, seconds, subscribers, frame_bytes);
+        BenchBroadcast("frame per peer", Mode::kBroadcastCopy, seconds, subscribers, frame_bytes);
+    }
+
+    BenchUnmask("byte loop", ByteLoopXorMask);
+    for (int level = 0; level <= static_cast<int>(jl::simd::SupportedLevel()); ++level) {
+        jl::simd::SetLevel(static_cast<jl::simd::Level>(level));
+        BenchUnmask(jl::simd::LevelName(jl::simd::ActiveLevel()), [](char* data, std::size_t n, const std::uint8_t key[4]) {
+            jl::simd::XorMask(data, n, key);
+            });
+    }
+    jl::simd::SetLevel(jl::simd::SupportedLevel());
+
+    ioct.stop();
+    for (auto& t : workers) {
+        t.join();
+    }
+    {
+        std::lock_guard<std::mutex> lock(gSubscribersMutex);
+        gSubscribers.clear();
+    }
+    return 0;
+}
@@ -0,0 +1,241 @@
+// WebSocket 测试：升级请求判断和 Sec-WebSocket-Accept、帧序列化与解析（任意位置拆包、64位长度）、
+// 分片消息中间插入控制帧、协议错误对应的关闭状态码、UTF-8 校验
+#include <websocket.h>
+#include <assert.h>
+#include <iostream>
+#include <string>
+
+using jl::http::ParseStatus;
+using jl::ws::CloseCode;
+using jl::ws::Message;
+using jl::ws::MessageParser;
+using jl::ws::Opcode;
+
+const std::uint8_t kKey[4] = { 0x12, 0x34, 0x56, 0x78 };
+
+bool IsUpgrade(const std::string& text)
+{
+    jl::http::RequestParser parser;
+    ParseStatus status = parser.Parse(text.data(), text.size());
+    assert(status == ParseStatus::kComplete);
+    return jl::ws::IsUpgradeRequest(parser.GetRequest());
+}
+
+void TestHandshake()
+{
+    // RFC 6455 1.3 中的示例
+    assert(jl::ws::AcceptKey("dGhlIHNhbXBsZSBub25jZQ==") == "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=");
+
+    const std::string request =
+        "GET /chat HTTP/1.1\r\n"
+        "Host: server.example.com\r\n"
+        "Upgrade: websocket\r\n"
+        "Connection: keep-alive, Upgrade\r\n"
+        "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+        "Sec-WebSocket-Version: 13\r\n"
+        "\r\n";
+    assert(IsUpgrade(request));
+    std::string bad = request;
+    bad.replace(bad.find("13"), 2, "8");
+    assert(!IsUpgrade(bad));
+    bad = request;
+    bad.replace(0, 3, "POST");
+    assert(!IsUpgrade(bad));
+    bad = request;
+    bad.replace(bad.find("Upgrade\r\n"), 7, "close");
+    assert(!IsUpgrade(bad));
+    bad = request;
+    bad.replace(bad.find("dGhl"), 4, "dGh");
+    assert(!IsUpgrade(bad));
+
+    std::string out;
+    jl::ws::AppendHandshakeResponse(out, "dGhlIHNhbXBsZSBub25jZQ==");
+    assert(out.compare(0, 34, "HTTP/1.1 101 Switching Protocols\r\n") == 0);
+    assert(out.find("Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n") != std::string::npos);
+    assert(out.compare(out.size() - 4, 4, "\r\n\r\n") == 0);
+}
+
+void TestFrameHeader()
+{
+    std::string out;
+    jl::ws::AppendFrame(out, Opcode::kText, "Hello");
+    assert(out == std::string("\x81\x05Hello", 7));
+    out.clear();
+    jl::ws::AppendFrameHeader(out, Opcode::kBinary, 256);
+    assert(out == std::string("\x82\x7e\x01\x00", 4));
+    out.clear();
+    jl::ws::AppendFrameHeader(out, Opcode::kBinary, 65536, false);
+    assert(out == std::string("\x02\x7f\x00\x00\x00\x00\x00\x01\x00\x00", 10));
+    out.clear();
+    jl::ws::AppendCloseFrame(out, CloseCode::kGoingAway, "bye");
+    assert(out == std::string("\x88\x05\x03\xe9" "bye", 7));
+    // RFC 6455 5.7 中带掩码的 "Hello"
+    out.clear();
+    const std::uint8_t key[4] = { 0x37, 0xfa, 0x21, 0x3d };
+    jl::ws::AppendMaskedFrame(out, Opcode::kText, "Hello", key);
+    assert(out == std::string("\x81\x85\x37\xfa\x21\x3d\x7f\x9f\x4d\x51\x58", 11));
+}
+
+// 各种长度的消息在每个位置拆成两段，负载原地去掩码后以缓冲区视图返回
+void TestSplitEverywhere()
+{
+    for (std::size_t size : { 0, 1, 125, 126, 1000, 65535, 65536, 70000 }) {
+        std::string payload(size, '\0');
+        for (std::size_t i = 0; i < size; ++i) {
+            payload[i] = static_cast<char>(i * 31 + 7);
+        }
+        std::string frame;
+        jl::ws::AppendMaskedFrame(frame, Opcode::kBinary, payload, kKey);
+        const std::size_t step = size > 1000 ? 997 : 1;
+        for (std::size_t split = 0; split < frame.size(); split += step) {
+            std::string buffer = frame.substr(0, split);
+            MessageParser parser;
+            Message message;
+            std::size_t consumed = 0;
+            ParseStatus status = parser.Parse(&buffer[0], buffer.size(), consumed, message);
+            assert(status == ParseStatus::kNeedMore);
+            assert(consumed == 0);
+            buffer.append(frame, split, std::string::npos);
+            status = parser.Parse(&buffer[0], buffer.size(), consumed, message);
+            assert(status == ParseStatus::kComplete);
+            assert(consumed == frame.size());
+            assert(message.opcode == Opcode::kBinary && message.payload == payload);
+            assert(size == 0 || (message.payload.data() >= buffer.data() && message.payload.data() < buffer.data() + buffer.size()));
+        }
+    }
+}
+
+// 分片消息的第一片和第二片之间插入 ping，ping 单独返回，消息在最后一片到达时返回
+void TestFragmentation()
+{
+    std::string buffer;
+    jl::ws::AppendMaskedFrame(buffer, Opcode::kText, "Hel", kKey, false);
+    jl::ws::AppendMaskedFrame(buffer, Opcode::kPing, "p", kKey);
+    jl::ws::AppendMaskedFrame(buffer, Opcode::kContinuation, "lo, ", kKey, false);
+    jl::ws::AppendMaskedFrame(buffer, Opcode::kContinuation, "world", kKey, true);
+    jl::ws::AppendMaskedFrame(buffer, Opcode::kText, "next", kKey);
+
+    MessageParser parser;
+    Message message;
+    std::size_t consumed = 0;
+    std::size_t offset = 0;
+    ParseStatus status = parser.Parse(&buffer[offset], buffer.size() - offset, consumed, message);
+    assert(status == ParseStatus::kComplete);
+    assert(message.opcode == Opcode::kPing && message.payload == "p");
+    offset += consumed;
+    status = parser.Parse(&buffer[offset], buffer.size() - offset, consumed, message);
+    assert(status == ParseStatus::kComplete);
+    assert(message.opcode == Opcode::kText && message.payload == "Hello, world");
+    offset += consumed;
+    status = parser.Parse(&buffer[offset], buffer.size() - offset, consumed, message);
+    assert(status == ParseStatus::kComplete);
+    assert(message.payload == "next");
+    offset += consumed;
+    assert(offset == buffer.size());
+
+    // 中间的分片先到达时被消费，之后才返回完整的消息
+    MessageParser partial;
+    std::string first;
+    jl::ws::AppendMaskedFrame(first, Opcode::kBinary, "ab", kKey, false);
+    std::string last;
+    jl::ws::AppendMaskedFrame(last, Opcode::kContinuation, "cd", kKey, true);
+    status = partial.Parse(&first[0], first.size(), consumed, message);
+    assert(status == ParseStatus::kNeedMore);
+    assert(consumed == first.size());
+    status = partial.Parse(&last[0], last.size(), consumed, message);
+    assert(status == ParseStatus::kComplete);
+    assert(message.opcode == Opcode::kBinary && message.payload == "abcd");
+}
+
+CloseCode ParseError(const std::string& frame, bool require_mask = true, std::uint64_t max_message_bytes = jl::ws::kDefaultMaxMessageBytes)
+{
+    std::string buffer = frame;
+    MessageParser parser(require_mask, max_message_bytes);
+    Message message;
+    std::size_t consumed = 0;
+    ParseStatus status;
+    std::size_t offset = 0;
+    while ((status = parser.Parse(&buffer[offset], buffer.size() - offset, consumed, message)) == ParseStatus::kComplete) {
+        offset += consumed;
+    }
+    assert(status == ParseStatus::kError);
+    return parser.Error();
+}
+
+std::string Masked(Opcode opcode, std::string_view payload, bool fin = true)
+{
+    std::string frame;
+    jl::ws::AppendMaskedFrame(frame, opcode, payload, kKey, fin);
+    return frame;
+}
+
+void TestErrors()
+{
+    // 客户端的帧没有掩码
+    std::string unmasked;
+    jl::ws::AppendFrame(unmasked, Opcode::kText, "hi");
+    assert(ParseError(unmasked) == CloseCode::kProtocolError);
+    // 客户端解析服务端的帧时不接受掩码
+    assert(ParseError(Masked(Opcode::kText, "hi"), false) == CloseCode::kProtocolError);
+    // RSV 位和保留的操作码
+    std::string rsv = Masked(Opcode::kText, "hi");
+    rsv[0] = static_cast<char>(rsv[0] | 0x40);
+    assert(ParseError(rsv) == CloseCode::kProtocolError);
+    assert(ParseError(Masked(static_cast<Opcode>(0x3), "hi")) == CloseCode::kProtocolError);
+    // 控制帧不能分片，负载不超过125字节
+    assert(ParseError(Masked(Opcode::kPing, "p", false)) == CloseCode::kProtocolError);
+    assert(ParseError(Masked(Opcode::kPing, std::string(126, 'p'))) == CloseCode::kProtocolError);
+    // 没有开始分片时收到后续片段，分片未结束时开始新消息
+    assert(ParseError(Masked(Opcode::kContinuation, "x")) == CloseCode::kProtocolError);
+    assert(ParseError(Masked(Opcode::kText, "a", false) + Masked(Opcode::kText, "b")) == CloseCode::kProtocolError);
+    // 消息过大，分片合并后过大
+    assert(ParseError(Masked(Opcode::kBinary, std::string(101, 'x')), true, 100) == CloseCode::kMessageTooBig);
+    assert(ParseError(Masked(Opcode::kBinary, std::string(60, 'x'), false) + Masked(Opcode::kContinuation, std::string(60, 'x')), true, 100) == CloseCode::kMessageTooBig);
+    // 文本不是 UTF-8，包括跨分片的多字节字符不完整
+    assert(ParseError(Masked(Opcode::kText, "ok\xff")) == CloseCode::kInvalidPayload);
+    assert(ParseError(Masked(Opcode::kText, "\xe4\xbd", false) + Masked(Opcode::kContinuation, "")) == CloseCode::kInvalidPayload);
+    // 关闭帧：只有1字节、保留的状态码、原因不是 UTF-8
+    assert(ParseError(Masked(Opcode::kClose, "\x03")) == CloseCode::kProtocolError);
+    assert(ParseError(Masked(Opcode::kClose, std::string("\x03\xed", 2))) == CloseCode::kProtocolError);
+    assert(ParseError(Masked(Opcode::kClose, std::string("\x03\xe8\xc0\x80", 4))) == CloseCode::kInvalidPayload);
+}
+
+void TestClosePayload()
+{
+    CloseCode code;
+    std::string_view reason;
+    bool ok = jl::ws::ParseClosePayload("", code, reason);
+    assert(ok && code == CloseCode::kNoStatus);
+    ok = jl::ws::ParseClosePayload(std::string_view("\x03\xe8" "done", 6), code, reason);
+    assert(ok && code == CloseCode::kNormal && reason == "done");
+    ok = jl::ws::ParseClosePayload(std::string_view("\x0f\xa0", 2), code, reason);
+    assert(ok && static_cast<int>(code) == 4000);
+    ok = jl::ws::ParseClosePayload(std::string_view("\x03\xee", 2), code, reason);   // 1006
+    assert(!ok);
+}
+
+void TestUtf8()
+{
+    assert(jl::ws::IsValidUtf8(""));
+    assert(jl::ws::IsValidUtf8("plain ascii text longer than eight bytes"));
+    assert(jl::ws::IsValidUtf8("\xe4\xbd\xa0\xe5\xa5\xbd, websocket \xf0\x9f\x98\x80"));
+    assert(jl::ws::IsValidUtf8("\xf4\x8f\xbf\xbf"));         // U+10FFFF
+    assert(!jl::ws::IsValidUtf8("\xf4\x90\x80\x80"));        // 超出 U+10FFFF
+    assert(!jl::ws::IsValidUtf8("\xed\xa0\x80"));            // 代理对
+    assert(!jl::ws::IsValidUtf8("\xc0\xaf"));                // 过长编码
+    assert(!jl::ws::IsValidUtf8("abcdefgh\x80"));            // 孤立的后续字节
+    assert(!jl::ws::IsValidUtf8("abcdefghijklmno\xe4\xbd")); // 末尾不完整
+}
+
+int main()
+{
+    TestHandshake();
+    TestFrameHeader();
+    TestSplitEverywhere();
+    TestFragmentation();
+    TestErrors();
+    TestClosePayload();
+    TestUtf8();
+    std::cout << "websocket_test passed" << std::endl;
+    return 0;
+}